@@ -1,11 +1,15 @@
 #include <iostream>
 #include <filesystem>
 #include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 
 #include "application.h"
 #include "logger.h"
 #include "timestep.h"
 #include "validation.h"
+#include "configuration.h"
 
 #include "openxr_components.h"
 
@@ -54,10 +58,18 @@ int Application::SetActiveScene(Scene* scene)
         // vrDisplay then is initialized with the correct extent
         OpenxrSession* session = openxr->NewSession();
         renderer->InitializeXrSession(session);
+
+        // Antialiasing is done by MSAA in the camera render passes,
+        // supersampling is optional and the largest extent
+        // dynamic resolution can use.
+        float scale = 1.0f;
+        std::string value;
+        if (Configuration::Get(CONFIG_VR_RESOLUTION_SCALE, value))
+            scale = std::max(0.1f, static_cast<float>(std::atof(value.c_str())));
+
         vrDisplay->Initialize({
-            // Software antialising by a factor of 4
-            session->GetWidth() * 4,
-            session->GetHeight() * 4
+            std::floor(session->GetWidth() * scale),
+            std::floor(session->GetHeight() * scale)
         });
 
         renderer->SetXRWindowContext(vrDisplay);
@@ -8,6 +8,7 @@
 
 #include "obj_loader.h"
 #include "gltf_importer.h"
+#include "mesh_optimizer.h"
 #include <stb/stb_image_write.h>
 
 #include "mesh_component.h"
@@ -247,6 +248,15 @@ std::shared_ptr<renderer::Texture> AssetManager::ImportTexture(std::string path)
     return texture;
 }
 
+renderer::VertexFormat AssetManager::GetImportVertexFormat()
+{
+    std::string value;
+    if (Configuration::Get(CONFIG_COMPACT_VERTEX, value) && value == "true")
+        return renderer::VertexFormat::Compact;
+
+    return renderer::VertexFormat::Standard;
+}
+
 Entity* AssetManager::ImportModelObj(std::string path, Scene* scene)
 {
 
@@ -262,6 +272,8 @@ Entity* AssetManager::ImportModelObj(std::string path, Scene* scene)
     std::filesystem::path fsPath = path;
     std::string fileName = fsPath.stem().string();
 
+    MeshOptimizer::Optimize(fileName, info.indices, info.vertices, info.lods);
+
     std::string validWsFullPath = Filesystem::GetUnusedFilePath(
         workspacePath + "/" + MESH_PATH + "/" + fileName + MESH_DATA_EXTENSION
     );
@@ -272,9 +284,10 @@ Entity* AssetManager::ImportModelObj(std::string path, Scene* scene)
     // Store the imported mesh into workspace
     info.resourcePath =
         Filesystem::ChangeExtensionTo(validWsRelativePath, MESH_EXTENSION);
+    info.vertexFormat = GetImportVertexFormat();
     MeshFile::Store(
         validWsFullPath,
-        info.indices, info.vertices
+        info.indices, info.vertices, info.lods
     );
 
     std::shared_ptr<renderer::Mesh> mesh = renderer::VulkanMesh::BuildMesh(info);
@@ -311,7 +324,7 @@ Entity* AssetManager::ImportModelGltf(std::string path, Scene* scene)
         );
         MeshFile::Store(
             GetWorkspacePath() + "/" + relativeMeshDataPath,
-            info->indices, info->vertices
+            info->indices, info->vertices, info->lods
         );
     }
 
@@ -477,6 +490,55 @@ bool AssetManager::GetSourceCode(
     return false;
 }
 
+std::string AssetManager::GetMeshDataPath(std::string path)
+{
+    Filesystem::ToUnixPath(path);
+    return workspacePath + "/" +
+        Filesystem::ChangeExtensionTo(path, MESH_DATA_EXTENSION);
+}
+
+bool AssetManager::GetMeshGeometry(std::string path,
+    std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices)
+{
+    std::string meshDataPath = GetMeshDataPath(path);
+
+    MappedFile mappedFile;
+    renderer::MeshDataView view{};
+    std::vector<renderer::Vertex> vertices;
+    std::vector<unsigned int> allIndices;
+    std::vector<renderer::MeshLod> lods;
+
+    if (!MeshFile::Map(meshDataPath, mappedFile, view))
+    { // Legacy mesh files are read into memory.
+        MeshFile::Load(meshDataPath, allIndices, vertices, lods);
+        view.vertices = vertices.data();
+        view.vertexCount = vertices.size();
+        view.indices = allIndices.data();
+        view.indexCount = allIndices.size();
+        view.lods = lods.data();
+        view.lodCount = lods.size();
+    }
+
+    if (view.vertexCount == 0 || view.indexCount == 0)
+        return false;
+
+    // Collision uses the finest level of detail.
+    uint64_t firstIndex = 0;
+    uint64_t indexCount = view.indexCount;
+    if (view.lodCount > 0)
+    {
+        firstIndex = view.lods[0].firstIndex;
+        indexCount = view.lods[0].indexCount;
+    }
+
+    positions.resize(view.vertexCount);
+    for (uint64_t i = 0; i < view.vertexCount; i++)
+        positions[i] = view.vertices[i].Position;
+    indices.assign(view.indices + firstIndex, view.indices + firstIndex + indexCount);
+
+    return true;
+}
+
 bool AssetManager::NewSourceCode(std::string fileName)
 {
     std::string fullPath = GetScriptPath(fileName);
@@ -514,6 +576,8 @@ std::shared_ptr<renderer::Material> AssetManager::LoadMaterial(
     DeserializeVec3(properties.albedo, json["albedo"]);
     properties.metallic = json["metallic"].asFloat();
     properties.roughness = json["roughness"].asFloat();
+    if (json.isMember("opacity"))
+        properties.opacity = json["opacity"].asFloat();
 
     std::string texturePath; 
     if((texturePath = json["albedoTexture"].asString()) != "none")
@@ -738,14 +802,26 @@ std::shared_ptr<renderer::Mesh> AssetManager::LoadMesh(
     ASSERT(json[JSON_TYPE].asInt() == (int)JsonType::Mesh);
     renderer::BuildMeshInfo info{};
     info.resourcePath = json["resourcePath"].asString();
+    if (!json["vertexFormat"].isNull())
+        info.vertexFormat = (renderer::VertexFormat)json["vertexFormat"].asInt();
 
-    MeshFile::Load(workspacePath + "/" +
-        Filesystem::ChangeExtensionTo(info.resourcePath, MESH_DATA_EXTENSION),
-        info.indices, info.vertices
-    );
+    std::string meshDataPath = workspacePath + "/" +
+        Filesystem::ChangeExtensionTo(info.resourcePath, MESH_DATA_EXTENSION);
 
-    std::shared_ptr<renderer::Mesh> mesh =
-        renderer::VulkanMesh::BuildMesh(info);
+    std::shared_ptr<renderer::Mesh> mesh;
+    MappedFile mappedFile;
+    renderer::MeshDataView view{};
+
+    if (MeshFile::Map(meshDataPath, mappedFile, view))
+    {
+        mesh = renderer::VulkanMesh::BuildMesh(
+            info.resourcePath, view, info.vertexFormat);
+    }
+    else
+    { // Legacy mesh files are read into memory.
+        MeshFile::Load(meshDataPath, info.indices, info.vertices, info.lods);
+        mesh = renderer::VulkanMesh::BuildMesh(info);
+    }
     
     std::string materialPath = json["material"].asString();
 
@@ -773,53 +849,3 @@ bool AssetManager::StoreMesh(std::shared_ptr<renderer::Mesh> mesh)
 
     return false;
 }
-
-
-void MeshFile::Store(
-    std::string fullPath,
-    const std::vector<unsigned int>& modelIndices,
-    const std::vector<renderer::Vertex>& modelVertices)
-{
-    MeshFile header;
-    header.indexSize = modelIndices.size();
-    header.vertexSize = modelVertices.size();
-
-    unsigned int indexBytes = modelIndices.size() * sizeof(unsigned int);
-    unsigned int vertexBytes = modelVertices.size() * sizeof(renderer::Vertex);
-
-    std::ofstream out;
-    out.open(fullPath, std::ifstream::out | std::ifstream::binary);
-    out.write((char*)&header, sizeof(header));
-    out.write((char*)modelIndices.data(), indexBytes);
-    out.write((char*)modelVertices.data(), vertexBytes);
-
-    out.close();
-}
-
-void MeshFile::Load(std::string fullPath,
-    std::vector<unsigned int>& modelIndices,
-    std::vector<renderer::Vertex>& modelVertices)
-{
-    std::ifstream in;
-    in.open(fullPath, std::ifstream::in | std::ifstream::binary);
-
-    MeshFile header;
-    in.read((char*)&header, sizeof(header));
-
-    Logger::Write(
-        "Loading model from workspace with mesh size " +
-        std::to_string(header.vertexSize) + " bytes and index size "  +
-        std::to_string(header.indexSize) + "bytes.",
-        Logger::Level::Info, Logger::MsgType::Platform
-    );
-
-    modelIndices.resize(header.indexSize);
-    modelVertices.resize(header.vertexSize);
-
-    unsigned int indexBytes = modelIndices.size() * sizeof(unsigned int);
-    unsigned int vertexBytes = modelVertices.size() * sizeof(renderer::Vertex);
-
-    in.read((char*)modelIndices.data(), indexBytes);
-    in.read((char*)modelVertices.data(), vertexBytes);
-    in.close();
-}
\ No newline at end of file
@@ -8,10 +8,12 @@
 #include "vulkan_material.h"
 #include "vulkan_mesh.h"
 #include "vulkan_texture.h"
+#include "mesh_file.h"
 
 #include "renderer_asset_manager.h"
 #include "core_asset_manager.h"
 #include "script_asset_manager.h"
+#include "physics_asset_manager.h"
 
 #include "scene.h"
 
@@ -36,6 +38,7 @@
 class AssetManager:
     public renderer::IRendererAssetManager,
     public scripting::IScriptAssetManager,
+    public physics::IPhysicsAssetManager,
     public ICoreAssetManager
 {
 public:
@@ -85,6 +88,13 @@ public:
     Entity* ImportModelObj(std::string path, Scene* scene);
     Entity* ImportModelGltf(std::string path, Scene* scene);
 
+    /**
+     * @brief Vertex format used by newly imported meshes,
+     * controlled by CONFIG_COMPACT_VERTEX.
+     * Mesh data files are always stored losslessly.
+     */
+    static renderer::VertexFormat GetImportVertexFormat();
+
     // bool ImportModelGlft(std::string path);
     // Entity* AddModelToScene(std::string path, Scene* scene);
 
@@ -123,6 +133,11 @@ public:
 
     bool NewSourceCode(std::string fileName) override;
 
+    std::string GetMeshDataPath(std::string path) override;
+    bool GetMeshGeometry(std::string path,
+        std::vector<glm::vec3>& positions,
+        std::vector<unsigned int>& indices) override;
+
     bool IsWorkspaceInitialized() override {return initialized;}
     std::string GetWorkspacePath() override {return workspacePath;}
     
@@ -171,19 +186,3 @@ private:
     std::string workspacePath;
     bool initialized = false;
 };
-
-struct MeshFile
-{
-    unsigned int indexSize;
-    unsigned int vertexSize;
-
-    static void Store(
-        std::string fullPath,
-        const std::vector<unsigned int>& modelIndices,
-        const std::vector<renderer::Vertex>& modelVertices
-    );
-    static void Load(std::string fullPath,
-        std::vector<unsigned int>& modelIndices,
-        std::vector<renderer::Vertex>& modelVertices
-    );
-};
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "gltf_importer.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <glm/glm.hpp>
@@ -13,6 +16,8 @@
 
 #include "mesh_component.h"
 #include "asset_manager.h"
+#include "mesh_optimizer.h"
+#include "job_system.h"
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb/stb_image_write.h"
@@ -31,6 +36,9 @@ std::shared_ptr<GltfModel> GltfModel::Import(std::string path, Scene* scene)
         Logger::MsgType::Loader
     );
 
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
     std::shared_ptr<GltfModel> model = std::make_shared<GltfModel>();
     model->scene = scene;
 
@@ -40,6 +48,11 @@ std::shared_ptr<GltfModel> GltfModel::Import(std::string path, Scene* scene)
     jsonIn.close();
 
     model->LoadBuffers();
+    Clock::time_point buffersLoaded = Clock::now();
+
+    model->DecodeAssets();
+    Clock::time_point assetsDecoded = Clock::now();
+
     model->LoadTextures();
     model->LoadMaterials();
 
@@ -57,6 +70,21 @@ std::shared_ptr<GltfModel> GltfModel::Import(std::string path, Scene* scene)
         model->ProcessNode(model->modelEntity, rootNodes[i].asInt());
     }
 
+    Clock::time_point end = Clock::now();
+    auto milliseconds = [](Clock::duration duration) {
+        return std::to_string(
+            std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+    };
+
+    Logger::Write(
+        "Imported " + path + " in " + milliseconds(end - start) + " ms: "
+        "buffers " + milliseconds(buffersLoaded - start) + " ms, "
+        "decode " + milliseconds(assetsDecoded - buffersLoaded) + " ms, "
+        "resources and entities " + milliseconds(end - assetsDecoded) + " ms, " +
+        std::to_string(JobSystem::GetInstance().GetWorkerCount()) + " workers.",
+        Logger::Level::Info, Logger::MsgType::Loader
+    );
+
     return model;
 }
 
@@ -64,29 +92,149 @@ void GltfModel::LoadBuffers()
 {
     ZoneScopedN("GltfModel::LoadBuffers");
 
-    Json::Value& gltfBuffers = gltf["buffers"];
+    const Json::Value& gltfBuffers = gltf["buffers"];
     const std::string header = "data:application/octet-stream;base64,";
 
-    for (int i = 0; i < gltfBuffers.size(); i++)
+    bufferList.resize(gltfBuffers.size());
+    JobSystem::GetInstance().ParallelFor(gltfBuffers.size(),
+        [this, &gltfBuffers, &header](uint32_t i)
     {
-        Json::Value& gltfBuffer = gltfBuffers[i];
+        const Json::Value& gltfBuffer = gltfBuffers[i];
+
+        // Read the uri in place, it can be hundreds of megabytes.
+        const char* uriBegin = nullptr;
+        const char* uriEnd = nullptr;
+        gltfBuffer["uri"].getString(&uriBegin, &uriEnd);
+        size_t uriLength = uriEnd - uriBegin;
 
-        if (gltfBuffer["uri"].asString().find(header) == 0)
+        if (uriLength >= header.size() &&
+            std::equal(header.begin(), header.end(), uriBegin))
         { // embedded
-            std::string data = gltfBuffer["uri"].asString().substr(header.size());
-            std::string decode = base64::base64_decode(data);
-            assert(decode.size() == gltfBuffer["byteLength"].asUInt());
-
-            std::vector<unsigned char> bin;
-            bin.resize(decode.size());
-            std::copy(decode.begin(), decode.end(), bin.begin());
-            bufferList.push_back(bin);
+            base64::base64_decode(uriBegin + header.size(),
+                uriLength - header.size(), bufferList[i]);
+            assert(bufferList[i].size() == gltfBuffer["byteLength"].asUInt());
         }
         else
         { // from a file
             throw; //TODO:
         }
+    });
+}
+
+void GltfModel::DecodeAssets()
+{
+    ZoneScopedN("GltfModel::DecodeAssets");
+
+    const Json::Value& gltfTextures = gltf["textures"];
+    const Json::Value& gltfMaterials = gltf["materials"];
+    const Json::Value& gltfMeshes = gltf["meshes"];
+
+    struct ImageJob
+    {
+        int textureIndex;
+        int channel; // Broadcast to RGBA, -1 keeps all channels
+        std::shared_ptr<PixelData>* result;
+    };
+
+    struct PrimitiveJob
+    {
+        int meshIndex;
+        int primIndex;
+    };
+
+    std::vector<ImageJob> imageJobs;
+    std::vector<PrimitiveJob> primitiveJobs;
+
+    decodedTextures.resize(gltfTextures.size());
+    for (int i = 0; i < gltfTextures.size(); i++)
+        imageJobs.push_back({i, -1, &decodedTextures[i]});
+
+    decodedRoughness.resize(gltfMaterials.size());
+    decodedMetalness.resize(gltfMaterials.size());
+    for (int i = 0; i < gltfMaterials.size(); i++)
+    {
+        const Json::Value& gltfPbr = gltfMaterials[i]["pbrMetallicRoughness"];
+        if (gltfPbr.isNull() || gltfPbr["metallicRoughnessTexture"].isNull())
+            continue;
+
+        int texIndex = gltfPbr["metallicRoughnessTexture"]["index"].asInt();
+        // green channel contains roughness values
+        imageJobs.push_back({texIndex, 1, &decodedRoughness[i]});
+        // blue channel contains metalness values
+        imageJobs.push_back({texIndex, 2, &decodedMetalness[i]});
+    }
+
+    decodedPrimitives.resize(gltfMeshes.size());
+    for (int i = 0; i < gltfMeshes.size(); i++)
+    {
+        int primCount = gltfMeshes[i]["primitives"].size();
+        decodedPrimitives[i].resize(primCount);
+        for (int j = 0; j < primCount; j++)
+            primitiveJobs.push_back({i, j});
+    }
+
+    // Images and primitives share one batch so that they overlap.
+    uint32_t jobCount = imageJobs.size() + primitiveJobs.size();
+    JobSystem::GetInstance().ParallelFor(jobCount,
+        [this, &imageJobs, &primitiveJobs](uint32_t i)
+    {
+        if (i < imageJobs.size())
+        {
+            const ImageJob& job = imageJobs[i];
+            *job.result = DecodeImage(job.textureIndex, job.channel);
+        }
+        else
+        {
+            const PrimitiveJob& job = primitiveJobs[i - imageJobs.size()];
+            decodedPrimitives[job.meshIndex][job.primIndex] =
+                DecodePrimitive(job.meshIndex, job.primIndex);
+        }
+    });
+}
+
+std::shared_ptr<GltfModel::PixelData> GltfModel::DecodeImage(
+    int textureIndex, int channel) const
+{
+    ZoneScopedN("GltfModel::DecodeImage");
+
+    int sourceIndex = gltf["textures"][textureIndex]["source"].asInt();
+    const Json::Value& gltfImage = gltf["images"][sourceIndex];
+
+    if (!gltfImage["uri"].isNull())
+    { // load image file
+        // TODO:
+        throw;
+    }
+
+    assert(gltfImage["bufferView"] && gltfImage["mimeType"]);
+    int viewIndex = gltfImage["bufferView"].asInt();
+    const Json::Value& gltfBufferView = gltf["bufferViews"][viewIndex];
+
+    assert(gltfBufferView["byteStride"].isNull()); // image data has no stride
+    int bufIndex = gltfBufferView["buffer"].asInt();
+    int bufLength = gltfBufferView["byteLength"].asInt();
+    int bufOffset = gltfBufferView["byteOffset"].asInt();
+
+    const std::vector<unsigned char> &buf = bufferList[bufIndex];
+
+    int width, height, channels;
+    stbi_uc* pixels = stbi_load_from_memory(&buf[bufOffset], bufLength,
+        &width, &height, &channels, STBI_rgb_alpha);
+
+    if (channel >= 0)
+    {
+        for (int p = 0; p < width * height; p++)
+        {
+            stbi_uc *pixel = &pixels[4*p];
+            stbi_uc value = pixel[channel];
+            pixel[0] = value;
+            pixel[1] = value;
+            pixel[2] = value;
+            pixel[3] = value;
+        }
     }
+
+    return std::make_shared<PixelData>(pixels, width, height);
 }
 
 void GltfModel::LoadTextures()
@@ -111,65 +259,43 @@ void GltfModel::LoadTextures()
         int magFilter = sampler["magFilter"].asInt();
         int minFilter = sampler["minFilter"].asInt();
 
-        Json::Value& gltfImage = gltfImages[sourceIndex];
+        std::shared_ptr<PixelData> pixelData = decodedTextures[i];
 
-        if (gltfImage["uri"].isNull())
-        {
-            assert(gltfImage["bufferView"] && gltfImage["mimeType"]);
-            int viewIndex = gltfImage["bufferView"].asInt();
-            Json::Value& gltfBufferView = gltf["bufferViews"][viewIndex];
-
-            assert(gltfBufferView["byteStride"].isNull()); // image data has no stride
-            int bufIndex = gltfBufferView["buffer"].asInt();
-            int bufLength = gltfBufferView["byteLength"].asInt();
-            int bufOffset = gltfBufferView["byteOffset"].asInt();
-
-            std::vector<unsigned char> &buf = bufferList[bufIndex];
-
-            int width, height, channels;
-            stbi_uc* pixels = stbi_load_from_memory(&buf[bufOffset], bufLength,
-                &width, &height, &channels, STBI_rgb_alpha);
-
-            renderer::TextureBuildInfo info{};
-            info.maxFilter = (magFilter == SamplerType::NEAREST)?
-                renderer::FILTER_NEAREST: renderer::FILTER_LINEAR;
-            info.minFilter = (minFilter == SamplerType::NEAREST)?
-                renderer::FILTER_NEAREST: renderer::FILTER_LINEAR;
-
-            std::string filename = gltfImages[sourceIndex]["name"].asString();
-            if (namePool.find(filename) != namePool.cend())
-            {
-                int num = namePool[filename];
-                namePool[filename] = num + 1;
-                filename = filename + "_" + std::to_string(num);
-            }
-            else
-            {
-                namePool[filename] = 1;
-            }
-            std::string fullwsPath = Filesystem::GetUnusedFilePath(
-                scene->GetAssetManager()->GetTexturePath(filename)
-            );
-            std::string relativeResourcePath = Filesystem::RemoveParentPath(
-                fullwsPath, scene->GetAssetManager()->GetWorkspacePath()
-            );
-            info.resourcePath = relativeResourcePath;
-            info.imagePath = Filesystem::ChangeExtensionTo(
-                info.resourcePath, TEXTURE_DATA_EXTENSION
-            );
+        renderer::TextureBuildInfo info{};
+        info.maxFilter = (magFilter == SamplerType::NEAREST)?
+            renderer::FILTER_NEAREST: renderer::FILTER_LINEAR;
+        info.minFilter = (minFilter == SamplerType::NEAREST)?
+            renderer::FILTER_NEAREST: renderer::FILTER_LINEAR;
 
-            std::shared_ptr<renderer::Texture> texture = renderer::VulkanTexture::
-                BuildTextureFromBuffer(pixels, width, height, &info);
-            
-            pixelDataList.push_back(std::make_shared<PixelData>(pixels, width, height));
-            textureList.push_back(
-                std::dynamic_pointer_cast<renderer::VulkanTexture>(texture));
+        std::string filename = gltfImages[sourceIndex]["name"].asString();
+        if (namePool.find(filename) != namePool.cend())
+        {
+            int num = namePool[filename];
+            namePool[filename] = num + 1;
+            filename = filename + "_" + std::to_string(num);
         }
-        else // load image file
+        else
         {
-            // TODO:
-            throw;
+            namePool[filename] = 1;
         }
+        std::string fullwsPath = Filesystem::GetUnusedFilePath(
+            scene->GetAssetManager()->GetTexturePath(filename)
+        );
+        std::string relativeResourcePath = Filesystem::RemoveParentPath(
+            fullwsPath, scene->GetAssetManager()->GetWorkspacePath()
+        );
+        info.resourcePath = relativeResourcePath;
+        info.imagePath = Filesystem::ChangeExtensionTo(
+            info.resourcePath, TEXTURE_DATA_EXTENSION
+        );
+
+        std::shared_ptr<renderer::Texture> texture = renderer::VulkanTexture::
+            BuildTextureFromBuffer(pixelData->pixels,
+                pixelData->width, pixelData->height, &info);
+
+        pixelDataList.push_back(pixelData);
+        textureList.push_back(
+            std::dynamic_pointer_cast<renderer::VulkanTexture>(texture));
     }
 }
 
@@ -233,6 +359,13 @@ void GltfModel::LoadMaterials()
                 }
             }
 
+            // Only blended materials are drawn as transparent.
+            if (gltfMaterial["alphaMode"].asString() == "BLEND" &&
+                !gltfPbr["baseColorFactor"].isNull())
+            {
+                prop.opacity = gltfPbr["baseColorFactor"][3].asFloat();
+            }
+
             if (!gltfPbr["metallicRoughnessTexture"].isNull())
             {
                 int texIndex = gltfPbr["metallicRoughnessTexture"]["index"].asInt();
@@ -243,137 +376,64 @@ void GltfModel::LoadMaterials()
                 int samplerIndex = gltfTextures[texIndex]["sampler"].asInt();
                 int sourceIndex = gltfTextures[texIndex]["source"].asInt();
 
-
                 Json::Value& sampler = gltf["samplers"][samplerIndex];
                 int magFilter = sampler["magFilter"].asInt();
                 int minFilter = sampler["minFilter"].asInt();
 
-                Json::Value& gltfImage = gltfImages[sourceIndex];
-
-                if (gltfImage["uri"].isNull())
+                // Channels were split by DecodeAssets.
+                auto buildChannel = [&](std::shared_ptr<PixelData> pixelData)
                 {
-                    assert(gltfImage["bufferView"] && gltfImage["mimeType"]);
-                    int viewIndex = gltfImage["bufferView"].asInt();
-                    Json::Value& gltfBufferView = gltf["bufferViews"][viewIndex];
-
-                    assert(gltfBufferView["byteStride"].isNull()); // image data has no stride
-                    int bufIndex = gltfBufferView["buffer"].asInt();
-                    int bufLength = gltfBufferView["byteLength"].asInt();
-                    int bufOffset = gltfBufferView["byteOffset"].asInt();
-
-                    std::vector<unsigned char> &buf = bufferList[bufIndex];
-
-                    { // green channel contains roughness values
-                        int width, height, channels;
-                        stbi_uc* pixels = stbi_load_from_memory(&buf[bufOffset], bufLength,
-                            &width, &height, &channels, STBI_rgb_alpha);
-
-                        for (int p = 0; p < width * height; p++)
-                        {
-                            stbi_uc *pixel = &pixels[4*p];
-                            pixel[0] = pixel[1];
-                            pixel[1] = pixel[1];
-                            pixel[2] = pixel[1];
-                            pixel[3] = pixel[1];
-                        }
-
-                        renderer::TextureBuildInfo info{};
-                        info.maxFilter = (magFilter == SamplerType::NEAREST)?
-                            renderer::FILTER_NEAREST: renderer::FILTER_LINEAR;
-                        info.minFilter = (minFilter == SamplerType::NEAREST)?
-                            renderer::FILTER_NEAREST: renderer::FILTER_LINEAR;
-
-                        std::string filename = gltfImages[sourceIndex]["name"].asString();
-                        if (namePool.find(filename) != namePool.cend())
-                        {
-                            int num = namePool[filename];
-                            namePool[filename] = num + 1;
-                            filename = filename + "_" + std::to_string(num);
-                        }
-                        else
-                        {
-                            namePool[filename] = 1;
-                        }
-                        std::string fullwsPath = Filesystem::GetUnusedFilePath(
-                            scene->GetAssetManager()->GetTexturePath(filename)
-                        );
-                        std::string relativeResourcePath = Filesystem::RemoveParentPath(
-                            fullwsPath, scene->GetAssetManager()->GetWorkspacePath()
-                        );
-                        info.resourcePath = relativeResourcePath;
-                        info.imagePath = Filesystem::ChangeExtensionTo(
-                            info.resourcePath, TEXTURE_DATA_EXTENSION
-                        );
-
-                        std::shared_ptr<renderer::Texture> texture = 
-                            renderer::VulkanTexture::BuildTextureFromBuffer(
-                                pixels, width, height, &info);
-
-                        roughPixDataList.push_back(std::make_shared<PixelData>(pixels, width, height));
-                        roughTexList.push_back(
-                            std::dynamic_pointer_cast<renderer::VulkanTexture>(texture));
-                        prop.roughnessTexture = texture;
+                    renderer::TextureBuildInfo info{};
+                    info.maxFilter = (magFilter == SamplerType::NEAREST)?
+                        renderer::FILTER_NEAREST: renderer::FILTER_LINEAR;
+                    info.minFilter = (minFilter == SamplerType::NEAREST)?
+                        renderer::FILTER_NEAREST: renderer::FILTER_LINEAR;
+
+                    std::string filename = gltfImages[sourceIndex]["name"].asString();
+                    if (namePool.find(filename) != namePool.cend())
+                    {
+                        int num = namePool[filename];
+                        namePool[filename] = num + 1;
+                        filename = filename + "_" + std::to_string(num);
                     }
-
-                    { // blue channel contains metalness values
-                        int width, height, channels;
-                        stbi_uc* pixels = stbi_load_from_memory(&buf[bufOffset], bufLength,
-                            &width, &height, &channels, STBI_rgb_alpha);
-
-                        for (int p = 0; p < width * height; p++)
-                        {
-                            stbi_uc *pixel = &pixels[4*p];
-                            pixel[0] = pixel[2];
-                            pixel[1] = pixel[2];
-                            pixel[2] = pixel[2];
-                            pixel[3] = pixel[2];
-                        }
-
-                        renderer::TextureBuildInfo info{};
-                        info.maxFilter = (magFilter == SamplerType::NEAREST)?
-                            renderer::FILTER_NEAREST: renderer::FILTER_LINEAR;
-                        info.minFilter = (minFilter == SamplerType::NEAREST)?
-                            renderer::FILTER_NEAREST: renderer::FILTER_LINEAR;
-
-                        std::string filename = gltfImages[sourceIndex]["name"].asString();
-                        if (namePool.find(filename) != namePool.cend())
-                        {
-                            int num = namePool[filename];
-                            namePool[filename] = num + 1;
-                            filename = filename + "_" + std::to_string(num);
-                        }
-                        else
-                        {
-                            namePool[filename] = 1;
-                        }
-                        std::string fullwsPath = Filesystem::GetUnusedFilePath(
-                            scene->GetAssetManager()->GetTexturePath(filename)
-                        );
-                        std::string relativeResourcePath = Filesystem::RemoveParentPath(
-                            fullwsPath, scene->GetAssetManager()->GetWorkspacePath()
-                        );
-                        info.resourcePath = relativeResourcePath;
-                        info.imagePath = Filesystem::ChangeExtensionTo(
-                            info.resourcePath, TEXTURE_DATA_EXTENSION
-                        );
-
-                        std::shared_ptr<renderer::Texture> texture = 
-                            renderer::VulkanTexture::BuildTextureFromBuffer(
-                                pixels, width, height, &info);
-                        
-                        metalPixDataList.push_back(std::make_shared<PixelData>(pixels, width, height));
-                        metalTexList.push_back(
-                            std::dynamic_pointer_cast<renderer::VulkanTexture>(
-                                texture));
-                        prop.metallicTexture = texture;
+                    else
+                    {
+                        namePool[filename] = 1;
                     }
-                }
-                else // load image file
-                {
-                    // TODO:
-                    throw;
+                    std::string fullwsPath = Filesystem::GetUnusedFilePath(
+                        scene->GetAssetManager()->GetTexturePath(filename)
+                    );
+                    std::string relativeResourcePath = Filesystem::RemoveParentPath(
+                        fullwsPath, scene->GetAssetManager()->GetWorkspacePath()
+                    );
+                    info.resourcePath = relativeResourcePath;
+                    info.imagePath = Filesystem::ChangeExtensionTo(
+                        info.resourcePath, TEXTURE_DATA_EXTENSION
+                    );
+
+                    return renderer::VulkanTexture::BuildTextureFromBuffer(
+                        pixelData->pixels, pixelData->width, pixelData->height, &info);
+                };
+
+                { // green channel contains roughness values
+                    std::shared_ptr<renderer::Texture> texture =
+                        buildChannel(decodedRoughness[i]);
+
+                    roughPixDataList.push_back(decodedRoughness[i]);
+                    roughTexList.push_back(
+                        std::dynamic_pointer_cast<renderer::VulkanTexture>(texture));
+                    prop.roughnessTexture = texture;
                 }
 
+                { // blue channel contains metalness values
+                    std::shared_ptr<renderer::Texture> texture =
+                        buildChannel(decodedMetalness[i]);
+
+                    metalPixDataList.push_back(decodedMetalness[i]);
+                    metalTexList.push_back(
+                        std::dynamic_pointer_cast<renderer::VulkanTexture>(texture));
+                    prop.metallicTexture = texture;
+                }
             }
             else
             {
@@ -500,189 +560,11 @@ void GltfModel::LoadMeshes(
         Entity* entity = scene->NewEntity();
         entity->ReparentTo(parentEntity);
 
-        // "attributes" : {
-        //     "POSITION" : 889,
-        //     "TEXCOORD_0" : 890,
-        //     "NORMAL" : 891,
-        //     "JOINTS_0" : 892,
-        //     "WEIGHTS_0" : 893
-        // },
-        // "indices" : 894,
-        // "material" : 2,
-
-        assert(!primList[i]["attributes"]["POSITION"].isNull());
-        assert(!primList[i]["attributes"]["TEXCOORD_0"].isNull());
-        assert(!primList[i]["attributes"]["NORMAL"].isNull());
-        assert(!primList[i]["indices"].isNull());
-
         std::shared_ptr<renderer::BuildMeshInfo> info =
-            std::make_shared<renderer::BuildMeshInfo>();
-
-        std::vector<renderer::Vertex>& vertexList = info->vertices;
-        std::vector<unsigned int>& indexList = info->indices;
-
-        { // vertex position
-            int posIndex = primList[i]["attributes"]["POSITION"].asInt();
-            Json::Value& gltfAccessor = gltf["accessors"][posIndex];
-
-            assert(gltfAccessor["type"].asString() == "VEC3");
-            assert(!gltfAccessor["bufferView"].isNull());
-
-            int accIndex = gltfAccessor["bufferView"].asInt();
-            Json::Value& gltfBufferView = gltf["bufferViews"][accIndex];
-
-            int accOffset = gltfAccessor["byteOffset"].asInt();
-            int accCount = gltfAccessor["count"].asInt();
-            int bufIndex = gltfBufferView["buffer"].asInt();
-            // int bufLength = gltfBufferView["byteLength"].asInt();
-            int bufOffset = gltfBufferView["byteOffset"].asInt();
-            int bufStride = gltfBufferView["byteStride"].asInt();
-
-            vertexList.resize(accCount);
-
-            std::vector<unsigned char> &buf = bufferList[bufIndex];
-
-            if (bufStride == 0)
-            {
-                for (int i = 0; i < accCount; i++)
-                {
-                    glm::vec3* point = reinterpret_cast<glm::vec3*>(
-                        &buf[bufOffset + accOffset + sizeof(glm::vec3)*i]);
-                    vertexList[i].Position = *point;
-                }
-            }
-            else
-            {
-                for (int i = 0; i < accCount; i++)
-                {
-                    glm::vec3* point = reinterpret_cast<glm::vec3*>(
-                        &buf[bufOffset + accOffset + bufStride*i]);
-                    vertexList[i].Position = *point;
-                }   
-            }
-        }
-
-        { // vertex uv
-            int uvIndex = primList[i]["attributes"]["TEXCOORD_0"].asInt();
-            Json::Value& gltfAccessor = gltf["accessors"][uvIndex];
-
-            assert(gltfAccessor["type"].asString() == "VEC2");
-            assert(!gltfAccessor["bufferView"].isNull());
-
-            int accIndex = gltfAccessor["bufferView"].asInt();
-            Json::Value& gltfBufferView = gltf["bufferViews"][accIndex];
-
-            int accOffset = gltfAccessor["byteOffset"].asInt();
-            int accCount = gltfAccessor["count"].asInt();
-            int bufIndex = gltfBufferView["buffer"].asInt();
-            // int bufLength = gltfBufferView["byteLength"].asInt();
-            int bufOffset = gltfBufferView["byteOffset"].asInt();
-            int bufStride = gltfBufferView["byteStride"].asInt();
-
-            assert(vertexList.size() == accCount);
-
-            std::vector<unsigned char> &buf = bufferList[bufIndex];
-
-            if (bufStride == 0)
-            {
-                for (int i = 0; i < accCount; i++)
-                {
-                    glm::vec2* uv = reinterpret_cast<glm::vec2*>(
-                        &buf[bufOffset + accOffset + sizeof(glm::vec2)*i]);
-                    vertexList[i].TexCoords = *uv;
-                }
-            }
-            else
-            {
-                for (int i = 0; i < accCount; i++)
-                {
-                    glm::vec2* uv = reinterpret_cast<glm::vec2*>(
-                        &buf[bufOffset + accOffset + bufStride*i]);
-                    vertexList[i].TexCoords = *uv;
-                }   
-            }
-        }
-
-        { // vertex normal
-            int normIndex = primList[i]["attributes"]["NORMAL"].asInt();
-            Json::Value& gltfAccessor = gltf["accessors"][normIndex];
-
-            assert(gltfAccessor["type"].asString() == "VEC3");
-            assert(!gltfAccessor["bufferView"].isNull());
-
-            int accIndex = gltfAccessor["bufferView"].asInt();
-            Json::Value& gltfBufferView = gltf["bufferViews"][accIndex];
-
-            int accOffset = gltfAccessor["byteOffset"].asInt();
-            int accCount = gltfAccessor["count"].asInt();
-            int bufIndex = gltfBufferView["buffer"].asInt();
-            // int bufLength = gltfBufferView["byteLength"].asInt();
-            int bufOffset = gltfBufferView["byteOffset"].asInt();
-            int bufStride = gltfBufferView["byteStride"].asInt();
-
-            vertexList.resize(accCount);
-
-            std::vector<unsigned char> &buf = bufferList[bufIndex];
-
-            if (bufStride == 0)
-            {
-                for (int i = 0; i < accCount; i++)
-                {
-                    glm::vec3* norm = reinterpret_cast<glm::vec3*>(
-                        &buf[bufOffset + accOffset + sizeof(glm::vec3)*i]);
-                    vertexList[i].Normal = *norm;
-                }
-            }
-            else
-            {
-                for (int i = 0; i < accCount; i++)
-                {
-                    glm::vec3* norm = reinterpret_cast<glm::vec3*>(
-                        &buf[bufOffset + accOffset + bufStride*i]);
-                    vertexList[i].Normal = *norm;
-                }   
-            }
-        }
-
-        { // vertex indices FIXME: type check
-            int vertIndex = primList[i]["indices"].asInt();
-            Json::Value& gltfAccessor = gltf["accessors"][vertIndex];
-
-            assert(gltfAccessor["type"].asString() == "SCALAR");
-            assert(!gltfAccessor["bufferView"].isNull());
-
-            int accIndex = gltfAccessor["bufferView"].asInt();
-            Json::Value& gltfBufferView = gltf["bufferViews"][accIndex];
-
-            int accOffset = gltfAccessor["byteOffset"].asInt();
-            int accCount = gltfAccessor["count"].asInt();
-            int bufIndex = gltfBufferView["buffer"].asInt();
-            // int bufLength = gltfBufferView["byteLength"].asInt();
-            int bufOffset = gltfBufferView["byteOffset"].asInt();
-            int bufStride = gltfBufferView["byteStride"].asInt();
-
-            indexList.resize(accCount);
-
-            std::vector<unsigned char> &buf = bufferList[bufIndex];
-
-            if (bufStride == 0)
-            {
-                for (int i = 0; i < accCount; i++)
-                {
-                    unsigned short* norm = reinterpret_cast<unsigned short*>(
-                        &buf[bufOffset + accOffset + sizeof(unsigned short)*i]);
-                    indexList[i] = static_cast<unsigned int>(*norm);
-                }
-            }
-            else
-            {
-                for (int i = 0; i < accCount; i++)
-                {
-                    unsigned int* norm = reinterpret_cast<unsigned int*>(
-                        &buf[bufOffset + accOffset + bufStride*i]);
-                    indexList[i] = *norm;
-                }   
-            }
+            decodedPrimitives[meshIndex][i];
+        if (!info->resourcePath.empty())
+        { // Mesh instanced by another node, it needs its own resource.
+            info = std::make_shared<renderer::BuildMeshInfo>(*info);
         }
 
         std::string filename = nodeName + "_" + std::to_string(meshIndex);
@@ -703,6 +585,7 @@ void GltfModel::LoadMeshes(
             fullwsPath, scene->GetAssetManager()->GetWorkspacePath()
         );
         info->resourcePath = relativeResourcePath;
+        info->vertexFormat = AssetManager::GetImportVertexFormat();
 
         std::shared_ptr<renderer::Mesh> mesh = renderer::VulkanMesh::BuildMesh(*info);
 
@@ -722,6 +605,130 @@ void GltfModel::LoadMeshes(
     }
 }
 
+std::shared_ptr<renderer::BuildMeshInfo> GltfModel::DecodePrimitive(
+    int meshIndex, int primIndex) const
+{
+    ZoneScopedN("GltfModel::DecodePrimitive");
+
+    const Json::Value& gltfMesh = gltf["meshes"][meshIndex];
+    const Json::Value& gltfPrim = gltfMesh["primitives"][primIndex];
+
+    // "attributes" : {
+    //     "POSITION" : 889,
+    //     "TEXCOORD_0" : 890,
+    //     "NORMAL" : 891,
+    //     "JOINTS_0" : 892,
+    //     "WEIGHTS_0" : 893
+    // },
+    // "indices" : 894,
+    // "material" : 2,
+
+    const Json::Value& gltfAttributes = gltfPrim["attributes"];
+    assert(!gltfAttributes["POSITION"].isNull());
+    assert(!gltfAttributes["TEXCOORD_0"].isNull());
+    assert(!gltfAttributes["NORMAL"].isNull());
+    assert(!gltfPrim["indices"].isNull());
+
+    std::shared_ptr<renderer::BuildMeshInfo> info =
+        std::make_shared<renderer::BuildMeshInfo>();
+
+    std::vector<renderer::Vertex>& vertexList = info->vertices;
+    std::vector<unsigned int>& indexList = info->indices;
+
+    { // vertex position
+        AccessorView view = GetAccessorView(
+            gltfAttributes["POSITION"].asInt(), "VEC3", sizeof(glm::vec3));
+        vertexList.resize(view.count);
+
+        for (int i = 0; i < view.count; i++)
+            memcpy(&vertexList[i].Position, view.data + view.stride*i, sizeof(glm::vec3));
+    }
+
+    { // vertex uv
+        AccessorView view = GetAccessorView(
+            gltfAttributes["TEXCOORD_0"].asInt(), "VEC2", sizeof(glm::vec2));
+        assert(vertexList.size() == view.count);
+
+        for (int i = 0; i < view.count; i++)
+            memcpy(&vertexList[i].TexCoords, view.data + view.stride*i, sizeof(glm::vec2));
+    }
+
+    { // vertex normal
+        AccessorView view = GetAccessorView(
+            gltfAttributes["NORMAL"].asInt(), "VEC3", sizeof(glm::vec3));
+        assert(vertexList.size() == view.count);
+
+        for (int i = 0; i < view.count; i++)
+            memcpy(&vertexList[i].Normal, view.data + view.stride*i, sizeof(glm::vec3));
+    }
+
+    { // vertex indices
+        int accessorIndex = gltfPrim["indices"].asInt();
+        int componentType = gltf["accessors"][accessorIndex]["componentType"].asInt();
+
+        int elementSize = 0;
+        switch (componentType)
+        {
+            case DataType::UNSIGNED_BYTE:  elementSize = sizeof(uint8_t);  break;
+            case DataType::UNSIGNED_SHORT: elementSize = sizeof(uint16_t); break;
+            case DataType::UNSIGNED_INT:   elementSize = sizeof(uint32_t); break;
+            default: ASSERT(false);
+        }
+
+        AccessorView view = GetAccessorView(accessorIndex, "SCALAR", elementSize);
+        indexList.resize(view.count);
+
+        for (int i = 0; i < view.count; i++)
+        {
+            const unsigned char* element = view.data + view.stride*i;
+            if (elementSize == sizeof(uint8_t))
+            {
+                indexList[i] = *element;
+            }
+            else if (elementSize == sizeof(uint16_t))
+            {
+                uint16_t index;
+                memcpy(&index, element, sizeof(uint16_t));
+                indexList[i] = index;
+            }
+            else
+            {
+                uint32_t index;
+                memcpy(&index, element, sizeof(uint32_t));
+                indexList[i] = index;
+            }
+        }
+    }
+
+    MeshOptimizer::Optimize(
+        gltfMesh["name"].asString(), indexList, vertexList, info->lods);
+
+    return info;
+}
+
+GltfModel::AccessorView GltfModel::GetAccessorView(
+    int accessorIndex, const char* type, int elementSize) const
+{
+    const Json::Value& gltfAccessor = gltf["accessors"][accessorIndex];
+    assert(gltfAccessor["type"].asString() == type);
+    assert(!gltfAccessor["bufferView"].isNull());
+
+    int viewIndex = gltfAccessor["bufferView"].asInt();
+    const Json::Value& gltfBufferView = gltf["bufferViews"][viewIndex];
+
+    int accOffset = gltfAccessor["byteOffset"].asInt();
+    int bufIndex = gltfBufferView["buffer"].asInt();
+    int bufOffset = gltfBufferView["byteOffset"].asInt();
+    int bufStride = gltfBufferView["byteStride"].asInt();
+
+    AccessorView view{};
+    view.data = bufferList[bufIndex].data() + bufOffset + accOffset;
+    view.count = gltfAccessor["count"].asInt();
+    view.stride = (bufStride == 0)? elementSize: bufStride;
+    view.componentType = gltfAccessor["componentType"].asInt();
+    return view;
+}
+
 const Json::Value&
 GltfModel::GetModel()
 {
@@ -54,12 +54,36 @@ public:
     Entity* GetModelEntity() {return modelEntity;} //FIXME: same issue
 
 private:
+    struct AccessorView
+    {
+        const unsigned char* data;
+        int count;
+        int stride;
+        int componentType;
+    };
+
+    /**
+     * Import runs in three stages:
+     * 1. LoadBuffers decodes the binary buffers.
+     * 2. DecodeAssets decodes images and converts primitive accessors
+     *    in parallel. This stage only reads gltf and bufferList.
+     * 3. LoadTextures, LoadMaterials and ProcessNode create Vulkan
+     *    resources and entities on the calling thread.
+     */
     void LoadBuffers();
+    void DecodeAssets();
     void LoadTextures();
     void LoadMaterials();
     void LoadMeshes(Entity* parentEntity, int meshIndex, std::string nodeName);
     void ProcessNode(Entity* parentEntity, int nodeIndex);
 
+    // Thread safe, used by DecodeAssets
+    std::shared_ptr<PixelData> DecodeImage(int textureIndex, int channel) const;
+    std::shared_ptr<renderer::BuildMeshInfo> DecodePrimitive(
+        int meshIndex, int primIndex) const;
+    AccessorView GetAccessorView(
+        int accessorIndex, const char* type, int elementSize) const;
+
 private:
     Json::Value gltf;       // GLTF format defined by its spec
     Json::Value model;      // Format defined by the engine
@@ -77,6 +101,13 @@ private:
     std::vector<std::shared_ptr<PixelData>>                 roughPixDataList;
     std::vector<std::shared_ptr<PixelData>>                 metalPixDataList;
 
+    // Results of DecodeAssets
+    std::vector<std::shared_ptr<PixelData>>                 decodedTextures;  // per texture
+    std::vector<std::shared_ptr<PixelData>>                 decodedRoughness; // per material
+    std::vector<std::shared_ptr<PixelData>>                 decodedMetalness; // per material
+    std::vector<std::vector<std::shared_ptr<renderer::BuildMeshInfo>>>
+                                                            decodedPrimitives;// per mesh, primitive
+
     // Ensure names saved to the filesystem are unique
     // the second element is next available number
     std::map<std::string, int> namePool{};
@@ -0,0 +1,217 @@
+#include "mesh_file.h"
+
+#include "logger.h"
+#include "validation.h"
+
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+#include <tracy/Tracy.hpp>
+
+
+static uint64_t AlignUp(uint64_t offset)
+{
+    return (offset + MESH_FILE_ALIGNMENT - 1) & ~uint64_t(MESH_FILE_ALIGNMENT - 1);
+}
+
+static uint64_t HeaderSize(uint32_t version)
+{
+    return (version == 1)? MESH_FILE_V1_HEADER: sizeof(MeshFile);
+}
+
+static bool ValidateHeader(const MeshFile& header, uint64_t fileSize)
+{
+    if (header.magic != MESH_FILE_MAGIC)
+        return false;
+
+    if (header.version != 1 && header.version != MESH_FILE_VERSION)
+    {
+        Logger::Write(
+            "Mesh file version " + std::to_string(header.version) +
+            " is not supported.",
+            Logger::Level::Warning, Logger::MsgType::Loader
+        );
+        return false;
+    }
+
+    if (header.vertexStride != sizeof(renderer::Vertex) ||
+        header.indexStride != sizeof(unsigned int))
+        return false;
+
+    if (header.vertexOffset % MESH_FILE_ALIGNMENT != 0 ||
+        header.indexOffset % MESH_FILE_ALIGNMENT != 0)
+        return false;
+
+    // Division avoids overflow on corrupted counts.
+    if (header.vertexOffset > fileSize || header.indexOffset > fileSize)
+        return false;
+    if (header.vertexCount > (fileSize - header.vertexOffset) / header.vertexStride)
+        return false;
+    if (header.indexCount > (fileSize - header.indexOffset) / header.indexStride)
+        return false;
+
+    if (header.lodCount > MESH_MAX_LOD)
+        return false;
+    for (uint32_t i = 0; i < header.lodCount; i++)
+    {
+        const renderer::MeshLod& lod = header.lods[i];
+        if ((uint64_t)lod.firstIndex + lod.indexCount > header.indexCount)
+            return false;
+    }
+
+    return true;
+}
+
+void MeshFile::Store(
+    std::string fullPath,
+    const std::vector<unsigned int>& modelIndices,
+    const std::vector<renderer::Vertex>& modelVertices,
+    const std::vector<renderer::MeshLod>& modelLods)
+{
+    ZoneScopedN("MeshFile::Store");
+
+    ASSERT(modelLods.size() <= MESH_MAX_LOD);
+
+    MeshFile header{};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertexStride = sizeof(renderer::Vertex);
+    header.indexStride = sizeof(unsigned int);
+    header.vertexCount = modelVertices.size();
+    header.indexCount = modelIndices.size();
+    header.lodCount = static_cast<uint32_t>(modelLods.size());
+    for (uint32_t i = 0; i < header.lodCount; i++)
+        header.lods[i] = modelLods[i];
+
+    uint64_t vertexBytes = header.vertexCount * header.vertexStride;
+    uint64_t indexBytes = header.indexCount * header.indexStride;
+
+    header.vertexOffset = AlignUp(sizeof(MeshFile));
+    header.indexOffset = AlignUp(header.vertexOffset + vertexBytes);
+
+    const char padding[MESH_FILE_ALIGNMENT] = {};
+
+    std::ofstream out;
+    out.open(fullPath, std::ofstream::out | std::ofstream::binary);
+    out.write((char*)&header, sizeof(header));
+    out.write(padding, header.vertexOffset - sizeof(header));
+    out.write((char*)modelVertices.data(), vertexBytes);
+    out.write(padding, header.indexOffset - header.vertexOffset - vertexBytes);
+    out.write((char*)modelIndices.data(), indexBytes);
+
+    out.close();
+}
+
+void MeshFile::Load(std::string fullPath,
+    std::vector<unsigned int>& modelIndices,
+    std::vector<renderer::Vertex>& modelVertices,
+    std::vector<renderer::MeshLod>& modelLods)
+{
+    ZoneScopedN("MeshFile::Load");
+
+    std::ifstream in;
+    in.open(fullPath, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+    uint64_t fileSize = in.tellg();
+    in.seekg(0);
+
+    MeshFile header{};
+    in.read((char*)&header, sizeof(uint32_t) * 2);
+
+    if (header.magic == MESH_FILE_MAGIC)
+    {
+        in.read((char*)&header + sizeof(uint32_t) * 2,
+            HeaderSize(header.version) - sizeof(uint32_t) * 2);
+
+        if (!ValidateHeader(header, fileSize))
+        {
+            Logger::Write(
+                "Mesh file " + fullPath + " is corrupted.",
+                Logger::Level::Warning, Logger::MsgType::Loader
+            );
+            return;
+        }
+
+        modelVertices.resize(header.vertexCount);
+        modelIndices.resize(header.indexCount);
+        modelLods.assign(header.lods, header.lods + header.lodCount);
+
+        in.seekg(header.vertexOffset);
+        in.read((char*)modelVertices.data(),
+            header.vertexCount * header.vertexStride);
+        in.seekg(header.indexOffset);
+        in.read((char*)modelIndices.data(),
+            header.indexCount * header.indexStride);
+    }
+    else
+    { // Legacy file: {indexCount, vertexCount} then packed data.
+        uint32_t legacyIndexCount = header.magic;
+        uint32_t legacyVertexCount = header.version;
+
+        modelIndices.resize(legacyIndexCount);
+        modelVertices.resize(legacyVertexCount);
+
+        in.read((char*)modelIndices.data(),
+            modelIndices.size() * sizeof(unsigned int));
+        in.read((char*)modelVertices.data(),
+            modelVertices.size() * sizeof(renderer::Vertex));
+    }
+    in.close();
+
+    Logger::Write(
+        "Loading model from workspace with " +
+        std::to_string(modelVertices.size()) + " vertices and "  +
+        std::to_string(modelIndices.size()) + " indices.",
+        Logger::Level::Info, Logger::MsgType::Platform
+    );
+}
+
+bool MeshFile::Map(std::string fullPath,
+    MappedFile& file, renderer::MeshDataView& view)
+{
+    ZoneScopedN("MeshFile::Map");
+
+    if (!file.Open(fullPath))
+        return false;
+
+    if (file.Size() < MESH_FILE_V1_HEADER)
+    {
+        file.Close();
+        return false;
+    }
+
+    // Version 1 headers are shorter, only copy what the file has.
+    MeshFile header{};
+    memcpy(&header, file.Data(), sizeof(uint32_t) * 2);
+    if (header.magic != MESH_FILE_MAGIC ||
+        file.Size() < HeaderSize(header.version))
+    {
+        file.Close();
+        return false;
+    }
+    memcpy(&header, file.Data(), HeaderSize(header.version));
+
+    if (!ValidateHeader(header, file.Size()))
+    {
+        file.Close();
+        return false;
+    }
+
+    view.vertices = reinterpret_cast<const renderer::Vertex*>(
+        file.Data() + header.vertexOffset);
+    view.vertexCount = header.vertexCount;
+    view.indices = reinterpret_cast<const unsigned int*>(
+        file.Data() + header.indexOffset);
+    view.indexCount = header.indexCount;
+    view.lods = reinterpret_cast<const renderer::MeshLod*>(
+        file.Data() + offsetof(MeshFile, lods));
+    view.lodCount = header.lodCount;
+
+    Logger::Write(
+        "Mapping model from workspace with " +
+        std::to_string(view.vertexCount) + " vertices and "  +
+        std::to_string(view.indexCount) + " indices.",
+        Logger::Level::Info, Logger::MsgType::Platform
+    );
+
+    return true;
+}
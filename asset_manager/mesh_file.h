@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "mesh.h"
+#include "mapped_file.h"
+
+#define MESH_FILE_MAGIC         0x444D4C53 // "SLMD" in little endian
+#define MESH_FILE_VERSION       2
+#define MESH_FILE_ALIGNMENT     64
+#define MESH_FILE_V1_HEADER     48 // Header size before LODs were added
+
+/**
+ * @brief Header of the .slmshd mesh data file.
+ *
+ * Layout on disk:
+ * | MeshFile header | pad | vertex data | pad | index data |
+ * Each data section starts at a multiple of MESH_FILE_ALIGNMENT
+ * so that it can be used in place when the file is memory mapped.
+ *
+ * The index section holds all levels of detail back to back,
+ * described by the LOD table in the header (version 2).
+ * Version 1 files have a single level with all indices.
+ *
+ * Files written before the header was versioned
+ * only contain {uint32 indexCount, uint32 vertexCount}
+ * followed by tightly packed index and vertex data.
+ * They are still readable by MeshFile::Load.
+ */
+struct MeshFile
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexStride;
+    uint32_t indexStride;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t vertexOffset;  // Byte offset from the start of the file
+    uint64_t indexOffset;   // Byte offset from the start of the file
+    uint32_t lodCount;
+    uint32_t reserved;
+    renderer::MeshLod lods[MESH_MAX_LOD];
+
+    static void Store(
+        std::string fullPath,
+        const std::vector<unsigned int>& modelIndices,
+        const std::vector<renderer::Vertex>& modelVertices,
+        const std::vector<renderer::MeshLod>& modelLods
+    );
+
+    /**
+     * @brief Read the mesh file into the containers.
+     * Supports both versioned and legacy files.
+     * modelLods is left empty for files without LODs.
+     */
+    static void Load(std::string fullPath,
+        std::vector<unsigned int>& modelIndices,
+        std::vector<renderer::Vertex>& modelVertices,
+        std::vector<renderer::MeshLod>& modelLods
+    );
+
+    /**
+     * @brief Memory map a versioned mesh file.
+     * The view points into the mapping and is valid
+     * as long as the mapped file is open.
+     *
+     * @return Return false if the file cannot be mapped,
+     * is a legacy file, or fails validation.
+     * Callers should fall back to MeshFile::Load.
+     */
+    static bool Map(std::string fullPath,
+        MappedFile& file, renderer::MeshDataView& view
+    );
+};
+
+static_assert(sizeof(renderer::MeshLod) == 12, "Mesh LOD layout changed.");
+static_assert(sizeof(MeshFile) == 104, "Mesh file header layout changed.");
@@ -0,0 +1,734 @@
+#include "mesh_optimizer.h"
+
+#include "logger.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <tracy/Tracy.hpp>
+
+
+namespace
+{
+
+struct VertexHash
+{
+    const std::vector<renderer::Vertex>* vertices;
+
+    size_t operator()(unsigned int index) const
+    {
+        // FNV-1a over the raw vertex bytes
+        const unsigned char* bytes =
+            reinterpret_cast<const unsigned char*>(&(*vertices)[index]);
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < sizeof(renderer::Vertex); i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+struct VertexEqual
+{
+    const std::vector<renderer::Vertex>* vertices;
+
+    bool operator()(unsigned int a, unsigned int b) const
+    {
+        return memcmp(&(*vertices)[a], &(*vertices)[b],
+            sizeof(renderer::Vertex)) == 0;
+    }
+};
+
+/**
+ * Triangles adjacent to each vertex, in compressed row storage.
+ */
+struct Adjacency
+{
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> triangles;
+
+    Adjacency(const std::vector<unsigned int>& indices, uint64_t vertexCount)
+    {
+        offsets.assign(vertexCount + 1, 0);
+        for (unsigned int index: indices)
+            offsets[index + 1]++;
+        for (uint64_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] += offsets[v];
+
+        triangles.resize(indices.size());
+        std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            triangles[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+};
+
+/**
+ * Symmetric 4x4 error quadric of weighted planes.
+ */
+struct Quadric
+{
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+    double weight = 0.0;
+
+    void AddPlane(const glm::vec3& n, double d, double w)
+    {
+        a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+        a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+        b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+        c += w * d * d;
+        weight += w;
+    }
+
+    void Add(const Quadric& q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02;
+        a11 += q.a11; a12 += q.a12; a22 += q.a22;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2;
+        c += q.c;
+        weight += q.weight;
+    }
+
+    // Weighted sum of squared distances to the planes
+    double Error(const glm::vec3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double error =
+            a00 * x * x + a11 * y * y + a22 * z * z +
+            2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+            2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return (error > 0.0)? error: 0.0;
+    }
+};
+
+struct Collapse
+{
+    unsigned int from;
+    unsigned int to;
+    double cost; // Mean squared distance
+};
+
+/**
+ * Vertices that must not move: on open borders, non-manifold edges
+ * or attribute seams where several vertices share a position.
+ */
+std::vector<bool> FindLockedVertices(
+    const std::vector<unsigned int>& indices,
+    const std::vector<renderer::Vertex>& vertices)
+{
+    std::vector<bool> locked(vertices.size(), false);
+
+    std::vector<unsigned int> order(vertices.size());
+    for (unsigned int v = 0; v < vertices.size(); v++)
+        order[v] = v;
+    auto positionLess = [&vertices](unsigned int a, unsigned int b) {
+        return memcmp(&vertices[a].Position, &vertices[b].Position,
+            sizeof(glm::vec3)) < 0;
+    };
+    std::sort(order.begin(), order.end(), positionLess);
+    for (size_t i = 1; i < order.size(); i++)
+    {
+        if (!positionLess(order[i - 1], order[i]))
+        {
+            locked[order[i - 1]] = true;
+            locked[order[i]] = true;
+        }
+    }
+
+    std::unordered_map<uint64_t, uint32_t> edgeCount;
+    edgeCount.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            uint64_t a = indices[i + k];
+            uint64_t b = indices[i + (k + 1) % 3];
+            edgeCount[(std::min(a, b) << 32) | std::max(a, b)]++;
+        }
+    }
+    for (const auto& edge: edgeCount)
+    {
+        if (edge.second != 2)
+        {
+            locked[edge.first >> 32] = true;
+            locked[edge.first & 0xFFFFFFFF] = true;
+        }
+    }
+
+    return locked;
+}
+
+} // namespace
+
+void MeshOptimizer::Optimize(
+    const std::string& name,
+    std::vector<unsigned int>& indices,
+    std::vector<renderer::Vertex>& vertices,
+    std::vector<renderer::MeshLod>& lods)
+{
+    ZoneScopedN("MeshOptimizer::Optimize");
+
+    lods.clear();
+    if (indices.size() < 3 || indices.size() % 3 != 0)
+        return;
+
+    uint64_t vertexCountBefore = vertices.size();
+    CacheStats before = AnalyzeVertexCache(indices, vertices.size());
+
+    WeldVertices(indices, vertices);
+    GenerateLods(indices, vertices, lods);
+
+    for (const renderer::MeshLod& lod: lods)
+    {
+        auto begin = indices.begin() + lod.firstIndex;
+        std::vector<unsigned int> levelIndices(begin, begin + lod.indexCount);
+
+        OptimizeVertexCache(levelIndices, vertices.size());
+        OptimizeOverdraw(levelIndices, vertices);
+        std::copy(levelIndices.begin(), levelIndices.end(), begin);
+    }
+
+    // Full resolution comes first, so it decides the vertex order.
+    OptimizeVertexFetch(indices, vertices);
+
+    std::vector<unsigned int> fullIndices(
+        indices.begin(), indices.begin() + lods[0].indexCount);
+    CacheStats after = AnalyzeVertexCache(fullIndices, vertices.size());
+
+    std::string lodTriangles;
+    for (const renderer::MeshLod& lod: lods)
+    {
+        lodTriangles += (lodTriangles.empty()? "": "/") +
+            std::to_string(lod.indexCount / 3);
+    }
+
+    Logger::Write(
+        "Optimized mesh " + name + ": vertices " +
+        std::to_string(vertexCountBefore) + " -> " +
+        std::to_string(vertices.size()) + ", ACMR " +
+        std::to_string(before.acmr) + " -> " + std::to_string(after.acmr) +
+        ", ATVR " +
+        std::to_string(before.atvr) + " -> " + std::to_string(after.atvr) +
+        ", LOD triangles " + lodTriangles,
+        Logger::Level::Info, Logger::MsgType::Loader
+    );
+}
+
+void MeshOptimizer::GenerateLods(
+    std::vector<unsigned int>& indices,
+    const std::vector<renderer::Vertex>& vertices,
+    std::vector<renderer::MeshLod>& lods)
+{
+    ZoneScopedN("MeshOptimizer::GenerateLods");
+
+    lods.clear();
+    lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.0f});
+
+    std::vector<unsigned int> current = indices;
+    std::vector<unsigned int> next;
+    float error = 0.0f;
+
+    for (int level = 1; level < MESH_MAX_LOD; level++)
+    {
+        size_t targetIndexCount = static_cast<size_t>(
+            current.size() / 3 * MESH_OPTIMIZER_LOD_REDUCTION) * 3;
+        if (targetIndexCount == 0)
+            break;
+
+        // Errors of consecutive levels add up.
+        float levelError = Simplify(current, vertices, targetIndexCount,
+            MESH_OPTIMIZER_LOD_MAX_ERROR - error, next);
+
+        if (next.empty() ||
+            next.size() > current.size() * MESH_OPTIMIZER_LOD_MIN_GAIN)
+            break;
+
+        error += levelError;
+        lods.push_back({
+            static_cast<uint32_t>(indices.size()),
+            static_cast<uint32_t>(next.size()),
+            error
+        });
+        indices.insert(indices.end(), next.begin(), next.end());
+        current.swap(next);
+    }
+}
+
+float MeshOptimizer::Simplify(
+    const std::vector<unsigned int>& indices,
+    const std::vector<renderer::Vertex>& vertices,
+    size_t targetIndexCount,
+    float maxError,
+    std::vector<unsigned int>& result)
+{
+    ZoneScopedN("MeshOptimizer::Simplify");
+
+    result = indices;
+    if (indices.size() <= targetIndexCount || maxError <= 0.0f)
+        return 0.0f;
+
+    uint64_t vertexCount = vertices.size();
+
+    glm::vec3 minBound = vertices[indices[0]].Position;
+    glm::vec3 maxBound = minBound;
+    for (unsigned int index: indices)
+    {
+        minBound = glm::min(minBound, vertices[index].Position);
+        maxBound = glm::max(maxBound, vertices[index].Position);
+    }
+    glm::vec3 center = (minBound + maxBound) * 0.5f;
+    float radius = 0.0f;
+    for (unsigned int index: indices)
+        radius = std::max(radius, glm::length(vertices[index].Position - center));
+    if (radius == 0.0f)
+        return 0.0f;
+
+    std::vector<bool> locked = FindLockedVertices(indices, vertices);
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const glm::vec3& p0 = vertices[indices[i + 0]].Position;
+        const glm::vec3& p1 = vertices[indices[i + 1]].Position;
+        const glm::vec3& p2 = vertices[indices[i + 2]].Position;
+
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+        if (length == 0.0f)
+            continue;
+
+        normal = normal / length;
+        double area = 0.5 * length;
+        double d = -glm::dot(normal, p0);
+        for (int k = 0; k < 3; k++)
+            quadrics[indices[i + k]].AddPlane(normal, d, area);
+    }
+
+    double maxCost = (double)maxError * radius * maxError * radius;
+    double resultCost = 0.0;
+
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<Collapse> collapses;
+
+    while (result.size() > targetIndexCount)
+    {
+        Adjacency adjacency(result, vertexCount);
+
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = result[i + k];
+                unsigned int b = result[i + (k + 1) % 3];
+
+                Quadric q = quadrics[a];
+                q.Add(quadrics[b]);
+                if (q.weight == 0.0)
+                    continue;
+
+                if (!locked[a])
+                    collapses.push_back({a, b, q.Error(vertices[b].Position) / q.weight});
+                if (!locked[b])
+                    collapses.push_back({b, a, q.Error(vertices[a].Position) / q.weight});
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+            [](const Collapse& x, const Collapse& y) {return x.cost < y.cost;});
+
+        for (unsigned int v = 0; v < vertexCount; v++)
+            remap[v] = v;
+        std::fill(touched.begin(), touched.end(), false);
+
+        // Each collapse of an interior edge removes two triangles.
+        size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+
+        for (const Collapse& collapse: collapses)
+        {
+            if (removed >= trianglesToRemove || collapse.cost > maxCost)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            const glm::vec3& target = vertices[collapse.to].Position;
+            unsigned int begin = adjacency.offsets[collapse.from];
+            unsigned int end = adjacency.offsets[collapse.from + 1];
+
+            // Reject collapses that flip any remaining triangle.
+            bool flipped = false;
+            size_t shared = 0;
+            for (unsigned int a = begin; a < end && !flipped; a++)
+            {
+                const unsigned int* triangle = &result[adjacency.triangles[a] * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to ||
+                    triangle[2] == collapse.to)
+                {
+                    shared++;
+                    continue;
+                }
+
+                glm::vec3 before[3], after[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    before[k] = vertices[triangle[k]].Position;
+                    after[k] = (triangle[k] == collapse.from)? target: before[k];
+                }
+
+                glm::vec3 normalBefore = glm::cross(
+                    before[1] - before[0], before[2] - before[0]);
+                glm::vec3 normalAfter = glm::cross(
+                    after[1] - after[0], after[2] - after[0]);
+                flipped = glm::dot(normalBefore, normalAfter) <= 0.0f;
+            }
+
+            if (flipped || shared == 0)
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+            resultCost = std::max(resultCost, collapse.cost);
+            removed += shared;
+
+            // The one ring changes, so neighbors wait for the next pass.
+            for (unsigned int a = begin; a < end; a++)
+            {
+                const unsigned int* triangle = &result[adjacency.triangles[a] * 3];
+                for (int k = 0; k < 3; k++)
+                    touched[triangle[k]] = true;
+            }
+        }
+
+        if (removed == 0)
+            break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            unsigned int a = remap[result[i + 0]];
+            unsigned int b = remap[result[i + 1]];
+            unsigned int c = remap[result[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    return static_cast<float>(std::sqrt(resultCost)) / radius;
+}
+
+uint64_t MeshOptimizer::WeldVertices(
+    std::vector<unsigned int>& indices,
+    std::vector<renderer::Vertex>& vertices)
+{
+    ZoneScopedN("MeshOptimizer::WeldVertices");
+
+    std::unordered_map<unsigned int, unsigned int, VertexHash, VertexEqual>
+        unique(vertices.size(), VertexHash{&vertices}, VertexEqual{&vertices});
+
+    // remap[old] = new, compacted in place since new <= old.
+    std::vector<unsigned int> remap(vertices.size());
+    unsigned int uniqueCount = 0;
+
+    for (unsigned int v = 0; v < vertices.size(); v++)
+    {
+        auto result = unique.emplace(v, uniqueCount);
+        if (result.second)
+        {
+            remap[v] = uniqueCount;
+            uniqueCount++;
+        }
+        else
+        {
+            remap[v] = result.first->second;
+        }
+    }
+
+    // Keys reference the vertex array, so compact only after hashing.
+    unique.clear();
+    for (unsigned int v = 0; v < vertices.size(); v++)
+        vertices[remap[v]] = vertices[v];
+    vertices.resize(uniqueCount);
+
+    for (unsigned int& index: indices)
+        index = remap[index];
+
+    return uniqueCount;
+}
+
+void MeshOptimizer::OptimizeVertexCache(
+    std::vector<unsigned int>& indices,
+    uint64_t vertexCount,
+    uint32_t cacheSize)
+{
+    ZoneScopedN("MeshOptimizer::OptimizeVertexCache");
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    Adjacency adjacency(indices, vertexCount);
+
+    std::vector<unsigned int> liveTriangles(vertexCount);
+    for (uint64_t v = 0; v < vertexCount; v++)
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    uint32_t timeStamp = cacheSize + 1;
+    uint64_t cursor = 0;
+    int64_t fanning = 0;
+
+    while (fanning >= 0)
+    {
+        candidates.clear();
+
+        // Emit all remaining triangles around the fanning vertex.
+        unsigned int begin = adjacency.offsets[fanning];
+        unsigned int end = adjacency.offsets[fanning + 1];
+        for (unsigned int a = begin; a < end; a++)
+        {
+            unsigned int t = adjacency.triangles[a];
+            if (emitted[t])
+                continue;
+
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[t * 3 + k];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+
+                if (timeStamp - cacheTime[v] > cacheSize)
+                    cacheTime[v] = timeStamp++;
+            }
+            emitted[t] = true;
+        }
+
+        // Prefer the oldest candidate that stays in cache
+        // while its remaining triangles are emitted.
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (unsigned int v: candidates)
+        {
+            if (liveTriangles[v] == 0)
+                continue;
+
+            int64_t priority = 0;
+            if (timeStamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+                priority = timeStamp - cacheTime[v];
+
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+
+        if (next == -1)
+        { // Dead end: recently used vertices, then input order.
+            while (!deadEnd.empty())
+            {
+                unsigned int v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveTriangles[v] > 0)
+                {
+                    next = v;
+                    break;
+                }
+            }
+
+            while (next == -1 && cursor < vertexCount)
+            {
+                if (liveTriangles[cursor] > 0)
+                    next = cursor;
+                cursor++;
+            }
+        }
+
+        fanning = next;
+    }
+
+    indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(
+    std::vector<unsigned int>& indices,
+    const std::vector<renderer::Vertex>& vertices,
+    float threshold,
+    uint32_t cacheSize)
+{
+    ZoneScopedN("MeshOptimizer::OptimizeOverdraw");
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // A cluster starts where all three vertices miss the cache,
+    // which is where Tipsify left a fan or hit a dead end.
+    std::vector<size_t> clusterStart;
+    {
+        std::vector<uint32_t> cacheTime(vertices.size(), 0);
+        uint32_t timeStamp = cacheSize + 1;
+
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            int misses = 0;
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[t * 3 + k];
+                if (timeStamp - cacheTime[v] > cacheSize)
+                {
+                    cacheTime[v] = timeStamp++;
+                    misses++;
+                }
+            }
+
+            if (t == 0 || misses == 3)
+                clusterStart.push_back(t);
+        }
+    }
+    clusterStart.push_back(triangleCount);
+
+    size_t clusterCount = clusterStart.size() - 1;
+    if (clusterCount < 2)
+        return;
+
+    glm::vec3 meshCenter{0.0f};
+    for (const renderer::Vertex& vertex: vertices)
+        meshCenter += vertex.Position;
+    meshCenter /= static_cast<float>(vertices.size());
+
+    // Clusters facing away from the mesh center are likely to occlude
+    // the rest of the mesh, so they are drawn first.
+    std::vector<float> sortKey(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        glm::vec3 centroid{0.0f};
+        glm::vec3 normal{0.0f};
+        float area = 0.0f;
+
+        for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++)
+        {
+            const glm::vec3& p0 = vertices[indices[t * 3 + 0]].Position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float triangleArea = glm::length(n);
+
+            centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+            normal += n;
+            area += triangleArea;
+        }
+
+        float normalLength = glm::length(normal);
+        if (area == 0.0f || normalLength == 0.0f)
+        {
+            sortKey[c] = 0.0f;
+            continue;
+        }
+
+        centroid /= area;
+        normal /= normalLength;
+        sortKey[c] = glm::dot(centroid - meshCenter, normal);
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(),
+        [&sortKey](size_t a, size_t b) {return sortKey[a] > sortKey[b];});
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (size_t c: order)
+    {
+        output.insert(output.end(),
+            indices.begin() + clusterStart[c] * 3,
+            indices.begin() + clusterStart[c + 1] * 3);
+    }
+
+    CacheStats before = AnalyzeVertexCache(indices, vertices.size(), cacheSize);
+    CacheStats after = AnalyzeVertexCache(output, vertices.size(), cacheSize);
+    if (after.acmr <= before.acmr * threshold)
+        indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(
+    std::vector<unsigned int>& indices,
+    std::vector<renderer::Vertex>& vertices)
+{
+    ZoneScopedN("MeshOptimizer::OptimizeVertexFetch");
+
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    std::vector<renderer::Vertex> output;
+    output.reserve(vertices.size());
+
+    for (unsigned int& index: indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = static_cast<unsigned int>(output.size());
+            output.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(output);
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(
+    const std::vector<unsigned int>& indices,
+    uint64_t vertexCount,
+    uint32_t cacheSize)
+{
+    CacheStats stats{0.0f, 0.0f};
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return stats;
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t timeStamp = cacheSize + 1;
+    uint64_t misses = 0;
+    uint64_t referencedCount = 0;
+
+    for (unsigned int index: indices)
+    {
+        if (timeStamp - cacheTime[index] > cacheSize)
+        {
+            cacheTime[index] = timeStamp++;
+            misses++;
+        }
+
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            referencedCount++;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / triangleCount;
+    stats.atvr = static_cast<float>(misses) / referencedCount;
+    return stats;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "mesh.h"
+
+#define MESH_OPTIMIZER_CACHE_SIZE       16
+#define MESH_OPTIMIZER_OVERDRAW_LIMIT   1.05f
+#define MESH_OPTIMIZER_LOD_REDUCTION    0.5f  // Target triangle ratio per level
+#define MESH_OPTIMIZER_LOD_MIN_GAIN     0.8f  // Drop levels above this ratio
+#define MESH_OPTIMIZER_LOD_MAX_ERROR    0.25f // Relative to the bounding radius
+
+/**
+ * @brief Import time mesh optimizations.
+ * All passes work on an indexed triangle list in place.
+ * Except for LOD generation, they keep the rendered result identical.
+ */
+struct MeshOptimizer
+{
+    struct CacheStats
+    {
+        float acmr; // Average cache miss ratio, transformed vertices per triangle
+        float atvr; // Average transform to vertex ratio, 1.0 is optimal
+    };
+
+    /**
+     * @brief Run all passes in order: weld, LOD generation,
+     * vertex cache and overdraw per level, then vertex fetch.
+     * ACMR/ATVR of the full resolution level before and after
+     * are written into the import log.
+     *
+     * On return indices holds all levels back to back as described by lods.
+     */
+    static void Optimize(
+        const std::string& name,
+        std::vector<unsigned int>& indices,
+        std::vector<renderer::Vertex>& vertices,
+        std::vector<renderer::MeshLod>& lods
+    );
+
+    /**
+     * @brief Append up to MESH_MAX_LOD - 1 simplified levels
+     * to the indices. Each level targets half the triangles
+     * of the previous one and reuses the existing vertices.
+     * Generation stops early when a level fails to reduce
+     * the mesh enough or exceeds MESH_OPTIMIZER_LOD_MAX_ERROR.
+     */
+    static void GenerateLods(
+        std::vector<unsigned int>& indices,
+        const std::vector<renderer::Vertex>& vertices,
+        std::vector<renderer::MeshLod>& lods
+    );
+
+    /**
+     * @brief Simplify with quadric error metrics by collapsing edges
+     * onto existing vertices. Vertices on borders and attribute seams
+     * are locked so the silhouette and texture mapping are kept.
+     *
+     * @param maxError Largest allowed error relative to the bounding radius.
+     * @return Error of the result relative to the bounding radius.
+     */
+    static float Simplify(
+        const std::vector<unsigned int>& indices,
+        const std::vector<renderer::Vertex>& vertices,
+        size_t targetIndexCount,
+        float maxError,
+        std::vector<unsigned int>& result
+    );
+
+    /**
+     * @brief Merge bitwise identical vertices.
+     * @return Number of vertices after welding.
+     */
+    static uint64_t WeldVertices(
+        std::vector<unsigned int>& indices,
+        std::vector<renderer::Vertex>& vertices
+    );
+
+    /**
+     * @brief Reorder triangles for post-transform vertex cache
+     * efficiency with Tipsify (Sander, Nehab and Barczak 2007).
+     */
+    static void OptimizeVertexCache(
+        std::vector<unsigned int>& indices,
+        uint64_t vertexCount,
+        uint32_t cacheSize = MESH_OPTIMIZER_CACHE_SIZE
+    );
+
+    /**
+     * @brief Sort triangle clusters produced by OptimizeVertexCache
+     * so that outward facing clusters are drawn first.
+     * The new order is dropped if ACMR grows by more than the threshold.
+     */
+    static void OptimizeOverdraw(
+        std::vector<unsigned int>& indices,
+        const std::vector<renderer::Vertex>& vertices,
+        float threshold = MESH_OPTIMIZER_OVERDRAW_LIMIT,
+        uint32_t cacheSize = MESH_OPTIMIZER_CACHE_SIZE
+    );
+
+    /**
+     * @brief Reorder vertices in the order they are first referenced.
+     * Unreferenced vertices are removed.
+     */
+    static void OptimizeVertexFetch(
+        std::vector<unsigned int>& indices,
+        std::vector<renderer::Vertex>& vertices
+    );
+
+    /**
+     * @brief Simulate a FIFO post-transform cache.
+     */
+    static CacheStats AnalyzeVertexCache(
+        const std::vector<unsigned int>& indices,
+        uint64_t vertexCount,
+        uint32_t cacheSize = MESH_OPTIMIZER_CACHE_SIZE
+    );
+};
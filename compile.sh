@@ -1,7 +1,23 @@
 
 cd /Users/zekailin00/Git/Vulkan-Renderer/resources/vulkan_shaders/Phong
 glslc shader.frag -o frag.spv
+glslc -DMULTIVIEW shader.frag -o multiview_frag.spv
+glslc depth.frag -o depth_frag.spv
 glslc shader.vert -o vert.spv
+glslc compact.vert -o compact_vert.spv
+glslc multiview.vert -o multiview_vert.spv
+glslc compact_multiview.vert -o compact_multiview_vert.spv
+glslc -DGPU_DRIVEN shader.frag -o gpu_frag.spv
+glslc -DGPU_DRIVEN -DMULTIVIEW shader.frag -o gpu_multiview_frag.spv
+glslc -DGPU_DRIVEN shader.vert -o gpu_vert.spv
+glslc -DGPU_DRIVEN compact.vert -o gpu_compact_vert.spv
+glslc -DGPU_DRIVEN multiview.vert -o gpu_multiview_vert.spv
+glslc -DGPU_DRIVEN compact_multiview.vert -o gpu_compact_multiview_vert.spv
+
+cd /Users/zekailin00/Git/Vulkan-Renderer/resources/vulkan_shaders/culling
+glslc cull.comp -o cull_comp.spv
+glslc depth_pyramid.comp -o depth_pyramid_comp.spv
+glslc -DMSAA depth_pyramid.comp -o depth_pyramid_msaa_comp.spv
 
 cd /Users/zekailin00/Git/Vulkan-Renderer/resources/vulkan_shaders/transfer
 glslc shader.frag -o frag.spv
@@ -10,6 +26,7 @@ glslc shader.vert -o vert.spv
 cd /Users/zekailin00/Git/Vulkan-Renderer/resources/vulkan_shaders/skybox
 glslc shader.frag -o frag.spv
 glslc shader.vert -o vert.spv
+glslc multiview.vert -o multiview_vert.spv
 
 cd /Users/zekailin00/Git/Vulkan-Renderer/resources/vulkan_shaders/wire
 glslc shader.frag -o frag.spv
@@ -19,6 +36,13 @@ cd /Users/zekailin00/Git/Vulkan-Renderer/resources/vulkan_shaders/imgui
 glslc shader.frag -o frag.spv
 glslc shader.vert -o vert.spv
 
+cd /Users/zekailin00/Git/Vulkan-Renderer/resources/vulkan_shaders/line
+glslc shader.frag -o frag.spv
+glslc shader.vert -o vert.spv
+glslc multiview.vert -o multiview_vert.spv
+glslc shape.vert -o shape_vert.spv
+glslc -DMULTIVIEW shape.vert -o shape_multiview_vert.spv
+
 
 cd /Users/zekailin00/Git/Vulkan-Renderer
 rm -rf build
\ No newline at end of file
@@ -3,6 +3,29 @@
 #include <string>
 #include <map>
 
+// Import meshes with CompactVertex and 16-bit indices when "true".
+#define CONFIG_COMPACT_VERTEX   "compactVertex"
+// Render both VR eyes in one pass with VK_KHR_multiview unless "false".
+#define CONFIG_VR_MULTIVIEW     "vrMultiview"
+// Samples per pixel of camera render targets: "1", "2", "4" or "8", 4 by default.
+#define CONFIG_MSAA_SAMPLES     "msaaSamples"
+// Size of the VR eye buffers relative to the size recommended by the headset.
+#define CONFIG_VR_RESOLUTION_SCALE      "vrResolutionScale"
+// Scale the VR eye buffers with GPU frame time unless "false".
+#define CONFIG_VR_DYNAMIC_RESOLUTION    "vrDynamicResolution"
+// Locate the VR eyes again right before command recording unless "false".
+#define CONFIG_VR_LATE_LATCH            "vrLateLatch"
+// Cull and draw opaque meshes on the GPU with indirect draws when "true".
+#define CONFIG_GPU_CULLING              "gpuCulling"
+// Run the last physics step of a frame while the frame renders unless "false".
+#define CONFIG_PHYSICS_ASYNC            "physicsAsync"
+// Job system workers shared by the PhysX scenes, all of them by default.
+#define CONFIG_PHYSICS_WORKERS          "physicsWorkers"
+// Fixed physics steps per second, 60 by default.
+#define CONFIG_PHYSICS_STEP_RATE        "physicsStepRate"
+// Physics steps run per frame at most, later steps are dropped and the scene slows down.
+#define CONFIG_PHYSICS_MAX_SUBSTEPS     "physicsMaxSubsteps"
+
 
 class Configuration
 {
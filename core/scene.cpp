@@ -41,6 +41,8 @@ Scene* Scene::LoadFromFile(
     Scene* scene = Scene::NewScene(sceneName, manager);
     ASSERT(json[JSON_TYPE] == (int)JsonType::Scene);
     scene->state = state;
+    if (json["settings"].isObject())
+        scene->settings = json["settings"];
     scene->rootEntity->Deserialize(json["rootEntity"]);
 
     return scene;
@@ -50,6 +52,7 @@ bool Scene::SaveToFile(std::string path)
 {
     Json::Value json;
     json[JSON_TYPE] = (int)JsonType::Scene;
+    json["settings"] = settings;
     rootEntity->Serialize(json["rootEntity"]);
 
     std::ofstream jsonOut;
@@ -100,6 +103,14 @@ void Scene::RemoveEntity(Entity* entity)
 
 Scene::~Scene()
 {
+    // Actors cannot be released while a step is running.
+    if (contexts[SceneContext::Type::PhysicsCtx])
+    {
+        std::dynamic_pointer_cast<ScenePhysicsContext>(
+            contexts[SceneContext::Type::PhysicsCtx])
+            ->FetchResults();
+    }
+
     std::list<Entity*> childrenCopy = rootEntity->children;
     for (Entity* e: childrenCopy)
         DeferredRemoveEntity(e);
@@ -118,8 +129,23 @@ Entity* Scene::GetRootEntity()
 
 void Scene::Update(Timestep ts)
 {
+    // The step started at the end of the last update ran while it rendered.
+    if (contexts[SceneContext::Type::PhysicsCtx])
+    {
+        std::dynamic_pointer_cast<ScenePhysicsContext>(
+            contexts[SceneContext::Type::PhysicsCtx])
+            ->FetchResults();
+    }
+
     ProcessDeferredActions();
 
+    if (contexts[SceneContext::Type::PhysicsCtx])
+    {
+        std::dynamic_pointer_cast<ScenePhysicsContext>(
+            contexts[SceneContext::Type::PhysicsCtx])
+            ->SyncTransforms();
+    }
+
     if (contexts[SceneContext::Type::RendererCtx])
     {
         std::dynamic_pointer_cast<SceneRendererContext>(
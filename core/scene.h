@@ -5,6 +5,8 @@
 #include "entity.h"
 #include "core_asset_manager.h"
 
+#include <json/json.h>
+
 #include <string>
 #include <list>
 #include <memory>
@@ -46,6 +48,13 @@ public:
 
     const std::string& GetSceneName() {return sceneName;}
     ICoreAssetManager* GetAssetManager() {return assetManager;}
+
+    /**
+     * @brief Settings of a subsystem saved with the scene, null if never set.
+     * Loaded before the entities, so contexts created while
+     * they are deserialized can read them.
+     */
+    Json::Value& GetSettings(const std::string& subsystem) {return settings[subsystem];}
     State GetState() {return state;}
 
     Entity* NewEntity();
@@ -79,6 +88,7 @@ private:
     unsigned int entityCounter = 0;
     ICoreAssetManager* assetManager = nullptr;
     std::shared_ptr<SceneContext> contexts[SceneContext::Type::CtxSize] = {};
+    Json::Value settings{Json::objectValue};
 
     std::list<Entity::DeferredAction> deferredActions;
 };
\ No newline at end of file
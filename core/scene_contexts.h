@@ -65,5 +65,9 @@ public:
 
 public:
     virtual int Simulate(Timestep ts) = 0;
+    // Wait for the step left running by the last Simulate, if any.
+    virtual void FetchResults() = 0;
+    // Write the poses of the bodies that moved in the last steps to their entities.
+    virtual void SyncTransforms() = 0;
     virtual void UpdatePhysicsTransform(Entity* e) = 0;
 };
\ No newline at end of file
@@ -319,17 +319,37 @@ void EntityProperties::ShowLightComponent()
             dynamic_cast<renderer::LightComponent*>(
                 selectedEntity->GetComponent(Component::Type::Light));
         
+        renderer::LightProperties& prop = component->properties;
+
         ImGui::SeparatorText("Type");
         {
-            ImGui::Text("Directional Light");
+            // Same order as renderer::LightType
+            const char* types[] = {"Spot Light", "Directional Light", "Point Light"};
+            int type = static_cast<int>(prop.type);
+            if (ImGui::Combo("Type##1", &type, types, IM_ARRAYSIZE(types)))
+                prop.type = static_cast<renderer::LightType>(type);
         }
         ImGui::SeparatorText("Color");
         {
-            float* color = &component->properties.color[0];
+            float* color = &prop.color[0];
             ImGui::ColorEdit3("Color##1", color,
             ImGuiColorEditFlags_HDR | ImGuiColorEditFlags_DisplayRGB |
             ImGuiColorEditFlags_Float | ImGuiColorEditFlags_InputRGB);
         }
+        if (prop.type != renderer::DIRECTIONAL_LIGHT)
+        {
+            ImGui::SeparatorText("Range");
+            ImGui::DragFloat("Range (meter)", &prop.range,
+                0.1f, 0.1f, 1000.0f, "%.1f", ImGuiSliderFlags_AlwaysClamp);
+        }
+        if (prop.type == renderer::SPOT_LIGHT)
+        {
+            ImGui::SeparatorText("Cone");
+            ImGui::DragFloat("Inner Angle (radian)", &prop.innerConeAngle,
+                0.005f, 0.0f, prop.outerConeAngle, "%.3f", ImGuiSliderFlags_AlwaysClamp);
+            ImGui::DragFloat("Outer Angle (radian)", &prop.outerConeAngle,
+                0.005f, prop.innerConeAngle, 1.57f, "%.3f", ImGuiSliderFlags_AlwaysClamp);
+        }
 
         ImGui::Separator();
     }
@@ -387,6 +407,17 @@ void EntityProperties::ShowCameraComponent()
                 prop.Extent.x / (float)prop.Extent.y, fovy, zNear, zFar);
         }
 
+        ImGui::SeparatorText("Rendering");
+        {
+            bool depthPrepass = prop.DepthPrepass;
+            ImGui::Checkbox("Depth Pre-pass", &depthPrepass);
+            component->camera->SetDepthPrepass(depthPrepass);
+
+            const glm::vec3& passTimes = component->camera->GetPassTimes();
+            ImGui::Text("GPU time (ms): pre-pass %.3f, opaque %.3f, transparent %.3f",
+                passTimes.x, passTimes.y, passTimes.z);
+        }
+
         if (ImGui::TreeNode("Rebuild Camera"))
         {
             ImGui::SeparatorText("Camera Properties");
@@ -943,6 +974,24 @@ void EntityProperties::ShowDynamicBodyComponent()
                     }
                 }
                     break;
+
+                case physics::GeometryType::eTRIANGLEMESH:
+                case physics::GeometryType::eCONVEXMESH:
+                {
+                    std::string treeName = std::to_string(i) + ". Mesh Shape";
+                    if(ImGui::TreeNodeEx(treeName.c_str(), treeFlags))
+                    {
+                        ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * WIDTH);
+
+                        ImGui::Text("Mesh: %s", shapeList[i]->GetMeshPath().c_str());
+
+                        DrawPhysicsShapeCommon(rigidbody, shapeList[i]);
+
+                        ImGui::PopItemWidth();
+                        ImGui::TreePop();
+                    }
+                }
+                    break;
                 
                 default:
                     break;
@@ -969,7 +1018,23 @@ void EntityProperties::ShowDynamicBodyComponent()
                     {
                         rigidbody->AttachShape(s.second);
                     }
-                }     
+                }
+
+                if (!availableMeshCached)
+                {
+                    assetManager->GetAvailableMeshes(availableMeshes);
+                    availableMeshCached = true;
+                }
+
+                if (ImGui::BeginMenu("Mesh"))
+                {
+                    for (const char* meshPath: availableMeshes)
+                    {
+                        if (ImGui::Selectable(meshPath))
+                            rigidbody->AttachMeshShape(assetManager, meshPath);
+                    }
+                    ImGui::EndMenu();
+                }
                 ImGui::EndPopup();
             }
 
@@ -1109,6 +1174,24 @@ void EntityProperties::ShowStaticBodyComponent()
                     }
                 }
                     break;
+
+                case physics::GeometryType::eTRIANGLEMESH:
+                case physics::GeometryType::eCONVEXMESH:
+                {
+                    std::string treeName = std::to_string(i) + ". Mesh Shape";
+                    if(ImGui::TreeNodeEx(treeName.c_str(), treeFlags))
+                    {
+                        ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * WIDTH);
+
+                        ImGui::Text("Mesh: %s", shapeList[i]->GetMeshPath().c_str());
+
+                        DrawPhysicsShapeCommon(rigidbody, shapeList[i]);
+
+                        ImGui::PopItemWidth();
+                        ImGui::TreePop();
+                    }
+                }
+                    break;
                 
                 default:
                     break;
@@ -1135,7 +1218,23 @@ void EntityProperties::ShowStaticBodyComponent()
                     {
                         rigidbody->AttachShape(s.second);
                     }
-                }     
+                }
+
+                if (!availableMeshCached)
+                {
+                    assetManager->GetAvailableMeshes(availableMeshes);
+                    availableMeshCached = true;
+                }
+
+                if (ImGui::BeginMenu("Mesh"))
+                {
+                    for (const char* meshPath: availableMeshes)
+                    {
+                        if (ImGui::Selectable(meshPath))
+                            rigidbody->AttachMeshShape(assetManager, meshPath);
+                    }
+                    ImGui::EndMenu();
+                }
                 ImGui::EndPopup();
             }
 
@@ -1344,6 +1443,12 @@ void DrawPhysicsShapeCommon(
         shape->SetTrigger(isTrigger);
     }
 
+    bool contactEvents = shape->GetContactEvents();
+    if (ImGui::Checkbox("Contact Events", &contactEvents))
+    {
+        shape->SetContactEvents(contactEvents);
+    }
+
     ImGui::SameLine(ImGui::GetContentRegionAvail().x-30);
     if (ImGui::SmallButton("Remove"))
     {
@@ -196,6 +196,13 @@ void MaterialEditor::ShowAlbedoSection(
     }
     if (hasTexture) ImGui::EndDisabled();
 
+    ImGui::Text("Opacity:");
+    {
+        float opacity = properties->opacity;
+        ImGui::SliderFloat("Opacity", &opacity, 0.0f, 1.0f, "%.2f");
+        selectedMat->SetOpacity(opacity);
+    }
+
 }
 
 void MaterialEditor::ShowMetallicSection(
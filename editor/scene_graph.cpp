@@ -1,6 +1,7 @@
 #include "scene_graph.h"
 
 #include "events.h"
+#include "physics_scene_settings.h"
 
 SceneGraph::SceneGraph()
 {
@@ -76,6 +77,9 @@ void SceneGraph::Draw()
         }
 
         ShowEntityChildren(scene->GetRootEntity()->GetChildren());
+
+        ImGui::Separator();
+        ShowPhysicsSettings();
     }
     else
     {
@@ -85,6 +89,85 @@ void SceneGraph::Draw()
     ImGui::End();
 }
 
+void SceneGraph::ShowPhysicsSettings()
+{
+    if (!ImGui::CollapsingHeader("Physics Settings"))
+        return;
+
+    ImGui::TextWrapped("Applied when the scene starts.");
+
+    physics::PhysicsSceneSettings settings;
+    Json::Value& json = scene->GetSettings(PHYSICS_SCENE_SETTINGS);
+    settings.Deserialize(json);
+    bool changed = false;
+
+    changed |= ImGui::DragFloat3("Gravity", &settings.gravity[0], 0.01f);
+
+    const char* broadphaseTypes[] = {"SAP", "MBP", "ABP"};
+    int broadphase = (int)settings.broadphase;
+    if (ImGui::Combo("Broadphase", &broadphase,
+        broadphaseTypes, IM_ARRAYSIZE(broadphaseTypes)))
+    {
+        settings.broadphase =
+            (physics::PhysicsSceneSettings::BroadphaseType)broadphase;
+        changed = true;
+    }
+
+    if (settings.broadphase == physics::PhysicsSceneSettings::BroadphaseType::MBP)
+    {
+        changed |= ImGui::DragFloat3("World Min", &settings.worldMin[0], 1.0f);
+        changed |= ImGui::DragFloat3("World Max", &settings.worldMax[0], 1.0f);
+
+        int subdivisions = settings.regionSubdivisions;
+        if (ImGui::DragInt("Region Subdivisions", &subdivisions, 1.0f, 1, 16,
+            "%d", ImGuiSliderFlags_AlwaysClamp))
+        {
+            settings.regionSubdivisions = subdivisions;
+            changed = true;
+        }
+    }
+
+    const char* solverTypes[] = {"PGS", "TGS"};
+    int solver = (int)settings.solver;
+    if (ImGui::Combo("Solver", &solver, solverTypes, IM_ARRAYSIZE(solverTypes)))
+    {
+        settings.solver = (physics::PhysicsSceneSettings::SolverType)solver;
+        changed = true;
+    }
+
+    const char* frictionTypes[] = {"Patch", "One Directional", "Two Directional"};
+    int friction = (int)settings.friction;
+    if (ImGui::Combo("Friction", &friction,
+        frictionTypes, IM_ARRAYSIZE(frictionTypes)))
+    {
+        settings.friction = (physics::PhysicsSceneSettings::FrictionType)friction;
+        changed = true;
+    }
+
+    int positionIterations = settings.positionIterations;
+    if (ImGui::DragInt("Position Iterations", &positionIterations, 1.0f, 1, 255,
+        "%d", ImGuiSliderFlags_AlwaysClamp))
+    {
+        settings.positionIterations = positionIterations;
+        changed = true;
+    }
+
+    int velocityIterations = settings.velocityIterations;
+    if (ImGui::DragInt("Velocity Iterations", &velocityIterations, 1.0f, 1, 255,
+        "%d", ImGuiSliderFlags_AlwaysClamp))
+    {
+        settings.velocityIterations = velocityIterations;
+        changed = true;
+    }
+
+    changed |= ImGui::Checkbox("CCD", &settings.enableCCD);
+    changed |= ImGui::Checkbox("PCM", &settings.enablePCM);
+    changed |= ImGui::Checkbox("Stabilization", &settings.enableStabilization);
+
+    if (changed)
+        settings.Serialize(json);
+}
+
 void SceneGraph::ShowEntityChildren(const std::list<Entity*>& children)
 {
     const static ImGuiTreeNodeFlags treeFlags =
@@ -18,6 +18,7 @@ private:
 
     void ShowEntityChildren(const std::list<Entity*>& children);
     void ShowEntityPopupContext(Entity* entity);
+    void ShowPhysicsSettings();
 
     void PublishEntitySelectedEvent(Entity* entity);
     void PublishNewEntityEvent(Entity* parent);
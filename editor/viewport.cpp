@@ -137,12 +137,12 @@ void Viewport::Draw(ImGuiID dockID)
             if (e->HasComponent(Component::Type::VrDisplay))
             {
                 // If entity has a VR display component,
-                // only show th left camera.
+                // only show its preview camera.
                 entityList.push_back({
                     e->GetName() + " (VR)",
                     ((renderer::VrDisplayComponent*)
                     e->GetComponent(Component::Type::VrDisplay))
-                        ->vrDisplay->GetLeftCamera()
+                        ->vrDisplay->GetPreviewCamera()
                 });
             }
         }
@@ -0,0 +1,115 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "physics_system.h"
+#include "physics_context.h"
+#include "physics_scene_settings.h"
+#include "dynamic_rigidbody.h"
+#include "static_rigidbody.h"
+#include "configuration.h"
+
+/**
+ * Steps an open world of 10000 bodies spread over 2 km x 2 km
+ * of ground tiles, sliding in random directions so that the broadphase
+ * keeps updating, with the SAP, MBP and ABP broadphases.
+ */
+
+#define WORLD_HALF_SIZE 1000.0f
+#define TILE_COUNT      20      // Ground tiles per side
+#define BODY_COUNT      10000
+#define WARMUP_STEPS    30
+#define TIMED_STEPS     240
+
+using Settings = physics::PhysicsSceneSettings;
+
+static double RunWorld(Settings::BroadphaseType broadphase)
+{
+    Configuration::Set(CONFIG_PHYSICS_ASYNC, "false");
+
+    Settings settings;
+    settings.broadphase = broadphase;
+    settings.worldMin = glm::vec3(-WORLD_HALF_SIZE, -50.0f, -WORLD_HALF_SIZE);
+    settings.worldMax = glm::vec3( WORLD_HALF_SIZE, 200.0f,  WORLD_HALF_SIZE);
+    settings.regionSubdivisions = 8;
+
+    physics::PhysicsSystem* system = new physics::PhysicsSystem();
+    physics::PhysicsContext* context = system->NewContext(settings);
+
+    const float tileHalfSize = WORLD_HALF_SIZE / TILE_COUNT;
+    std::vector<physics::StaticRigidbody*> tiles;
+    for (uint32_t x = 0; x < TILE_COUNT; x++)
+    {
+        for (uint32_t z = 0; z < TILE_COUNT; z++)
+        {
+            physics::StaticRigidbody* tile = context->NewStaticRigidbody(nullptr);
+            physics::CollisionShape* shape = tile->AttachShape(physx::PxGeometryType::eBOX);
+            shape->SetGeometry(physics::BoxGeometry(tileHalfSize, 0.5f, tileHalfSize));
+            tile->SetGlobalTransform(glm::translate(glm::mat4(1.0f), glm::vec3(
+                (2 * x + 1) * tileHalfSize - WORLD_HALF_SIZE, -0.5f,
+                (2 * z + 1) * tileHalfSize - WORLD_HALF_SIZE)));
+            tiles.push_back(tile);
+        }
+    }
+
+    // Same bodies for every broadphase.
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(
+        -WORLD_HALF_SIZE * 0.9f, WORLD_HALF_SIZE * 0.9f);
+    std::uniform_real_distribution<float> height(0.5f, 20.0f);
+    std::uniform_real_distribution<float> speed(-5.0f, 5.0f);
+
+    std::vector<physics::DynamicRigidbody*> bodies;
+    for (uint32_t i = 0; i < BODY_COUNT; i++)
+    {
+        physics::DynamicRigidbody* body = context->NewDynamicRigidbody(nullptr);
+        body->AttachShape(i % 2? physx::PxGeometryType::eBOX: physx::PxGeometryType::eSPHERE);
+        body->SetGlobalTransform(glm::translate(glm::mat4(1.0f), glm::vec3(
+            position(random), height(random), position(random))));
+        body->SetLinearVelocity(glm::vec3(speed(random), 0.0f, speed(random)));
+        bodies.push_back(body);
+    }
+
+    const float step = 1.0f / 60.0f;
+    for (uint32_t i = 0; i < WARMUP_STEPS; i++)
+        context->Simulate(step);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < TIMED_STEPS; i++)
+        context->Simulate(step);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    for (physics::DynamicRigidbody* body: bodies)
+        delete body;
+    for (physics::StaticRigidbody* tile: tiles)
+        delete tile;
+    delete context;
+    delete system;
+
+    return std::chrono::duration<double, std::milli>(end - start).count() / TIMED_STEPS;
+}
+
+int main(int, char**)
+{
+    std::cout << BODY_COUNT << " dynamic bodies on "
+        << TILE_COUNT * TILE_COUNT << " ground tiles" << std::endl;
+
+    const std::pair<const char*, Settings::BroadphaseType> broadphases[] = {
+        {"SAP", Settings::BroadphaseType::SAP},
+        {"MBP", Settings::BroadphaseType::MBP},
+        {"ABP", Settings::BroadphaseType::ABP}
+    };
+
+    for (auto& broadphase: broadphases)
+    {
+        double milliseconds = RunWorld(broadphase.second);
+        std::cout << broadphase.first << ": " << milliseconds << " ms per step" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "physics_system.h"
+#include "physics_context.h"
+#include "dynamic_rigidbody.h"
+#include "static_rigidbody.h"
+#include "configuration.h"
+
+/**
+ * Steps 5000 boxes stacked in a 25 x 25 grid of 8 high columns
+ * with 1, 2, 4 and 8 PhysX workers taken from the job system.
+ * Counts above the job system workers are capped, those rows are skipped.
+ */
+
+#define GRID_SIZE       25
+#define STACK_HEIGHT    8
+#define WARMUP_STEPS    30
+#define TIMED_STEPS     240
+
+static void RunStack(uint32_t workers)
+{
+    Configuration::Set(CONFIG_PHYSICS_WORKERS, std::to_string(workers));
+    Configuration::Set(CONFIG_PHYSICS_ASYNC, "false");
+
+    physics::PhysicsSystem* system = new physics::PhysicsSystem();
+    uint32_t actualWorkers = system->GetWorkerCount();
+    if (actualWorkers != workers)
+    {
+        std::cout << workers << " workers: skipped, capped to "
+            << actualWorkers << " by the job system" << std::endl;
+        delete system;
+        return;
+    }
+
+    physics::PhysicsContext* context = system->NewContext();
+
+    physics::StaticRigidbody* ground = context->NewStaticRigidbody(nullptr);
+    physics::CollisionShape* groundShape = ground->AttachShape(physx::PxGeometryType::eBOX);
+    groundShape->SetGeometry(physics::BoxGeometry(100.0f, 0.5f, 100.0f));
+    ground->SetGlobalTransform(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.5f, 0.0f)));
+
+    // Unit boxes with a small gap so that the columns settle.
+    std::vector<physics::DynamicRigidbody*> bodies;
+    for (uint32_t x = 0; x < GRID_SIZE; x++)
+    {
+        for (uint32_t z = 0; z < GRID_SIZE; z++)
+        {
+            for (uint32_t y = 0; y < STACK_HEIGHT; y++)
+            {
+                physics::DynamicRigidbody* body = context->NewDynamicRigidbody(nullptr);
+                body->AttachShape(physx::PxGeometryType::eBOX);
+                body->SetGlobalTransform(glm::translate(glm::mat4(1.0f), glm::vec3(
+                    x * 1.5f - GRID_SIZE * 0.75f, y * 1.01f + 0.5f, z * 1.5f - GRID_SIZE * 0.75f)));
+                bodies.push_back(body);
+            }
+        }
+    }
+
+    const float step = 1.0f / 60.0f;
+    for (uint32_t i = 0; i < WARMUP_STEPS; i++)
+        context->Simulate(step);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < TIMED_STEPS; i++)
+        context->Simulate(step);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    for (physics::DynamicRigidbody* body: bodies)
+        delete body;
+    delete ground;
+    delete context;
+    delete system;
+
+    double milliseconds =
+        std::chrono::duration<double, std::milli>(end - start).count() / TIMED_STEPS;
+    std::cout << actualWorkers << " workers: " << milliseconds << " ms per step" << std::endl;
+}
+
+int main(int, char**)
+{
+    std::cout << GRID_SIZE * GRID_SIZE * STACK_HEIGHT << " stacked dynamic bodies" << std::endl;
+
+    for (uint32_t workers: {1u, 2u, 4u, 8u})
+        RunStack(workers);
+}
@@ -20,7 +20,7 @@ CollisionShape::~CollisionShape()
 {
     physx::PxMaterial* gMaterial;
 
-    rigidbody->GetContext()->RemoveTrigger(this);
+    rigidbody->GetContext()->RemoveShapeEvents(this);
     gShape->getMaterials(&gMaterial, 1);
     gMaterial->release();
     gShape->release();
@@ -84,7 +84,7 @@ void CollisionShape::SetTrigger(bool isTrigger)
         gShape->setFlag(physx::PxShapeFlag::eTRIGGER_SHAPE, false);
         gShape->setFlag(physx::PxShapeFlag::eSCENE_QUERY_SHAPE, true);
         gShape->setFlag(physx::PxShapeFlag::eSIMULATION_SHAPE, true);
-        // rigidbody->GetContext()->RemoveTrigger(this);
+        // rigidbody->GetContext()->RemoveShapeEvents(this);
         // Notes: When shape is not removed and trigger is disabled
         // eNOTIFY_TOUCH_LOST is received, but not eREMOVED_SHAPE_OTHER
         // so trigger does NOT need to be removed here.
@@ -97,6 +97,26 @@ bool CollisionShape::GetTrigger() const
     return (gShape->getFlags() & physx::PxShapeFlag::eTRIGGER_SHAPE);
 }
 
+void CollisionShape::SetContactEvents(bool isEnabled)
+{
+    physx::PxFilterData filterData = gShape->getSimulationFilterData();
+    if (isEnabled)
+        filterData.word3 |= SHAPE_FILTER_CONTACT_EVENTS;
+    else
+        filterData.word3 &= ~SHAPE_FILTER_CONTACT_EVENTS;
+    gShape->setSimulationFilterData(filterData);
+
+    // Pairs already found keep their flags until they are filtered again.
+    physx::PxRigidActor* actor = gShape->getActor();
+    if (actor && actor->getScene())
+        actor->getScene()->resetFiltering(*actor);
+}
+
+bool CollisionShape::GetContactEvents() const
+{
+    return gShape->getSimulationFilterData().word3 & SHAPE_FILTER_CONTACT_EVENTS;
+}
+
 GeometryType CollisionShape::GetGeometryType() const
 {
     return gShape->getGeometryType();
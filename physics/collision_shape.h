@@ -3,7 +3,10 @@
 #include <PxPhysicsAPI.h>
 #include <glm/mat4x4.hpp>
 #include <functional>
+#include <string>
 
+// Bit of word 3 of the simulation filter data, set on shapes reporting contacts.
+#define SHAPE_FILTER_CONTACT_EVENTS 0x1
 
 class Entity;
 
@@ -40,6 +43,18 @@ struct TriggerEvent
     }
 };
 
+/**
+ * @brief Contact between two simulation shapes, at least one of them
+ * reporting contacts. From the side of collisionShape.
+ */
+struct ContactEvent
+{
+    Entity* entity;
+    CollisionShape* collisionShape;
+    Entity* otherEntity;
+    CollisionShape* otherCollisionShape;
+};
+
 class CollisionShape
 {
 
@@ -80,10 +95,40 @@ public:
         OnTriggerLeave = nullptr;
     }
 
+    /**
+     * Contacts are only reported for shapes that enable them,
+     * their events are dispatched with the trigger events once per frame.
+     */
+    void SetContactEvents(bool isEnabled);
+    bool GetContactEvents() const;
+
+    void SetOnContactEnter(std::function<void(ContactEvent*)> callback)
+    {
+        OnContactEnter = callback;
+    }
+
+    void SetOnContactLeave(std::function<void(ContactEvent*)> callback)
+    {
+        OnContactLeave = callback;
+    }
+
+    void ClearOnContactEnter()
+    {
+        OnContactEnter = nullptr;
+    }
+
+    void ClearOnContactLeave()
+    {
+        OnContactLeave = nullptr;
+    }
+
     GeometryType GetGeometryType() const;
 
     void SetGeometry(const Geometry &geometry);
 
+    // Mesh asset the shape was cooked from, empty for primitive shapes.
+    const std::string& GetMeshPath() const {return meshPath;}
+
     template<typename T>
     bool GetGeometry(GeometryType type, T& geometry) const
     {
@@ -129,6 +174,18 @@ private:
             OnTriggerLeave(event);
     }
 
+    void ExecuteOnContactEnter(ContactEvent* event)
+    {
+        if (OnContactEnter)
+            OnContactEnter(event);
+    }
+
+    void ExecuteOnContactLeave(ContactEvent* event)
+    {
+        if (OnContactLeave)
+            OnContactLeave(event);
+    }
+
     friend PhysicsContext;
     friend Rigidbody;
 
@@ -138,8 +195,13 @@ private:
     std::function<void(TriggerEvent*)> OnTriggerEnter = nullptr;
     std::function<void(TriggerEvent*)> OnTriggerLeave = nullptr;
     std::function<void(TriggerEvent*)> OnTriggerStay = nullptr;
+    std::function<void(ContactEvent*)> OnContactEnter = nullptr;
+    std::function<void(ContactEvent*)> OnContactLeave = nullptr;
+
+    unsigned int triggerPairCount = 0; // Touching trigger pairs it is part of
 
     Rigidbody* rigidbody; // owned by component
+    std::string meshPath;
 };
 
 } // namespace physics
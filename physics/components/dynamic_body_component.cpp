@@ -5,6 +5,7 @@
 
 #include "dynamic_rigidbody.h"
 #include "components/physics_components_common.h"
+#include "physics_asset_manager.h"
 
 #include "serialization.h"
 #include "math_library.h"
@@ -110,6 +111,19 @@ Component* DynamicBodyDeserializer::operator()(Entity* entity, Json::Value& json
         }
             break;
 
+        case GeometryType::eTRIANGLEMESH:
+        case GeometryType::eCONVEXMESH:
+        {
+            IPhysicsAssetManager* assetManager = dynamic_cast<IPhysicsAssetManager*>(
+                entity->GetScene()->GetAssetManager());
+            CollisionShape* shape = component->dynamicBody->AttachMeshShape(
+                assetManager, jsonShape["mesh"].asString()
+            );
+            if (shape)
+                DeserializeShapeCommons(shape, jsonShape);
+        }
+            break;
+
         default:
             throw;
         }
@@ -120,14 +134,8 @@ Component* DynamicBodyDeserializer::operator()(Entity* entity, Json::Value& json
 
 void DynamicBodyComponent::Update(Timestep ts)
 {
-    glm::mat4 transform;
-    dynamicBody->GetGlobalTransform(transform);
-    
-    glm::mat4 parentTransform = entity->GetParent()->GetGlobalTransform();
-    glm::mat4 localTransform = glm::inverse(parentTransform) * transform;
-    glm::mat4 scaleTransform = glm::scale(glm::mat4(1.0f), entity->GetLocalScale());
-    entity->SetLocalTransform(localTransform * scaleTransform, true);
-
+    // The transform is written by PhysicsContext::SyncTransforms
+    // before the entities update, only while the body moves.
     if (entity->GetScene()->GetSceneContext(SceneContext::Type::RendererCtx))
     {
         std::shared_ptr<SceneRendererContext> renderCtx =
@@ -202,6 +210,10 @@ void DynamicBodyComponent::Update(Timestep ts)
             }
                 break;
 
+            case GeometryType::eTRIANGLEMESH:
+            case GeometryType::eCONVEXMESH:
+                break; // Drawn by the mesh of the entity
+
             default:
                 throw;
             }
@@ -276,6 +288,16 @@ void DynamicBodyComponent::Serialize(Json::Value& json)
         }
             break;
 
+        case GeometryType::eTRIANGLEMESH:
+        case GeometryType::eCONVEXMESH:
+        {
+            jsonShape["GeometryType"] = shape->GetGeometryType();
+            jsonShape["mesh"] = shape->GetMeshPath();
+
+            SerializeShapeCommons(shape, jsonShape);
+        }
+            break;
+
         default:
             throw;
         }
@@ -21,6 +21,7 @@ static void SerializeShapeCommons(CollisionShape* shape, Json::Value& jsonShape)
     jsonShape["dynamicFriction"] = shape->GetDynamicFriction();
     jsonShape["restitution"]     = shape->GetRestitution();
     jsonShape["isTrigger"]       = shape->GetTrigger();
+    jsonShape["contactEvents"]   = shape->GetContactEvents();
 }
 
 static void DeserializeShapeCommons(CollisionShape* shape, Json::Value& jsonShape)
@@ -33,6 +34,7 @@ static void DeserializeShapeCommons(CollisionShape* shape, Json::Value& jsonShap
     shape->SetDynamicFriction(jsonShape["dynamicFriction"].asFloat());
     shape->SetRestitution(jsonShape["restitution"].asFloat());
     shape->SetTrigger(jsonShape["isTrigger"].asBool());
+    shape->SetContactEvents(jsonShape["contactEvents"].asBool());
 }
 
 static std::shared_ptr<PhysicsContext> GetPhysicsContext(
@@ -42,7 +44,10 @@ static std::shared_ptr<PhysicsContext> GetPhysicsContext(
 
     if (!scene->GetSceneContext(SceneContext::Type::PhysicsCtx))
     {
-        physicsCtx = std::shared_ptr<PhysicsContext>(system->NewContext());
+        PhysicsSceneSettings settings;
+        settings.Deserialize(scene->GetSettings(PHYSICS_SCENE_SETTINGS));
+
+        physicsCtx = std::shared_ptr<PhysicsContext>(system->NewContext(settings));
 
         scene->SetSceneContext(
             SceneContext::Type::PhysicsCtx,
@@ -5,6 +5,7 @@
 
 #include "static_rigidbody.h"
 #include "components/physics_components_common.h"
+#include "physics_asset_manager.h"
 
 #include "serialization.h"
 #include "math_library.h"
@@ -107,6 +108,19 @@ Component* StaticBodyDeserializer::operator()(Entity* entity, Json::Value& json)
         }
             break;
 
+        case GeometryType::eTRIANGLEMESH:
+        case GeometryType::eCONVEXMESH:
+        {
+            IPhysicsAssetManager* assetManager = dynamic_cast<IPhysicsAssetManager*>(
+                entity->GetScene()->GetAssetManager());
+            CollisionShape* shape = component->staticBody->AttachMeshShape(
+                assetManager, jsonShape["mesh"].asString()
+            );
+            if (shape)
+                DeserializeShapeCommons(shape, jsonShape);
+        }
+            break;
+
         default:
             throw;
         }
@@ -191,6 +205,10 @@ void StaticBodyComponent::Update(Timestep ts)
             }
                 break;
 
+            case GeometryType::eTRIANGLEMESH:
+            case GeometryType::eCONVEXMESH:
+                break; // Drawn by the mesh of the entity
+
             default:
                 throw;
             }
@@ -255,6 +273,16 @@ void StaticBodyComponent::Serialize(Json::Value& json)
         }
             break;
 
+        case GeometryType::eTRIANGLEMESH:
+        case GeometryType::eCONVEXMESH:
+        {
+            jsonShape["GeometryType"] = shape->GetGeometryType();
+            jsonShape["mesh"] = shape->GetMeshPath();
+
+            SerializeShapeCommons(shape, jsonShape);
+        }
+            break;
+
         default:
             throw;
         }
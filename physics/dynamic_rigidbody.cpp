@@ -2,6 +2,7 @@
 
 #include "physics_context.h"
 
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/vec3.hpp>
@@ -20,9 +21,38 @@ DynamicRigidbody::DynamicRigidbody(
 
 DynamicRigidbody::~DynamicRigidbody()
 {
+    context->RemoveDynamicRigidbody(this);
     PX_RELEASE(gRigidDynamic);
 }
 
+void DynamicRigidbody::SetGlobalTransform(const glm::mat4& transform)
+{
+    Rigidbody::SetGlobalTransform(transform);
+
+    currentPose = gRigidDynamic->getGlobalPose();
+    previousPose = currentPose;
+}
+
+void DynamicRigidbody::GetInterpolatedTransform(glm::mat4& transform, float alpha) const
+{
+    glm::quat previousRotation(
+        previousPose.q.w, previousPose.q.x, previousPose.q.y, previousPose.q.z);
+    glm::quat currentRotation(
+        currentPose.q.w, currentPose.q.x, currentPose.q.y, currentPose.q.z);
+    glm::vec3 previousPosition(previousPose.p.x, previousPose.p.y, previousPose.p.z);
+    glm::vec3 currentPosition(currentPose.p.x, currentPose.p.y, currentPose.p.z);
+
+    transform =
+        glm::translate(glm::mat4(1.0f), glm::mix(previousPosition, currentPosition, alpha)) *
+        glm::toMat4(glm::slerp(previousRotation, currentRotation, alpha));
+}
+
+void DynamicRigidbody::SavePose()
+{
+    previousPose = currentPose;
+    currentPose = gRigidDynamic->getGlobalPose();
+}
+
 void DynamicRigidbody::SetGravity(bool isEnabled)
 {
     gRigidDynamic->setActorFlag(physx::PxActorFlag::eDISABLE_GRAVITY, !isEnabled);
@@ -202,7 +232,13 @@ void DynamicRigidbody::SetAngularVelocity(const glm::vec3& angularVelocity)
 
 void DynamicRigidbody::SetKinematic(bool isKinematic)
 {
+    // PhysX does not sweep kinematic bodies, CCD is only kept on simulated ones.
+    const bool enableCCD = !isKinematic && context->GetSettings().enableCCD;
+    if (!enableCCD)
+        gRigidDynamic->setRigidBodyFlag(physx::PxRigidBodyFlag::eENABLE_CCD, false);
     gRigidDynamic->setRigidBodyFlag(physx::PxRigidBodyFlag::eKINEMATIC, isKinematic);
+    if (enableCCD)
+        gRigidDynamic->setRigidBodyFlag(physx::PxRigidBodyFlag::eENABLE_CCD, true);
     if (!isKinematic)
     {
         // Force non-kinematic rigidbody to wake up with zero force
@@ -4,8 +4,13 @@
 
 #include <PxPhysicsAPI.h>
 #include <glm/mat4x4.hpp>
+
+#include <cstdint>
 #include <vector>
 
+// Moving index of a body the context does not sync.
+#define DYNAMIC_BODY_NOT_MOVING 0xFFFFFFFF
+
 namespace physics
 {
 
@@ -65,9 +70,34 @@ public:
     bool GetKinematic();
     void SetKinematicTarget(const glm::mat4& destination);
 
+    /**
+     * Teleport the body, it is not interpolated from its last pose.
+     */
+    void SetGlobalTransform(const glm::mat4& transform) override;
+
+    /**
+     * @brief Pose between the last two simulation steps.
+     *
+     * @param alpha 0 for the pose before the last step, 1 for the latest pose
+     */
+    void GetInterpolatedTransform(glm::mat4& transform, float alpha) const;
+
+private:
+    friend PhysicsContext;
+
+    // Called by PhysicsContext after each step that moved the body,
+    // and once more after it stopped.
+    void SavePose();
+
 private:
     physx::PxRigidDynamic* gRigidDynamic;
     RigidDynamicsProperties properties{};
+
+    physx::PxTransform previousPose{physx::PxIdentity};
+    physx::PxTransform currentPose{physx::PxIdentity};
+    unsigned int movingIndex = DYNAMIC_BODY_NOT_MOVING; // In the moving bodies of the context
+    bool active = false; // Moved by the last step
+    uint32_t bodyId = 0; // Unique in the context, see BodySnapshot
 };
 
 } // namespace physics
@@ -0,0 +1,55 @@
+#include "job_dispatcher.h"
+
+#include "job_system.h"
+
+#include <algorithm>
+
+
+namespace physics
+{
+
+JobDispatcher::JobDispatcher(uint32_t workerCount)
+{
+    // Without workers, jobs run on the thread that submits them.
+    uint32_t jobWorkers = std::max(1u, JobSystem::GetInstance().GetWorkerCount());
+    this->workerCount = std::min(std::max(1u, workerCount), jobWorkers);
+}
+
+void JobDispatcher::submitTask(physx::PxBaseTask& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        tasks.push_back(&task);
+
+        if (runningJobs == workerCount)
+            return;
+        runningJobs++;
+    }
+
+    JobSystem::GetInstance().Submit([this]() {Drain();});
+}
+
+void JobDispatcher::Drain()
+{
+    while (true)
+    {
+        physx::PxBaseTask* task;
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+            if (tasks.empty())
+            {
+                runningJobs--;
+                return;
+            }
+
+            task = tasks.front();
+            tasks.pop_front();
+        }
+
+        // Releasing a task may submit the tasks that depend on it.
+        task->run();
+        task->release();
+    }
+}
+
+} // namespace physics
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <PxPhysicsAPI.h>
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+
+namespace physics
+{
+
+/**
+ * @brief Runs the tasks of PhysX on the JobSystem of the engine.
+ *
+ * All scenes share one dispatcher, so they never use more than
+ * workerCount job system threads together, instead of each scene
+ * spawning threads of its own. Tasks wait in a queue and are drained
+ * by at most workerCount jobs at a time.
+ */
+class JobDispatcher: public physx::PxCpuDispatcher
+{
+public:
+    /**
+     * @param workerCount jobs running PhysX tasks at once,
+     * capped by the workers of the job system
+     */
+    JobDispatcher(uint32_t workerCount);
+    ~JobDispatcher() override = default;
+
+    JobDispatcher(const JobDispatcher&) = delete;
+    JobDispatcher& operator=(const JobDispatcher&) = delete;
+
+    void submitTask(physx::PxBaseTask& task) override;
+    uint32_t getWorkerCount() const override {return workerCount;}
+
+private:
+    void Drain();
+
+private:
+    uint32_t workerCount;
+
+    std::mutex taskMutex;
+    std::deque<physx::PxBaseTask*> tasks;
+    uint32_t runningJobs = 0;
+};
+
+} // namespace physics
@@ -0,0 +1,244 @@
+#include "mesh_cooker.h"
+
+#include "physics_asset_manager.h"
+
+#include "filesystem.h"
+#include "logger.h"
+
+#include <glm/vec3.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace physics
+{
+
+static bool GetSourceStamp(const std::string& sourcePath,
+    uint64_t& sourceSize, int64_t& sourceTime)
+{
+    std::error_code error;
+    sourceSize = std::filesystem::file_size(sourcePath, error);
+    if (error)
+        return false;
+
+    sourceTime = std::filesystem::last_write_time(sourcePath, error)
+        .time_since_epoch().count();
+    return !error;
+}
+
+MeshCooker::MeshCooker(physx::PxFoundation* gFoundation, physx::PxPhysics* gPhysics)
+{
+    this->gPhysics = gPhysics;
+
+    // BVH34 is the faster midphase for queries and contacts on all platforms.
+    physx::PxCookingParams params(gPhysics->getTolerancesScale());
+    params.midphaseDesc = physx::PxMeshMidPhase::eBVH34;
+    gCooking = PxCreateCooking(PX_PHYSICS_VERSION, *gFoundation, params);
+}
+
+MeshCooker::~MeshCooker()
+{
+    for (auto& m: triangleMeshes)
+        m.second->release();
+    for (auto& m: convexMeshes)
+        m.second->release();
+
+    PX_RELEASE(gCooking);
+    gPhysics = nullptr;
+}
+
+physx::PxTriangleMesh* MeshCooker::GetTriangleMesh(
+    IPhysicsAssetManager* assetManager, const std::string& meshPath)
+{
+    auto it = triangleMeshes.find(meshPath);
+    if (it != triangleMeshes.end())
+        return it->second;
+
+    std::string sourcePath = assetManager->GetMeshDataPath(meshPath);
+    std::string cachePath =
+        Filesystem::ChangeExtensionTo(sourcePath, TRIANGLE_MESH_EXTENSION);
+
+    std::vector<uint8_t> data;
+    physx::PxTriangleMesh* mesh = nullptr;
+    if (ReadCache(cachePath, sourcePath, data))
+    {
+        physx::PxDefaultMemoryInputData input(data.data(), data.size());
+        mesh = gPhysics->createTriangleMesh(input);
+    }
+
+    if (!mesh)
+    {
+        physx::PxDefaultMemoryOutputStream stream;
+        if (!CookTriangleMesh(assetManager, meshPath, stream))
+            return nullptr;
+
+        WriteCache(cachePath, sourcePath, stream.getData(), stream.getSize());
+        physx::PxDefaultMemoryInputData input(stream.getData(), stream.getSize());
+        mesh = gPhysics->createTriangleMesh(input);
+    }
+
+    if (mesh)
+        triangleMeshes[meshPath] = mesh;
+    return mesh;
+}
+
+physx::PxConvexMesh* MeshCooker::GetConvexMesh(
+    IPhysicsAssetManager* assetManager, const std::string& meshPath)
+{
+    auto it = convexMeshes.find(meshPath);
+    if (it != convexMeshes.end())
+        return it->second;
+
+    std::string sourcePath = assetManager->GetMeshDataPath(meshPath);
+    std::string cachePath =
+        Filesystem::ChangeExtensionTo(sourcePath, CONVEX_MESH_EXTENSION);
+
+    std::vector<uint8_t> data;
+    physx::PxConvexMesh* mesh = nullptr;
+    if (ReadCache(cachePath, sourcePath, data))
+    {
+        physx::PxDefaultMemoryInputData input(data.data(), data.size());
+        mesh = gPhysics->createConvexMesh(input);
+    }
+
+    if (!mesh)
+    {
+        physx::PxDefaultMemoryOutputStream stream;
+        if (!CookConvexMesh(assetManager, meshPath, stream))
+            return nullptr;
+
+        WriteCache(cachePath, sourcePath, stream.getData(), stream.getSize());
+        physx::PxDefaultMemoryInputData input(stream.getData(), stream.getSize());
+        mesh = gPhysics->createConvexMesh(input);
+    }
+
+    if (mesh)
+        convexMeshes[meshPath] = mesh;
+    return mesh;
+}
+
+bool MeshCooker::ReadCache(const std::string& cachePath,
+    const std::string& sourcePath, std::vector<uint8_t>& data)
+{
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if (!GetSourceStamp(sourcePath, sourceSize, sourceTime))
+        return false;
+
+    std::ifstream in;
+    in.open(cachePath, std::ifstream::in | std::ifstream::binary);
+    if (!in.is_open())
+        return false;
+
+    CookedMeshFile header{};
+    in.read((char*)&header, sizeof(header));
+    if (!in ||
+        header.magic != COOKED_MESH_MAGIC ||
+        header.version != COOKED_MESH_VERSION ||
+        header.physxVersion != PX_PHYSICS_VERSION ||
+        header.sourceSize != sourceSize ||
+        header.sourceTime != sourceTime)
+        return false;
+
+    data.resize(header.dataSize);
+    in.read((char*)data.data(), header.dataSize);
+    return static_cast<bool>(in);
+}
+
+void MeshCooker::WriteCache(const std::string& cachePath,
+    const std::string& sourcePath, const uint8_t* data, uint64_t dataSize)
+{
+    CookedMeshFile header{};
+    header.magic = COOKED_MESH_MAGIC;
+    header.version = COOKED_MESH_VERSION;
+    header.physxVersion = PX_PHYSICS_VERSION;
+    header.dataSize = dataSize;
+    if (!GetSourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+        return;
+
+    std::ofstream out;
+    out.open(cachePath, std::ofstream::out | std::ofstream::binary);
+    out.write((char*)&header, sizeof(header));
+    out.write((const char*)data, dataSize);
+    out.close();
+
+    if (!out)
+    {
+        Logger::Write(
+            "[Physics] Cooked mesh cache " + cachePath + " cannot be written",
+            Logger::Level::Warning, Logger::MsgType::Physics
+        );
+    }
+}
+
+bool MeshCooker::CookTriangleMesh(IPhysicsAssetManager* assetManager,
+    const std::string& meshPath, physx::PxDefaultMemoryOutputStream& stream)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> indices;
+    if (!assetManager->GetMeshGeometry(meshPath, positions, indices) ||
+        positions.empty() || indices.size() < 3)
+        return false;
+
+    physx::PxTriangleMeshDesc desc;
+    desc.points.count = positions.size();
+    desc.points.stride = sizeof(glm::vec3);
+    desc.points.data = positions.data();
+    desc.triangles.count = indices.size() / 3;
+    desc.triangles.stride = 3 * sizeof(unsigned int);
+    desc.triangles.data = indices.data();
+
+    physx::PxTriangleMeshCookingResult::Enum result;
+    if (!gCooking->cookTriangleMesh(desc, stream, &result))
+    {
+        Logger::Write(
+            "[Physics] Triangle mesh of " + meshPath + " cannot be cooked",
+            Logger::Level::Warning, Logger::MsgType::Physics
+        );
+        return false;
+    }
+
+    Logger::Write(
+        "[Physics] Cooked triangle mesh of " + meshPath + " with " +
+        std::to_string(desc.triangles.count) + " triangles",
+        Logger::Level::Info, Logger::MsgType::Physics
+    );
+    return true;
+}
+
+bool MeshCooker::CookConvexMesh(IPhysicsAssetManager* assetManager,
+    const std::string& meshPath, physx::PxDefaultMemoryOutputStream& stream)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> indices;
+    if (!assetManager->GetMeshGeometry(meshPath, positions, indices) ||
+        positions.size() < 4)
+        return false;
+
+    // The hull is computed from the points, with at most 255 vertices.
+    physx::PxConvexMeshDesc desc;
+    desc.points.count = positions.size();
+    desc.points.stride = sizeof(glm::vec3);
+    desc.points.data = positions.data();
+    desc.flags = physx::PxConvexFlag::eCOMPUTE_CONVEX |
+        physx::PxConvexFlag::eSHIFT_VERTICES;
+
+    physx::PxConvexMeshCookingResult::Enum result;
+    if (!gCooking->cookConvexMesh(desc, stream, &result))
+    {
+        Logger::Write(
+            "[Physics] Convex hull of " + meshPath + " cannot be cooked",
+            Logger::Level::Warning, Logger::MsgType::Physics
+        );
+        return false;
+    }
+
+    Logger::Write(
+        "[Physics] Cooked convex hull of " + meshPath,
+        Logger::Level::Info, Logger::MsgType::Physics
+    );
+    return true;
+}
+
+} // namespace physics
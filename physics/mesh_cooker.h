@@ -0,0 +1,88 @@
+#pragma once
+
+#include <PxPhysicsAPI.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define COOKED_MESH_MAGIC       0x434C5353 // "SSLC" in little endian
+#define COOKED_MESH_VERSION     1
+
+// Caches next to the mesh data file, named after it.
+#define TRIANGLE_MESH_EXTENSION ".sltrimsh"
+#define CONVEX_MESH_EXTENSION   ".slcvxmsh"
+
+namespace physics
+{
+
+class IPhysicsAssetManager;
+
+/**
+ * @brief Header of a cooked mesh cache file, followed by the PhysX cooked stream.
+ * The cache is cooked again when the mesh data file changes
+ * or when it was cooked by another PhysX version.
+ */
+struct CookedMeshFile
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t physxVersion;  // PX_PHYSICS_VERSION that cooked the stream
+    uint32_t reserved;
+    uint64_t sourceSize;    // Size of the mesh data file
+    int64_t  sourceTime;    // Last write time of the mesh data file
+    uint64_t dataSize;      // Bytes of the cooked stream
+};
+
+/**
+ * @brief Collision meshes cooked from mesh assets, shared by all contexts.
+ *
+ * Static bodies use triangle meshes and dynamic bodies use convex hulls,
+ * PhysX does not simulate triangle meshes on dynamic bodies.
+ * A mesh is cooked once and cached to disk, later runs only load
+ * the cooked stream. Meshes stay loaded until the system is destroyed,
+ * shapes keep their own reference.
+ */
+class MeshCooker
+{
+public:
+    MeshCooker(physx::PxFoundation* gFoundation, physx::PxPhysics* gPhysics);
+    ~MeshCooker();
+
+    MeshCooker(const MeshCooker&) = delete;
+    void operator=(const MeshCooker&) = delete;
+
+    /**
+     * @param meshPath Path of the mesh relative to workspace directory.
+     * @return nullptr if the mesh cannot be read or cooked
+     */
+    physx::PxTriangleMesh* GetTriangleMesh(
+        IPhysicsAssetManager* assetManager, const std::string& meshPath);
+    physx::PxConvexMesh* GetConvexMesh(
+        IPhysicsAssetManager* assetManager, const std::string& meshPath);
+
+private:
+    /**
+     * @brief Read the cooked stream cached next to the mesh data.
+     * @return Return false if there is no cache or it is stale.
+     */
+    bool ReadCache(const std::string& cachePath, const std::string& sourcePath,
+        std::vector<uint8_t>& data);
+    void WriteCache(const std::string& cachePath, const std::string& sourcePath,
+        const uint8_t* data, uint64_t dataSize);
+
+    bool CookTriangleMesh(IPhysicsAssetManager* assetManager,
+        const std::string& meshPath, physx::PxDefaultMemoryOutputStream& stream);
+    bool CookConvexMesh(IPhysicsAssetManager* assetManager,
+        const std::string& meshPath, physx::PxDefaultMemoryOutputStream& stream);
+
+private:
+    physx::PxCooking* gCooking;
+    physx::PxPhysics* gPhysics; // Owned by physics system
+
+    std::unordered_map<std::string, physx::PxTriangleMesh*> triangleMeshes;
+    std::unordered_map<std::string, physx::PxConvexMesh*> convexMeshes;
+};
+
+} // namespace physics
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <string>
+#include <vector>
+
+namespace physics
+{
+
+class IPhysicsAssetManager
+{
+public:
+    /**
+     * @brief Absolute path of the data file of a mesh asset.
+     * Shapes cooked from the mesh are cached next to it.
+     *
+     * @param path Path of the mesh relative to workspace directory.
+     */
+    virtual std::string GetMeshDataPath(std::string path) = 0;
+
+    /**
+     * @brief Positions and indices of the finest level of detail of a mesh asset.
+     * Only read when the shapes cooked from the mesh are not cached.
+     *
+     * @param path Path of the mesh relative to workspace directory.
+     * @return Return false if the mesh data cannot be read.
+     */
+    virtual bool GetMeshGeometry(std::string path,
+        std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices) = 0;
+
+    virtual ~IPhysicsAssetManager() {}
+};
+
+} // namespace physics
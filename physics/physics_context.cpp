@@ -3,104 +3,207 @@
 #include "dynamic_rigidbody.h"
 #include "static_rigidbody.h"
 #include "rigidbody.h"
+#include "scene_query_batch.h"
+#include "physics_snapshot.h"
+#include "mesh_cooker.h"
 
 #include "logger.h"
 #include "math_library.h"
+#include "configuration.h"
+#include "job_system.h"
 
 #include "component.h"
 #include "components/dynamic_body_component.h"
 #include "components/static_body_component.h"
 
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
 namespace physics
 {
 
+// Same as PxDefaultSimulationFilterShader without collision groups,
+// contacts are reported for the shapes that ask for them
+// and swept when CCD is enabled for the scene.
+static physx::PxFilterFlags ContactFilterShader(
+	physx::PxFilterObjectAttributes attributes0, physx::PxFilterData filterData0,
+	physx::PxFilterObjectAttributes attributes1, physx::PxFilterData filterData1,
+	physx::PxPairFlags& pairFlags, const void* constantBlock,
+	physx::PxU32 /*constantBlockSize*/)
+{
+	const FilterShaderData* data = static_cast<const FilterShaderData*>(constantBlock);
+
+	if (physx::PxFilterObjectIsTrigger(attributes0) ||
+		physx::PxFilterObjectIsTrigger(attributes1))
+	{
+		pairFlags = physx::PxPairFlag::eTRIGGER_DEFAULT;
+		return physx::PxFilterFlag::eDEFAULT;
+	}
+
+	pairFlags = physx::PxPairFlag::eCONTACT_DEFAULT;
+	if (data->enableCCD)
+		pairFlags |= physx::PxPairFlag::eDETECT_CCD_CONTACT;
+	if ((filterData0.word3 | filterData1.word3) & SHAPE_FILTER_CONTACT_EVENTS)
+	{
+		pairFlags |= physx::PxPairFlag::eNOTIFY_TOUCH_FOUND |
+			physx::PxPairFlag::eNOTIFY_TOUCH_LOST;
+	}
+	return physx::PxFilterFlag::eDEFAULT;
+}
+
 void SimulationEventCallback::onTrigger(
 	physx::PxTriggerPair* pairs, physx::PxU32 count)
 {
-	for (int i = 0; i < count; i++)
+	for (physx::PxU32 i = 0; i < count; i++)
 	{
-		if(pairs[i].flags & 
+		// Pairs of a removed shape are dropped by RemoveShapeEvents
+		// when the shape is destroyed, its user data may be gone.
+		if(pairs[i].flags &
 			(physx::PxTriggerPairFlag::eREMOVED_SHAPE_TRIGGER |
 			 physx::PxTriggerPairFlag::eREMOVED_SHAPE_OTHER))
-		{
-			// Logger::Write(
-			// 	"Trigger Deleted",
-			// 	Logger::Level::Warning, Logger::MsgType::Physics
-			// );
 			continue;
-			// delete shape and rigidbody are
-			// handles in destructor and SetTrigger,
-			// which cause this event
-		}
 
 		const physx::PxTriggerPair& current = pairs[i];
+
+		PhysicsContext::QueuedEvent event;
+		event.collisionShape = static_cast<CollisionShape*>(
+			current.triggerShape->userData);
+		event.otherCollisionShape = static_cast<CollisionShape*>(
+			current.otherShape->userData);
+		event.entity = static_cast<Entity*>(current.triggerActor->userData);
+		event.otherEntity = static_cast<Entity*>(current.otherActor->userData);
+
 		if(current.status & physx::PxPairFlag::eNOTIFY_TOUCH_FOUND)
 		{
-			// Logger::Write(
-			// 	"Trigger Enter",
-			// 	Logger::Level::Warning, Logger::MsgType::Physics
-			// );
-
-			TriggerEvent event;
-			event.triggerCollisionShape = static_cast<CollisionShape*>(
-				current.triggerShape->userData);
-			event.otherCollisionShape = static_cast<CollisionShape*>(
-				current.otherShape->userData);
-			event.triggerEntity = static_cast<Entity*>(
-				current.triggerActor->userData);
-			event.otherEntity = static_cast<Entity*>(
-				current.otherActor->userData);
-
-			context->AddTriggerEvent(event);
-			
-			/** Notes;
-			 * shape->SetTriggerEvents(True);
-			 * otherShape->SetTriggerEvents(true);
-			 * 
-			 * context->addTriggerEvent(TriggerEvent);
-			 * 
-			 * context->ProcessTrigger(): loop all
-			 * 
-			 * when collision destructor is called and has triggers
-			 * - context->CleanAllTriggers(this)
-			 * 
-			 */
+			event.type = PhysicsContext::QueuedEvent::TriggerEnter;
+			context->queuedEvents.push_back(event);
 		}
 
 		if(current.status & physx::PxPairFlag::eNOTIFY_TOUCH_LOST)
 		{
-			// Logger::Write(
-			// 	"Trigger Leave",
-			// 	Logger::Level::Warning, Logger::MsgType::Physics
-			// );
+			event.type = PhysicsContext::QueuedEvent::TriggerLeave;
+			context->queuedEvents.push_back(event);
+		}
+	}
+}
 
-			TriggerEvent event;
-			event.triggerCollisionShape = static_cast<CollisionShape*>(
-				current.triggerShape->userData);
-			event.otherCollisionShape = static_cast<CollisionShape*>(
-				current.otherShape->userData);
-			event.triggerEntity = static_cast<Entity*>(
-				current.triggerActor->userData);
-			event.otherEntity = static_cast<Entity*>(
-				current.otherActor->userData);
-
-			context->RemoveTriggerEvent(event);
+void SimulationEventCallback::onContact(
+	const physx::PxContactPairHeader& pairHeader,
+	const physx::PxContactPair* pairs, physx::PxU32 count)
+{
+	if (pairHeader.flags &
+		(physx::PxContactPairHeaderFlag::eREMOVED_ACTOR_0 |
+		 physx::PxContactPairHeaderFlag::eREMOVED_ACTOR_1))
+		return;
+
+	for (physx::PxU32 i = 0; i < count; i++)
+	{
+		const physx::PxContactPair& current = pairs[i];
+		if (current.flags &
+			(physx::PxContactPairFlag::eREMOVED_SHAPE_0 |
+			 physx::PxContactPairFlag::eREMOVED_SHAPE_1))
+			continue;
+
+		PhysicsContext::QueuedEvent event;
+		event.collisionShape = static_cast<CollisionShape*>(
+			current.shapes[0]->userData);
+		event.otherCollisionShape = static_cast<CollisionShape*>(
+			current.shapes[1]->userData);
+		event.entity = static_cast<Entity*>(pairHeader.actors[0]->userData);
+		event.otherEntity = static_cast<Entity*>(pairHeader.actors[1]->userData);
+
+		if (current.events & physx::PxPairFlag::eNOTIFY_TOUCH_FOUND)
+		{
+			event.type = PhysicsContext::QueuedEvent::ContactEnter;
+			context->queuedEvents.push_back(event);
+		}
+
+		if (current.events & physx::PxPairFlag::eNOTIFY_TOUCH_LOST)
+		{
+			event.type = PhysicsContext::QueuedEvent::ContactLeave;
+			context->queuedEvents.push_back(event);
 		}
 	}
 }
 
-PhysicsContext::PhysicsContext(physx::PxPhysics* gPhysics)
+PhysicsContext::PhysicsContext(
+	physx::PxPhysics* gPhysics, physx::PxCpuDispatcher* gDispatcher,
+	MeshCooker* meshCooker, const PhysicsSceneSettings& settings)
 {
 	this->gPhysics = gPhysics;
+	this->gDispatcher = gDispatcher;
+	this->meshCooker = meshCooker;
+	this->settings = settings;
+
+	std::string value;
+	asyncSimulation =
+		!(Configuration::Get(CONFIG_PHYSICS_ASYNC, value) && value == "false");
+	if (Configuration::Get(CONFIG_PHYSICS_STEP_RATE, value) && std::atoi(value.c_str()) > 0)
+		stepSize = 1.0f / std::atoi(value.c_str());
+	if (Configuration::Get(CONFIG_PHYSICS_MAX_SUBSTEPS, value) && std::atoi(value.c_str()) > 0)
+		maxSubsteps = std::atoi(value.c_str());
 
     physx::PxSceneDesc sceneDesc(gPhysics->getTolerancesScale());
-	sceneDesc.gravity = physx::PxVec3(0.0f, -9.81f, 0.0f);
-	gDispatcher = physx::PxDefaultCpuDispatcherCreate(2);
+	sceneDesc.gravity = physx::PxVec3(
+		settings.gravity.x, settings.gravity.y, settings.gravity.z);
 	sceneDesc.cpuDispatcher = gDispatcher;
-	sceneDesc.filterShader = physx::PxDefaultSimulationFilterShader;
-	sceneDesc.simulationEventCallback = new SimulationEventCallback(this);
+
+	FilterShaderData filterShaderData;
+	filterShaderData.enableCCD = settings.enableCCD;
+	sceneDesc.filterShader = ContactFilterShader;
+	sceneDesc.filterShaderData = &filterShaderData;
+	sceneDesc.filterShaderDataSize = sizeof(filterShaderData);
+
+	switch (settings.broadphase)
+	{
+	case PhysicsSceneSettings::BroadphaseType::SAP:
+		sceneDesc.broadPhaseType = physx::PxBroadPhaseType::eSAP;
+		break;
+	case PhysicsSceneSettings::BroadphaseType::MBP:
+		sceneDesc.broadPhaseType = physx::PxBroadPhaseType::eMBP;
+		break;
+	default:
+		sceneDesc.broadPhaseType = physx::PxBroadPhaseType::eABP;
+		break;
+	}
+
+	sceneDesc.solverType = settings.solver == PhysicsSceneSettings::SolverType::TGS?
+		physx::PxSolverType::eTGS: physx::PxSolverType::ePGS;
+
+	switch (settings.friction)
+	{
+	case PhysicsSceneSettings::FrictionType::OneDirectional:
+		sceneDesc.frictionType = physx::PxFrictionType::eONE_DIRECTIONAL;
+		break;
+	case PhysicsSceneSettings::FrictionType::TwoDirectional:
+		sceneDesc.frictionType = physx::PxFrictionType::eTWO_DIRECTIONAL;
+		break;
+	default:
+		sceneDesc.frictionType = physx::PxFrictionType::ePATCH;
+		break;
+	}
+
+	sceneDesc.flags |= physx::PxSceneFlag::eENABLE_ACTIVE_ACTORS;
+	if (settings.enableCCD)
+		sceneDesc.flags |= physx::PxSceneFlag::eENABLE_CCD;
+	if (settings.enablePCM)
+		sceneDesc.flags |= physx::PxSceneFlag::eENABLE_PCM;
+	else
+		sceneDesc.flags &= ~physx::PxSceneFlags(physx::PxSceneFlag::eENABLE_PCM);
+	if (settings.enableStabilization)
+		sceneDesc.flags |= physx::PxSceneFlag::eENABLE_STABILIZATION;
+
+	simulationEventCallback = new SimulationEventCallback(this);
+	sceneDesc.simulationEventCallback = simulationEventCallback;
 	gScene = gPhysics->createScene(sceneDesc);
 
+	if (settings.broadphase == PhysicsSceneSettings::BroadphaseType::MBP)
+		AddBroadphaseRegions();
+
     physx::PxPvdSceneClient* pvdClient = gScene->getScenePvdClient();
 	if(pvdClient)
 	{
@@ -115,43 +218,193 @@ PhysicsContext::PhysicsContext(physx::PxPhysics* gPhysics)
 
 PhysicsContext::~PhysicsContext()
 {
-	delete simulationEventCallback;
+	FetchResults();
     PX_RELEASE(gScene);
-	PX_RELEASE(gDispatcher);
+	delete simulationEventCallback;
+	meshCooker = nullptr;
+	gDispatcher = nullptr;
 	gPhysics = nullptr;
 }
 
-void PhysicsContext::AddTriggerEvent(TriggerEvent& event)
+void PhysicsContext::AddBroadphaseRegions()
+{
+	const physx::PxBounds3 worldBounds(
+		physx::PxVec3(settings.worldMin.x, settings.worldMin.y, settings.worldMin.z),
+		physx::PxVec3(settings.worldMax.x, settings.worldMax.y, settings.worldMax.z));
+
+	std::vector<physx::PxBounds3> regions(
+		settings.regionSubdivisions * settings.regionSubdivisions);
+	physx::PxU32 regionCount = physx::PxBroadPhaseExt::createRegionsFromWorldBounds(
+		regions.data(), worldBounds, settings.regionSubdivisions);
+
+	for (physx::PxU32 i = 0; i < regionCount; i++)
+	{
+		physx::PxBroadPhaseRegion region;
+		region.bounds = regions[i];
+		region.userData = nullptr;
+		gScene->addBroadPhaseRegion(region);
+	}
+
+	Logger::Write(
+		"[Physics] Broadphase split in " + std::to_string(regionCount) + " regions",
+		Logger::Level::Info, Logger::MsgType::Physics
+	);
+}
+
+void PhysicsContext::AddTriggerPair(const TriggerEvent& event)
 {
-	event.triggerCollisionShape->ExecuteOnTriggerEnter(&event);
-	triggerEvents.push_back(event);
+	auto key = std::make_pair(event.triggerCollisionShape, event.otherCollisionShape);
+	if (triggerPairIndices.count(key))
+		return;
+
+	triggerPairIndices[key] = triggerPairs.size();
+	triggerPairs.push_back(event);
+	event.triggerCollisionShape->triggerPairCount++;
+	event.otherCollisionShape->triggerPairCount++;
 }
 
-void PhysicsContext::RemoveTriggerEvent(TriggerEvent& event)
+void PhysicsContext::RemoveTriggerPair(unsigned int index)
 {
-	event.triggerCollisionShape->ExecuteOnTriggerLeave(&event);
-	triggerEvents.remove(event);
+	TriggerEvent& event = triggerPairs[index];
+	event.triggerCollisionShape->triggerPairCount--;
+	event.otherCollisionShape->triggerPairCount--;
+	triggerPairIndices.erase(
+		std::make_pair(event.triggerCollisionShape, event.otherCollisionShape));
+
+	if (index != triggerPairs.size() - 1)
+	{
+		event = triggerPairs.back();
+		triggerPairIndices[std::make_pair(
+			event.triggerCollisionShape, event.otherCollisionShape)] = index;
+	}
+	triggerPairs.pop_back();
 }
 
-void PhysicsContext::RemoveTrigger(CollisionShape* shape)
+void PhysicsContext::RemoveShapeEvents(CollisionShape* shape)
 {
-	std::list<TriggerEvent> copy = triggerEvents;
+	for (QueuedEvent& e: queuedEvents)
+	{
+		if (e.collisionShape == shape || e.otherCollisionShape == shape)
+			e.type = QueuedEvent::Removed;
+	}
+
+	if (shape->triggerPairCount == 0)
+		return;
 
-	for(auto& e: copy)
+	// Pairs are all removed before the callbacks run, which may destroy shapes too.
+	std::vector<TriggerEvent> removedPairs;
+	unsigned int i = 0;
+	while (shape->triggerPairCount > 0 && i < triggerPairs.size())
 	{
-		if (e.triggerCollisionShape == shape)
+		const TriggerEvent& event = triggerPairs[i];
+		if (event.triggerCollisionShape != shape && event.otherCollisionShape != shape)
 		{
-			e.triggerCollisionShape->ExecuteOnTriggerLeave(&e);
-			triggerEvents.remove(e);
+			i++;
+			continue;
 		}
+
+		// The last pair is moved to i, it is checked next.
+		removedPairs.push_back(event);
+		RemoveTriggerPair(i);
 	}
+
+	for (TriggerEvent& event: removedPairs)
+		event.triggerCollisionShape->ExecuteOnTriggerLeave(&event);
 }
 
-void PhysicsContext::ProcessOnTriggerStayEvents()
+void PhysicsContext::DispatchEvents()
 {
-	for (auto& e: triggerEvents)
+	// Callbacks may destroy shapes, which marks their queued events as removed,
+	// so the queue is walked by index.
+	for (size_t i = 0; i < queuedEvents.size(); i++)
+	{
+		const QueuedEvent e = queuedEvents[i];
+
+		switch (e.type)
+		{
+		case QueuedEvent::TriggerEnter:
+		case QueuedEvent::TriggerLeave:
+		{
+			TriggerEvent event;
+			event.triggerEntity = e.entity;
+			event.triggerCollisionShape = e.collisionShape;
+			event.otherEntity = e.otherEntity;
+			event.otherCollisionShape = e.otherCollisionShape;
+
+			if (e.type == QueuedEvent::TriggerEnter)
+			{
+				AddTriggerPair(event);
+				event.triggerCollisionShape->ExecuteOnTriggerEnter(&event);
+			}
+			else
+			{
+				auto it = triggerPairIndices.find(
+					std::make_pair(e.collisionShape, e.otherCollisionShape));
+				if (it != triggerPairIndices.end())
+					RemoveTriggerPair(it->second);
+				event.triggerCollisionShape->ExecuteOnTriggerLeave(&event);
+			}
+			break;
+		}
+
+		case QueuedEvent::ContactEnter:
+		case QueuedEvent::ContactLeave:
+		{
+			const bool isEnter = e.type == QueuedEvent::ContactEnter;
+
+			ContactEvent event;
+			event.entity = e.entity;
+			event.collisionShape = e.collisionShape;
+			event.otherEntity = e.otherEntity;
+			event.otherCollisionShape = e.otherCollisionShape;
+			if (event.collisionShape->GetContactEvents())
+			{
+				if (isEnter)
+					event.collisionShape->ExecuteOnContactEnter(&event);
+				else
+					event.collisionShape->ExecuteOnContactLeave(&event);
+			}
+
+			// The first callback may have destroyed either shape.
+			if (queuedEvents[i].type == QueuedEvent::Removed)
+				break;
+
+			std::swap(event.entity, event.otherEntity);
+			std::swap(event.collisionShape, event.otherCollisionShape);
+			if (event.collisionShape->GetContactEvents())
+			{
+				if (isEnter)
+					event.collisionShape->ExecuteOnContactEnter(&event);
+				else
+					event.collisionShape->ExecuteOnContactLeave(&event);
+			}
+			break;
+		}
+
+		case QueuedEvent::Removed:
+			break;
+		}
+	}
+	queuedEvents.clear();
+
+	// Stay callbacks may destroy shapes and swap other pairs into
+	// the removed slots, so the pairs touching now are collected first
+	// and each one is looked up again before its callback.
+	triggerStayPairs.clear();
+	for (const TriggerEvent& event: triggerPairs)
+	{
+		triggerStayPairs.push_back(std::make_pair(
+			event.triggerCollisionShape, event.otherCollisionShape));
+	}
+
+	for (const auto& pair: triggerStayPairs)
 	{
-		e.triggerCollisionShape->ExecuteOnTriggerStay(&e);
+		auto it = triggerPairIndices.find(pair);
+		if (it == triggerPairIndices.end())
+			continue;
+
+		TriggerEvent event = triggerPairs[it->second];
+		event.triggerCollisionShape->ExecuteOnTriggerStay(&event);
 	}
 }
 
@@ -171,9 +424,14 @@ DynamicRigidbody* PhysicsContext::NewDynamicRigidbody(void* userData)
 	physx::PxRigidDynamic* body =
 		gPhysics->createRigidDynamic(physx::PxTransform(physx::PxIdentity));
 	body->userData = userData;
+	body->setSolverIterationCounts(
+		settings.positionIterations, settings.velocityIterations);
+	body->setRigidBodyFlag(physx::PxRigidBodyFlag::eENABLE_CCD, settings.enableCCD);
 	gScene->addActor(*body);
 
 	DynamicRigidbody* dynamicRigidBody = new DynamicRigidbody(this, body);
+	dynamicRigidBody->bodyId = nextBodyId++;
+	dynamicBodies[body] = dynamicRigidBody;
 	return dynamicRigidBody;
 }
 
@@ -244,11 +502,67 @@ CollisionShape* PhysicsContext::AddCollisionShape(
 	return collisionShape;
 }
 
+CollisionShape* PhysicsContext::AddMeshShape(IPhysicsAssetManager* assetManager,
+	const std::string& meshPath, bool isStatic)
+{
+	physx::PxShape* shape = nullptr;
+	physx::PxMaterial* material = gPhysics->createMaterial(0.5f, 0.5f, 0.5f);
+
+	if (isStatic)
+	{
+		physx::PxTriangleMesh* mesh =
+			meshCooker->GetTriangleMesh(assetManager, meshPath);
+		if (mesh)
+		{
+			shape = gPhysics->createShape(
+				physx::PxTriangleMeshGeometry(mesh),
+				*material, true
+			);
+		}
+	}
+	else
+	{
+		physx::PxConvexMesh* mesh =
+			meshCooker->GetConvexMesh(assetManager, meshPath);
+		if (mesh)
+		{
+			shape = gPhysics->createShape(
+				physx::PxConvexMeshGeometry(mesh),
+				*material, true
+			);
+		}
+	}
+
+	if (!shape)
+	{
+		material->release();
+		return nullptr;
+	}
+
+	CollisionShape* collisionShape = new CollisionShape(shape);
+	collisionShape->meshPath = meshPath;
+	return collisionShape;
+}
+
 void PhysicsContext::RemoveRigidbody(physx::PxRigidActor* actor)
 {
 	//gScene->removeActor(*actor);
 }
 
+void PhysicsContext::RemoveDynamicRigidbody(DynamicRigidbody* rigidbody)
+{
+	dynamicBodies.erase(rigidbody->gRigidDynamic);
+
+	if (rigidbody->movingIndex != DYNAMIC_BODY_NOT_MOVING)
+	{
+		DynamicRigidbody* last = movingBodies.back();
+		movingBodies[rigidbody->movingIndex] = last;
+		last->movingIndex = rigidbody->movingIndex;
+		movingBodies.pop_back();
+		rigidbody->movingIndex = DYNAMIC_BODY_NOT_MOVING;
+	}
+}
+
 void PhysicsContext::RaycastClosest(
 	const glm::vec3& origin, const glm::vec3& direction,
 	const float maxDistance, Hit& hit)
@@ -278,8 +592,9 @@ void PhysicsContext::Raycast(
 	const float maxDistance, std::vector<Hit>& hitList, unsigned int maxHits)
 {
 	hitList.clear();
-	std::vector<physx::PxRaycastHit> hitBuffer(maxHits);
-	physx::PxRaycastBuffer result(hitBuffer.data(), maxHits);
+	if (raycastHits.size() < maxHits)
+		raycastHits.resize(maxHits);
+	physx::PxRaycastBuffer result(raycastHits.data(), maxHits);
 
 	const physx::PxVec3* gOrigin =
 		reinterpret_cast<const physx::PxVec3*>(&origin);
@@ -374,8 +689,9 @@ void PhysicsContext::Sweep(
     pose.q.z = rotation.z;
 
 	hitList.clear();
-	std::vector<physx::PxSweepHit> hitBuffer(maxHits);
-	physx::PxSweepBuffer result(hitBuffer.data(), maxHits);
+	if (sweepHits.size() < maxHits)
+		sweepHits.resize(maxHits);
+	physx::PxSweepBuffer result(sweepHits.data(), maxHits);
 
 	const glm::vec3 normDir = glm::normalize(direction);
 	const physx::PxVec3* gDirection =
@@ -402,25 +718,250 @@ void PhysicsContext::Sweep(
 	}
 }
 
+void PhysicsContext::ExecuteQueries(SceneQueryBatch& batch)
+{
+	batch.PrepareResults();
+
+	const unsigned int queryCount = batch.GetQueryCount();
+	const unsigned int jobCount =
+		(queryCount + SCENE_QUERY_JOB_SIZE - 1) / SCENE_QUERY_JOB_SIZE;
+
+	JobSystem::GetInstance().ParallelFor(jobCount,
+		[this, &batch, queryCount](uint32_t job)
+	{
+		physx::PxSceneReadLock lock(*gScene);
+
+		const unsigned int first = job * SCENE_QUERY_JOB_SIZE;
+		const unsigned int last = std::min(first + SCENE_QUERY_JOB_SIZE, queryCount);
+		for (unsigned int i = first; i < last; i++)
+			batch.hitCounts[i] = batch.Execute(gScene, i);
+	});
+}
+
 int PhysicsContext::Simulate(Timestep ts)
 {
+	FetchResults();
+
 	accumulator += ts;
-    if(accumulator < STEP_SIZE)
+    if(accumulator < stepSize)
         return 0;
 
+	// Steps that do not fit are dropped rather than run in later frames,
+	// which would make them longer still. The fraction of a step is kept
+	// so that the interpolation does not jump.
+	if (accumulator >= stepSize * (maxSubsteps + 1))
+		accumulator = stepSize * maxSubsteps + std::fmod(accumulator, stepSize);
+
 	int simCount = 0;
-	while (accumulator >= STEP_SIZE)
+	while (accumulator >= stepSize)
 	{
-		accumulator -= STEP_SIZE;
-    	gScene->simulate(STEP_SIZE);
+		accumulator -= stepSize;
+		simCount++;
+		stepCount++;
+    	gScene->simulate(stepSize);
+
+		// The last step overlaps with rendering and the other scenes.
+		if (asyncSimulation && accumulator < stepSize)
+		{
+			simulating = true;
+			return simCount;
+		}
+
 		gScene->fetchResults(true);
+		UpdateMovingBodies();
 	}
 
-	ProcessOnTriggerStayEvents();
+	DispatchEvents();
 
     return simCount;
 }
 
+void PhysicsContext::FetchResults()
+{
+	if (!simulating)
+		return;
+
+	gScene->fetchResults(true);
+	simulating = false;
+
+	UpdateMovingBodies();
+	DispatchEvents();
+}
+
+void PhysicsContext::UpdateMovingBodies()
+{
+	for (DynamicRigidbody* rigidbody: movingBodies)
+		rigidbody->active = false;
+
+	physx::PxU32 activeCount = 0;
+	physx::PxActor** activeActors = gScene->getActiveActors(activeCount);
+	for (physx::PxU32 i = 0; i < activeCount; i++)
+	{
+		auto it = dynamicBodies.find(activeActors[i]);
+		if (it == dynamicBodies.end())
+			continue;
+
+		// Kinematic bodies move with their entities, there is nothing to sync.
+		DynamicRigidbody* rigidbody = it->second;
+		if (rigidbody->GetKinematic())
+			continue;
+
+		rigidbody->SavePose();
+		rigidbody->active = true;
+		AddMovingBody(rigidbody);
+	}
+
+	// Bodies that stopped rest at their last pose, without interpolation.
+	for (DynamicRigidbody* rigidbody: movingBodies)
+	{
+		if (!rigidbody->active)
+			rigidbody->SavePose();
+	}
+}
+
+void PhysicsContext::AddMovingBody(DynamicRigidbody* rigidbody)
+{
+	if (rigidbody->movingIndex != DYNAMIC_BODY_NOT_MOVING)
+		return;
+
+	rigidbody->movingIndex = movingBodies.size();
+	movingBodies.push_back(rigidbody);
+}
+
+void PhysicsContext::SaveSnapshot(PhysicsSnapshotRing& ring)
+{
+	FetchResults();
+
+	PhysicsSnapshotRing::Snapshot& snapshot = ring.Push();
+	snapshot.step = stepCount;
+	snapshot.accumulator = accumulator;
+	snapshot.bodies.reserve(dynamicBodies.size());
+
+	for (auto& e: dynamicBodies)
+	{
+		const physx::PxRigidDynamic* gBody = e.second->gRigidDynamic;
+
+		BodySnapshot body;
+		body.actor = e.first;
+		body.bodyId = e.second->bodyId;
+		body.flags = 0;
+		body.pose = gBody->getGlobalPose();
+		body.kinematicTarget = body.pose;
+		body.linearVelocity = physx::PxVec3(0.0f);
+		body.angularVelocity = physx::PxVec3(0.0f);
+
+		if (gBody->getRigidBodyFlags() & physx::PxRigidBodyFlag::eKINEMATIC)
+		{
+			body.flags |= BODY_SNAPSHOT_KINEMATIC;
+			if (gBody->getKinematicTarget(body.kinematicTarget))
+				body.flags |= BODY_SNAPSHOT_HAS_TARGET;
+		}
+		else
+		{
+			body.linearVelocity = gBody->getLinearVelocity();
+			body.angularVelocity = gBody->getAngularVelocity();
+		}
+
+		if (gBody->isSleeping())
+			body.flags |= BODY_SNAPSHOT_SLEEPING;
+
+		snapshot.bodies.push_back(body);
+	}
+}
+
+bool PhysicsContext::RestoreSnapshot(const PhysicsSnapshotRing& ring, unsigned int age)
+{
+	if (age >= ring.GetCount())
+		return false;
+
+	FetchResults();
+
+	const PhysicsSnapshotRing::Snapshot& snapshot = ring.Get(age);
+	stepCount = snapshot.step;
+	accumulator = snapshot.accumulator;
+
+	for (const BodySnapshot& body: snapshot.bodies)
+	{
+		auto it = dynamicBodies.find(body.actor);
+		if (it == dynamicBodies.end() || it->second->bodyId != body.bodyId)
+			continue;
+
+		DynamicRigidbody* rigidbody = it->second;
+		physx::PxRigidDynamic* gBody = rigidbody->gRigidDynamic;
+
+		const bool isKinematic = body.flags & BODY_SNAPSHOT_KINEMATIC;
+		if (rigidbody->GetKinematic() != isKinematic)
+			rigidbody->SetKinematic(isKinematic);
+		gBody->setGlobalPose(body.pose, false);
+
+		if (isKinematic)
+		{
+			if (body.flags & BODY_SNAPSHOT_HAS_TARGET)
+				gBody->setKinematicTarget(body.kinematicTarget);
+		}
+		else
+		{
+			gBody->setLinearVelocity(body.linearVelocity, false);
+			gBody->setAngularVelocity(body.angularVelocity, false);
+			gBody->clearForce();
+			gBody->clearTorque();
+
+			if (body.flags & BODY_SNAPSHOT_SLEEPING)
+				gBody->putToSleep();
+			else
+				gBody->wakeUp();
+		}
+
+		// Not interpolated from the pose before the restore, synced once
+		// and kept moving if the next step reports it active.
+		rigidbody->currentPose = body.pose;
+		rigidbody->previousPose = body.pose;
+		rigidbody->active = false;
+		AddMovingBody(rigidbody);
+	}
+
+	return true;
+}
+
+void PhysicsContext::SyncTransforms()
+{
+	const float alpha = GetInterpolationAlpha();
+
+	unsigned int i = 0;
+	while (i < movingBodies.size())
+	{
+		DynamicRigidbody* rigidbody = movingBodies[i];
+
+		// A kinematic body follows its entity, which already holds the pose.
+		// Only a restored one is written back, once.
+		Entity* entity = static_cast<Entity*>(rigidbody->gRigidDynamic->userData);
+		if (entity && !(rigidbody->GetKinematic() && rigidbody->active))
+		{
+			// Steps are fixed and frames are not, the pose is interpolated
+			// between the last two steps so that motion does not judder.
+			glm::mat4 transform;
+			rigidbody->GetInterpolatedTransform(transform, alpha);
+
+			glm::mat4 parentTransform = entity->GetParent()->GetGlobalTransform();
+			glm::mat4 localTransform = glm::inverse(parentTransform) * transform;
+			glm::mat4 scaleTransform = glm::scale(glm::mat4(1.0f), entity->GetLocalScale());
+			entity->SetLocalTransform(localTransform * scaleTransform, true);
+		}
+
+		// Written with its final pose, the body is left alone until it moves again.
+		if (!rigidbody->active)
+		{
+			DynamicRigidbody* last = movingBodies.back();
+			movingBodies[i] = last;
+			last->movingIndex = i;
+			movingBodies.pop_back();
+			rigidbody->movingIndex = DYNAMIC_BODY_NOT_MOVING;
+			continue;
+		}
+		i++;
+	}
+}
+
 void PhysicsContext::UpdatePhysicsTransform(Entity* e)
 {
 	if (e->HasComponent(Component::Type::DynamicBody))
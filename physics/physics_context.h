@@ -3,11 +3,15 @@
 #include <PxPhysicsAPI.h>
 
 #include "collision_shape.h"
+#include "physics_scene_settings.h"
 #include "timestep.h"
 #include "scene_contexts.h"
 #include "entity.h"
 
-#include <list>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 
@@ -18,6 +22,16 @@ class StaticRigidbody;
 class DynamicRigidbody;
 class Rigidbody;
 class PhysicsContext;
+class SceneQueryBatch;
+class PhysicsSnapshotRing;
+class MeshCooker;
+class IPhysicsAssetManager;
+
+// Constant block of the filter shader, copied by PhysX when the scene is created.
+struct FilterShaderData
+{
+    bool enableCCD;
+};
 
 class SimulationEventCallback: public physx::PxSimulationEventCallback
 {
@@ -40,8 +54,8 @@ private:
         const physx::PxTransform*, const physx::PxU32) {}
 
 	void onContact(
-        const physx::PxContactPairHeader& /*pairHeader*/,
-        const physx::PxContactPair* pairs, physx::PxU32 count) {}
+        const physx::PxContactPairHeader& pairHeader,
+        const physx::PxContactPair* pairs, physx::PxU32 count);
 
 private:
     PhysicsContext* context;
@@ -62,12 +76,15 @@ public:
     };
 
 public:
-    PhysicsContext(physx::PxPhysics* gPhysics);
+    PhysicsContext(physx::PxPhysics* gPhysics, physx::PxCpuDispatcher* gDispatcher,
+        MeshCooker* meshCooker, const PhysicsSceneSettings& settings);
     ~PhysicsContext();
 
-    void AddTriggerEvent(TriggerEvent& event);
-    void RemoveTriggerEvent(TriggerEvent& event);
-    void RemoveTrigger(CollisionShape* shape);
+    /**
+     * @brief Drop the touching pairs and the pending events of a shape
+     * that is destroyed. Triggers it was touching get their leave event.
+     */
+    void RemoveShapeEvents(CollisionShape* shape);
 
     StaticRigidbody* NewStaticRigidbody(void* userData);
     DynamicRigidbody* NewDynamicRigidbody(void* userData);
@@ -87,31 +104,147 @@ public:
         const glm::vec3& direction, const float maxDistance,
         std::vector<Hit>& hitList, unsigned int maxHits = 1024);
 
+    /**
+     * @brief Run all queries of the batch across the job system workers
+     * and wait for their results. The scene is read locked by each job,
+     * it must not be written to until the call returns.
+     */
+    void ExecuteQueries(SceneQueryBatch& batch);
+
+    /**
+     * @brief Step the scene by the fixed step size for each step accumulated in ts.
+     * At most maxSubsteps steps run per call. Time beyond them is dropped,
+     * so the scene slows down after a hitch instead of falling further behind.
+     * In async mode, the last step keeps running after the call
+     * and its results are fetched by FetchResults. Writes to bodies
+     * are buffered by PhysX until then, reads return the last results.
+     *
+     * @return number of steps started
+     */
     int Simulate(Timestep ts) override;
+    void FetchResults() override;
+
+    /**
+     * @brief Write the interpolated poses of the moving bodies to their entities.
+     * Only the actors PhysX reported active in the last steps are moving,
+     * sleeping bodies cost nothing. A body that stops moving is written
+     * once more with its final pose.
+     */
+    void SyncTransforms() override;
+
+    /**
+     * Fraction of a step accumulated since the latest results,
+     * dynamic bodies are drawn this far between their last two poses.
+     */
+    float GetInterpolationAlpha() const {return accumulator / stepSize;}
+    float GetStepSize() const {return stepSize;}
+    const PhysicsSceneSettings& GetSettings() const {return settings;}
+    // Steps run since the context was created, or set by the last restore.
+    uint64_t GetStepCount() const {return stepCount;}
+
+    /**
+     * @brief Save the state of all dynamic bodies as the newest snapshot of the ring.
+     * Waits for the running step, the snapshot is taken between steps.
+     */
+    void SaveSnapshot(PhysicsSnapshotRing& ring);
+    /**
+     * @brief Put the dynamic bodies back in the state of a snapshot.
+     * Bodies removed since are skipped and bodies added since are left as they are.
+     * Trigger pairs are not saved, they are reported again by the next steps.
+     *
+     * @param age 0 for the newest snapshot
+     * @return false if the ring has no snapshot of that age
+     */
+    bool RestoreSnapshot(const PhysicsSnapshotRing& ring, unsigned int age = 0);
 
     void UpdatePhysicsTransform(Entity* e) override;
 
 private:
     void RemoveRigidbody(physx::PxRigidActor* actor);
+    void RemoveDynamicRigidbody(DynamicRigidbody* rigidbody);
     CollisionShape* AddCollisionShape(GeometryType geometryType);
-    void ProcessOnTriggerStayEvents();
+    // Triangle mesh for static bodies, convex hull for dynamic bodies.
+    CollisionShape* AddMeshShape(IPhysicsAssetManager* assetManager,
+        const std::string& meshPath, bool isStatic);
+    /**
+     * @brief Run the callbacks of the events reported by the steps since
+     * the last dispatch, then the stay callbacks of the touching trigger pairs.
+     * Called once per frame after the results are fetched, so that
+     * callbacks can write to the scene.
+     */
+    void DispatchEvents();
+    // Regions of the MBP broadphase, from the world bounds of the settings.
+    void AddBroadphaseRegions();
+    void AddTriggerPair(const TriggerEvent& event);
+    void RemoveTriggerPair(unsigned int index);
+    void UpdateMovingBodies();
+    void AddMovingBody(DynamicRigidbody* rigidbody);
 
     friend StaticRigidbody;
     friend DynamicRigidbody;
     friend Rigidbody;
+    friend SimulationEventCallback;
 
 private:
+    // Reported by SimulationEventCallback during fetchResults.
+    struct QueuedEvent
+    {
+        enum Type
+        {
+            TriggerEnter,
+            TriggerLeave,
+            ContactEnter,
+            ContactLeave,
+            Removed // A shape of the event was destroyed before dispatch
+        };
+
+        Type type;
+        Entity* entity;
+        CollisionShape* collisionShape; // Trigger shape of trigger events
+        Entity* otherEntity;
+        CollisionShape* otherCollisionShape;
+    };
+
+    struct ShapePairHash
+    {
+        size_t operator()(const std::pair<CollisionShape*, CollisionShape*>& pair) const
+        {
+            return std::hash<CollisionShape*>()(pair.first) ^
+                (std::hash<CollisionShape*>()(pair.second) * 31);
+        }
+    };
+
     SimulationEventCallback* simulationEventCallback;
-    physx::PxDefaultCpuDispatcher* gDispatcher;
     physx::PxScene* gScene;
+    PhysicsSceneSettings settings;
 
     float accumulator = 0.0f;
-    const float STEP_SIZE = 1.0f / 60.0f;
-
-    std::list<TriggerEvent> triggerEvents;
+    float stepSize = 1.0f / 60.0f;
+    int maxSubsteps = 4;
+    bool asyncSimulation = true;
+    bool simulating = false; // A step runs until FetchResults
+    uint64_t stepCount = 0;
+    uint32_t nextBodyId = 0;
+
+    std::unordered_map<const physx::PxActor*, DynamicRigidbody*> dynamicBodies;
+    std::vector<DynamicRigidbody*> movingBodies; // Active in the last steps
+
+    std::vector<QueuedEvent> queuedEvents;
+    // Touching trigger pairs, removed by swapping with the last one.
+    std::vector<TriggerEvent> triggerPairs;
+    std::unordered_map<std::pair<CollisionShape*, CollisionShape*>,
+        unsigned int, ShapePairHash> triggerPairIndices;
+    // Pairs of the current trigger stay callbacks, reused every step.
+    std::vector<std::pair<CollisionShape*, CollisionShape*>> triggerStayPairs;
+
+    // Touches of Raycast and Sweep, grown to the largest maxHits.
+    std::vector<physx::PxRaycastHit> raycastHits;
+    std::vector<physx::PxSweepHit> sweepHits;
 
     //Owned by physics system.
     physx::PxPhysics* gPhysics;
+    physx::PxCpuDispatcher* gDispatcher;
+    MeshCooker* meshCooker;
 };
 
 } // namespace physics
\ No newline at end of file
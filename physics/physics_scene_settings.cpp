@@ -0,0 +1,63 @@
+#include "physics_scene_settings.h"
+
+#include "serialization.h"
+
+#include <algorithm>
+
+namespace physics
+{
+
+void PhysicsSceneSettings::Serialize(Json::Value& json) const
+{
+    SerializeVec3(gravity, json["gravity"]);
+
+    json["broadphase"] = (int)broadphase;
+    SerializeVec3(worldMin, json["worldMin"]);
+    SerializeVec3(worldMax, json["worldMax"]);
+    json["regionSubdivisions"] = regionSubdivisions;
+
+    json["solver"] = (int)solver;
+    json["friction"] = (int)friction;
+    json["positionIterations"] = positionIterations;
+    json["velocityIterations"] = velocityIterations;
+
+    json["enableCCD"] = enableCCD;
+    json["enablePCM"] = enablePCM;
+    json["enableStabilization"] = enableStabilization;
+}
+
+void PhysicsSceneSettings::Deserialize(Json::Value& json)
+{
+    if (!json.isObject())
+        return;
+
+    if (json.isMember("gravity"))
+        DeserializeVec3(gravity, json["gravity"]);
+
+    broadphase = (BroadphaseType)json.get("broadphase", (int)broadphase).asInt();
+    if (json.isMember("worldMin"))
+        DeserializeVec3(worldMin, json["worldMin"]);
+    if (json.isMember("worldMax"))
+        DeserializeVec3(worldMax, json["worldMax"]);
+    regionSubdivisions =
+        json.get("regionSubdivisions", regionSubdivisions).asUInt();
+
+    solver = (SolverType)json.get("solver", (int)solver).asInt();
+    friction = (FrictionType)json.get("friction", (int)friction).asInt();
+    positionIterations =
+        json.get("positionIterations", positionIterations).asUInt();
+    velocityIterations =
+        json.get("velocityIterations", velocityIterations).asUInt();
+
+    enableCCD = json.get("enableCCD", enableCCD).asBool();
+    enablePCM = json.get("enablePCM", enablePCM).asBool();
+    enableStabilization =
+        json.get("enableStabilization", enableStabilization).asBool();
+
+    // PhysX limits: 256 broadphase regions, 1 to 255 solver iterations.
+    regionSubdivisions = std::clamp(regionSubdivisions, 1u, 16u);
+    positionIterations = std::clamp(positionIterations, 1u, 255u);
+    velocityIterations = std::clamp(velocityIterations, 1u, 255u);
+}
+
+} // namespace physics
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <json/json.h>
+#include <glm/vec3.hpp>
+
+// Key of the physics settings in the settings of a scene.
+#define PHYSICS_SCENE_SETTINGS "physics"
+
+namespace physics
+{
+
+/**
+ * @brief Simulation settings of one scene, saved with the scene.
+ * They are read when the context of the scene is created,
+ * so edits apply the next time the scene is loaded or started.
+ * Solver, friction, iteration and contact defaults are the PhysX ones.
+ * The broadphase defaults to ABP on purpose instead of the PABP of PhysX:
+ * it runs on the CPU like the rest of the scene and needs no world bounds.
+ */
+struct PhysicsSceneSettings
+{
+    enum class BroadphaseType
+    {
+        SAP,    // Sweep and prune, good for few moving bodies
+        MBP,    // Multi box pruning, needs world bounds split in regions
+        ABP     // Automatic box pruning, no bounds needed
+    };
+
+    enum class SolverType
+    {
+        PGS,    // Projected Gauss-Seidel
+        TGS     // Temporal Gauss-Seidel, converges faster on stacks and joints
+    };
+
+    enum class FrictionType
+    {
+        Patch,
+        OneDirectional,
+        TwoDirectional
+    };
+
+    glm::vec3 gravity = {0.0f, -9.81f, 0.0f};
+
+    BroadphaseType broadphase = BroadphaseType::ABP;
+    // MBP regions, the bounds are split in subdivisions x subdivisions
+    // regions on the ground plane. Bodies outside of them do not collide.
+    glm::vec3 worldMin = {-1000.0f, -1000.0f, -1000.0f};
+    glm::vec3 worldMax = { 1000.0f,  1000.0f,  1000.0f};
+    unsigned int regionSubdivisions = 4;
+
+    SolverType solver = SolverType::PGS;
+    FrictionType friction = FrictionType::Patch;
+    // Of each new dynamic body
+    unsigned int positionIterations = 4;
+    unsigned int velocityIterations = 1;
+
+    bool enableCCD = false;             // Continuous collision on all dynamic bodies
+    bool enablePCM = true;              // Persistent contact manifolds
+    bool enableStabilization = false;   // Extra damping of resting stacks
+
+    void Serialize(Json::Value& json) const;
+    // Missing values keep their defaults.
+    void Deserialize(Json::Value& json);
+};
+
+} // namespace physics
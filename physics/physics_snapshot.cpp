@@ -0,0 +1,37 @@
+#include "physics_snapshot.h"
+
+#include "validation.h"
+
+namespace physics
+{
+
+PhysicsSnapshotRing::PhysicsSnapshotRing(unsigned int capacity):
+    snapshots(capacity > 0? capacity: 1)
+{
+}
+
+void PhysicsSnapshotRing::Clear()
+{
+    newest = 0;
+    count = 0;
+}
+
+PhysicsSnapshotRing::Snapshot& PhysicsSnapshotRing::Push()
+{
+    if (count > 0)
+        newest = (newest + 1) % snapshots.size();
+    if (count < snapshots.size())
+        count++;
+
+    Snapshot& snapshot = snapshots[newest];
+    snapshot.bodies.clear();
+    return snapshot;
+}
+
+const PhysicsSnapshotRing::Snapshot& PhysicsSnapshotRing::Get(unsigned int age) const
+{
+    ASSERT(age < count);
+    return snapshots[(newest + snapshots.size() - age) % snapshots.size()];
+}
+
+} // namespace physics
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <PxPhysicsAPI.h>
+
+#include <cstdint>
+#include <vector>
+
+// Flags of BodySnapshot
+#define BODY_SNAPSHOT_SLEEPING      0x1
+#define BODY_SNAPSHOT_KINEMATIC     0x2
+#define BODY_SNAPSHOT_HAS_TARGET    0x4 // Kinematic target set for the next step
+
+namespace physics
+{
+
+class PhysicsContext;
+
+/**
+ * @brief State of one dynamic body, everything a step reads from it.
+ * The body is found again by its actor, the id tells apart
+ * a body created later at the same address.
+ */
+struct BodySnapshot
+{
+    const physx::PxActor* actor;
+    uint32_t bodyId;
+    uint32_t flags;
+    physx::PxTransform pose;
+    physx::PxTransform kinematicTarget;
+    physx::PxVec3 linearVelocity;
+    physx::PxVec3 angularVelocity;
+};
+
+/**
+ * @brief Last snapshots of the dynamic bodies of a context.
+ *
+ * Saved by PhysicsContext::SaveSnapshot and put back by
+ * PhysicsContext::RestoreSnapshot, for restarts, rewinds and replays
+ * that do not deserialize the scene again. Static bodies do not move
+ * and are not saved. When the ring is full, a new snapshot replaces
+ * the oldest one and reuses its storage, so recording every step
+ * stops allocating once the ring has wrapped.
+ */
+class PhysicsSnapshotRing
+{
+public:
+    PhysicsSnapshotRing(unsigned int capacity);
+
+    void Clear();
+
+    unsigned int GetCapacity() const {return snapshots.size();}
+    unsigned int GetCount() const {return count;}
+
+    /**
+     * @param age 0 for the newest snapshot, must be less than GetCount
+     * @return step count of the context when the snapshot was saved
+     */
+    uint64_t GetStep(unsigned int age) const {return Get(age).step;}
+
+    friend PhysicsContext;
+
+private:
+    struct Snapshot
+    {
+        uint64_t step;
+        float accumulator;
+        std::vector<BodySnapshot> bodies;
+    };
+
+    // Oldest snapshot becomes the newest, its bodies are cleared.
+    Snapshot& Push();
+    const Snapshot& Get(unsigned int age) const;
+
+private:
+    std::vector<Snapshot> snapshots;
+    unsigned int newest = 0;
+    unsigned int count = 0;
+};
+
+} // namespace physics
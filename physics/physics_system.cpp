@@ -1,10 +1,19 @@
 #include "physics_system.h"
 
 #include "physics_context.h"
+#include "job_dispatcher.h"
+#include "mesh_cooker.h"
 #include "components/dynamic_body_component.h"
 #include "components/static_body_component.h"
 
 #include "component.h"
+#include "configuration.h"
+#include "job_system.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
 
 /**
  * PhysX is version 0x05010300 on Windows, 0x05010200 on Mac.
@@ -38,6 +47,19 @@ PhysicsSystem::PhysicsSystem()
         physx::PxTolerancesScale(), true, gPvd
     );
 
+    uint32_t workerCount = JobSystem::GetInstance().GetWorkerCount();
+    std::string value;
+    if (Configuration::Get(CONFIG_PHYSICS_WORKERS, value))
+        workerCount = static_cast<uint32_t>(std::max(1, std::atoi(value.c_str())));
+    gDispatcher = new JobDispatcher(workerCount);
+    meshCooker = new MeshCooker(gFoundation, gPhysics);
+
+    Logger::Write(
+        "[Physics] PhysX scenes share " +
+        std::to_string(gDispatcher->getWorkerCount()) + " workers",
+        Logger::Level::Info, Logger::MsgType::Physics
+    );
+
     ComponentLocator::SetInitializer(Component::Type::DynamicBody,
         DynamicBodyInitializer(this));
     ComponentLocator::SetDeserializer(Component::Type::DynamicBody,
@@ -50,6 +72,10 @@ PhysicsSystem::PhysicsSystem()
 
 PhysicsSystem::~PhysicsSystem()
 {
+    delete meshCooker;
+    meshCooker = nullptr;
+    delete gDispatcher;
+    gDispatcher = nullptr;
     PX_RELEASE(gPhysics);
     if(gPvd)
 	{
@@ -61,9 +87,14 @@ PhysicsSystem::~PhysicsSystem()
 	PX_RELEASE(gFoundation);
 }
 
-PhysicsContext* PhysicsSystem::NewContext()
+PhysicsContext* PhysicsSystem::NewContext(const PhysicsSceneSettings& settings)
+{
+    return new PhysicsContext(gPhysics, gDispatcher, meshCooker, settings);
+}
+
+uint32_t PhysicsSystem::GetWorkerCount() const
 {
-    return new PhysicsContext(gPhysics);
+    return gDispatcher->getWorkerCount();
 }
 
 
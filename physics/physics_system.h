@@ -2,10 +2,14 @@
 
 #include <PxPhysicsAPI.h>
 
+#include "physics_scene_settings.h"
+
 namespace physics
 {
 
 class PhysicsContext;
+class JobDispatcher;
+class MeshCooker;
 
 class PhysicsSystem
 {
@@ -14,12 +18,19 @@ public:
 
     ~PhysicsSystem();
 
-    PhysicsContext* NewContext();
+    PhysicsContext* NewContext(
+        const PhysicsSceneSettings& settings = PhysicsSceneSettings());
+
+    // PhysX workers shared by the contexts, after capping
+    // the configured count to the job system workers.
+    uint32_t GetWorkerCount() const;
 
 private:
     physx::PxFoundation* gFoundation;
     physx::PxPvd*        gPvd;
     physx::PxPhysics*    gPhysics;
+    JobDispatcher*       gDispatcher; // Shared by all contexts
+    MeshCooker*          meshCooker;  // Shared by all contexts
 
     physx::PxDefaultAllocator		gAllocator{};
     physx::PxDefaultErrorCallback	gErrorCallback{};
@@ -63,18 +63,23 @@ void Rigidbody::SetGlobalTransform(const glm::mat4& transform)
     gRigidActor->setGlobalPose(pose);
 }
 
+void Rigidbody::AddShape(CollisionShape* collisionShape)
+{
+    collisionShape->rigidbody = this;
+    collisionShape->gShape->userData = collisionShape;
+    gRigidActor->attachShape(*(collisionShape->gShape));
+    collisionShapeList.push_back(collisionShape);
+
+    UpdateCenterOfMass();
+}
+
 CollisionShape* Rigidbody::AttachShape(GeometryType geometryType)
 {
     CollisionShape* collisionShape =
         context->AddCollisionShape(geometryType);
     if (collisionShape)
     {
-        collisionShape->rigidbody = this;
-        collisionShape->gShape->userData = collisionShape;
-        gRigidActor->attachShape(*(collisionShape->gShape));
-        collisionShapeList.push_back(collisionShape);
-
-        UpdateCenterOfMass();
+        AddShape(collisionShape);
     }
     else
     {
@@ -87,6 +92,27 @@ CollisionShape* Rigidbody::AttachShape(GeometryType geometryType)
     return collisionShape;
 }
 
+CollisionShape* Rigidbody::AttachMeshShape(
+    IPhysicsAssetManager* assetManager, const std::string& meshPath)
+{
+    CollisionShape* collisionShape = context->AddMeshShape(
+        assetManager, meshPath,
+        GetRigidbodyType() == physx::PxActorType::eRIGID_STATIC);
+    if (collisionShape)
+    {
+        AddShape(collisionShape);
+    }
+    else
+    {
+        Logger::Write(
+            "[Physics] Mesh " + meshPath + " cannot be used as a collision shape.",
+            Logger::Level::Warning, Logger::MsgType::Physics
+        );
+    }
+
+    return collisionShape;
+}
+
 void Rigidbody::DetachShape(CollisionShape* shape)
 {
     bool found = false;
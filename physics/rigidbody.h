@@ -12,6 +12,7 @@ namespace physics
 
 class PhysicsContext;
 class CollisionShape;
+class IPhysicsAssetManager;
 
 typedef physx::PxActorType::Enum RigidbodyType;
 
@@ -34,14 +35,27 @@ public:
     }
 
     void GetGlobalTransform(glm::mat4& transform) const;
-    void SetGlobalTransform(const glm::mat4& transform);
+    virtual void SetGlobalTransform(const glm::mat4& transform);
 
     CollisionShape* AttachShape(GeometryType geometryType);
+
+    /**
+     * @brief Attach a shape cooked from a mesh asset. Static bodies get
+     * a triangle mesh and dynamic bodies get the convex hull of the mesh.
+     *
+     * @param meshPath Path of the mesh relative to workspace directory.
+     */
+    CollisionShape* AttachMeshShape(
+        IPhysicsAssetManager* assetManager, const std::string& meshPath);
+
     void DetachShape(CollisionShape* shape);
     CollisionShape* GetShape(unsigned int index) const;
     unsigned int GetNbShapes() const;
     unsigned int GetShapes(std::vector<CollisionShape*>& shapes) const;
 
+private:
+    void AddShape(CollisionShape* collisionShape);
+
 protected:
     std::vector<CollisionShape*> collisionShapeList;
     PhysicsContext* context; // Owned by scene
@@ -0,0 +1,205 @@
+#include "scene_query_batch.h"
+
+#include "collision_shape.h"
+#include "math_library.h"
+
+#include "entity.h"
+
+namespace physics
+{
+
+static physx::PxTransform ToPose(const glm::mat4& transform)
+{
+    glm::vec3 _0, _1;
+    glm::quat rotation;
+    glm::vec3 translate;
+    glm::vec4 _2;
+    glm::decompose(
+        transform, _0, rotation,
+        translate, _1, _2
+    );
+
+    return physx::PxTransform(
+        physx::PxVec3(translate.x, translate.y, translate.z),
+        physx::PxQuat(rotation.x, rotation.y, rotation.z, rotation.w)
+    );
+}
+
+static physx::PxVec3 ToDirection(const glm::vec3& direction)
+{
+    const glm::vec3 normDir = glm::normalize(direction);
+    return physx::PxVec3(normDir.x, normDir.y, normDir.z);
+}
+
+static void WriteHit(const physx::PxLocationHit& gHit, PhysicsContext::Hit& hit)
+{
+    hit.hasHit = true;
+    hit.position = glm::vec3(gHit.position.x, gHit.position.y, gHit.position.z);
+    hit.normal = glm::vec3(gHit.normal.x, gHit.normal.y, gHit.normal.z);
+    hit.distance = glm::vec3(gHit.distance);
+    hit.collisionShape = static_cast<CollisionShape*>(gHit.shape->userData);
+    hit.entity = static_cast<Entity*>(gHit.actor->userData);
+}
+
+static void WriteHit(const physx::PxOverlapHit& gHit, PhysicsContext::Hit& hit)
+{
+    hit.hasHit = true;
+    hit.position = glm::vec3(0.0f);
+    hit.normal = glm::vec3(0.0f);
+    hit.distance = glm::vec3(0.0f);
+    hit.collisionShape = static_cast<CollisionShape*>(gHit.shape->userData);
+    hit.entity = static_cast<Entity*>(gHit.actor->userData);
+}
+
+SceneQueryBatch::SceneQueryBatch(unsigned int maxHitsPerQuery):
+    maxHitsPerQuery(maxHitsPerQuery > 0? maxHitsPerQuery: 1)
+{
+}
+
+void SceneQueryBatch::Clear()
+{
+    queries.clear();
+    hitCounts.clear();
+}
+
+void SceneQueryBatch::Reserve(unsigned int queryCount)
+{
+    queries.reserve(queryCount);
+    hitCounts.reserve(queryCount);
+    hits.reserve(queryCount * maxHitsPerQuery);
+}
+
+unsigned int SceneQueryBatch::AddRaycast(
+    const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+{
+    Query query;
+    query.type = QueryType::Raycast;
+    query.pose = physx::PxTransform(physx::PxVec3(origin.x, origin.y, origin.z));
+    query.direction = ToDirection(direction);
+    query.maxDistance = maxDistance;
+
+    queries.push_back(query);
+    return queries.size() - 1;
+}
+
+unsigned int SceneQueryBatch::AddSweep(
+    const Geometry& geometry, const glm::mat4& transform,
+    const glm::vec3& direction, float maxDistance)
+{
+    Query query;
+    query.type = QueryType::Sweep;
+    query.geometry.storeAny(geometry);
+    query.pose = ToPose(transform);
+    query.direction = ToDirection(direction);
+    query.maxDistance = maxDistance;
+
+    queries.push_back(query);
+    return queries.size() - 1;
+}
+
+unsigned int SceneQueryBatch::AddOverlap(
+    const Geometry& geometry, const glm::mat4& transform)
+{
+    Query query;
+    query.type = QueryType::Overlap;
+    query.geometry.storeAny(geometry);
+    query.pose = ToPose(transform);
+    query.direction = physx::PxVec3(0.0f);
+    query.maxDistance = 0.0f;
+
+    queries.push_back(query);
+    return queries.size() - 1;
+}
+
+void SceneQueryBatch::PrepareResults()
+{
+    const unsigned int hitCapacity = queries.size() * maxHitsPerQuery;
+    hitCounts.resize(queries.size());
+    if (hits.size() < hitCapacity)
+        hits.resize(hitCapacity);
+
+    // Overlaps have no closest hit, they always need a touch buffer.
+    unsigned int counts[3] = {0, 0, 0};
+    for (const Query& query: queries)
+        counts[static_cast<int>(query.type)]++;
+
+    if (maxHitsPerQuery > 1 && counts[0] > 0 && raycastHits.size() < hitCapacity)
+        raycastHits.resize(hitCapacity);
+    if (maxHitsPerQuery > 1 && counts[1] > 0 && sweepHits.size() < hitCapacity)
+        sweepHits.resize(hitCapacity);
+    if (counts[2] > 0 && overlapHits.size() < hitCapacity)
+        overlapHits.resize(hitCapacity);
+}
+
+unsigned int SceneQueryBatch::Execute(physx::PxScene* scene, unsigned int index)
+{
+    const Query& query = queries[index];
+    PhysicsContext::Hit* results = &hits[index * maxHitsPerQuery];
+
+    // Hits only touch with several per query, so that none of them stops the others.
+    const physx::PxQueryFilterData anyHits(
+        physx::PxQueryFlag::eSTATIC | physx::PxQueryFlag::eDYNAMIC |
+        physx::PxQueryFlag::eNO_BLOCK);
+
+    switch (query.type)
+    {
+    case QueryType::Raycast:
+    {
+        if (maxHitsPerQuery == 1)
+        {
+            physx::PxRaycastBuffer gHit;
+            scene->raycast(query.pose.p, query.direction, query.maxDistance, gHit);
+            if (!gHit.hasBlock)
+                return 0;
+
+            WriteHit(gHit.block, results[0]);
+            return 1;
+        }
+
+        physx::PxRaycastBuffer gHits(
+            &raycastHits[index * maxHitsPerQuery], maxHitsPerQuery);
+        scene->raycast(query.pose.p, query.direction, query.maxDistance, gHits,
+            physx::PxHitFlag::eDEFAULT, anyHits);
+        for (physx::PxU32 i = 0; i < gHits.nbTouches; i++)
+            WriteHit(gHits.touches[i], results[i]);
+        return gHits.nbTouches;
+    }
+
+    case QueryType::Sweep:
+    {
+        if (maxHitsPerQuery == 1)
+        {
+            physx::PxSweepBuffer gHit;
+            scene->sweep(query.geometry.any(), query.pose, query.direction,
+                query.maxDistance, gHit);
+            if (!gHit.hasBlock)
+                return 0;
+
+            WriteHit(gHit.block, results[0]);
+            return 1;
+        }
+
+        physx::PxSweepBuffer gHits(
+            &sweepHits[index * maxHitsPerQuery], maxHitsPerQuery);
+        scene->sweep(query.geometry.any(), query.pose, query.direction,
+            query.maxDistance, gHits, physx::PxHitFlag::eDEFAULT, anyHits);
+        for (physx::PxU32 i = 0; i < gHits.nbTouches; i++)
+            WriteHit(gHits.touches[i], results[i]);
+        return gHits.nbTouches;
+    }
+
+    case QueryType::Overlap:
+    {
+        physx::PxOverlapBuffer gHits(
+            &overlapHits[index * maxHitsPerQuery], maxHitsPerQuery);
+        scene->overlap(query.geometry.any(), query.pose, gHits, anyHits);
+        for (physx::PxU32 i = 0; i < gHits.nbTouches; i++)
+            WriteHit(gHits.touches[i], results[i]);
+        return gHits.nbTouches;
+    }
+    }
+
+    return 0;
+}
+
+} // namespace physics
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "physics_context.h"
+
+#include <PxPhysicsAPI.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+// Queries run by one job of PhysicsContext::ExecuteQueries.
+#define SCENE_QUERY_JOB_SIZE 32
+
+namespace physics
+{
+
+/**
+ * @brief Raycasts, sweeps and overlaps run together by PhysicsContext::ExecuteQueries.
+ *
+ * Queries are split across the job system workers. Each query owns
+ * maxHitsPerQuery entries of a flat hit buffer. With one hit per query,
+ * raycasts and sweeps keep the closest hit; with more, they keep any
+ * hits in no particular order. Overlaps always keep any hits.
+ * Buffers only grow, so a batch that is cleared and refilled
+ * every frame stops allocating once it has seen its largest frame.
+ */
+class SceneQueryBatch
+{
+public:
+    SceneQueryBatch(unsigned int maxHitsPerQuery = 1);
+
+    /**
+     * Remove all queries and their results, buffers are kept.
+     */
+    void Clear();
+    void Reserve(unsigned int queryCount);
+
+    /**
+     * @return index of the query in the batch
+     */
+    unsigned int AddRaycast(
+        const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
+    unsigned int AddSweep(
+        const Geometry& geometry, const glm::mat4& transform,
+        const glm::vec3& direction, float maxDistance);
+    unsigned int AddOverlap(const Geometry& geometry, const glm::mat4& transform);
+
+    unsigned int GetQueryCount() const {return queries.size();}
+    unsigned int GetMaxHitsPerQuery() const {return maxHitsPerQuery;}
+
+    /**
+     * Results of the last ExecuteQueries, hits of a query are in [0, GetHitCount).
+     */
+    unsigned int GetHitCount(unsigned int query) const {return hitCounts[query];}
+    const PhysicsContext::Hit& GetHit(unsigned int query, unsigned int hit = 0) const
+    {
+        return hits[query * maxHitsPerQuery + hit];
+    }
+
+    friend PhysicsContext;
+
+private:
+    enum class QueryType
+    {
+        Raycast,
+        Sweep,
+        Overlap
+    };
+
+    struct Query
+    {
+        QueryType type;
+        physx::PxGeometryHolder geometry;
+        physx::PxTransform pose;        // Origin of raycasts
+        physx::PxVec3 direction;
+        float maxDistance;
+    };
+
+    /**
+     * Run one query against a scene that is read locked by the caller.
+     *
+     * @return number of hits written
+     */
+    unsigned int Execute(physx::PxScene* scene, unsigned int query);
+
+    // Size the results for the queries, called before they are executed.
+    void PrepareResults();
+
+private:
+    unsigned int maxHitsPerQuery;
+    std::vector<Query> queries;
+
+    std::vector<PhysicsContext::Hit> hits;  // maxHitsPerQuery per query
+    std::vector<unsigned int> hitCounts;
+
+    // PhysX hits of queries with more than one hit, same layout as hits.
+    std::vector<physx::PxRaycastHit> raycastHits;
+    std::vector<physx::PxSweepHit> sweepHits;
+    std::vector<physx::PxOverlapHit> overlapHits;
+};
+
+} // namespace physics
@@ -0,0 +1,63 @@
+#include <cmath>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "physics_system.h"
+#include "dynamic_rigidbody.h"
+#include "components/dynamic_body_component.h"
+#include "configuration.h"
+#include "entity.h"
+#include "scene.h"
+
+/**
+ * A kinematic body moved by a script every frame, as a scene would.
+ * The entity must keep the transform the script gave it
+ * after Scene::Update, physics does not write it back.
+ */
+
+#define FRAME_COUNT 120
+
+int main(int, char**)
+{
+    Configuration::Set(CONFIG_PHYSICS_ASYNC, "false");
+
+    physics::PhysicsSystem* system = new physics::PhysicsSystem();
+    Scene* scene = Scene::NewScene("kinematic", nullptr);
+
+    Entity* entity = scene->NewEntity();
+    physics::DynamicBodyComponent* component =
+        static_cast<physics::DynamicBodyComponent*>(
+            entity->AddComponent(Component::Type::DynamicBody));
+    component->dynamicBody->AttachShape(physx::PxGeometryType::eBOX);
+    component->dynamicBody->SetKinematic(true);
+
+    bool passed = true;
+    glm::vec3 position(0.0f);
+    const float step = 1.0f / 60.0f;
+    for (uint32_t i = 0; i < FRAME_COUNT; i++)
+    {
+        // Incremental moves, like a script adding a velocity
+        position += glm::vec3(0.05f, 0.0f, 0.02f);
+        entity->SetLocalTransform(glm::translate(glm::mat4(1.0f), position));
+
+        scene->Update(step);
+
+        glm::vec3 actual = glm::vec3(entity->GetGlobalTransform()[3]);
+        if (glm::length(actual - position) > 1e-4f)
+        {
+            std::cout << "frame " << i << ": entity at (" << actual.x << ", "
+                << actual.y << ", " << actual.z << "), script put it at ("
+                << position.x << ", " << position.y << ", " << position.z
+                << ")" << std::endl;
+            passed = false;
+            break;
+        }
+    }
+
+    delete scene;
+    delete system;
+
+    std::cout << (passed? "passed": "failed") << std::endl;
+    return passed? 0: 1;
+}
@@ -8,6 +8,8 @@
 #include "math_library.h"
 
 #include <vector>
+#include <algorithm>
+#include <string>
 #include <tracy/Tracy.hpp>
 
 static XrResult result;
@@ -364,19 +366,9 @@ void OpenxrSession::BeginFrame()
             return;
         }
 
-        {   // Locate eyes
-            XrViewLocateInfo locateInfo {XR_TYPE_VIEW_LOCATE_INFO};
-            locateInfo.viewConfigurationType = 
-                XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
-            locateInfo.displayTime = frameState.predictedDisplayTime;
-            locateInfo.space = localSpace;
-
-            XrViewState viewState{XR_TYPE_VIEW_STATE};
-            views[0] = {XR_TYPE_VIEW};
-            views[1] = {XR_TYPE_VIEW};
-            uint32_t count;
-            CHK_XRCMD(xrLocateViews(
-                xrSession, &locateInfo, &viewState, 2, &count, views));
+        {   // Locate eyes, the renderer can late latch them again
+            LocateViews();
+            frameLocateTime = poseLocateTime;
 
             Input* input = Input::GetInstance();
             
@@ -485,6 +477,34 @@ void OpenxrSession::EndFrame()
         const XrCompositionLayerBaseHeader* pLayer =
             reinterpret_cast<XrCompositionLayerBaseHeader*>(&layer);
 
+        if (ShouldRender())
+        {   // Age of the submitted poses, late latching shortens it.
+            std::chrono::steady_clock::time_point now =
+                std::chrono::steady_clock::now();
+            float poseAge = std::chrono::duration<float, std::milli>(
+                now - poseLocateTime).count();
+            float frameAge = std::chrono::duration<float, std::milli>(
+                now - frameLocateTime).count();
+            TracyPlot("XR pose age (ms)", poseAge);
+
+            poseAgeSum += poseAge;
+            poseAgeMax = std::max(poseAgeMax, poseAge);
+            frameAgeSum += frameAge;
+            if (++poseAgeFrames == XR_POSE_AGE_LOG_FRAMES)
+            {
+                Logger::Write(
+                    "[OpenXR] Pose age at submit: average " +
+                    std::to_string(poseAgeSum / poseAgeFrames) + " ms, max " +
+                    std::to_string(poseAgeMax) + " ms, " +
+                    std::to_string(frameAgeSum / poseAgeFrames) +
+                    " ms since xrWaitFrame poses.",
+                    Logger::Level::Info, Logger::MsgType::Platform
+                );
+                poseAgeSum = poseAgeMax = frameAgeSum = 0.0f;
+                poseAgeFrames = 0;
+            }
+        }
+
         XrFrameEndInfo frameEndInfo {XR_TYPE_FRAME_END_INFO};
         frameEndInfo.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
         frameEndInfo.displayTime = frameState.predictedDisplayTime;
@@ -501,6 +521,49 @@ void OpenxrSession::EndFrame()
     }
 }
 
+bool OpenxrSession::LocateViews()
+{
+    ZoneScopedN("OpenxrSession::LocateViews");
+
+    XrViewLocateInfo locateInfo {XR_TYPE_VIEW_LOCATE_INFO};
+    locateInfo.viewConfigurationType = 
+        XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+    locateInfo.displayTime = frameState.predictedDisplayTime;
+    locateInfo.space = localSpace;
+
+    XrViewState viewState{XR_TYPE_VIEW_STATE};
+    XrView located[2] = {{XR_TYPE_VIEW}, {XR_TYPE_VIEW}};
+    uint32_t count = 0;
+    CHK_XRCMD(result = xrLocateViews(
+        xrSession, &locateInfo, &viewState, 2, &count, located));
+
+    // Keep the last poses if tracking is lost.
+    if (XR_FAILED(result) || count != 2 ||
+        !(viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT))
+        return false;
+
+    views[0] = located[0];
+    views[1] = located[1];
+    poseLocateTime = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool OpenxrSession::LateLatchViews(EyeView eyeViews[2])
+{
+    ZoneScopedN("OpenxrSession::LateLatchViews");
+
+    if (!ShouldRender() || !LocateViews())
+        return false;
+
+    for (int i = 0; i < 2; i++)
+    {
+        eyeViews[i].fov = *reinterpret_cast<glm::vec4*>(&views[i].fov);
+        eyeViews[i].quat = *reinterpret_cast<glm::vec4*>(&views[i].pose.orientation);
+        eyeViews[i].pos = *reinterpret_cast<glm::vec3*>(&views[i].pose.position);
+    }
+    return true;
+}
+
 uint32_t OpenxrSession::GetNextImageIndex(VulkanDevice* vulkanDevice,
     VkSemaphore imageAcquiredSemaphores)
 {
@@ -579,6 +642,12 @@ uint32_t OpenxrSession::GetHeight()
     return imageHeight;
 }
 
+float OpenxrSession::GetDisplayPeriod()
+{
+    // Predicted by the runtime in xrWaitFrame, in nanoseconds.
+    return static_cast<float>(frameState.predictedDisplayPeriod) * 1e-9f;
+}
+
 VkImage OpenxrSession::GetImage(int index)
 {
     return images[index];
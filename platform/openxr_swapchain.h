@@ -10,6 +10,10 @@
 #include <openxr/openxr_platform.h>
 
 #include <vector>
+#include <chrono>
+
+// Frames between two pose age reports in the log
+#define XR_POSE_AGE_LOG_FRAMES  600
 
 
 class OpenxrPlatform;
@@ -57,6 +61,8 @@ public:
     void PresentImage(VulkanDevice* vulkanDevice,
         VkSemaphore renderFinishedSemaphores, uint32_t imageIndex) override;
     bool ShouldRender() override;
+    float GetDisplayPeriod() override;
+    bool LateLatchViews(EyeView views[2]) override;
 
     void RebuildSwapchain(VulkanDevice* vulkanDevice) override;
 
@@ -66,6 +72,7 @@ private:
     void InitializeSpaces();
     bool SelectImageFormat(VkFormat format);
     void PrintErrorMsg(XrResult result);
+    bool LocateViews();
 
 private:    
     OpenxrPlatform* platform = nullptr;
@@ -104,4 +111,12 @@ private:
     XrCompositionLayerProjectionView layerViews[2]; 
     XrView views[2];
     int eye;
+
+    // Pose age instrumentation, from locating the views to xrEndFrame
+    std::chrono::steady_clock::time_point frameLocateTime{}; // In BeginFrame
+    std::chrono::steady_clock::time_point poseLocateTime{};  // Poses submitted
+    float poseAgeSum = 0.0f;
+    float poseAgeMax = 0.0f;
+    float frameAgeSum = 0.0f;
+    uint32_t poseAgeFrames = 0;
 };
\ No newline at end of file
@@ -68,6 +68,8 @@ Component* CameraDeserializer::operator()(Entity* entity, Json::Value& json)
 
     CameraProperties prop{};
     prop.UseFrameExtent = false;
+    if (json.isMember("depthPrepass"))
+        prop.DepthPrepass = json["depthPrepass"].asBool();
     component->camera = VulkanCamera::BuildCamera(prop);
 
     AddRenderContext(entity, technique, vulkanDevice, linePipelineLayout);
@@ -83,8 +85,8 @@ void CameraComponent::Update(Timestep ts)
 
 void CameraComponent::Serialize(Json::Value& json)
 {
-    json["nothing"] = "nothing";
-    // TODO: for now, it does not support changing parameters of the camera
+    json["depthPrepass"] = camera->IsDepthPrepass();
+    // TODO: for now, it does not support changing other parameters of the camera
 }
 
 CameraComponent::~CameraComponent()
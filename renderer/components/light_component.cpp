@@ -32,8 +32,17 @@ Component* LightDeserializer::operator()(Entity* entity, Json::Value& json)
 
     glm::vec4 color;
     DeserializeVec4(color, json["color"]);
-    component->properties.type = DIRECTIONAL_LIGHT;
     component->properties.color = color;
+
+    // Scenes saved before point and spot lights only have directional lights.
+    component->properties.type = json["type"].isNull()?
+        DIRECTIONAL_LIGHT: static_cast<LightType>(json["type"].asInt());
+    if (!json["range"].isNull())
+    {
+        component->properties.range = json["range"].asFloat();
+        component->properties.innerConeAngle = json["innerConeAngle"].asFloat();
+        component->properties.outerConeAngle = json["outerConeAngle"].asFloat();
+    }
     component->light = VulkanLight::BuildLight(component->properties);
 
     return component;
@@ -41,9 +50,9 @@ Component* LightDeserializer::operator()(Entity* entity, Json::Value& json)
 
 void LightComponent::Update(Timestep ts)
 {
+    light->SetLightProperties(properties);
     light->SetTransform(entity->GetGlobalTransform());
-    light->dirLight.color = glm::vec4(properties.color, 1.0f);
-    technique->PushRendererData(light->dirLight);
+    technique->PushRendererData(light->lightData);
 
     Scene* scene = entity->GetScene();
     std::shared_ptr<SceneContext> ctx;
@@ -56,7 +65,11 @@ void LightComponent::Update(Timestep ts)
 
 void LightComponent::Serialize(Json::Value& json)
 {
-    SerializeVec4(light->dirLight.color, json["color"]);
+    SerializeVec4(light->lightData.color, json["color"]);
+    json["type"] = static_cast<int>(properties.type);
+    json["range"] = properties.range;
+    json["innerConeAngle"] = properties.innerConeAngle;
+    json["outerConeAngle"] = properties.outerConeAngle;
 }
 
 LightComponent::~LightComponent()
@@ -79,8 +79,18 @@ void MeshComponent::Update(Timestep ts)
     if (!mesh)
         return;
 
-    *transform = entity->GetGlobalTransform();
-    RenderTechnique::MeshPacket packet{mesh, descSet};
+    // Only moved entities write their transform, static ones cost no upload.
+    const glm::mat4& globalTransform = entity->GetGlobalTransform();
+    if (!transformWritten || globalTransform != lastTransform)
+    {
+        *transform = globalTransform;
+        lastTransform = globalTransform;
+        transformWritten = true;
+        instance.moved = true;
+    }
+
+    RenderTechnique::MeshPacket packet{
+        mesh, descSet, globalTransform, &instance};
 
     technique->PushRendererData(packet);
 }
@@ -93,6 +103,8 @@ void MeshComponent::Serialize(Json::Value& json)
 MeshComponent::~MeshComponent()
 {
     vkDeviceWaitIdle(vulkanDevice->vkDevice);
+    if (instance.slot != GPU_INSTANCE_NONE)
+        VulkanRenderer::GetInstance().GetCulling().RemoveInstance(instance.slot);
     uniform.Destroy();
     vulkanDevice = nullptr;
     transform = nullptr;
@@ -45,6 +45,9 @@ struct MeshComponent: public Component
     VkDescriptorSet descSet = VK_NULL_HANDLE;
     VulkanDevice* vulkanDevice = nullptr;
     glm::mat4* transform = nullptr;
+    glm::mat4 lastTransform{1.0f}; // Last written to the uniform
+    bool transformWritten = false;
+    RenderTechnique::MeshInstance instance;
 
     void Update(Timestep ts) override;
     void Serialize(Json::Value& json) override;
@@ -43,38 +43,17 @@ void VrDisplayComponent::Update(Timestep ts)
     if (state == Scene::State::Editor)
     {
         std::shared_ptr<VulkanCamera> camera =
-            vrDisplay->GetLeftCamera();
+            vrDisplay->GetPreviewCamera();
 
         ASSERT(camera != nullptr);
 
-        camera->SetTransform(entity->GetGlobalTransform());
+        for (uint32_t i = 0; i < camera->GetViewCount(); i++)
+            camera->SetTransform(entity->GetGlobalTransform(), i);
         technique->PushRendererData(camera);
     }
     else if (state == Scene::State::RunningVR)
     {
-        std::shared_ptr<VulkanVrDisplay> vkCamera = this->vrDisplay;
-
         Input* input = Input::GetInstance();
-        std::shared_ptr<VulkanCamera> cameraL =
-            vrDisplay->GetLeftCamera();
-        std::shared_ptr<VulkanCamera> cameraR =
-            vrDisplay->GetRightCamera();
-        
-        ASSERT(cameraL != nullptr);
-        ASSERT(cameraR != nullptr);
-
-        const renderer::CameraProperties& propL = cameraL->GetCamProperties();
-        const renderer::CameraProperties& propR = cameraR->GetCamProperties();
-
-        {   // project matrices of the left eye
-            glm::vec4 xrFoV = input->xr_left_eye_fov;
-            cameraL->SetProjection(xrFoV, propL.ZNear, propL.ZFar);
-        }
-
-        {   // project matrices of the right eye
-            glm::vec4 xrFoV = input->xr_right_eye_fov;
-            cameraR->SetProjection(xrFoV, propR.ZNear, propR.ZFar);
-        }
 
         {   // Set local transform of the entity
             const glm::vec3& xrPosL = input->xr_left_eye_pos;
@@ -93,49 +72,35 @@ void VrDisplayComponent::Update(Timestep ts)
             entity->SetLocalTransform(translation * rotation);
         }
 
-        {   // view matrix of the left eye
-            glm::vec4 xrQuat = input->xr_left_eye_quat;
-            glm::vec3 xrPos = input->xr_left_eye_pos;
-            glm::quat quat;
-            quat.x = xrQuat[0];
-            quat.y = xrQuat[1];
-            quat.z = xrQuat[2];
-            quat.w = xrQuat[3];
+        // index 0 = left eye, index 1 = right eye
+        EyeView views[2];
+        views[0] = {input->xr_left_eye_fov,
+            input->xr_left_eye_quat, input->xr_left_eye_pos};
+        views[1] = {input->xr_right_eye_fov,
+            input->xr_right_eye_quat, input->xr_right_eye_pos};
 
-            glm::mat4 rotation = glm::toMat4(quat);
-            glm::mat4 translation = glm::translate(glm::mat4(1.0f), xrPos);
+        // The renderer late latches the views with the same origin.
+        vrDisplay->SetEyeViews(views, entity->GetParent()->GetGlobalTransform());
 
-            cameraL->SetTransform(
-                entity->GetParent()->GetGlobalTransform() * translation * rotation);
+        if (vrDisplay->IsMultiview())
+        {   // Both eyes are views of one camera, rendered in a single pass
+            technique->PushRendererData(vrDisplay->GetStereoCamera());
         }
-
-        {   // view matrix of the right eye
-            glm::vec4 xrQuat = input->xr_right_eye_quat;
-            glm::vec3 xrPos = input->xr_right_eye_pos;
-            glm::quat quat;
-            quat.x = xrQuat[0];
-            quat.y = xrQuat[1];
-            quat.z = xrQuat[2];
-            quat.w = xrQuat[3];
-
-            glm::mat4 rotation = glm::toMat4(quat);
-            glm::mat4 translation = glm::translate(glm::mat4(1.0f), xrPos);
-
-            cameraR->SetTransform(
-                entity->GetParent()->GetGlobalTransform() * translation * rotation);
+        else
+        {
+            technique->PushRendererData(vrDisplay->GetLeftCamera());
+            technique->PushRendererData(vrDisplay->GetRightCamera());
         }
-
-        technique->PushRendererData(cameraL);
-        technique->PushRendererData(cameraR);
     }
     else if (state == Scene::State::Running)
     {
         std::shared_ptr<VulkanCamera> camera =
-            vrDisplay->GetLeftCamera();
+            vrDisplay->GetPreviewCamera();
 
         ASSERT(camera != nullptr);
 
-        camera->SetTransform(entity->GetGlobalTransform());
+        for (uint32_t i = 0; i < camera->GetViewCount(); i++)
+            camera->SetTransform(entity->GetGlobalTransform(), i);
         technique->PushRendererData(camera);
     }
 }
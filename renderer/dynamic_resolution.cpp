@@ -0,0 +1,50 @@
+#include "dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace renderer
+{
+
+float DynamicResolution::Update(float gpuTime, float displayPeriod)
+{
+    if (gpuTime <= 0.0f || displayPeriod <= 0.0f)
+        return scale;
+
+    // Estimate the cost at full scale so that the history
+    // stays valid when the scale changes.
+    float fullTime = gpuTime / (scale * scale);
+    smoothedTime = (smoothedTime == 0.0f)? fullTime:
+        smoothedTime + DYNAMIC_RESOLUTION_SMOOTHING * (fullTime - smoothedTime);
+
+    // React to a single slow frame, the headset would drop it.
+    float estimate = std::max(smoothedTime, fullTime);
+    float budget = displayPeriod * DYNAMIC_RESOLUTION_HEADROOM;
+    float target = std::sqrt(budget / estimate);
+
+    // Always give up resolution when over budget,
+    // but only raise it again with enough margin.
+    if (target >= scale && target / scale - 1.0f < DYNAMIC_RESOLUTION_DEADBAND)
+        return scale;
+
+    float factor = std::clamp(target / scale,
+        DYNAMIC_RESOLUTION_MAX_DOWN, DYNAMIC_RESOLUTION_MAX_UP);
+    scale = std::clamp(scale * factor, minScale, maxScale);
+    return scale;
+}
+
+void DynamicResolution::SetRange(float minScale, float maxScale)
+{
+    this->minScale = std::min(minScale, maxScale);
+    this->maxScale = maxScale;
+    scale = std::clamp(scale, this->minScale, this->maxScale);
+}
+
+void DynamicResolution::Reset()
+{
+    scale = maxScale;
+    smoothedTime = 0.0f;
+}
+
+} // namespace renderer
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+#define DYNAMIC_RESOLUTION_MIN_SCALE    0.5f  // Of the allocated eye buffer
+#define DYNAMIC_RESOLUTION_HEADROOM     0.9f  // Fraction of the display period
+#define DYNAMIC_RESOLUTION_SMOOTHING    0.1f  // Weight of a new GPU time sample
+#define DYNAMIC_RESOLUTION_DEADBAND     0.03f // Ignore smaller scale errors
+#define DYNAMIC_RESOLUTION_MAX_UP       1.02f // Largest increase per frame
+#define DYNAMIC_RESOLUTION_MAX_DOWN     0.9f  // Largest decrease per frame
+
+
+namespace renderer
+{
+
+/**
+ * @brief Scale the render extent so that GPU frame time
+ * stays within the display period of the headset.
+ *
+ * The scale applies to both axes, so GPU cost is assumed
+ * to grow with its square. It drops quickly when a frame is over
+ * budget and recovers slowly to avoid oscillating.
+ */
+class DynamicResolution
+{
+public:
+    /**
+     * @brief Feed the GPU time of the last frame.
+     * 
+     * @param gpuTime GPU time of the frame in seconds
+     * @param displayPeriod time between two display refreshes in seconds,
+     * the scale is not changed if it is 0.
+     * @return the render scale for the next frame
+     */
+    float Update(float gpuTime, float displayPeriod);
+
+    float GetScale() const {return scale;}
+    float GetFullScaleTime() const {return smoothedTime;}
+
+    void SetRange(float minScale, float maxScale);
+    void Reset();
+
+private:
+    float scale = 1.0f;
+    float smoothedTime = 0.0f; // GPU time estimated at a scale of 1
+    float minScale = DYNAMIC_RESOLUTION_MIN_SCALE;
+    float maxScale = 1.0f;
+};
+
+} // namespace renderer
@@ -0,0 +1,218 @@
+#include "gpu_culling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tracy/Tracy.hpp>
+
+
+void GpuCulling::ExtractPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+    auto row = [&viewProjection](int i) {
+        return glm::vec4(viewProjection[0][i], viewProjection[1][i],
+            viewProjection[2][i], viewProjection[3][i]);
+    };
+
+    // Clip space is -w <= x, y <= w and 0 <= z <= w.
+    planes[0] = row(3) + row(0);
+    planes[1] = row(3) - row(0);
+    planes[2] = row(3) + row(1);
+    planes[3] = row(3) - row(1);
+    planes[4] = row(2);
+    planes[5] = row(3) - row(2);
+
+    for (int i = 0; i < 6; i++)
+    {
+        float length = glm::length(glm::vec3(planes[i]));
+        planes[i] = (length > 1e-6f)?
+            planes[i] / length: glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+bool GpuCulling::IsInFrustum(const glm::vec4 planes[6], glm::vec4 sphere)
+{
+    glm::vec3 center = glm::vec3(sphere);
+    for (int i = 0; i < 6; i++)
+    {
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -sphere.w)
+            return false;
+    }
+    return true;
+}
+
+bool GpuCulling::ProjectSphere(glm::vec3 center, float radius,
+    const glm::mat4& projection, glm::vec4& rect, float& depth)
+{
+    float d = -center.z;
+    float nearest = d - radius;
+    if (nearest < 1e-4f)
+        return false;
+
+    // z_ndc = p32 / depth - p22, see LightClustering::SetProjection
+    depth = projection[3][2] / nearest - projection[2][2];
+    if (depth < 0.0f)
+        return false;
+
+    // Tangents of the lines from the camera touching the sphere,
+    // tan(a -+ b) with tan(a) = c / d and sin(b) = radius / |(c, d)|.
+    auto tangents = [d, radius](float c) {
+        float t = c / d;
+        float s = radius / std::sqrt(c * c + d * d - radius * radius);
+        return glm::vec2((t - s) / (1.0f + t * s), (t + s) / (1.0f - t * s));
+    };
+
+    // Without skew, ndc = p00 * x / depth - p20, and y the same way.
+    glm::vec2 x = tangents(center.x) * projection[0][0] - glm::vec2(projection[2][0]);
+    glm::vec2 y = tangents(center.y) * projection[1][1] - glm::vec2(projection[2][1]);
+
+    rect = glm::vec4(
+        std::min(x.x, x.y), std::min(y.x, y.y),
+        std::max(x.x, x.y), std::max(y.x, y.y)) * 0.5f + glm::vec4(0.5f);
+    return true;
+}
+
+uint32_t GpuCulling::SelectLod(float screenSize, uint32_t lodCount, uint32_t previous)
+{
+    if (lodCount <= 1)
+        return 0;
+
+    auto levelForSize = [lodCount](float size) {
+        uint32_t level = 0;
+        float threshold = MESH_LOD_SCREEN_SIZE;
+        while (level + 1 < lodCount && size < threshold)
+        {
+            level++;
+            threshold *= 0.5f;
+        }
+        return level;
+    };
+
+    uint32_t finest = levelForSize(screenSize * (1.0f + MESH_LOD_HYSTERESIS));
+    uint32_t coarsest = levelForSize(screenSize * (1.0f - MESH_LOD_HYSTERESIS));
+
+    uint32_t level = (previous < lodCount)? previous: levelForSize(screenSize);
+    return std::min(std::max(level, finest), coarsest);
+}
+
+glm::uvec2 GpuCulling::GetPyramidSize(uint32_t width, uint32_t height)
+{
+    auto previousPowerOfTwo = [](uint32_t value) {
+        uint32_t result = 1;
+        while (result * 2 <= value)
+            result *= 2;
+        return result;
+    };
+    return glm::uvec2(previousPowerOfTwo(width), previousPowerOfTwo(height));
+}
+
+uint32_t GpuCulling::GetPyramidLevels(glm::uvec2 size)
+{
+    uint32_t levels = 1;
+    while ((std::max(size.x, size.y) >> levels) > 0)
+        levels++;
+    return levels;
+}
+
+void GpuCulling::BuildPyramid(const float* depth, uint32_t width, uint32_t height,
+    glm::uvec2 size, std::vector<std::vector<float>>& levels)
+{
+    ZoneScopedN("GpuCulling::BuildPyramid");
+
+    levels.resize(GetPyramidLevels(size));
+
+    // A texel of level 0 takes the farthest depth of all pixels it touches,
+    // at most 3 per side as the pyramid is over half the size of the image.
+    levels[0].resize(size.x * size.y);
+    for (uint32_t y = 0; y < size.y; y++)
+    {
+        uint32_t y0 = y * height / size.y;
+        uint32_t y1 = std::max(y0, ((y + 1) * height + size.y - 1) / size.y - 1);
+        for (uint32_t x = 0; x < size.x; x++)
+        {
+            uint32_t x0 = x * width / size.x;
+            uint32_t x1 = std::max(x0, ((x + 1) * width + size.x - 1) / size.x - 1);
+
+            float farthest = 0.0f;
+            for (uint32_t sy = y0; sy <= std::min(y1, height - 1); sy++)
+                for (uint32_t sx = x0; sx <= std::min(x1, width - 1); sx++)
+                    farthest = std::max(farthest, depth[sy * width + sx]);
+            levels[0][y * size.x + x] = farthest;
+        }
+    }
+
+    for (uint32_t level = 1; level < levels.size(); level++)
+    {
+        glm::uvec2 source(std::max(size.x >> (level - 1), 1u),
+            std::max(size.y >> (level - 1), 1u));
+        glm::uvec2 target(std::max(size.x >> level, 1u), std::max(size.y >> level, 1u));
+        const std::vector<float>& from = levels[level - 1];
+
+        levels[level].resize(target.x * target.y);
+        for (uint32_t y = 0; y < target.y; y++)
+        {
+            uint32_t y0 = std::min(y * 2, source.y - 1);
+            uint32_t y1 = std::min(y * 2 + 1, source.y - 1);
+            for (uint32_t x = 0; x < target.x; x++)
+            {
+                uint32_t x0 = std::min(x * 2, source.x - 1);
+                uint32_t x1 = std::min(x * 2 + 1, source.x - 1);
+                levels[level][y * target.x + x] = std::max(
+                    std::max(from[y0 * source.x + x0], from[y0 * source.x + x1]),
+                    std::max(from[y1 * source.x + x0], from[y1 * source.x + x1]));
+            }
+        }
+    }
+}
+
+bool GpuCulling::IsOccluded(const std::vector<std::vector<float>>& levels,
+    glm::uvec2 size, glm::vec4 rect, float depth)
+{
+    rect = glm::clamp(rect, 0.0f, 1.0f);
+
+    // The level where the bounds are at most one texel wide,
+    // so they touch 2 by 2 texels at most.
+    float extent = std::max((rect.z - rect.x) * size.x, (rect.w - rect.y) * size.y);
+    int32_t level = static_cast<int32_t>(std::ceil(std::log2(std::max(extent, 1.0f))));
+    level = std::min(level, static_cast<int32_t>(levels.size()) - 1);
+
+    glm::uvec2 levelSize(std::max(size.x >> level, 1u), std::max(size.y >> level, 1u));
+    auto texel = [](float uv, uint32_t count) {
+        return std::min(static_cast<uint32_t>(uv * count), count - 1);
+    };
+
+    float farthest = 0.0f;
+    for (uint32_t y = texel(rect.y, levelSize.y); y <= texel(rect.w, levelSize.y); y++)
+        for (uint32_t x = texel(rect.x, levelSize.x); x <= texel(rect.z, levelSize.x); x++)
+            farthest = std::max(farthest, levels[level][y * levelSize.x + x]);
+
+    return depth > farthest;
+}
+
+void GpuCulling::GetDirtyRanges(const std::vector<uint64_t>& bits,
+    std::vector<glm::uvec2>& ranges)
+{
+    ZoneScopedN("GpuCulling::GetDirtyRanges");
+
+    ranges.clear();
+    bool open = false;
+    for (uint32_t word = 0; word < bits.size(); word++)
+    {
+        // Whole words are skipped, most instances of a frame are static.
+        if (!open && bits[word] == 0)
+            continue;
+        if (open && bits[word] == ~0ull)
+        {
+            ranges.back().y += 64;
+            continue;
+        }
+
+        for (uint32_t bit = 0; bit < 64; bit++)
+        {
+            bool set = (bits[word] >> bit) & 1ull;
+            if (set && !open)
+                ranges.push_back(glm::uvec2(word * 64 + bit, 0));
+            open = set;
+            if (set)
+                ranges.back().y++;
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// LOD 1 is used below this fraction of the view height,
+// and each following level at half the size of the previous one.
+// Mirrored in culling/cull.comp.
+#define MESH_LOD_SCREEN_SIZE    0.5f
+#define MESH_LOD_HYSTERESIS     0.15f
+
+#define GPU_CULL_GROUP_SIZE     64      // Instances per cull workgroup
+#define DEPTH_PYRAMID_GROUP_SIZE 8      // Texels per side of a reduce workgroup
+
+/**
+ * @brief Math of the GPU culling pass.
+ *
+ * The compute shaders in vulkan_shaders/culling do the same
+ * per instance, this is the reference they are tested against.
+ * An instance is kept when its bounding sphere touches the frustum of a view
+ * and is not behind the depth pyramid of the previous frame.
+ * The depth pyramid is a max reduction of the depth buffer into
+ * power of two levels, level 0 being the largest power of two
+ * not above the image. Depth grows with distance, reversed depth
+ * is not supported.
+ */
+class GpuCulling
+{
+public:
+    /**
+     * @brief Normalized planes of a view frustum, inside is dot(xyz, p) + w >= 0.
+     * Degenerate planes of an infinite far plane keep everything.
+     */
+    static void ExtractPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+    static bool IsInFrustum(const glm::vec4 planes[6], glm::vec4 sphere);
+
+    /**
+     * @brief Screen bounds of a view space sphere.
+     *
+     * @param rect min and max framebuffer position in [0, 1], y down
+     * @param depth depth buffer value of the closest point
+     * @return False if the sphere reaches the camera plane
+     * or the near plane, the bounds are unknown then.
+     */
+    static bool ProjectSphere(glm::vec3 center, float radius,
+        const glm::mat4& projection, glm::vec4& rect, float& depth);
+
+    /**
+     * @brief Level of detail with the hysteresis of RenderTechnique.
+     *
+     * @param screenSize fraction of the view height covered by the bounds
+     * @param previous level of the last frame, lodCount or more if none
+     */
+    static uint32_t SelectLod(float screenSize, uint32_t lodCount, uint32_t previous);
+
+    static glm::uvec2 GetPyramidSize(uint32_t width, uint32_t height);
+    static uint32_t GetPyramidLevels(glm::uvec2 size);
+
+    /**
+     * @brief Reduce a depth buffer into a depth pyramid on the CPU.
+     *
+     * @param levels one texel vector per level, rows top to bottom
+     */
+    static void BuildPyramid(const float* depth, uint32_t width, uint32_t height,
+        glm::uvec2 size, std::vector<std::vector<float>>& levels);
+
+    /**
+     * @brief Whether the screen bounds of ProjectSphere
+     * are entirely behind the depth in the pyramid.
+     */
+    static bool IsOccluded(const std::vector<std::vector<float>>& levels,
+        glm::uvec2 size, glm::vec4 rect, float depth);
+
+    /**
+     * @brief Runs of set bits, 64 per word, as first bit and count.
+     * Dirty instances are uploaded with one copy region per run.
+     */
+    static void GetDirtyRanges(const std::vector<uint64_t>& bits,
+        std::vector<glm::uvec2>& ranges);
+};
@@ -13,6 +13,7 @@ struct CameraProperties
     float      Fov            = 45.0f; // Y-axis
     float      ZNear          = 0.01f;
     float      ZFar           = 100.0f;
+    bool       DepthPrepass   = true;  // Lay down depth before shading opaque meshes
 };
 
 enum class CameraType
@@ -16,6 +16,10 @@ struct LightProperties
 {
     LightType type = DIRECTIONAL_LIGHT;
     glm::vec3 color = {10, 10, 10}; // [0, inf] intensity HDR
+
+    float range = 10.0f; // Point and spot lights fade out to zero at the range
+    float innerConeAngle = 0.4f; // Spot lights, half angles in radians
+    float outerConeAngle = 0.5f;
 };
 
 class Light
@@ -27,6 +27,8 @@ struct MaterialProperties
     std::shared_ptr<Texture> roughnessTexture = nullptr;
 
     std::shared_ptr<Texture> normalTexture = nullptr;
+
+    float opacity = 1.0f; // [0, 1], blended and drawn after opaque meshes below 1
 };
 
 class Material
@@ -39,6 +41,7 @@ public:
     virtual void SetAlbedo(glm::vec3 albedo) = 0;
     virtual void SetMetallic(float metallic) = 0;
     virtual void SetRoughness(float roughness) = 0;
+    virtual void SetOpacity(float opacity) = 0;
 
     virtual void AddAlbedoTexture(std::shared_ptr<Texture> texture) = 0;
     virtual void AddMetallicTexture(std::shared_ptr<Texture> texture) = 0;
@@ -7,6 +7,9 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <cstdint>
+
+#define MESH_MAX_LOD 4
 
 namespace renderer
 {
@@ -18,11 +21,45 @@ struct Vertex
     glm::vec2 TexCoords;
 };
 
+enum class VertexFormat
+{
+    Standard,   // 32-byte Vertex
+    Compact     // 16-byte quantized vertex
+};
+
+/**
+ * A level of detail is a range of the index buffer.
+ * All levels share the vertices of the full resolution mesh.
+*/
+struct MeshLod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error; // Simplification error relative to the bounding radius
+};
+
 struct BuildMeshInfo
 {
     std::string resourcePath;
+    VertexFormat vertexFormat = VertexFormat::Standard;
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
+    std::vector<MeshLod> lods; // Empty means a single level with all indices
+};
+
+/**
+ * Non-owning view of mesh data that already lives in memory,
+ * such as a memory mapped mesh file.
+ * The pointers only need to stay valid during mesh building.
+*/
+struct MeshDataView
+{
+    const Vertex* vertices = nullptr;
+    uint64_t vertexCount = 0;
+    const unsigned int* indices = nullptr;
+    uint64_t indexCount = 0;
+    const MeshLod* lods = nullptr;
+    uint32_t lodCount = 0;
 };
 
 class Mesh
@@ -0,0 +1,263 @@
+#include "light_clustering.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tracy/Tracy.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHT_CLUSTERING_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define LIGHT_CLUSTERING_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+static inline uint32_t CountTrailingZeros(uint32_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctz(bits));
+#endif
+}
+
+void LightClustering::SetProjection(const glm::mat4& projection)
+{
+    ZoneScopedN("LightClustering::SetProjection");
+
+    if (!minX.empty() && projection == this->projection)
+        return;
+    this->projection = projection;
+
+    // Perspective division by w = depth gives
+    // z_ndc = p32 / depth - p22, so depth = p32 / (z_ndc + p22).
+    // Works for reversed and infinite depth as well.
+    float p22 = projection[2][2];
+    float p32 = projection[3][2];
+    auto depthAt = [p22, p32](float zNdc) {
+        float denom = zNdc + p22;
+        float depth = (std::abs(denom) > 1e-7f)? p32 / denom: -1.0f;
+        return (depth > 0.0f)? depth: std::numeric_limits<float>::max();
+    };
+    float depth0 = depthAt(0.0f);
+    float depth1 = depthAt(1.0f);
+
+    zNear = std::max(std::min(depth0, depth1), 1e-3f);
+    zFar = std::min(std::max(depth0, depth1), CLUSTER_MAX_DEPTH);
+    zFar = std::max(zFar, zNear * 1.001f);
+
+    float logRatio = std::log(zFar / zNear);
+    sliceScale = CLUSTER_GRID_Z / logRatio;
+    sliceBias = -CLUSTER_GRID_Z * std::log(zNear) / logRatio;
+
+    minX.resize(CLUSTER_COUNT); minY.resize(CLUSTER_COUNT); minZ.resize(CLUSTER_COUNT);
+    maxX.resize(CLUSTER_COUNT); maxY.resize(CLUSTER_COUNT); maxZ.resize(CLUSTER_COUNT);
+
+    // Without skew, a point at a given depth has
+    // view x = depth * (x_ndc + p20) / p00, and y the same way.
+    auto viewScale = [](float ndc, float offset, float scale) {
+        return (ndc + offset) / scale;
+    };
+
+    for (uint32_t z = 0; z < CLUSTER_GRID_Z; z++)
+    {
+        float sliceNear = zNear * std::pow(zFar / zNear,
+            static_cast<float>(z) / CLUSTER_GRID_Z);
+        float sliceFar = zNear * std::pow(zFar / zNear,
+            static_cast<float>(z + 1) / CLUSTER_GRID_Z);
+
+        for (uint32_t y = 0; y < CLUSTER_GRID_Y; y++)
+        {
+            float y0 = viewScale(-1.0f + 2.0f * y / CLUSTER_GRID_Y,
+                projection[2][1], projection[1][1]);
+            float y1 = viewScale(-1.0f + 2.0f * (y + 1) / CLUSTER_GRID_Y,
+                projection[2][1], projection[1][1]);
+
+            for (uint32_t x = 0; x < CLUSTER_GRID_X; x++)
+            {
+                float x0 = viewScale(-1.0f + 2.0f * x / CLUSTER_GRID_X,
+                    projection[2][0], projection[0][0]);
+                float x1 = viewScale(-1.0f + 2.0f * (x + 1) / CLUSTER_GRID_X,
+                    projection[2][0], projection[0][0]);
+
+                uint32_t i = (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x;
+                minX[i] = std::min({sliceNear * x0, sliceNear * x1, sliceFar * x0, sliceFar * x1});
+                maxX[i] = std::max({sliceNear * x0, sliceNear * x1, sliceFar * x0, sliceFar * x1});
+                minY[i] = std::min({sliceNear * y0, sliceNear * y1, sliceFar * y0, sliceFar * y1});
+                maxY[i] = std::max({sliceNear * y0, sliceNear * y1, sliceFar * y0, sliceFar * y1});
+                minZ[i] = -sliceFar;
+                maxZ[i] = -sliceNear;
+            }
+        }
+    }
+}
+
+uint32_t LightClustering::Bin(const Sphere* lights, uint32_t lightCount,
+    uint32_t lightBase, glm::uvec2* clusters, uint32_t* indices,
+    uint32_t maxIndices, uint32_t indexBase)
+{
+    ZoneScopedN("LightClustering::Bin");
+
+    const uint32_t tileCount = CLUSTER_GRID_X * CLUSTER_GRID_Y;
+    static_assert(CLUSTER_GRID_X % 4 == 0, "Froxels are tested four at a time");
+
+    const uint32_t words = (lightCount + 31) / 32;
+    lightMask.assign(static_cast<size_t>(CLUSTER_COUNT) * words, 0);
+
+    for (uint32_t i = 0; i < lightCount; i++)
+    {
+        const Sphere& light = lights[i];
+        float depth = -light.center.z;
+        if (depth + light.radius < zNear || depth - light.radius > zFar)
+            continue;
+
+        int32_t firstSlice = GetSlice(std::max(depth - light.radius, zNear));
+        int32_t lastSlice = GetSlice(std::min(depth + light.radius, zFar));
+
+        const uint32_t word = i / 32;
+        const uint32_t bit = 1u << (i % 32);
+
+#if defined(LIGHT_CLUSTERING_SSE)
+        const __m128 cx = _mm_set1_ps(light.center.x);
+        const __m128 cy = _mm_set1_ps(light.center.y);
+        const __m128 cz = _mm_set1_ps(light.center.z);
+        const __m128 r2 = _mm_set1_ps(light.radius * light.radius);
+        const __m128 zero = _mm_setzero_ps();
+#elif defined(LIGHT_CLUSTERING_NEON)
+        const float32x4_t cx = vdupq_n_f32(light.center.x);
+        const float32x4_t cy = vdupq_n_f32(light.center.y);
+        const float32x4_t cz = vdupq_n_f32(light.center.z);
+        const float32x4_t r2 = vdupq_n_f32(light.radius * light.radius);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const uint32_t laneBits[4] = {1, 2, 4, 8};
+        const uint32x4_t lanes = vld1q_u32(laneBits);
+#endif
+
+        for (int32_t z = firstSlice; z <= lastSlice; z++)
+        {
+            // Box x only depends on the column and y on the row,
+            // skip those the sphere bounds do not reach.
+            const uint32_t first = z * tileCount;
+            int32_t x0 = 0, x1 = CLUSTER_GRID_X - 1;
+            while (x0 <= x1 && maxX[first + x0] < light.center.x - light.radius)
+                x0++;
+            while (x0 <= x1 && minX[first + x1] > light.center.x + light.radius)
+                x1--;
+            int32_t y0 = 0, y1 = CLUSTER_GRID_Y - 1;
+            while (y0 <= y1 && maxY[first + y0 * CLUSTER_GRID_X] <
+                light.center.y - light.radius)
+                y0++;
+            while (y0 <= y1 && minY[first + y1 * CLUSTER_GRID_X] >
+                light.center.y + light.radius)
+                y1--;
+            if (x0 > x1 || y0 > y1)
+                continue;
+
+            for (int32_t y = y0; y <= y1; y++)
+            for (uint32_t c = first + y * CLUSTER_GRID_X + (x0 & ~3);
+                c <= first + y * CLUSTER_GRID_X + x1; c += 4)
+            {
+                // Squared distance from the center to each box,
+                // one bit per froxel the sphere touches.
+#if defined(LIGHT_CLUSTERING_SSE)
+                __m128 dx = _mm_max_ps(zero, _mm_max_ps(
+                    _mm_sub_ps(_mm_loadu_ps(&minX[c]), cx),
+                    _mm_sub_ps(cx, _mm_loadu_ps(&maxX[c]))));
+                __m128 dy = _mm_max_ps(zero, _mm_max_ps(
+                    _mm_sub_ps(_mm_loadu_ps(&minY[c]), cy),
+                    _mm_sub_ps(cy, _mm_loadu_ps(&maxY[c]))));
+                __m128 dz = _mm_max_ps(zero, _mm_max_ps(
+                    _mm_sub_ps(_mm_loadu_ps(&minZ[c]), cz),
+                    _mm_sub_ps(cz, _mm_loadu_ps(&maxZ[c]))));
+                __m128 distance2 = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                uint32_t hits = static_cast<uint32_t>(
+                    _mm_movemask_ps(_mm_cmple_ps(distance2, r2)));
+#elif defined(LIGHT_CLUSTERING_NEON)
+                float32x4_t dx = vmaxq_f32(zero, vmaxq_f32(
+                    vsubq_f32(vld1q_f32(&minX[c]), cx),
+                    vsubq_f32(cx, vld1q_f32(&maxX[c]))));
+                float32x4_t dy = vmaxq_f32(zero, vmaxq_f32(
+                    vsubq_f32(vld1q_f32(&minY[c]), cy),
+                    vsubq_f32(cy, vld1q_f32(&maxY[c]))));
+                float32x4_t dz = vmaxq_f32(zero, vmaxq_f32(
+                    vsubq_f32(vld1q_f32(&minZ[c]), cz),
+                    vsubq_f32(cz, vld1q_f32(&maxZ[c]))));
+                float32x4_t distance2 = vmlaq_f32(vmlaq_f32(
+                    vmulq_f32(dx, dx), dy, dy), dz, dz);
+                uint32x4_t masked = vandq_u32(vcleq_f32(distance2, r2), lanes);
+                uint32_t hits =
+                    vgetq_lane_u32(masked, 0) | vgetq_lane_u32(masked, 1) |
+                    vgetq_lane_u32(masked, 2) | vgetq_lane_u32(masked, 3);
+#else
+                uint32_t hits = 0;
+                for (uint32_t j = 0; j < 4; j++)
+                {
+                    float dx = std::max({0.0f, minX[c + j] - light.center.x,
+                        light.center.x - maxX[c + j]});
+                    float dy = std::max({0.0f, minY[c + j] - light.center.y,
+                        light.center.y - maxY[c + j]});
+                    float dz = std::max({0.0f, minZ[c + j] - light.center.z,
+                        light.center.z - maxZ[c + j]});
+                    if (dx * dx + dy * dy + dz * dz <= light.radius * light.radius)
+                        hits |= 1u << j;
+                }
+#endif
+                while (hits)
+                {
+                    uint32_t j = CountTrailingZeros(hits);
+                    lightMask[static_cast<size_t>(word) * CLUSTER_COUNT + c + j] |= bit;
+                    hits &= hits - 1;
+                }
+            }
+        }
+    }
+
+    // Written in order, the output is usually mapped GPU memory.
+    uint32_t indexCount = 0;
+    uint32_t dropped = 0;
+    for (uint32_t c = 0; c < CLUSTER_COUNT; c++)
+    {
+        uint32_t first = indexCount;
+        for (uint32_t w = 0; w < words; w++)
+        {
+            uint32_t bits = lightMask[static_cast<size_t>(w) * CLUSTER_COUNT + c];
+            while (bits)
+            {
+                if (indexCount < maxIndices)
+                    indices[indexCount++] = lightBase + w * 32 + CountTrailingZeros(bits);
+                else
+                    dropped++;
+                bits &= bits - 1;
+            }
+        }
+        clusters[c] = glm::uvec2(indexBase + first, indexCount - first);
+    }
+
+    return dropped;
+}
+
+uint32_t LightClustering::GetClusterIndex(glm::vec2 uv, float depth) const
+{
+    int32_t x = std::min(std::max(static_cast<int32_t>(uv.x * CLUSTER_GRID_X), 0),
+        CLUSTER_GRID_X - 1);
+    int32_t y = std::min(std::max(static_cast<int32_t>(uv.y * CLUSTER_GRID_Y), 0),
+        CLUSTER_GRID_Y - 1);
+    int32_t z = GetSlice(depth);
+    return (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x;
+}
+
+int32_t LightClustering::GetSlice(float depth) const
+{
+    float slice = std::floor(std::log(std::max(depth, 1e-6f)) * sliceScale + sliceBias);
+    return static_cast<int32_t>(std::min(std::max(slice, 0.0f),
+        static_cast<float>(CLUSTER_GRID_Z - 1)));
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Froxel grid of a view, mirrored in Phong/shader.frag.
+#define CLUSTER_GRID_X          16
+#define CLUSTER_GRID_Y          9
+#define CLUSTER_GRID_Z          24
+#define CLUSTER_COUNT           (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+#define CLUSTER_MAX_INDICES     65536   // Light indices per view
+#define CLUSTER_MAX_DEPTH       500.0f  // Depth slices end here for far away planes
+
+/**
+ * @brief Assign lights to the froxels of a perspective view
+ * for clustered forward shading.
+ *
+ * The view frustum is divided into CLUSTER_GRID_X * CLUSTER_GRID_Y tiles
+ * in screen space and CLUSTER_GRID_Z exponential depth slices.
+ * Lights are bounded by spheres in view space and tested against
+ * the view space bounding box of every froxel, four at a time with SIMD.
+ * Clusters are indexed by (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x,
+ * with y = 0 at the top of the framebuffer.
+ */
+class LightClustering
+{
+public:
+    struct Sphere
+    {
+        glm::vec3 center; // view space
+        float radius;
+    };
+
+    /**
+     * @brief Rebuild the froxel bounds if the projection changed.
+     * Only perspective projections without skew are supported,
+     * asymmetric ones from XR runtimes included.
+     */
+    void SetProjection(const glm::mat4& projection);
+
+    /**
+     * @brief Bin the lights into the clusters.
+     *
+     * @param lights light bounds in view space
+     * @param lightBase index written for lights[0], the rest follow
+     * @param clusters CLUSTER_COUNT pairs of first index and count
+     * @param indices light indices of all clusters back to back
+     * @param indexBase offset of indices in the buffer the shader reads
+     * @return Number of light and cluster pairs dropped
+     * because maxIndices was reached.
+     */
+    uint32_t Bin(const Sphere* lights, uint32_t lightCount, uint32_t lightBase,
+        glm::uvec2* clusters, uint32_t* indices, uint32_t maxIndices,
+        uint32_t indexBase = 0);
+
+    /**
+     * @brief Cluster of a fragment, same as the shader.
+     *
+     * @param uv framebuffer position in [0, 1], y down
+     * @param depth distance along the view direction
+     */
+    uint32_t GetClusterIndex(glm::vec2 uv, float depth) const;
+
+    /**
+     * @brief Slice of a depth: floor(log(depth) * scale + bias)
+     *
+     * @return <scale, bias>
+     */
+    glm::vec2 GetSliceParameters() const {return {sliceScale, sliceBias};}
+    float GetNear() const {return zNear;}
+    float GetFar() const {return zFar;}
+
+private:
+    int32_t GetSlice(float depth) const;
+
+private:
+    glm::mat4 projection{0.0f};
+    float zNear = 0.0f;
+    float zFar = 0.0f;
+    float sliceScale = 0.0f;
+    float sliceBias = 0.0f;
+
+    // Froxel bounding boxes, structure of arrays in cluster order.
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    // One bit per light and cluster, 32 lights per word.
+    // Word major, so that binning nearby lights stays in cache.
+    std::vector<uint32_t> lightMask;
+};
@@ -212,6 +212,13 @@ void GltfModel::LoadMaterials()
                 }
             }
 
+            // Only blended materials are drawn as transparent.
+            if (gltfMaterial["alphaMode"].asString() == "BLEND" &&
+                !gltfPbr["baseColorFactor"].isNull())
+            {
+                prop.opacity = gltfPbr["baseColorFactor"][3].asFloat();
+            }
+
             if (!gltfPbr["metallicRoughnessTexture"].isNull())
             {
                 int texIndex = gltfPbr["metallicRoughnessTexture"]["index"].asInt();
@@ -119,7 +119,7 @@ PipelineImgui::PipelineImgui(
         vertex_info.vertexAttributeDescriptionCount = 3;
         vertex_info.pVertexAttributeDescriptions = attribute_desc;
 
-        imguiPipeline->BuildPipeline(
+        imguiPipeline->PreparePipeline(
             &vertex_info,
             std::move(imguiLayout),
             renderpass
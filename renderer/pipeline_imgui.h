@@ -17,6 +17,10 @@ class PipelineImgui
 {
 
 public:
+    /**
+     * The pipeline is only prepared, it has to be compiled
+     * with VulkanPipeline::CompilePipelines before rendering.
+    */
     PipelineImgui(
         VulkanDevice& vulkanDevice,
         VkDescriptorPool vkDescriptorPool,
@@ -29,6 +33,11 @@ public:
     void RenderUI(ImDrawData* drawData,
         VkBuffer vertexBuffer, VkBuffer indexBuffer, VkCommandBuffer commandbuffer);
 
+    VulkanPipeline* GetVulkanPipeline()
+    {
+        return imguiPipeline.get();
+    }
+
 private:
     std::shared_ptr<VulkanTexture> fontTexture;
     std::unique_ptr<VulkanPipeline> imguiPipeline;
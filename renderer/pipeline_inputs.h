@@ -1,6 +1,7 @@
 #pragma once 
 
 #include <glm/glm.hpp>
+#include <cstdint>
 
 struct Vertex
 {
@@ -10,6 +11,53 @@ struct Vertex
 };
 
 typedef uint32_t VertexIndex;
+typedef uint16_t CompactVertexIndex;
+
+/**
+ * 16-byte vertex used by meshes imported with the compact format.
+ * Position is UNORM16 relative to the mesh bounds,
+ * normal is SNORM16 octahedral encoded,
+ * and texture coordinates are half floats.
+ */
+struct CompactVertex
+{
+    uint16_t Position[4]; // w is padding
+    int16_t Normal[2];
+    uint16_t TexCoords[2];
+};
+
+/**
+ * Push constant that restores compact vertex positions:
+ * position = offset + unorm * scale
+ */
+struct VertexQuantization
+{
+    glm::vec4 offset;
+    glm::vec4 scale;
+};
+
+/**
+ * Fragment push constant of the mesh pipelines, placed after
+ * the vertex quantization so that all of them share the offset.
+ * Same as Phong/shader.frag.
+ */
+struct MaterialPushConst
+{
+    uint32_t materialIndex; // Slot in VulkanBindless
+};
+#define MATERIAL_PUSH_OFFSET sizeof(VertexQuantization)
+
+/**
+ * Push constant of the transfer shaders that copy a camera
+ * or a texture to a swapchain. Only [0, uvScale] of the image
+ * is sampled, the rest is left over from a larger render extent.
+ */
+struct TransferPushConst
+{
+    int isTexture;
+    float _0;
+    glm::vec2 uvScale;
+};
 
 struct MeshProperties
 {
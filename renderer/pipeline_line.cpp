@@ -9,40 +9,25 @@
 #include <memory>
 #include <array>
 #include <vector>
+#include <cstring>
 #include <tracy/Tracy.hpp>
 
 namespace renderer
 {
 
 PipelineLine::PipelineLine(VulkanDevice& vulkanDevice,
-    VkDescriptorPool vkDescriptorPool, VkRenderPass renderpass)
+    VkDescriptorPool vkDescriptorPool, VkRenderPass renderpass, bool multiview)
 {
     this->vulkanDevice = &vulkanDevice;
     this->vkDescriptorPool = vkDescriptorPool;
 
     linePipeline = std::make_unique<VulkanPipeline>(vulkanDevice.vkDevice);
-    PipelineLayoutBuilder layoutBuilder(&vulkanDevice);
-    std::unique_ptr<VulkanPipelineLayout> wireLayout;
 
-    linePipeline->LoadShader("resources/vulkan_shaders/line/vert.spv",
+    linePipeline->LoadShader(multiview?
+                             "resources/vulkan_shaders/line/multiview_vert.spv":
+                             "resources/vulkan_shaders/line/vert.spv",
                              "resources/vulkan_shaders/line/frag.spv");
 
-    layoutBuilder.PushDescriptorSetLayout("camera",
-    {
-        layoutBuilder.descriptorSetLayoutBinding(
-            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0)
-    });
-
-    layoutBuilder.PushDescriptorSetLayout("lineProperties",
-    {
-        layoutBuilder.descriptorSetLayoutBinding(
-            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0),
-    });
-
-    wireLayout = layoutBuilder.BuildPipelineLayout(
-        vkDescriptorPool
-    );
-
     linePipeline->rasterState.cullMode = VK_CULL_MODE_NONE;
 
     std::vector<VkVertexInputBindingDescription> bindingDesc =
@@ -67,17 +52,97 @@ PipelineLine::PipelineLine(VulkanDevice& vulkanDevice,
     info.vertexAttributeDescriptionCount = attributeDesc.size();
     info.pVertexAttributeDescriptions = attributeDesc.data();
 
-    linePipeline->BuildPipeline(
+    linePipeline->PreparePipeline(
         &info,
-        std::move(wireLayout),
+        BuildPipelineLayout(),
         renderpass
     );
+
+    // Shapes: segments of the unit shape per vertex, shape per instance
+    shapePipeline = std::make_unique<VulkanPipeline>(vulkanDevice.vkDevice);
+
+    shapePipeline->LoadShader(multiview?
+                              "resources/vulkan_shaders/line/shape_multiview_vert.spv":
+                              "resources/vulkan_shaders/line/shape_vert.spv",
+                              "resources/vulkan_shaders/line/frag.spv");
+
+    shapePipeline->rasterState.cullMode = VK_CULL_MODE_NONE;
+
+    std::vector<VkVertexInputBindingDescription> shapeBindingDesc =
+    {
+        {0, sizeof(ShapeVertex), VK_VERTEX_INPUT_RATE_VERTEX},
+        {1, sizeof(ShapeInstance), VK_VERTEX_INPUT_RATE_INSTANCE},
+    };
+
+    std::vector<VkVertexInputAttributeDescription> shapeAttributeDesc =
+    {
+        {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(ShapeVertex, position)},
+        {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(ShapeVertex, beginPoint)},
+        {2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(ShapeVertex, endPoint)},
+        // A mat4 takes one location per column
+        {3, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(ShapeInstance, transform)},
+        {4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(ShapeInstance, transform) + 16},
+        {5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(ShapeInstance, transform) + 32},
+        {6, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(ShapeInstance, transform) + 48},
+        {7, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(ShapeInstance, color)},
+    };
+
+    info.vertexBindingDescriptionCount = shapeBindingDesc.size();
+    info.pVertexBindingDescriptions = shapeBindingDesc.data();
+    info.vertexAttributeDescriptionCount = shapeAttributeDesc.size();
+    info.pVertexAttributeDescriptions = shapeAttributeDesc.data();
+
+    shapePipeline->PreparePipeline(
+        &info,
+        BuildPipelineLayout(),
+        renderpass
+    );
+
+    for (int i = 0; i < LINE_UNIT_SHAPE_COUNT; i++)
+    {
+        std::vector<uint32_t> indices;
+        std::vector<ShapeVertex> vertices;
+        VulkanLineGenerator::GetShapeMesh(
+            static_cast<VulkanLineGenerator::UnitShape>(i), indices, vertices);
+
+        shapeMeshes[i].Initialize(&vulkanDevice,
+            sizeof(uint32_t) * indices.size(),
+            sizeof(ShapeVertex) * vertices.size());
+        memcpy(shapeMeshes[i].MapIndex(), indices.data(),
+            sizeof(uint32_t) * indices.size());
+        memcpy(shapeMeshes[i].MapVertex(), vertices.data(),
+            sizeof(ShapeVertex) * vertices.size());
+    }
+}
+
+std::unique_ptr<VulkanPipelineLayout> PipelineLine::BuildPipelineLayout()
+{
+    PipelineLayoutBuilder layoutBuilder(vulkanDevice);
+
+    layoutBuilder.PushDescriptorSetLayout("camera",
+    {
+        layoutBuilder.descriptorSetLayoutBinding(
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0)
+    });
+
+    layoutBuilder.PushDescriptorSetLayout("lineProperties",
+    {
+        layoutBuilder.descriptorSetLayoutBinding(
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0),
+    });
+
+    return layoutBuilder.BuildPipelineLayout(
+        vkDescriptorPool
+    );
 }
 
 PipelineLine::~PipelineLine()
 {
     vkDeviceWaitIdle(vulkanDevice->vkDevice);
     linePipeline = nullptr;
+    shapePipeline = nullptr;
+    for (VulkanVertexbuffer& mesh: shapeMeshes)
+        mesh.Destroy();
 }
 
 void PipelineLine::Render(
@@ -113,6 +178,41 @@ void PipelineLine::Render(
         vkCmdDrawIndexed(commandBuffer, e->GetIndexCount(), e->GetInstanceCount(), 0, 0, 0);
     }
 
+    vkCmdBindPipeline(commandBuffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        shapePipeline->pipeline
+    );
+
+    vkCmdBindDescriptorSets(
+        commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+        shapePipeline->pipelineLayout->layout,
+        0, 1, cameraDescSet, 0, nullptr
+    );
+
+    for(const std::shared_ptr<LineRenderer>& e: lineList)
+    {
+        vkCmdBindDescriptorSets(
+            commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+            shapePipeline->pipelineLayout->layout,
+            1, 1, e->GetLinePropDescSet(), 0, nullptr
+        );
+
+        // All instances of a unit shape in one draw
+        for (int i = 0; i < LINE_UNIT_SHAPE_COUNT; i++)
+        {
+            VulkanBuffer<ShapeInstance>* instances = e->GetShapeInstances(
+                static_cast<VulkanLineGenerator::UnitShape>(i));
+            if (instances->Size() == 0)
+                continue;
+
+            VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &shapeMeshes[i].vertexBuffer, &offset);
+            vkCmdBindVertexBuffers(commandBuffer, 1, 1, instances->GetBuffer(), &offset);
+            vkCmdBindIndexBuffer(commandBuffer, shapeMeshes[i].indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+            vkCmdDrawIndexed(commandBuffer, shapeMeshes[i].GetIndexCount(),
+                instances->Size(), 0, 0, 0);
+        }
+    }
 }
 
 
@@ -2,6 +2,8 @@
 
 #include "vk_primitives/vulkan_device.h"
 #include "vk_primitives/vulkan_pipeline.h"
+#include "vk_primitives/vulkan_pipeline_layout.h"
+#include "vk_primitives/vulkan_vertexbuffer.h"
 
 #include "vulkan_wireframe.h"
 
@@ -16,10 +18,19 @@ class PipelineLine
 {
 
 public:
+    /**
+     * The pipelines are only prepared, they have to be compiled
+     * with VulkanPipeline::CompilePipelines before rendering.
+     * A multiview pipeline draws the lines into both views of
+     * a multiview render pass.
+     * The shape pipeline draws the unit shapes of the line renderers,
+     * one instanced draw per shape. Their meshes are built here once.
+    */
     PipelineLine(
         VulkanDevice& vulkanDevice,
         VkDescriptorPool vkDescriptorPool,
-        VkRenderPass renderpass);
+        VkRenderPass renderpass,
+        bool multiview = false);
     ~PipelineLine();
 
     PipelineLine(const PipelineLine&) = delete;
@@ -33,11 +44,22 @@ public:
     {
         return linePipeline.get();
     }
-    
+
+    VulkanPipeline* GetShapePipeline()
+    {
+        return shapePipeline.get();
+    }
+
+private:
+    std::unique_ptr<VulkanPipelineLayout> BuildPipelineLayout();
+
 public:
     VulkanDevice* vulkanDevice;
     VkDescriptorPool vkDescriptorPool;
     std::unique_ptr<VulkanPipeline> linePipeline;
+    // Same descriptor set layouts as linePipeline
+    std::unique_ptr<VulkanPipeline> shapePipeline;
+    VulkanVertexbuffer shapeMeshes[LINE_UNIT_SHAPE_COUNT];
 };
 
 } // namespace renderer
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include "vk_primitives/vulkan_pipeline_layout.h"
 #include "loaders/gltfloader.h"
 #include "input.h"
+#include "job_system.h"
+#include "logger.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -16,7 +18,12 @@
 
 #include <array>
 #include <vector>
+#include <string>
 #include <memory>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
 #include <tracy/TracyVulkan.hpp>
 
 
@@ -25,6 +32,20 @@ namespace renderer
 
 extern TracyVkCtx tracyVkCtx;
 
+/**
+ * World space bounding sphere of a mesh packet, center and radius.
+ */
+static glm::vec4 GetWorldBounds(const RenderTechnique::MeshPacket& packet)
+{
+    const glm::vec4& sphere = packet.mesh->GetBoundingSphere();
+    glm::vec3 center = glm::vec3(
+        packet.transform * glm::vec4(glm::vec3(sphere), 1.0f));
+    float scale = std::max(glm::length(glm::vec3(packet.transform[0])),
+        std::max(glm::length(glm::vec3(packet.transform[1])),
+        glm::length(glm::vec3(packet.transform[2]))));
+    return glm::vec4(center, sphere.w * scale);
+}
+
 RenderTechnique::~RenderTechnique()
 {
     ZoneScopedN("RenderTechnique::~RenderTechnique");
@@ -37,7 +58,6 @@ void RenderTechnique::Destroy()
     ZoneScopedN("RenderTechnique::Destroy");
 
     ResetSceneData();
-    sceneUniform.Destroy();
     
     skyboxMesh = nullptr;
     textureCube = nullptr;
@@ -51,21 +71,24 @@ void RenderTechnique::ResetSceneData()
     wireList.clear();
     uiList.clear();
     lineList.clear();
-    sceneMap->nLight.x = 0;
+    lightList.clear();
 }
 
 void RenderTechnique::ExecuteCommand(VkCommandBuffer commandBuffer)
 {
     ZoneScopedN("RenderTechnique::ExecuteCommand");
 
-    if(sceneMap->nLight.x == 0)
-    {
-        sceneMap->dirLight[0] = VulkanLight::GetDefaultLight()->dirLight;
-        sceneMap->nLight++;
-    }
+    if (lightList.empty())
+        lightList.push_back(VulkanLight::GetDefaultLight()->lightData);
+
+    // Directional lights go first, they are not binned into clusters.
+    uint32_t directionalCount = static_cast<uint32_t>(
+        std::stable_partition(lightList.begin(), lightList.end(),
+            [](const LightData& light) {
+                return light.type == DIRECTIONAL_LIGHT;
+            }) - lightList.begin());
 
     VulkanRenderer& vkr = VulkanRenderer::GetInstance();
-    VkPipelineLayout layout = vkr.GetPipelineLayout("render").layout;
 
     VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
     barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -120,13 +143,57 @@ void RenderTechnique::ExecuteCommand(VkCommandBuffer commandBuffer)
         return;
     }
 
+    // Opaque meshes are culled and drawn by the GPU, the instances
+    // are shared by all cameras.
+    bool gpuCulling = vkr.IsGpuCullingEnabled();
+    if (gpuCulling)
+        UpdateInstances(commandBuffer);
+
     std::vector<VkImageMemoryBarrier> camBarriers;
+    glm::vec3 passTimes{0.0f};
     for (std::shared_ptr<VulkanCamera> camera: cameraList)
     {
         ZoneScopedN("ExecuteCommand#cameraList");
         TracyVkZone(tracyVkCtx, commandBuffer, "ExecuteCommand#cameraList");
 
+        // A multiview camera renders all its views in one pass,
+        // the pipelines pick the view matrices with gl_ViewIndex.
+        bool multiview = camera->GetViewCount() > 1;
+
+        UpdateLights(*camera, directionalCount);
+
+        if (camera->timestampPool != VK_NULL_HANDLE)
+        { // Results of the last frame, EndCommand waited for it.
+            passTimes += ReadPassTimes(*camera);
+            vkCmdResetQueryPool(commandBuffer, camera->timestampPool,
+                0, CAMERA_TIMESTAMP_COUNT * camera->GetViewCount());
+            camera->timestampsWritten = true;
+        }
+
+        std::vector<MeshDraw> opaqueDraws;
+        std::vector<MeshDraw> transparentDraws;
+        SortMeshes(*camera, opaqueDraws, transparentDraws);
+
+        // Transparent meshes do not cast shadows.
+        RenderShadows(commandBuffer, *camera, opaqueDraws, directionalCount);
+
+        if (gpuCulling)
+        {
+            TracyVkZone(tracyVkCtx, commandBuffer, "ExecuteCommand#gpuCulling");
+
+            glm::mat4 views[CAMERA_MAX_VIEWS];
+            glm::mat4 projections[CAMERA_MAX_VIEWS];
+            for (uint32_t view = 0; view < camera->viewCount; view++)
+            {
+                views[view] = camera->vpMap[view].view;
+                projections[view] = camera->vpMap[view].projection;
+            }
+            vkr.GetCulling().Cull(commandBuffer, camera->culling,
+                views, projections, camera->viewCount);
+        }
+
         barrier.image = camera->colorImage.GetImage();
+        barrier.subresourceRange.layerCount = camera->GetViewCount();
         camBarriers.push_back(barrier);
 
         std::array<VkClearValue, 2> clearValues{};
@@ -134,12 +201,12 @@ void RenderTechnique::ExecuteCommand(VkCommandBuffer commandBuffer)
         clearValues[1].depthStencil = {1.0f, 0};
 
         VkRenderPassBeginInfo vkRenderPassInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
-        vkRenderPassInfo.renderPass = vkr.vkRenderPass.defaultCamera;
+        vkRenderPassInfo.renderPass = multiview?
+            vkr.vkRenderPass.multiviewCamera: vkr.vkRenderPass.defaultCamera;
         vkRenderPassInfo.framebuffer = camera->GetFrameBuffer();
-        vkRenderPassInfo.renderArea.extent = {
-            camera->GetCamProperties().Extent.x,
-            camera->GetCamProperties().Extent.y
-        };
+        // Dynamic resolution renders to the top left part of the images.
+        VkExtent2D renderExtent = camera->GetRenderExtent();
+        vkRenderPassInfo.renderArea.extent = renderExtent;
         vkRenderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         vkRenderPassInfo.pClearValues = clearValues.data();
         vkCmdBeginRenderPass(commandBuffer, &vkRenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
@@ -147,26 +214,24 @@ void RenderTechnique::ExecuteCommand(VkCommandBuffer commandBuffer)
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
-        viewport.width = camera->GetCamProperties().Extent.x;
-        viewport.height = camera->GetCamProperties().Extent.y;
+        viewport.width = static_cast<float>(renderExtent.width);
+        viewport.height = static_cast<float>(renderExtent.height);
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
         vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
         VkRect2D scissor{};
         scissor.offset = {0, 0};
-        scissor.extent = {
-            camera->GetCamProperties().Extent.x,
-            camera->GetCamProperties().Extent.y
-        };
+        scissor.extent = renderExtent;
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
         { //skybox
-            VkPipelineLayout layout = vkr.GetPipelineLayout("skybox").layout;
+            const char* skyboxPipeline = multiview? "skyboxMultiview": "skybox";
+            VkPipelineLayout layout = vkr.GetPipelineLayout(skyboxPipeline).layout;
 
             vkCmdBindPipeline(commandBuffer, 
                 VK_PIPELINE_BIND_POINT_GRAPHICS,
-                vkr.GetPipeline("skybox").pipeline);
+                vkr.GetPipeline(skyboxPipeline).pipeline);
 
             vkCmdBindDescriptorSets(
                 commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
@@ -182,59 +247,80 @@ void RenderTechnique::ExecuteCommand(VkCommandBuffer commandBuffer)
             vkCmdBindVertexBuffers(commandBuffer, 0, 1,
                 &skyboxMesh->GetVertexbuffer().vertexBuffer, &offset);
             vkCmdBindIndexBuffer(commandBuffer,
-                skyboxMesh->GetVertexbuffer().indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+                skyboxMesh->GetVertexbuffer().indexBuffer, 0,
+                skyboxMesh->GetVertexbuffer().GetIndexType());
             vkCmdDrawIndexed(commandBuffer, 
                 skyboxMesh->GetVertexbuffer().GetIndexCount(), 1, 0, 0, 0);
         }
 
-        vkCmdBindPipeline(commandBuffer, 
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
-            vkr.GetPipeline("render").pipeline);
-
+        bool timestamps = camera->timestampPool != VK_NULL_HANDLE;
+        auto writeTimestamp = [&](uint32_t timestamp) {
+            if (timestamps)
+            {
+                vkCmdWriteTimestamp(commandBuffer,
+                    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, camera->timestampPool,
+                    timestamp * camera->GetViewCount());
+            }
+        };
 
-        vkCmdBindDescriptorSets(
-            commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
-            layout, 2, 1, camera->GetDescriptorSet(), 0, nullptr
-        );
-        vkCmdBindDescriptorSets(
-            commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
-            layout, 3, 1, &sceneDescSet, 0, nullptr
-        );
+        writeTimestamp(CAMERA_TIMESTAMP_BEGIN);
+
+        VkDescriptorSet* cameraDescSet = camera->GetDescriptorSet();
+        VkDescriptorSet* lightDescSet = camera->GetLightDescriptorSet();
+
+        auto drawOpaque = [&](const char* pass, VkDescriptorSet* lights) {
+            if (gpuCulling)
+            {
+                DrawMeshesIndirect(commandBuffer, *camera, pass, multiview,
+                    cameraDescSet, lights);
+            }
+            else
+            {
+                DrawMeshes(commandBuffer, opaqueDraws, pass, multiview,
+                    cameraDescSet, lights);
+            }
+        };
 
-        for(const auto& m: renderMesh)
+        if (camera->IsDepthPrepass())
+        { // Opaque meshes only shade the fragments left by the pre-pass.
+            {
+                TracyVkZone(tracyVkCtx, commandBuffer, "ExecuteCommand#depthPrepass");
+                drawOpaque("Depth", nullptr);
+            }
+            writeTimestamp(CAMERA_TIMESTAMP_DEPTH_PREPASS);
+            drawOpaque("Equal", lightDescSet);
+        }
+        else
         {
-            ZoneScopedN("ExecuteCommand#renderMesh");
-            TracyVkZone(tracyVkCtx, commandBuffer, "ExecuteCommand#renderMesh");
-
-            VulkanVertexbuffer& vvb = m.mesh->GetVertexbuffer();
-            std::shared_ptr<VulkanMaterial> vm = m.mesh->GetVulkanMaterial();
-
-            vkCmdBindDescriptorSets(
-                commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
-                layout, 1, 1, &m.descSet, 0, nullptr
-            );
-
-            vkCmdBindDescriptorSets(
-                commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
-                layout, 0, 1, vm->GetDescriptorSet(), 0, nullptr
-            );
-
-            VkDeviceSize offset = 0;
-            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vvb.vertexBuffer, &offset);
-            vkCmdBindIndexBuffer(commandBuffer, vvb.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-            vkCmdDrawIndexed(commandBuffer, vvb.GetIndexCount(), 1, 0, 0, 0);
+            writeTimestamp(CAMERA_TIMESTAMP_DEPTH_PREPASS);
+            drawOpaque("", lightDescSet);
         }
+        writeTimestamp(CAMERA_TIMESTAMP_OPAQUE);
 
+        DrawMeshes(commandBuffer, transparentDraws, "Transparent", multiview,
+            cameraDescSet, lightDescSet);
+        writeTimestamp(CAMERA_TIMESTAMP_TRANSPARENT);
 
         { // Wireframe rendering
-            vkr.pipelineLine->Render(
+            PipelineLine* pipelineLine = multiview?
+                vkr.pipelineLineMultiview.get(): vkr.pipelineLine.get();
+            pipelineLine->Render(
                 lineList, camera->GetDescriptorSet(),
-                camera->GetCamProperties().Extent,
+                glm::vec2(renderExtent.width, renderExtent.height),
                 commandBuffer
             );
         }
 
         vkCmdEndRenderPass(commandBuffer);
+
+        // Occluders of the next frame, only single view cameras have a pyramid.
+        if (gpuCulling && !multiview)
+        {
+            TracyVkZone(tracyVkCtx, commandBuffer, "ExecuteCommand#depthPyramid");
+            vkr.GetCulling().BuildPyramid(commandBuffer, camera->culling,
+                camera->depthImage, renderExtent,
+                camera->vpMap[0].view, camera->vpMap[0].projection);
+        }
     }
 
     vkCmdPipelineBarrier(commandBuffer,
@@ -243,6 +329,10 @@ void RenderTechnique::ExecuteCommand(VkCommandBuffer commandBuffer)
         0, 0, nullptr, 0, nullptr,
         camBarriers.size(), camBarriers.data() 
     );
+
+    TracyPlot("GPU depth pre-pass (ms)", passTimes.x);
+    TracyPlot("GPU opaque meshes (ms)", passTimes.y);
+    TracyPlot("GPU transparent meshes (ms)", passTimes.z);
 }
 
 void RenderTechnique::Initialize(VulkanDevice* vulkanDevice)
@@ -250,25 +340,6 @@ void RenderTechnique::Initialize(VulkanDevice* vulkanDevice)
     ZoneScopedN("RenderTechnique::Initialize");
 
     VulkanRenderer& vkr = VulkanRenderer::GetInstance();
-    sceneUniform.Initialize(vulkanDevice, sizeof(SceneData));
-    sceneMap = static_cast<SceneData*>(sceneUniform.Map());
-    
-    {
-        VulkanPipelineLayout& layout = vkr.GetPipelineLayout("render");
-        layout.AllocateDescriptorSet("scene", vkr.FRAME_IN_FLIGHT, &sceneDescSet);
-
-        VkWriteDescriptorSet descriptorWrite{};
-        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrite.dstSet = this->sceneDescSet;
-        descriptorWrite.dstBinding = 0;
-        descriptorWrite.dstArrayElement = 0;
-        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrite.descriptorCount = 1;
-        descriptorWrite.pBufferInfo = this->sceneUniform.GetDescriptor();
-
-        vkUpdateDescriptorSets(
-            vulkanDevice->vkDevice, 1, &descriptorWrite, 0, nullptr);
-    }
 
     { //setup default skybox
         skyboxMesh = std::make_shared<VulkanMesh>();
@@ -307,14 +378,479 @@ void RenderTechnique::Initialize(VulkanDevice* vulkanDevice)
     ResetSceneData();
 }
 
-void RenderTechnique::PushRendererData(const DirLight& dirLight)
+void RenderTechnique::PushRendererData(const LightData& light)
 {
-    if (sceneMap->nLight.x != 5)
+    if (lightList.size() < LIGHT_MAX_COUNT)
     {
-        
-        uint32_t i = sceneMap->nLight.x++;
-        sceneMap->dirLight[i] = dirLight;
+        lightList.push_back(light);
+    }
+    else if (!lightOverflowLogged)
+    {
+        Logger::Write(
+            "[Render Technique] More than " + std::to_string(LIGHT_MAX_COUNT) +
+                " lights, the rest are not rendered",
+            Logger::Level::Warning,
+            Logger::MsgType::Renderer
+        );
+        lightOverflowLogged = true;
+    }
+}
+
+void RenderTechnique::UpdateLights(VulkanCamera& camera, uint32_t directionalCount)
+{
+    ZoneScopedN("RenderTechnique::UpdateLights");
+
+    SceneLights* lightMap = camera.lightMap;
+    uint32_t lightCount = static_cast<uint32_t>(lightList.size());
+    lightMap->lightCount = glm::uvec4(lightCount, directionalCount, 0, 0);
+    memcpy(lightMap->lights, lightList.data(), sizeof(LightData) * lightCount);
+
+    // Clusters are found from the pixel, so they follow dynamic resolution.
+    VkExtent2D renderExtent = camera.GetRenderExtent();
+    uint32_t dropped[CAMERA_MAX_VIEWS] = {};
+
+    JobSystem::GetInstance().ParallelFor(camera.viewCount,
+        [&](uint32_t view)
+        {
+            const ViewProjection& vp = camera.vpMap[view];
+            LightClustering& clustering = camera.clustering[view];
+            clustering.SetProjection(vp.projection);
+
+            std::vector<LightClustering::Sphere> bounds;
+            bounds.reserve(lightCount - directionalCount);
+            for (uint32_t i = directionalCount; i < lightCount; i++)
+            {
+                const LightData& light = lightList[i];
+                bounds.push_back({
+                    glm::vec3(vp.view * glm::vec4(glm::vec3(light.position), 1.0f)),
+                    light.position.w
+                });
+            }
+
+            glm::vec2 slice = clustering.GetSliceParameters();
+            lightMap->views[view].depth = glm::vec4(
+                vp.projection[2][2], vp.projection[3][2], slice.x, slice.y);
+            lightMap->views[view].grid = glm::vec4(
+                static_cast<float>(CLUSTER_GRID_X) / renderExtent.width,
+                static_cast<float>(CLUSTER_GRID_Y) / renderExtent.height,
+                0.0f, 0.0f);
+
+            dropped[view] = clustering.Bin(
+                bounds.data(), static_cast<uint32_t>(bounds.size()),
+                directionalCount, lightMap->clusters[view],
+                lightMap->indices + view * CLUSTER_MAX_INDICES,
+                CLUSTER_MAX_INDICES, view * CLUSTER_MAX_INDICES);
+        });
+
+    for (uint32_t view = 0; view < camera.viewCount; view++)
+    {
+        if (dropped[view] > 0 && !clusterOverflowLogged)
+        {
+            Logger::Write(
+                "[Render Technique] Light clusters are full, " +
+                    std::to_string(dropped[view]) + " light assignments dropped",
+                Logger::Level::Warning,
+                Logger::MsgType::Renderer
+            );
+            clusterOverflowLogged = true;
+        }
+    }
+}
+
+void RenderTechnique::SortMeshes(VulkanCamera& camera,
+    std::vector<MeshDraw>& opaqueDraws, std::vector<MeshDraw>& transparentDraws)
+{
+    ZoneScopedN("RenderTechnique::SortMeshes");
+
+    // Keep the LODs of the last frame only, so that destroyed instances
+    // do not stay in the camera.
+    std::swap(camera.lastLods, camera.currentLods);
+    camera.currentLods.clear();
+
+    const glm::mat4& view = camera.GetTransform();
+    for (const MeshPacket& m: renderMesh)
+    {
+        glm::vec4 sphere = GetWorldBounds(m);
+        float depth = -(view * glm::vec4(glm::vec3(sphere), 1.0f)).z;
+
+        // The LOD is picked once so that all passes draw the same triangles.
+        MeshDraw draw{&m, SelectLod(m, camera), depth, sphere};
+        if (m.mesh->GetVulkanMaterial()->IsTransparent())
+            transparentDraws.push_back(draw);
+        else
+            opaqueDraws.push_back(draw);
     }
+
+    // Front to back within each vertex format, so that each pipeline
+    // is still bound once while most hidden fragments fail the depth test.
+    std::sort(opaqueDraws.begin(), opaqueDraws.end(),
+        [](const MeshDraw& a, const MeshDraw& b) {
+            VertexFormat formatA = a.packet->mesh->GetVertexFormat();
+            VertexFormat formatB = b.packet->mesh->GetVertexFormat();
+            return (formatA != formatB)? formatA < formatB: a.depth < b.depth;
+        });
+
+    // Back to front for blending, regardless of the pipeline.
+    std::sort(transparentDraws.begin(), transparentDraws.end(),
+        [](const MeshDraw& a, const MeshDraw& b) {
+            return a.depth > b.depth;
+        });
+}
+
+void RenderTechnique::DrawMeshes(VkCommandBuffer commandBuffer,
+    const std::vector<MeshDraw>& draws, const char* pass, bool multiview,
+    VkDescriptorSet* cameraDescSet, VkDescriptorSet* lightDescSet)
+{
+    ZoneScopedN("RenderTechnique::DrawMeshes");
+
+    VulkanRenderer& vkr = VulkanRenderer::GetInstance();
+    bool depthOnly = lightDescSet == nullptr; // No material is read
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    bool pipelineBound = false;
+    VertexFormat boundFormat = VertexFormat::Standard;
+
+    for (const MeshDraw& draw: draws)
+    {
+        const MeshPacket& m = *draw.packet;
+        VertexFormat format = m.mesh->GetVertexFormat();
+
+        if (!pipelineBound || format != boundFormat)
+        {
+            std::string pipeline = (format == VertexFormat::Compact)?
+                (multiview? "renderCompactMultiview": "renderCompact"):
+                (multiview? "renderMultiview": "render");
+            pipeline += pass;
+            layout = vkr.GetPipelineLayout(pipeline).layout;
+
+            vkCmdBindPipeline(commandBuffer, 
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                vkr.GetPipeline(pipeline).pipeline);
+
+            vkCmdBindDescriptorSets(
+                commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
+                layout, 2, 1, cameraDescSet, 0, nullptr
+            );
+            if (!depthOnly)
+            { // All materials, draws only push their index.
+                vkCmdBindDescriptorSets(
+                    commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
+                    layout, 0, 1, vkr.GetBindless().GetDescriptorSet(), 0, nullptr
+                );
+                vkCmdBindDescriptorSets(
+                    commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
+                    layout, 3, 1, lightDescSet, 0, nullptr
+                );
+            }
+            pipelineBound = true;
+            boundFormat = format;
+        }
+
+        VulkanVertexbuffer& vvb = m.mesh->GetVertexbuffer();
+
+        vkCmdBindDescriptorSets(
+            commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
+            layout, 1, 1, &m.descSet, 0, nullptr
+        );
+
+        if (!depthOnly)
+        {
+            MaterialPushConst material{m.mesh->GetVulkanMaterial()->GetBindlessIndex()};
+            vkCmdPushConstants(commandBuffer, layout,
+                VK_SHADER_STAGE_FRAGMENT_BIT, MATERIAL_PUSH_OFFSET,
+                sizeof(MaterialPushConst), &material);
+        }
+
+        if (format == VertexFormat::Compact)
+        {
+            vkCmdPushConstants(commandBuffer, layout,
+                VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(VertexQuantization),
+                &m.mesh->GetQuantization());
+        }
+
+        const MeshLod& lod = m.mesh->GetLod(draw.lod);
+
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vvb.vertexBuffer, &offset);
+        vkCmdBindIndexBuffer(commandBuffer, vvb.indexBuffer, 0, vvb.GetIndexType());
+        vkCmdDrawIndexed(commandBuffer, lod.indexCount, 1, lod.firstIndex, 0, 0);
+    }
+}
+
+void RenderTechnique::UpdateInstances(VkCommandBuffer commandBuffer)
+{
+    ZoneScopedN("RenderTechnique::UpdateInstances");
+
+    VulkanCulling& culling = VulkanRenderer::GetInstance().GetCulling();
+    for (const MeshPacket& m: renderMesh)
+    {
+        MeshInstance& instance = *m.instance;
+        bool opaque = !m.mesh->GetVulkanMaterial()->IsTransparent();
+
+        // The mesh of a component can be replaced or become transparent.
+        if (instance.slot != GPU_INSTANCE_NONE && (instance.slotMesh != m.mesh || !opaque))
+        {
+            culling.RemoveInstance(instance.slot);
+            instance.slot = GPU_INSTANCE_NONE;
+            instance.slotMesh = nullptr;
+        }
+        if (!opaque)
+            continue;
+
+        if (instance.slot == GPU_INSTANCE_NONE)
+        {
+            instance.slot = culling.AddInstance(m.mesh.get());
+            instance.slotMesh = m.mesh;
+            instance.moved = true;
+        }
+
+        // Static meshes are not written again.
+        if (instance.moved)
+        {
+            culling.SetTransform(instance.slot, m.transform, GetWorldBounds(m));
+            instance.moved = false;
+        }
+        culling.SetMaterial(instance.slot,
+            m.mesh->GetVulkanMaterial()->GetBindlessIndex());
+        culling.KeepInstance(instance.slot);
+    }
+
+    culling.Upload(commandBuffer);
+}
+
+void RenderTechnique::DrawMeshesIndirect(VkCommandBuffer commandBuffer,
+    VulkanCamera& camera, const char* pass, bool multiview,
+    VkDescriptorSet* cameraDescSet, VkDescriptorSet* lightDescSet)
+{
+    ZoneScopedN("RenderTechnique::DrawMeshesIndirect");
+
+    VulkanRenderer& vkr = VulkanRenderer::GetInstance();
+    VulkanCulling& culling = vkr.GetCulling();
+    bool depthOnly = lightDescSet == nullptr; // No material is read
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    bool pipelineBound = false;
+    VertexFormat boundFormat = VertexFormat::Standard;
+
+    const std::vector<VulkanCulling::Batch>& batches = culling.GetBatches();
+    for (uint32_t i: culling.GetDrawOrder())
+    {
+        VulkanMesh* mesh = batches[i].mesh;
+        VertexFormat format = mesh->GetVertexFormat();
+
+        if (!pipelineBound || format != boundFormat)
+        {
+            std::string pipeline = (format == VertexFormat::Compact)?
+                (multiview? "renderCompactMultiview": "renderCompact"):
+                (multiview? "renderMultiview": "render");
+            pipeline += std::string(pass) + "Gpu";
+            layout = vkr.GetPipelineLayout(pipeline).layout;
+
+            vkCmdBindPipeline(commandBuffer, 
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                vkr.GetPipeline(pipeline).pipeline);
+
+            vkCmdBindDescriptorSets(
+                commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
+                layout, 1, 1, culling.GetInstanceSet(), 0, nullptr
+            );
+            vkCmdBindDescriptorSets(
+                commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
+                layout, 2, 1, cameraDescSet, 0, nullptr
+            );
+            if (!depthOnly)
+            { // Instances carry their material index.
+                vkCmdBindDescriptorSets(
+                    commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
+                    layout, 0, 1, vkr.GetBindless().GetDescriptorSet(), 0, nullptr
+                );
+                vkCmdBindDescriptorSets(
+                    commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
+                    layout, 3, 1, lightDescSet, 0, nullptr
+                );
+            }
+            pipelineBound = true;
+            boundFormat = format;
+        }
+
+        if (format == VertexFormat::Compact)
+        {
+            vkCmdPushConstants(commandBuffer, layout,
+                VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(VertexQuantization),
+                &mesh->GetQuantization());
+        }
+
+        VulkanVertexbuffer& vvb = mesh->GetVertexbuffer();
+
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vvb.vertexBuffer, &offset);
+        vkCmdBindIndexBuffer(commandBuffer, vvb.indexBuffer, 0, vvb.GetIndexType());
+        culling.DrawIndirect(commandBuffer, camera.culling, i);
+    }
+}
+
+void RenderTechnique::RenderShadows(VkCommandBuffer commandBuffer,
+    VulkanCamera& camera, const std::vector<MeshDraw>& casters,
+    uint32_t directionalCount)
+{
+    ZoneScopedN("RenderTechnique::RenderShadows");
+    TracyVkZone(tracyVkCtx, commandBuffer, "RenderTechnique::RenderShadows");
+
+    ShadowData& shadow = camera.lightMap->shadow;
+    if (directionalCount == 0)
+    {
+        shadow.light = glm::uvec4(0);
+        return;
+    }
+
+    VulkanRenderer& vkr = VulkanRenderer::GetInstance();
+
+    // The first directional light casts shadows.
+    glm::mat4 views[CAMERA_MAX_VIEWS];
+    glm::mat4 projections[CAMERA_MAX_VIEWS];
+    for (uint32_t view = 0; view < camera.viewCount; view++)
+    {
+        views[view] = camera.vpMap[view].view;
+        projections[view] = camera.vpMap[view].projection;
+    }
+    camera.shadowCascades.Fit(views, projections, camera.viewCount,
+        glm::vec3(lightList[0].direction));
+
+    std::vector<glm::vec4> spheres;
+    spheres.reserve(casters.size());
+    for (const MeshDraw& draw: casters)
+        spheres.push_back(draw.sphere);
+
+    std::vector<uint32_t> culled;
+    std::vector<MeshDraw> draws;
+    for (uint32_t c = 0; c < SHADOW_CASCADE_COUNT; c++)
+    {
+        camera.shadowCascades.Cull(c, spheres.data(),
+            static_cast<uint32_t>(spheres.size()), culled);
+
+        const ShadowCascades::Cascade& cascade = camera.shadowCascades.GetCascade(c);
+        shadow.cascades[c] = cascade.viewProjection;
+        shadow.splitDepth[c] = cascade.splitDepth;
+        shadow.texelSize[c] = cascade.texelSize;
+
+        // FNV-1a of everything that ends up in the cascade. Distant cascades
+        // move in large texels, so with static casters they are rarely drawn.
+        uint64_t key = 14695981039346656037ull;
+        auto hash = [&key](const void* data, size_t size) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; i++)
+            {
+                key ^= bytes[i];
+                key *= 1099511628211ull;
+            }
+        };
+        hash(&cascade.viewProjection, sizeof(glm::mat4));
+        for (uint32_t i: culled)
+        {
+            const MeshDraw& draw = casters[i];
+            const VulkanMesh* mesh = draw.packet->mesh.get();
+            hash(&mesh, sizeof(mesh));
+            hash(&draw.lod, sizeof(draw.lod));
+            hash(&draw.packet->transform, sizeof(glm::mat4));
+        }
+
+        if (key == camera.shadowKeys[c])
+            continue;
+        camera.shadowKeys[c] = key;
+
+        camera.shadowVpMaps[c]->view = glm::mat4(1.0f);
+        camera.shadowVpMaps[c]->projection = cascade.viewProjection;
+
+        draws.clear();
+        for (uint32_t i: culled)
+            draws.push_back(casters[i]);
+
+        VkClearValue clearValue{};
+        clearValue.depthStencil = {1.0f, 0};
+
+        VkRenderPassBeginInfo vkRenderPassInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+        vkRenderPassInfo.renderPass = vkr.vkRenderPass.shadow;
+        vkRenderPassInfo.framebuffer = camera.shadowFramebuffers[c];
+        vkRenderPassInfo.renderArea.extent = {SHADOW_MAP_SIZE, SHADOW_MAP_SIZE};
+        vkRenderPassInfo.clearValueCount = 1;
+        vkRenderPassInfo.pClearValues = &clearValue;
+        vkCmdBeginRenderPass(commandBuffer, &vkRenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport{};
+        viewport.width = static_cast<float>(SHADOW_MAP_SIZE);
+        viewport.height = static_cast<float>(SHADOW_MAP_SIZE);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+        VkRect2D scissor{};
+        scissor.extent = {SHADOW_MAP_SIZE, SHADOW_MAP_SIZE};
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        DrawMeshes(commandBuffer, draws, "Shadow", false,
+            &camera.shadowDescSets[c], nullptr);
+
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+    shadow.light = glm::uvec4(1, 0, 0, 0);
+}
+
+glm::vec3 RenderTechnique::ReadPassTimes(VulkanCamera& camera)
+{
+    ZoneScopedN("RenderTechnique::ReadPassTimes");
+
+    if (!camera.timestampsWritten)
+        return camera.passTimes;
+
+    uint32_t viewCount = camera.GetViewCount();
+    uint64_t timestamps[CAMERA_TIMESTAMP_COUNT * CAMERA_MAX_VIEWS];
+    VkResult result = vkGetQueryPoolResults(camera.vulkanDevice->vkDevice,
+        camera.timestampPool, 0, CAMERA_TIMESTAMP_COUNT * viewCount,
+        sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS)
+        return camera.passTimes;
+
+    float period = VulkanRenderer::GetInstance().GetTimestampPeriod();
+    auto elapsed = [&](uint32_t from, uint32_t to) {
+        uint64_t begin = timestamps[from * viewCount];
+        uint64_t end = timestamps[to * viewCount];
+        return (end > begin)? static_cast<float>(end - begin) * period * 1e-6f: 0.0f;
+    };
+
+    camera.passTimes = glm::vec3(
+        elapsed(CAMERA_TIMESTAMP_BEGIN, CAMERA_TIMESTAMP_DEPTH_PREPASS),
+        elapsed(CAMERA_TIMESTAMP_DEPTH_PREPASS, CAMERA_TIMESTAMP_OPAQUE),
+        elapsed(CAMERA_TIMESTAMP_OPAQUE, CAMERA_TIMESTAMP_TRANSPARENT));
+    return camera.passTimes;
+}
+
+uint32_t RenderTechnique::SelectLod(const MeshPacket& packet, VulkanCamera& camera)
+{
+    ZoneScopedN("RenderTechnique::SelectLod");
+
+    uint32_t lodCount = packet.mesh->GetLodCount();
+    if (lodCount <= 1)
+        return 0;
+
+    glm::vec4 sphere = GetWorldBounds(packet);
+    float radius = sphere.w;
+
+    glm::vec3 viewCenter = glm::vec3(
+        camera.GetTransform() * glm::vec4(glm::vec3(sphere), 1.0f));
+    float distance = glm::length(viewCenter);
+
+    // Fraction of the view height covered by the bounding sphere
+    float screenSize = (distance > radius)?
+        radius * std::abs(camera.GetProjection()[1][1]) / distance:
+        std::numeric_limits<float>::max();
+
+    auto it = camera.lastLods.find(packet.instance->id);
+    uint32_t previous = (it != camera.lastLods.end())? it->second: lodCount;
+    uint32_t level = GpuCulling::SelectLod(screenSize, lodCount, previous);
+
+    camera.currentLods[packet.instance->id] = level;
+    return level;
 }
 
 void RenderTechnique::PushRendererData(const MeshPacket& meshPacket)
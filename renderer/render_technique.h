@@ -3,13 +3,16 @@
 #include "vk_primitives/vulkan_uniform.h"
 #include "vk_primitives/vulkan_vertexbuffer.h"
 
+#include "gpu_culling.h"
 #include "vulkan_camera.h"
+#include "vulkan_culling.h"
 #include "vulkan_light.h"
 #include "vulkan_mesh.h"
 #include "vulkan_wireframe.h"
 #include "vulkan_ui.h"
 
 #include <vulkan/vulkan.h>
+#include <atomic>
 #include <vector>
 #include <memory>
 
@@ -19,12 +22,42 @@ namespace renderer
 class RenderTechnique
 {
 public:
+    /**
+     * State of a mesh kept across frames, owned by its component.
+     */
+    struct MeshInstance
+    {
+        // Key of the LODs chosen by the cameras, never reused
+        uint64_t id = NewId();
+        // Slot in the instance table of VulkanCulling, opaque meshes only
+        uint32_t slot = GPU_INSTANCE_NONE;
+        std::shared_ptr<VulkanMesh> slotMesh; // Mesh the slot was added for
+        bool moved = true; // Transform changed since the slot was written
+
+        // Meshes are imported in parallel on the job system
+        static uint64_t NewId()
+        {
+            static std::atomic<uint64_t> nextId{0};
+            return nextId.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
     struct MeshPacket
     {
         std::shared_ptr<VulkanMesh> mesh;
         VkDescriptorSet descSet; // Mesh transform
         // FIXME: descset is not protected by shared_ptr
         // freee std::__ptr node can have memory access error. 
+        glm::mat4 transform;
+        MeshInstance* instance;
+    };
+
+    struct MeshDraw
+    {
+        const MeshPacket* packet;
+        uint32_t lod;
+        float depth; // View space depth of the bounding sphere center
+        glm::vec4 sphere; // World space bounds, center and radius
     };
 
 public:
@@ -40,7 +73,7 @@ public:
     void ExecuteCommand(VkCommandBuffer commandBuffer);
     VkDescriptorSet* GetXrDisplayDescSet() {return xrDisplay;}
 
-    void PushRendererData(const DirLight& dirLight);
+    void PushRendererData(const LightData& light);
     void PushRendererData(const MeshPacket& meshPacket);
     void PushRendererData(const std::shared_ptr<VulkanUI> ui);
     void PushRendererData(const std::vector<renderer::WirePushConst>& wireList);
@@ -48,12 +81,63 @@ public:
     void PushRendererData(const std::shared_ptr<LineRenderer> lineRenderer);
 
 private:
+    /**
+     * Pick a level of detail from the projected size
+     * of the mesh bounding sphere. A level only changes when the size
+     * moves past its threshold by more than MESH_LOD_HYSTERESIS.
+     */
+    static uint32_t SelectLod(const MeshPacket& packet, VulkanCamera& camera);
 
-    struct SceneData
-    { // only the first element is nLight is used.
-        glm::uvec4 nLight; // dirLight index has to be less that nLight
-        DirLight dirLight[5];
-    };
+    /**
+     * Copy the lights into the light buffer of the camera
+     * and bin all but the first directionalCount into
+     * the clusters of each view.
+     */
+    void UpdateLights(VulkanCamera& camera, uint32_t directionalCount);
+
+    /**
+     * Split the meshes into opaque draws sorted front to back
+     * and transparent draws sorted back to front, as seen by the camera.
+     */
+    void SortMeshes(VulkanCamera& camera,
+        std::vector<MeshDraw>& opaqueDraws, std::vector<MeshDraw>& transparentDraws);
+
+    /**
+     * Record the draws with the mesh pipelines of a pass:
+     * "" for the default one, "Depth", "Equal", "Transparent" or "Shadow".
+     * Without a light descriptor set, materials are not bound either.
+     */
+    void DrawMeshes(VkCommandBuffer commandBuffer, const std::vector<MeshDraw>& draws,
+        const char* pass, bool multiview, VkDescriptorSet* cameraDescSet,
+        VkDescriptorSet* lightDescSet);
+
+    /**
+     * Give the opaque meshes a slot in the instance table of VulkanCulling,
+     * write the slots of the meshes that moved and record their upload.
+     * Must be recorded outside of a render pass.
+     */
+    void UpdateInstances(VkCommandBuffer commandBuffer);
+
+    /**
+     * Same as DrawMeshes for the opaque meshes kept by the last
+     * VulkanCulling::Cull of the camera, with the "Gpu" pipelines.
+     */
+    void DrawMeshesIndirect(VkCommandBuffer commandBuffer, VulkanCamera& camera,
+        const char* pass, bool multiview, VkDescriptorSet* cameraDescSet,
+        VkDescriptorSet* lightDescSet);
+
+    /**
+     * Fit the shadow cascades of the first directional light to the camera
+     * and draw the cascades whose matrix or casters changed.
+     * Must be recorded outside of a render pass.
+     */
+    void RenderShadows(VkCommandBuffer commandBuffer, VulkanCamera& camera,
+        const std::vector<MeshDraw>& casters, uint32_t directionalCount);
+
+    /**
+     * GPU time of the passes of the last frame of the camera, in milliseconds.
+     */
+    static glm::vec3 ReadPassTimes(VulkanCamera& camera);
 
     /**
      * Using shared_ptr can resolve resource deallocation issue that
@@ -64,11 +148,10 @@ private:
     std::vector<WirePushConst> wireList{};
     std::vector<std::shared_ptr<VulkanUI>> uiList{};
     std::vector<std::shared_ptr<LineRenderer>> lineList{};
+    std::vector<LightData> lightList{};
 
-
-    VulkanUniform sceneUniform{};
-    VkDescriptorSet sceneDescSet;
-    SceneData *sceneMap = nullptr; // 5 directional light elements
+    bool lightOverflowLogged = false;
+    bool clusterOverflowLogged = false;
 
     VkDescriptorSet xrDisplay[2];
 
@@ -0,0 +1,159 @@
+#include "shadow_cascades.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tracy/Tracy.hpp>
+
+
+void ShadowCascades::Fit(const glm::mat4* views, const glm::mat4* projections,
+    uint32_t viewCount, glm::vec3 direction)
+{
+    ZoneScopedN("ShadowCascades::Fit");
+
+    // depth = p32 / (z_ndc + p22), see LightClustering::SetProjection
+    const glm::mat4& projection = projections[0];
+    float p22 = projection[2][2];
+    float p32 = projection[3][2];
+    auto depthAt = [p22, p32](float zNdc) {
+        float denom = zNdc + p22;
+        float depth = (std::abs(denom) > 1e-7f)? p32 / denom: -1.0f;
+        return (depth > 0.0f)? depth: std::numeric_limits<float>::max();
+    };
+    float depth0 = depthAt(0.0f);
+    float depth1 = depthAt(1.0f);
+
+    float zNear = std::max(std::min(depth0, depth1), 1e-3f);
+    float zFar = std::min(std::max(depth0, depth1), SHADOW_MAX_DISTANCE);
+    zFar = std::max(zFar, zNear * 1.001f);
+
+    glm::vec3 forward = glm::normalize(direction);
+    glm::vec3 up = (std::abs(forward.y) < 0.99f)?
+        glm::vec3(0.0f, 1.0f, 0.0f): glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 right = glm::normalize(glm::cross(forward, up));
+    up = glm::cross(right, forward);
+
+    lightView = glm::mat4(1.0f);
+    for (int i = 0; i < 3; i++)
+    {
+        lightView[i][0] = right[i];
+        lightView[i][1] = up[i];
+        lightView[i][2] = -forward[i];
+    }
+
+    glm::mat4 viewToWorld[2];
+    uint32_t cornerViews = std::min(viewCount, 2u);
+    for (uint32_t v = 0; v < cornerViews; v++)
+        viewToWorld[v] = glm::inverse(views[v]);
+
+    float sliceNear = zNear;
+    for (uint32_t c = 0; c < SHADOW_CASCADE_COUNT; c++)
+    {
+        // Logarithmic splits keep the texel to pixel ratio even,
+        // uniform ones keep the near cascades from getting too small.
+        float t = static_cast<float>(c + 1) / SHADOW_CASCADE_COUNT;
+        float sliceFar = SHADOW_SPLIT_LAMBDA * zNear * std::pow(zFar / zNear, t) +
+            (1.0f - SHADOW_SPLIT_LAMBDA) * (zNear + (zFar - zNear) * t);
+        if (c == SHADOW_CASCADE_COUNT - 1)
+            sliceFar = zFar;
+
+        glm::vec3 corners[16];
+        uint32_t cornerCount = 0;
+        for (uint32_t v = 0; v < cornerViews; v++)
+        {
+            const glm::mat4& p = projections[v];
+            for (float depth: {sliceNear, sliceFar})
+            {
+                for (uint32_t corner = 0; corner < 4; corner++)
+                {
+                    float x = (corner % 2)? 1.0f: -1.0f;
+                    float y = (corner / 2)? 1.0f: -1.0f;
+                    glm::vec4 point(
+                        depth * (x + p[2][0]) / p[0][0],
+                        depth * (y + p[2][1]) / p[1][1],
+                        -depth, 1.0f);
+                    corners[cornerCount++] = glm::vec3(viewToWorld[v] * point);
+                }
+            }
+        }
+
+        glm::vec3 center(0.0f);
+        for (uint32_t i = 0; i < cornerCount; i++)
+            center += corners[i];
+        center /= static_cast<float>(cornerCount);
+
+        float radius = 0.0f;
+        for (uint32_t i = 0; i < cornerCount; i++)
+            radius = std::max(radius, glm::length(corners[i] - center));
+
+        // The corners move rigidly with the camera, so the radius only changes
+        // with the projection. Rounding hides the error of the inverse views.
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+        float texelSize = 2.0f * radius / SHADOW_MAP_SIZE;
+
+        glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+        lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+        lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+
+        centers[c] = lightCenter;
+        radii[c] = radius;
+        zMin[c] = lightCenter.z - radius;
+        zMax[c] = lightCenter.z + radius;
+
+        cascades[c].splitDepth = sliceFar;
+        cascades[c].texelSize = texelSize;
+        UpdateMatrix(c);
+
+        sliceNear = sliceFar;
+    }
+}
+
+void ShadowCascades::Cull(uint32_t cascade, const glm::vec4* spheres,
+    uint32_t count, std::vector<uint32_t>& casters)
+{
+    ZoneScopedN("ShadowCascades::Cull");
+
+    casters.clear();
+
+    const glm::vec3& center = centers[cascade];
+    float radius = radii[cascade];
+    zMax[cascade] = center.z + radius;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        glm::vec3 p = glm::vec3(lightView * glm::vec4(glm::vec3(spheres[i]), 1.0f));
+        float r = spheres[i].w;
+
+        if (std::abs(p.x - center.x) > radius + r ||
+            std::abs(p.y - center.y) > radius + r)
+            continue;
+
+        // Entirely behind what the cascade receives shadows on.
+        if (p.z + r < zMin[cascade])
+            continue;
+
+        casters.push_back(i);
+        zMax[cascade] = std::max(zMax[cascade], p.z + r);
+    }
+
+    UpdateMatrix(cascade);
+}
+
+void ShadowCascades::UpdateMatrix(uint32_t cascade)
+{
+    const glm::vec3& center = centers[cascade];
+    float radius = radii[cascade];
+    float depthRange = zMax[cascade] - zMin[cascade];
+
+    // Orthographic, x and y in [-1, 1] around the center,
+    // depth 0 closest to the light.
+    glm::mat4 projection(1.0f);
+    projection[0][0] = 1.0f / radius;
+    projection[1][1] = 1.0f / radius;
+    projection[2][2] = -1.0f / depthRange;
+    projection[3][0] = -center.x / radius;
+    projection[3][1] = -center.y / radius;
+    projection[3][2] = zMax[cascade] / depthRange;
+
+    cascades[cascade].viewProjection = projection * lightView;
+}
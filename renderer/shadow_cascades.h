@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Mirrored in Phong/shader.frag, the split depths of all cascades fit in a vec4.
+#define SHADOW_CASCADE_COUNT    4
+#define SHADOW_MAP_SIZE         2048    // Texels per side of a cascade
+#define SHADOW_MAX_DISTANCE     80.0f   // Cascades end here or at the far plane
+#define SHADOW_SPLIT_LAMBDA     0.75f   // Share of logarithmic over uniform splits
+
+/**
+ * @brief Fit the cascaded shadow maps of a directional light
+ * to the views of a camera.
+ *
+ * The view frustum up to SHADOW_MAX_DISTANCE is split into
+ * SHADOW_CASCADE_COUNT slices, each covered by one cascade.
+ * A cascade bounds its slice with a sphere, so its size does not change
+ * when the camera turns, and it only moves in whole shadow map texels,
+ * so shadow edges do not shimmer when the camera moves.
+ * Toward the light, the depth range of a cascade is extended
+ * to contain the casters culled into it.
+ */
+class ShadowCascades
+{
+public:
+    struct Cascade
+    {
+        glm::mat4 viewProjection; // World to shadow map clip space, depth in [0, 1]
+        float splitDepth;         // Far end of the slice in view depth
+        float texelSize;          // World size of a shadow map texel
+    };
+
+    /**
+     * @brief Fit the cascades to the views. All views share the depth range
+     * of the first projection, with the same assumptions as LightClustering.
+     *
+     * @param views world to view matrices
+     * @param direction direction the light travels in, in world space
+     */
+    void Fit(const glm::mat4* views, const glm::mat4* projections,
+        uint32_t viewCount, glm::vec3 direction);
+
+    /**
+     * @brief Find the casters that can throw a shadow into the cascade
+     * and extend its depth range toward the light to contain them.
+     *
+     * @param spheres world space bounds, center and radius
+     * @param casters indices of the spheres in the cascade, cleared first
+     */
+    void Cull(uint32_t cascade, const glm::vec4* spheres, uint32_t count,
+        std::vector<uint32_t>& casters);
+
+    const Cascade& GetCascade(uint32_t cascade) const {return cascades[cascade];}
+
+private:
+    void UpdateMatrix(uint32_t cascade);
+
+private:
+    // Rotation into light space, looking down -z. It only depends on the
+    // light, so the texel grid of a cascade is fixed in the world.
+    glm::mat4 lightView{1.0f};
+    Cascade cascades[SHADOW_CASCADE_COUNT]{};
+
+    // Light space bounds of each cascade, centers snapped to the texel grid.
+    glm::vec3 centers[SHADOW_CASCADE_COUNT]{};
+    float radii[SHADOW_CASCADE_COUNT]{};
+    float zMin[SHADOW_CASCADE_COUNT]{};
+    float zMax[SHADOW_CASCADE_COUNT]{};
+};
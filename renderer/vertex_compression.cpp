@@ -0,0 +1,215 @@
+#include "vertex_compression.h"
+
+#include <cmath>
+#include <cstring>
+#include <tracy/Tracy.hpp>
+
+
+namespace renderer
+{
+
+static float SignNotZero(float value)
+{
+    return (value >= 0.0f)? 1.0f: -1.0f;
+}
+
+static uint16_t QuantizeUnorm16(float value)
+{
+    value = glm::clamp(value, 0.0f, 1.0f);
+    return static_cast<uint16_t>(std::lround(value * 65535.0f));
+}
+
+static int16_t QuantizeSnorm16(float value)
+{
+    value = glm::clamp(value, -1.0f, 1.0f);
+    return static_cast<int16_t>(std::lround(value * 32767.0f));
+}
+
+VertexQuantization ComputeQuantization(const Vertex* vertices, uint64_t count)
+{
+    ZoneScopedN("ComputeQuantization");
+
+    glm::vec3 minBound{0.0f};
+    glm::vec3 maxBound{0.0f};
+
+    if (count > 0)
+    {
+        minBound = vertices[0].Position;
+        maxBound = vertices[0].Position;
+    }
+
+    for (uint64_t i = 1; i < count; i++)
+    {
+        minBound = glm::min(minBound, vertices[i].Position);
+        maxBound = glm::max(maxBound, vertices[i].Position);
+    }
+
+    glm::vec3 extent = maxBound - minBound;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (extent[axis] <= 0.0f)
+            extent[axis] = 1.0f;
+    }
+
+    VertexQuantization quantization{};
+    quantization.offset = glm::vec4(minBound, 0.0f);
+    quantization.scale = glm::vec4(extent, 0.0f);
+    return quantization;
+}
+
+void CompressVertices(const Vertex* src, uint64_t count,
+    const VertexQuantization& quantization, CompactVertex* dst)
+{
+    ZoneScopedN("CompressVertices");
+
+    glm::vec3 offset = glm::vec3(quantization.offset);
+    glm::vec3 invScale = glm::vec3(1.0f) / glm::vec3(quantization.scale);
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        const Vertex& in = src[i];
+        CompactVertex out;
+
+        glm::vec3 unorm = (in.Position - offset) * invScale;
+        out.Position[0] = QuantizeUnorm16(unorm.x);
+        out.Position[1] = QuantizeUnorm16(unorm.y);
+        out.Position[2] = QuantizeUnorm16(unorm.z);
+        out.Position[3] = 0;
+
+        glm::vec2 oct = OctEncode(in.Normal);
+        out.Normal[0] = QuantizeSnorm16(oct.x);
+        out.Normal[1] = QuantizeSnorm16(oct.y);
+
+        out.TexCoords[0] = FloatToHalf(in.TexCoords.x);
+        out.TexCoords[1] = FloatToHalf(in.TexCoords.y);
+
+        // Write the whole vertex at once, dst can be write-combined memory.
+        memcpy(&dst[i], &out, sizeof(CompactVertex));
+    }
+}
+
+void CompressIndices(const unsigned int* src, uint64_t count,
+    CompactVertexIndex* dst)
+{
+    ZoneScopedN("CompressIndices");
+
+    for (uint64_t i = 0; i < count; i++)
+        dst[i] = static_cast<CompactVertexIndex>(src[i]);
+}
+
+glm::vec2 OctEncode(glm::vec3 normal)
+{
+    float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 == 0.0f)
+        return glm::vec2(0.0f, 0.0f);
+
+    normal = normal / l1;
+    glm::vec2 encoded{normal.x, normal.y};
+
+    if (normal.z < 0.0f)
+    { // Fold the lower hemisphere over the diagonals.
+        encoded = glm::vec2(
+            (1.0f - std::abs(normal.y)) * SignNotZero(normal.x),
+            (1.0f - std::abs(normal.x)) * SignNotZero(normal.y)
+        );
+    }
+
+    return encoded;
+}
+
+glm::vec3 OctDecode(glm::vec2 encoded)
+{
+    glm::vec3 normal{
+        encoded.x, encoded.y,
+        1.0f - std::abs(encoded.x) - std::abs(encoded.y)
+    };
+
+    if (normal.z < 0.0f)
+    {
+        float x = normal.x;
+        normal.x = (1.0f - std::abs(normal.y)) * SignNotZero(x);
+        normal.y = (1.0f - std::abs(x)) * SignNotZero(normal.y);
+    }
+
+    return glm::normalize(normal);
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF);
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF) // Inf or NaN
+        return sign | 0x7C00 | (mantissa? 0x200: 0);
+
+    exponent = exponent - 127 + 15;
+    if (exponent >= 0x1F) // Overflow to Inf
+        return sign | 0x7C00;
+
+    if (exponent <= 0)
+    { // Subnormal half or zero
+        if (exponent < -10)
+            return sign;
+
+        mantissa |= 0x800000;
+        uint32_t shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+            half++;
+        return sign | half;
+    }
+
+    // Round to nearest even. A carry correctly bumps the exponent.
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        half++;
+    return sign | half;
+}
+
+float HalfToFloat(uint16_t value)
+{
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+
+    uint32_t bits;
+    if (exponent == 0x1F)
+    {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        { // Normalize the subnormal half.
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400) == 0)
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            mantissa &= 0x3FF;
+            bits = sign | (exponent << 23) | (mantissa << 13);
+        }
+    }
+    else
+    {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+} // namespace renderer
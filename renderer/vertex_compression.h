@@ -0,0 +1,48 @@
+#pragma once
+
+#include "mesh.h"
+#include "pipeline_inputs.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+
+namespace renderer
+{
+
+/**
+ * @brief Compute the bounds used to quantize positions of the vertices.
+ * Degenerated axes get a scale of 1 so that decoding stays finite.
+ */
+VertexQuantization ComputeQuantization(const Vertex* vertices, uint64_t count);
+
+/**
+ * @brief Convert full precision vertices into CompactVertex.
+ * dst must have room for count elements.
+ * It can point to mapped GPU memory.
+ */
+void CompressVertices(const Vertex* src, uint64_t count,
+    const VertexQuantization& quantization, CompactVertex* dst);
+
+/**
+ * @brief Convert 32-bit indices into 16-bit indices.
+ * Caller must ensure all indices are less than 65536.
+ */
+void CompressIndices(const unsigned int* src, uint64_t count,
+    CompactVertexIndex* dst);
+
+/**
+ * @brief 16-bit indices can address at most 65536 vertices.
+ */
+inline bool CanUseCompactIndices(uint64_t vertexCount)
+{
+    return vertexCount <= 65536;
+}
+
+glm::vec2 OctEncode(glm::vec3 normal);
+glm::vec3 OctDecode(glm::vec2 encoded);
+
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+
+} // namespace renderer
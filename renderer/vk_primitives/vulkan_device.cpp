@@ -5,6 +5,7 @@
 
 #include <vector>
 #include <string>
+#include <cstring>
 
 #include <tracy/Tracy.hpp>
 
@@ -37,6 +38,21 @@ uint32_t VulkanDevice::GetMemoryTypeIndex(uint32_t memoryType, VkMemoryPropertyF
     return -1;
 }
 
+bool VulkanDevice::HasExtension(VkPhysicalDevice gpu, const char* name)
+{
+    ZoneScopedN("VulkanDevice::HasExtension");
+
+    uint32_t extensionsCount;
+    vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extensionsCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionsCount);
+    vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extensionsCount, extensions.data());
+
+    for (const VkExtensionProperties& extension: extensions)
+        if (std::strcmp(extension.extensionName, name) == 0)
+            return true;
+    return false;
+}
+
 void VulkanDevice::InitializePhysicalDevice()
 {
     ZoneScopedN("VulkanDevice::InitializePhysicalDevice");
@@ -46,18 +62,36 @@ void VulkanDevice::InitializePhysicalDevice()
     VkPhysicalDevice* gpuList = (VkPhysicalDevice*)malloc(sizeof(VkPhysicalDevice) * gpuCount);
     CHECK_VKCMD(vkEnumeratePhysicalDevices(vkInstance, &gpuCount, gpuList));
 
-    int gpuIndex = 0;
+    // Meshes are only rendered with bindless materials, so a device
+    // without descriptor indexing cannot be used. Prefer a discrete one.
+    int gpuIndex = -1;
     for (int i = 0; i < static_cast<int>(gpuCount); i++)
     {
+        if (!HasExtension(gpuList[i], VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+            continue;
+
         VkPhysicalDeviceProperties properties;
         vkGetPhysicalDeviceProperties(gpuList[i], &properties);
-        if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+        if (gpuIndex < 0 ||
+            properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
         {
             gpuIndex = i;
-            break;
+            if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+                break;
         }
     }
 
+    if (gpuIndex < 0)
+    {
+        free(gpuList);
+        Logger::Write(
+            "[Vulkan Device] No device supports VK_EXT_descriptor_indexing.",
+            Logger::Level::Error,
+            Logger::MsgType::Renderer
+        );
+        ASSERT(false);
+    }
+
     vkPhysicalDevice = gpuList[gpuIndex];
     free(gpuList);
 
@@ -88,14 +122,101 @@ void VulkanDevice::InitializeLogicalDevice(std::vector<const char*> extensions)
     {
         if (std::strcmp(extensionProperty.extensionName, "VK_KHR_portability_subset") == 0)
             extensions.push_back("VK_KHR_portability_subset");
+
+        // Single pass stereo rendering
+        if (std::strcmp(extensionProperty.extensionName, VK_KHR_MULTIVIEW_EXTENSION_NAME) == 0)
+            multiviewSupported = true;
+
+        // Bindless materials and textures
+        if (std::strcmp(extensionProperty.extensionName,
+            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) == 0)
+            descriptorIndexingSupported = true;
+
+        // GPU culling
+        if (std::strcmp(extensionProperty.extensionName,
+            VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0)
+            drawIndirectCountSupported = true;
     }
 
+    // Indirect draws of GPU culling hold many instances with their own
+    // material, so the texture array is indexed with non-uniform values.
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT supportedIndexing{
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT};
+    PFN_vkGetPhysicalDeviceFeatures2KHR getFeatures2 =
+        reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+            vkGetInstanceProcAddr(vkInstance, "vkGetPhysicalDeviceFeatures2KHR"));
+    if (descriptorIndexingSupported && getFeatures2 != nullptr)
+    {
+        VkPhysicalDeviceFeatures2KHR features2{
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
+        features2.pNext = &supportedIndexing;
+        getFeatures2(vkPhysicalDevice, &features2);
+    }
+    drawIndirectCountSupported = drawIndirectCountSupported &&
+        vkFeatures.multiDrawIndirect && vkFeatures.drawIndirectFirstInstance &&
+        supportedIndexing.shaderSampledImageArrayNonUniformIndexing;
+
+    auto requestExtension = [&extensions](const char* name) {
+        for (const char* extension: extensions)
+            if (std::strcmp(extension, name) == 0)
+                return;
+        extensions.push_back(name);
+    };
+
+    VkPhysicalDeviceMultiviewFeaturesKHR multiviewFeatures{
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES_KHR};
+    if (multiviewSupported)
+    {
+        requestExtension(VK_KHR_MULTIVIEW_EXTENSION_NAME);
+
+        // Required to be supported by every device exposing the extension.
+        multiviewFeatures.multiview = VK_TRUE;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures{
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT};
+    if (descriptorIndexingSupported)
+    {
+        requestExtension(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+        requestExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+
+        // Also required to be supported with the extension.
+        descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    }
+
+    VkPhysicalDeviceFeatures enabledFeatures{};
+    if (drawIndirectCountSupported)
+    {
+        requestExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+        enabledFeatures.multiDrawIndirect = VK_TRUE;
+        enabledFeatures.drawIndirectFirstInstance = VK_TRUE;
+        descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    }
+
+    // Chain the features of the enabled extensions.
+    void* features = nullptr;
+    if (descriptorIndexingSupported)
+    {
+        descriptorIndexingFeatures.pNext = features;
+        features = &descriptorIndexingFeatures;
+    }
+    if (multiviewSupported)
+    {
+        multiviewFeatures.pNext = features;
+        features = &multiviewFeatures;
+    }
 
     VkDeviceCreateInfo vkDeviceCreateInfo{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
     vkDeviceCreateInfo.queueCreateInfoCount = 1;
     vkDeviceCreateInfo.pQueueCreateInfos = &vkQueueCreateInfo;
     vkDeviceCreateInfo.enabledExtensionCount = (uint32_t)extensions.size();
     vkDeviceCreateInfo.ppEnabledExtensionNames = extensions.data();
+    vkDeviceCreateInfo.pEnabledFeatures = &enabledFeatures;
+    vkDeviceCreateInfo.pNext = features;
 
     // Create logical device and device queues.
     CHECK_VKCMD(vkCreateDevice(vkPhysicalDevice, &vkDeviceCreateInfo, nullptr, &vkDevice));
@@ -10,6 +10,7 @@ public:
     void Initialize(VkInstance vkInstance, std::vector<const char*> deviceExt);
     uint32_t GetMemoryTypeIndex(uint32_t memoryType, VkMemoryPropertyFlags memoryProperties);
     VkFormat GetDepthFormat();
+    const VkPhysicalDeviceProperties& GetProperties() {return vkProperties;}
     void Destroy();
 
 private:
@@ -18,6 +19,7 @@ private:
         std::vector<const char*> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME});
 
     void GetPhysicalDeviceInfo();
+    static bool HasExtension(VkPhysicalDevice gpu, const char* name);
     uint32_t GetQueueFamilyIndex(VkQueueFlags vkQueueFlags);
 
 public:
@@ -28,6 +30,15 @@ public:
     uint32_t graphicsIndex;
     VkQueue graphicsQueue;
 
+    // VK_KHR_multiview is enabled when the device exposes it.
+    bool multiviewSupported = false;
+    // VK_EXT_descriptor_indexing, required by the bindless materials.
+    // Devices without it are not selected.
+    bool descriptorIndexingSupported = false;
+    // VK_KHR_draw_indirect_count with multi draw indirect and
+    // non-uniform texture indexing, required by GPU culling.
+    bool drawIndirectCountSupported = false;
+
 private: 
     std::vector<VkQueueFamilyProperties> vkQueueFamilyProperties;
     std::vector<VkExtensionProperties> vkExtensionProperties;
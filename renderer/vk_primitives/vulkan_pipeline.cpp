@@ -3,6 +3,7 @@
 #include "vulkan_shader.h"
 #include "validation.h"
 #include "logger.h"
+#include "job_system.h"
 
 #include <string>
 #include <memory>
@@ -102,41 +103,125 @@ void VulkanPipeline::LoadShader(std::string vertPath, std::string fragPath)
 {
     ZoneScopedN("VulkanPipeline::LoadShader");
 
-    shaderStages = {
-        VulkanShader::LoadFromFile(device, vertPath, VK_SHADER_STAGE_VERTEX_BIT),
-        VulkanShader::LoadFromFile(device, fragPath, VK_SHADER_STAGE_FRAGMENT_BIT)
-    };
+    this->vertPath = vertPath;
+    this->fragPath = fragPath;
+}
 
-    vkPipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-    vkPipelineInfo.pStages = shaderStages.data();
+void VulkanPipeline::BuildPipeline(
+    VkPipelineVertexInputStateCreateInfo* vertexInputInfo,
+    std::unique_ptr<VulkanPipelineLayout> pipelineLayout,
+    VkRenderPass renderPass, VkPipelineCache pipelineCache
+){
+    ZoneScopedN("VulkanPipeline::BuildPipeline");
 
-    this->vertShader = shaderStages[0].module;
-    this->fragShader = shaderStages[1].module;
+    PreparePipeline(vertexInputInfo, std::move(pipelineLayout), renderPass);
+    CompilePipeline(pipelineCache);
 }
 
-void VulkanPipeline::BuildPipeline(
+void VulkanPipeline::PreparePipeline(
     VkPipelineVertexInputStateCreateInfo* vertexInputInfo,
     std::unique_ptr<VulkanPipelineLayout> pipelineLayout,
     VkRenderPass renderPass
 ){
-    ZoneScopedN("VulkanPipeline::BuildPipeline");
+    ZoneScopedN("VulkanPipeline::PreparePipeline");
+
+    vertexBindings.assign(vertexInputInfo->pVertexBindingDescriptions,
+        vertexInputInfo->pVertexBindingDescriptions +
+        vertexInputInfo->vertexBindingDescriptionCount);
+    vertexAttributes.assign(vertexInputInfo->pVertexAttributeDescriptions,
+        vertexInputInfo->pVertexAttributeDescriptions +
+        vertexInputInfo->vertexAttributeDescriptionCount);
+
+    vertexInputState = *vertexInputInfo;
+    vertexInputState.pVertexBindingDescriptions = vertexBindings.data();
+    vertexInputState.pVertexAttributeDescriptions = vertexAttributes.data();
+
+    vkPipelineInfo.pVertexInputState = &vertexInputState;
+    vkPipelineInfo.layout = pipelineLayout->layout;
+    vkPipelineInfo.renderPass = renderPass;
+
+    this->pipelineLayout = std::move(pipelineLayout);
+}
+
+void VulkanPipeline::CompilePipeline(VkPipelineCache pipelineCache)
+{
+    ZoneScopedN("VulkanPipeline::CompilePipeline");
+
+    LoadShaderStages();
+    VkResult result = CreatePipeline(pipelineCache);
+    DestroyShaderStages();
+    CHECK_VKCMD(result);
+}
 
-    if (shaderStages.size() != 2)
+void VulkanPipeline::CompilePipelines(
+    const std::vector<VulkanPipeline*>& pipelines,
+    VkPipelineCache pipelineCache)
+{
+    ZoneScopedN("VulkanPipeline::CompilePipelines");
+
+    // Errors are logged and thrown, which has to happen on this thread,
+    // so the jobs only create the pipelines and keep their results.
+    for (VulkanPipeline* pipeline: pipelines)
+        pipeline->LoadShaderStages();
+
+    std::vector<VkResult> results(pipelines.size(), VK_SUCCESS);
+    JobSystem::GetInstance().ParallelFor(pipelines.size(),
+        [&pipelines, &results, pipelineCache](uint32_t i)
+    {
+        results[i] = pipelines[i]->CreatePipeline(pipelineCache);
+    });
+
+    for (VulkanPipeline* pipeline: pipelines)
+        pipeline->DestroyShaderStages();
+
+    for (size_t i = 0; i < pipelines.size(); i++)
+    {
+        if (results[i] < 0)
+            Logger::Write(
+                "[Vulkan Pipeline] Failed to create the pipeline of " +
+                pipelines[i]->vertPath + " and " + pipelines[i]->fragPath +
+                ": " + std::to_string(results[i]),
+                Logger::Level::Error,
+                Logger::MsgType::Renderer
+            );
+    }
+}
+
+void VulkanPipeline::LoadShaderStages()
+{
+    ZoneScopedN("VulkanPipeline::LoadShaderStages");
+
+    if (vertPath.empty() || fragPath.empty())
         Logger::Write( 
             "[Vulkan Pipeline] Shaders loadded incorrectly.",
             Logger::Level::Error,
             Logger::MsgType::Renderer
         );
 
-    vkPipelineInfo.pVertexInputState = vertexInputInfo;
-    vkPipelineInfo.layout = pipelineLayout->layout;
-    vkPipelineInfo.renderPass = renderPass;
+    shaderStages = {
+        VulkanShader::LoadFromFile(device, vertPath, VK_SHADER_STAGE_VERTEX_BIT),
+        VulkanShader::LoadFromFile(device, fragPath, VK_SHADER_STAGE_FRAGMENT_BIT)
+    };
 
-    this->pipelineLayout = std::move(pipelineLayout);
+    vkPipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+    vkPipelineInfo.pStages = shaderStages.data();
+
+    this->vertShader = shaderStages[0].module;
+    this->fragShader = shaderStages[1].module;
+}
+
+VkResult VulkanPipeline::CreatePipeline(VkPipelineCache pipelineCache)
+{
+    ZoneScopedN("VulkanPipeline::CreatePipeline");
 
-    CHECK_VKCMD(vkCreateGraphicsPipelines(
-        device, VK_NULL_HANDLE, 1, &vkPipelineInfo, nullptr, &pipeline));
+    return vkCreateGraphicsPipelines(
+        device, pipelineCache, 1, &vkPipelineInfo, nullptr, &pipeline);
+}
 
+void VulkanPipeline::DestroyShaderStages()
+{
     vkDestroyShaderModule(this->device, this->vertShader, nullptr);
     vkDestroyShaderModule(this->device, this->fragShader, nullptr); 
+    this->vertShader = VK_NULL_HANDLE;
+    this->fragShader = VK_NULL_HANDLE;
 }
@@ -3,6 +3,7 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <memory>
+#include <string>
 
 #include "vulkan_pipeline_layout.h"
 
@@ -13,15 +14,51 @@ public:
 
     ~VulkanPipeline();
 
+    /**
+     * Record the SPIR-V paths. The files are read
+     * when the pipeline is compiled.
+    */
     void LoadShader(std::string vertPath, std::string fragPath);
 
+    /**
+     * Prepare and compile the pipeline immediately.
+    */
     void BuildPipeline(VkPipelineVertexInputStateCreateInfo* vertexInputInfo,
+        std::unique_ptr<VulkanPipelineLayout> pipelineLayout,
+        VkRenderPass renderPass, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+
+    /**
+     * Store all state needed to compile the pipeline later.
+     * The vertex input state is copied, so it does not
+     * have to outlive this call.
+    */
+    void PreparePipeline(VkPipelineVertexInputStateCreateInfo* vertexInputInfo,
         std::unique_ptr<VulkanPipelineLayout> pipelineLayout,
         VkRenderPass renderPass);
 
+    /**
+     * Read the shaders and create the VkPipeline.
+    */
+    void CompilePipeline(VkPipelineCache pipelineCache);
+
+    /**
+     * Compile prepared pipelines in parallel on the job system.
+     * Only the pipeline creation runs in the jobs, the shaders are
+     * read and the errors reported on the calling thread.
+    */
+    static void CompilePipelines(
+        const std::vector<VulkanPipeline*>& pipelines,
+        VkPipelineCache pipelineCache);
+
     VulkanPipeline(const VulkanPipeline&) = delete;
     VulkanPipeline& operator=(const VulkanPipeline&) = delete;
 
+private:
+    void LoadShaderStages();
+    // Does not log nor throw, so it can run in a job.
+    VkResult CreatePipeline(VkPipelineCache pipelineCache);
+    void DestroyShaderStages();
+
 public:
     VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
     VkPipelineRasterizationStateCreateInfo rasterState{};
@@ -33,13 +70,18 @@ public:
     std::vector<VkDynamicState> dynamicStateEnables{};
     VkPipelineDynamicStateCreateInfo dynamicStateInfo{};
     std::vector<VkPipelineShaderStageCreateInfo> shaderStages{};
+    std::vector<VkVertexInputBindingDescription> vertexBindings{};
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes{};
+    VkPipelineVertexInputStateCreateInfo vertexInputState{};
     VkGraphicsPipelineCreateInfo vkPipelineInfo{};
 
 public:
-    VkShaderModule vertShader;
-    VkShaderModule fragShader;
+    std::string vertPath;
+    std::string fragPath;
+    VkShaderModule vertShader = VK_NULL_HANDLE;
+    VkShaderModule fragShader = VK_NULL_HANDLE;
     
-    VkPipeline pipeline;
+    VkPipeline pipeline = VK_NULL_HANDLE;
     std::unique_ptr<VulkanPipelineLayout> pipelineLayout;
     VkDevice device;
 };
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "vulkan_pipeline_cache.h"
+
+#include "validation.h"
+#include "logger.h"
+
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <tracy/Tracy.hpp>
+
+
+void VulkanPipelineCache::Initialize(VulkanDevice* vulkanDevice)
+{
+    ZoneScopedN("VulkanPipelineCache::Initialize");
+
+    this->vulkanDevice = vulkanDevice;
+
+    std::vector<char> data;
+    std::string path = GetFilePath();
+    std::ifstream file(path, std::ios::binary);
+    if (file.is_open())
+    {
+        FileHeader header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+        if (file && header.dataSize < (1ull << 32))
+        {
+            data.resize(header.dataSize);
+            file.read(data.data(), data.size());
+        }
+
+        if (!file || !ValidateData(header, data))
+        {
+            Logger::Write(
+                "[Vulkan Pipeline Cache] Discarded invalid or outdated cache: " + path,
+                Logger::Level::Warning,
+                Logger::MsgType::Renderer
+            );
+            data.clear();
+        }
+        file.close();
+    }
+
+    VkPipelineCacheCreateInfo createInfo{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty()? nullptr: data.data();
+    CHECK_VKCMD(vkCreatePipelineCache(
+        vulkanDevice->vkDevice, &createInfo, nullptr, &vkPipelineCache));
+
+    loadedSize = data.size();
+    Logger::Write(
+        "[Vulkan Pipeline Cache] Loaded " + std::to_string(loadedSize) +
+        " bytes from " + path,
+        Logger::Level::Info,
+        Logger::MsgType::Renderer
+    );
+}
+
+void VulkanPipelineCache::Save()
+{
+    ZoneScopedN("VulkanPipelineCache::Save");
+
+    if (vkPipelineCache == VK_NULL_HANDLE)
+        return;
+
+    size_t dataSize = 0;
+    CHECK_VKCMD(vkGetPipelineCacheData(
+        vulkanDevice->vkDevice, vkPipelineCache, &dataSize, nullptr));
+    std::vector<char> data(dataSize);
+    CHECK_VKCMD(vkGetPipelineCacheData(
+        vulkanDevice->vkDevice, vkPipelineCache, &dataSize, data.data()));
+    data.resize(dataSize);
+
+    FileHeader header = GetExpectedHeader();
+    header.dataSize = data.size();
+    header.dataHash = Hash(data.data(), data.size());
+
+    std::error_code error;
+    std::filesystem::create_directories(PIPELINE_CACHE_DIRECTORY, error);
+
+    // Write next to the old file and swap, so that a crash
+    // while writing never leaves a truncated cache behind.
+    std::string path = GetFilePath();
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+        file.write(data.data(), data.size());
+        if (!file)
+        {
+            Logger::Write(
+                "[Vulkan Pipeline Cache] Failed to write " + tempPath,
+                Logger::Level::Warning,
+                Logger::MsgType::Renderer
+            );
+            return;
+        }
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        // Renaming onto an existing file fails on Windows,
+        // remove the old cache first and try again.
+        Logger::Write(
+            "[Vulkan Pipeline Cache] Failed to rename " + tempPath + ": " +
+            error.message() + ", removing the old cache first",
+            Logger::Level::Verbose,
+            Logger::MsgType::Renderer
+        );
+        error.clear();
+        std::filesystem::remove(path, error);
+        if (!error)
+            std::filesystem::rename(tempPath, path, error);
+    }
+    if (error)
+    {
+        std::error_code removeError;
+        std::filesystem::remove(tempPath, removeError);
+        Logger::Write(
+            "[Vulkan Pipeline Cache] Failed to replace " + path + ": " + error.message(),
+            Logger::Level::Warning,
+            Logger::MsgType::Renderer
+        );
+        return;
+    }
+
+    Logger::Write(
+        "[Vulkan Pipeline Cache] Saved " + std::to_string(data.size()) +
+        " bytes to " + path,
+        Logger::Level::Info,
+        Logger::MsgType::Renderer
+    );
+}
+
+void VulkanPipelineCache::Destroy()
+{
+    ZoneScopedN("VulkanPipelineCache::Destroy");
+
+    if (vkPipelineCache == VK_NULL_HANDLE)
+        return;
+
+    vkDestroyPipelineCache(vulkanDevice->vkDevice, vkPipelineCache, nullptr);
+    vkPipelineCache = VK_NULL_HANDLE;
+}
+
+std::string VulkanPipelineCache::GetFilePath()
+{
+    const VkPhysicalDeviceProperties& properties = vulkanDevice->GetProperties();
+
+    char name[64];
+    snprintf(name, sizeof(name), "/%08x_%08x.bin",
+        properties.vendorID, properties.deviceID);
+    return std::string(PIPELINE_CACHE_DIRECTORY) + name;
+}
+
+VulkanPipelineCache::FileHeader VulkanPipelineCache::GetExpectedHeader()
+{
+    const VkPhysicalDeviceProperties& properties = vulkanDevice->GetProperties();
+
+    FileHeader header{};
+    header.magic = PIPELINE_CACHE_MAGIC;
+    header.version = PIPELINE_CACHE_VERSION;
+    header.vendorID = properties.vendorID;
+    header.deviceID = properties.deviceID;
+    header.driverVersion = properties.driverVersion;
+    memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+}
+
+bool VulkanPipelineCache::ValidateData(
+    const FileHeader& header, const std::vector<char>& data)
+{
+    FileHeader expected = GetExpectedHeader();
+    if (header.magic != expected.magic ||
+        header.version != expected.version ||
+        header.vendorID != expected.vendorID ||
+        header.deviceID != expected.deviceID ||
+        header.driverVersion != expected.driverVersion ||
+        memcmp(header.pipelineCacheUUID,
+            expected.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        return false;
+
+    if (header.dataSize != data.size() ||
+        header.dataHash != Hash(data.data(), data.size()))
+        return false;
+
+    // Drivers validate their own header too, but not all of them do it well.
+    VkPipelineCacheHeaderVersionOne cacheHeader{};
+    if (data.size() < sizeof(cacheHeader))
+        return false;
+    memcpy(&cacheHeader, data.data(), sizeof(cacheHeader));
+
+    return cacheHeader.headerSize >= sizeof(cacheHeader) &&
+        cacheHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        cacheHeader.vendorID == expected.vendorID &&
+        cacheHeader.deviceID == expected.deviceID &&
+        memcmp(cacheHeader.pipelineCacheUUID,
+            expected.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+uint64_t VulkanPipelineCache::Hash(const char* data, size_t size)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "vk_primitives/vulkan_device.h"
+
+#include <string>
+#include <vector>
+
+#define PIPELINE_CACHE_DIRECTORY    "resources/pipeline_cache"
+#define PIPELINE_CACHE_MAGIC        0x43504C53 // "SLPC"
+#define PIPELINE_CACHE_VERSION      1
+
+
+/**
+ * VkPipelineCache persisted to disk between runs.
+ * One file is kept per vendor and device, and the driver's
+ * pipeline cache UUID is validated on load, so a driver update
+ * starts from an empty cache instead of feeding stale data to it.
+ * The handle is internally synchronized and can be shared by
+ * pipelines compiled on worker threads.
+*/
+class VulkanPipelineCache
+{
+public:
+    void Initialize(VulkanDevice* vulkanDevice);
+    void Save();
+    void Destroy();
+
+    VkPipelineCache GetPipelineCache() {return vkPipelineCache;}
+
+    /**
+     * Bytes of valid cache data loaded from disk,
+     * zero on a cold start.
+    */
+    size_t GetLoadedSize() {return loadedSize;}
+
+    VulkanPipelineCache() = default;
+    ~VulkanPipelineCache() {Destroy();}
+
+    VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+    VulkanPipelineCache& operator=(const VulkanPipelineCache&) = delete;
+
+private:
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t  pipelineCacheUUID[VK_UUID_SIZE];
+        uint32_t reserved;
+        uint64_t dataSize;
+        uint64_t dataHash;
+    };
+
+    std::string GetFilePath();
+    FileHeader GetExpectedHeader();
+    bool ValidateData(const FileHeader& header, const std::vector<char>& data);
+
+    static uint64_t Hash(const char* data, size_t size);
+
+    VulkanDevice* vulkanDevice = nullptr;
+    VkPipelineCache vkPipelineCache = VK_NULL_HANDLE;
+    size_t loadedSize = 0;
+};
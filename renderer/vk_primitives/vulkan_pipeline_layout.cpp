@@ -43,16 +43,26 @@ VkDescriptorSetLayoutBinding PipelineLayoutBuilder::descriptorSetLayoutBinding(
 }
 
 int PipelineLayoutBuilder::PushDescriptorSetLayout(
-    std::string name, std::vector<VkDescriptorSetLayoutBinding> bindings)
+    std::string name, std::vector<VkDescriptorSetLayoutBinding> bindings,
+    VkDescriptorSetLayoutCreateFlags flags,
+    std::vector<VkDescriptorBindingFlagsEXT> bindingFlags)
 {
     ZoneScopedN("PipelineLayoutBuilder::PushDescriptorSetLayout");
 
     VkDescriptorSetLayout descSetLayout;
 
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT};
+    bindingFlagsInfo.bindingCount = bindingFlags.size();
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
     VkDescriptorSetLayoutCreateInfo descLayoutInfo{};
     descLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descLayoutInfo.flags = flags;
     descLayoutInfo.pBindings = bindings.data();
     descLayoutInfo.bindingCount = bindings.size();
+    if (!bindingFlags.empty())
+        descLayoutInfo.pNext = &bindingFlagsInfo;
 
     CHECK_VKCMD(vkCreateDescriptorSetLayout(vulkanDevice->vkDevice, 
         &descLayoutInfo, nullptr, &descSetLayout));
@@ -62,7 +72,8 @@ int PipelineLayoutBuilder::PushDescriptorSetLayout(
 }
 
 std::unique_ptr<VulkanPipelineLayout> PipelineLayoutBuilder::BuildPipelineLayout(
-    VkDescriptorPool descriptorPool, VkPushConstantRange* pushConst 
+    VkDescriptorPool descriptorPool, VkPushConstantRange* pushConst,
+    uint32_t pushConstCount
 ){
     ZoneScopedN("PipelineLayoutBuilder::BuildPipelineLayout");
 
@@ -83,7 +94,7 @@ std::unique_ptr<VulkanPipelineLayout> PipelineLayoutBuilder::BuildPipelineLayout
     if (pushConst)
     {
         layoutInfo.pPushConstantRanges = pushConst;
-        layoutInfo.pushConstantRangeCount = 1;
+        layoutInfo.pushConstantRangeCount = pushConstCount;
     }
     
     for(std::pair e: this->descSetLayouts)
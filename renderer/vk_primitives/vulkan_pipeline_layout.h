@@ -42,11 +42,19 @@ class PipelineLayoutBuilder
 {
 
 public:
+    /**
+     * Binding flags, if not empty, have one entry per binding.
+     * Sets of layouts with update after bind bindings
+     * have to be allocated from a pool created for them.
+     */
     int PushDescriptorSetLayout(
         std::string name,
-        std::vector<VkDescriptorSetLayoutBinding> bindings);
+        std::vector<VkDescriptorSetLayoutBinding> bindings,
+        VkDescriptorSetLayoutCreateFlags flags = 0,
+        std::vector<VkDescriptorBindingFlagsEXT> bindingFlags = {});
     std::unique_ptr<VulkanPipelineLayout> BuildPipelineLayout(
-        VkDescriptorPool descriptorPool, VkPushConstantRange* pushConst = nullptr);
+        VkDescriptorPool descriptorPool, VkPushConstantRange* pushConst = nullptr,
+        uint32_t pushConstCount = 1);
     VkDescriptorSetLayoutBinding descriptorSetLayoutBinding(
         VkDescriptorType type, VkShaderStageFlags stageFlags,
         uint32_t binding, uint32_t descriptorCount = 1);
@@ -6,7 +6,8 @@
 #include <vulkan/vulkan.h>
 #include <tracy/Tracy.hpp>
 
-void VulkanUniform::Initialize(VulkanDevice* vulkanDevice, VkDeviceSize size)
+void VulkanUniform::Initialize(VulkanDevice* vulkanDevice, VkDeviceSize size,
+    VkBufferUsageFlags usage)
 {
     ZoneScopedN("VulkanUniform::Initialize");
 
@@ -18,7 +19,7 @@ void VulkanUniform::Initialize(VulkanDevice* vulkanDevice, VkDeviceSize size)
 
     VkBufferCreateInfo bufferInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
     bufferInfo.size = vkDeviceSize;
-    bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
     CHECK_VKCMD(vkCreateBuffer(vkDevice, &bufferInfo, nullptr, &vkBuffer));
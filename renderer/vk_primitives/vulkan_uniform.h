@@ -13,8 +13,11 @@ public:
      * Initialize uniform and vulkan resources are allocated.
      * If it is called multiple times,
      * previously allocated resources are destroyed.
+     * Mapped storage buffers are created the same way with
+     * VK_BUFFER_USAGE_STORAGE_BUFFER_BIT as usage.
     */
-    void Initialize(VulkanDevice* vulkanDevice, VkDeviceSize size);
+    void Initialize(VulkanDevice* vulkanDevice, VkDeviceSize size,
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
     /**
      * Destroy all vulkan resources.
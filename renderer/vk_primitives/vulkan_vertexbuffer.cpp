@@ -10,8 +10,13 @@ VkPipelineVertexInputStateCreateInfo VulkanVertexbuffer::vertexInputState;
 std::vector<VkVertexInputAttributeDescription> VulkanVertexbuffer::inputAttributeDesc;
 VkVertexInputBindingDescription VulkanVertexbuffer::inputBindingDesc;
 
+VkPipelineVertexInputStateCreateInfo VulkanVertexbuffer::compactInputState;
+std::vector<VkVertexInputAttributeDescription> VulkanVertexbuffer::compactAttributeDesc;
+VkVertexInputBindingDescription VulkanVertexbuffer::compactBindingDesc;
+
 void VulkanVertexbuffer::Initialize(VulkanDevice* vulkanDevice,
-    VkDeviceSize indexBufferSize, VkDeviceSize vertexBufferSize)
+    VkDeviceSize indexBufferSize, VkDeviceSize vertexBufferSize,
+    VkIndexType indexType)
 {
     ZoneScopedN("VulkanVertexbuffer::Initialize");
 
@@ -23,7 +28,9 @@ void VulkanVertexbuffer::Initialize(VulkanDevice* vulkanDevice,
     
     this->indexBufferSize = indexBufferSize;
     this->vertexBufferSize = vertexBufferSize;
-    this->indexCount = indexBufferSize / sizeof(unsigned int);
+    this->indexType = indexType;
+    this->indexCount = indexBufferSize / ((indexType == VK_INDEX_TYPE_UINT16)?
+        sizeof(CompactVertexIndex): sizeof(VertexIndex));
 
     {
         VkBufferCreateInfo bufferInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
@@ -142,4 +149,28 @@ VkPipelineVertexInputStateCreateInfo* VulkanVertexbuffer::GetVertexInputState()
     vertexInputState.pVertexAttributeDescriptions = inputAttributeDesc.data();
 
     return &vertexInputState;
+}
+
+VkPipelineVertexInputStateCreateInfo* VulkanVertexbuffer::GetCompactVertexInputState()
+{
+    ZoneScopedN("VulkanVertexbuffer::GetCompactVertexInputState");
+
+    compactBindingDesc.binding = 0;
+    compactBindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    compactBindingDesc.stride = sizeof(CompactVertex);
+
+    compactAttributeDesc = 
+    {
+        {0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactVertex, Position)},
+        {1, 0, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, Normal)},
+        {2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, TexCoords)},
+    };
+
+    compactInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    compactInputState.vertexBindingDescriptionCount = 1;
+    compactInputState.pVertexBindingDescriptions = &compactBindingDesc;
+    compactInputState.vertexAttributeDescriptionCount = compactAttributeDesc.size();
+    compactInputState.pVertexAttributeDescriptions = compactAttributeDesc.data();
+
+    return &compactInputState;
 }
\ No newline at end of file
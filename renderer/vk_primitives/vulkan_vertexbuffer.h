@@ -15,9 +15,11 @@ public:
      * When calling more than one time,
      * all the old resources are deallocated,
      * and new resources will be allocated again.
+     * indexType decides how many bytes each index takes.
     */
     void Initialize(VulkanDevice* vulkanDevice, 
-        VkDeviceSize indexBufferSize, VkDeviceSize vertexBufferSize);
+        VkDeviceSize indexBufferSize, VkDeviceSize vertexBufferSize,
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32);
 
     /**
      * Deallocate all resources.
@@ -40,9 +42,18 @@ public:
 
     uint32_t GetIndexCount();
 
+    VkIndexType GetIndexType() {return indexType;}
+
 
     static VkPipelineVertexInputStateCreateInfo* GetVertexInputState();
 
+    /**
+     * Vertex input state of CompactVertex.
+     * Positions are UNORM16 and have to be restored
+     * with VertexQuantization in the vertex shader.
+    */
+    static VkPipelineVertexInputStateCreateInfo* GetCompactVertexInputState();
+
     VulkanVertexbuffer() = default;
     ~VulkanVertexbuffer() {Destroy();}
 
@@ -62,8 +73,13 @@ private:
     VkDeviceSize vertexBufferSize{0};
     VkDeviceSize indexBufferSize{0};
     uint32_t indexCount = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
 
     static VkPipelineVertexInputStateCreateInfo vertexInputState;
     static std::vector<VkVertexInputAttributeDescription> inputAttributeDesc;
     static VkVertexInputBindingDescription inputBindingDesc;
+
+    static VkPipelineVertexInputStateCreateInfo compactInputState;
+    static std::vector<VkVertexInputAttributeDescription> compactAttributeDesc;
+    static VkVertexInputBindingDescription compactBindingDesc;
 };
\ No newline at end of file
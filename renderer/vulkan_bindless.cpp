@@ -0,0 +1,238 @@
+#include "vulkan_bindless.h"
+
+#include "validation.h"
+#include "logger.h"
+
+#include <tracy/Tracy.hpp>
+
+
+namespace renderer
+{
+
+std::vector<VkDescriptorSetLayoutBinding> VulkanBindless::GetBindings(
+    std::vector<VkDescriptorBindingFlagsEXT>& bindingFlags)
+{
+    /*
+    layout (set = 0, binding = 0, std430) readonly buffer Materials
+    {
+        Material materials[];
+    };
+    layout (set = 0, binding = 1) uniform sampler2D Textures[];
+    */
+    std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[1].descriptorCount = BINDLESS_MAX_TEXTURES;
+    bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    // Unused slots are never written, new textures are written
+    // while command buffers using the set are recorded.
+    bindingFlags = {
+        0,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+        VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT
+    };
+
+    return bindings;
+}
+
+void VulkanBindless::PushDescriptorSetLayout(PipelineLayoutBuilder& layoutBuilder)
+{
+    ZoneScopedN("VulkanBindless::PushDescriptorSetLayout");
+
+    std::vector<VkDescriptorBindingFlagsEXT> bindingFlags;
+    std::vector<VkDescriptorSetLayoutBinding> bindings = GetBindings(bindingFlags);
+    layoutBuilder.PushDescriptorSetLayout("material", bindings,
+        VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT, bindingFlags);
+}
+
+void VulkanBindless::Initialize(VulkanDevice* vulkanDevice)
+{
+    ZoneScopedN("VulkanBindless::Initialize");
+
+    this->vulkanDevice = vulkanDevice;
+    VkDevice vkDevice = vulkanDevice->vkDevice;
+
+    // Checked when the device is selected.
+    ASSERT(vulkanDevice->descriptorIndexingSupported);
+
+    std::vector<VkDescriptorBindingFlagsEXT> bindingFlags;
+    std::vector<VkDescriptorSetLayoutBinding> bindings = GetBindings(bindingFlags);
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT};
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    CHECK_VKCMD(vkCreateDescriptorSetLayout(
+        vkDevice, &layoutInfo, nullptr, &descriptorSetLayout));
+
+    std::vector<VkDescriptorPoolSize> poolSizes =
+    {
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BINDLESS_MAX_TEXTURES }
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    CHECK_VKCMD(vkCreateDescriptorPool(vkDevice, &poolInfo, nullptr, &descriptorPool));
+
+    VkDescriptorSetAllocateInfo allocInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+    CHECK_VKCMD(vkAllocateDescriptorSets(vkDevice, &allocInfo, &descriptorSet));
+
+    materialBuffer.Initialize(vulkanDevice,
+        sizeof(MaterialData) * BINDLESS_MAX_MATERIALS,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    materials = static_cast<MaterialData*>(materialBuffer.Map());
+    materials[0] = MaterialData{};
+
+    VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    descWrite.dstSet = descriptorSet;
+    descWrite.dstBinding = 0;
+    descWrite.dstArrayElement = 0;
+    descWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descWrite.descriptorCount = 1;
+    descWrite.pBufferInfo = materialBuffer.GetDescriptor();
+    vkUpdateDescriptorSets(vkDevice, 1, &descWrite, 0, nullptr);
+
+    freeTextures.clear();
+    freeMaterials.clear();
+    textureCount = 1;
+    materialCount = 1;
+}
+
+void VulkanBindless::Destroy()
+{
+    ZoneScopedN("VulkanBindless::Destroy");
+
+    if (vulkanDevice == nullptr)
+        return;
+
+    VkDevice vkDevice = vulkanDevice->vkDevice;
+
+    materialBuffer.Destroy();
+    materials = nullptr;
+
+    // Frees the set as well.
+    vkDestroyDescriptorPool(vkDevice, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(vkDevice, descriptorSetLayout, nullptr);
+    descriptorPool = VK_NULL_HANDLE;
+    descriptorSetLayout = VK_NULL_HANDLE;
+    descriptorSet = VK_NULL_HANDLE;
+
+    vulkanDevice = nullptr;
+}
+
+uint32_t VulkanBindless::AddTexture(const VkDescriptorImageInfo& imageInfo)
+{
+    ZoneScopedN("VulkanBindless::AddTexture");
+
+    uint32_t slot = 0;
+    if (!freeTextures.empty())
+    {
+        slot = freeTextures.back();
+        freeTextures.pop_back();
+    }
+    else if (textureCount < BINDLESS_MAX_TEXTURES)
+    {
+        slot = textureCount++;
+    }
+    else
+    {
+        if (!textureOverflowLogged)
+        {
+            Logger::Write(
+                "[Vulkan Bindless] All " + std::to_string(BINDLESS_MAX_TEXTURES) +
+                    " texture slots are taken, new textures are not sampled.",
+                Logger::Level::Warning,
+                Logger::MsgType::Renderer
+            );
+            textureOverflowLogged = true;
+        }
+        return 0;
+    }
+
+    VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    descWrite.dstSet = descriptorSet;
+    descWrite.dstBinding = 1;
+    descWrite.dstArrayElement = slot;
+    descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descWrite.descriptorCount = 1;
+    descWrite.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(vulkanDevice->vkDevice, 1, &descWrite, 0, nullptr);
+
+    return slot;
+}
+
+void VulkanBindless::RemoveTexture(uint32_t slot)
+{
+    ZoneScopedN("VulkanBindless::RemoveTexture");
+
+    // Partially bound, the stale descriptor is not read until it is rewritten.
+    if (slot != 0 && vulkanDevice != nullptr)
+        freeTextures.push_back(slot);
+}
+
+uint32_t VulkanBindless::AddMaterial(MaterialData** data)
+{
+    ZoneScopedN("VulkanBindless::AddMaterial");
+
+    uint32_t slot = 0;
+    if (!freeMaterials.empty())
+    {
+        slot = freeMaterials.back();
+        freeMaterials.pop_back();
+    }
+    else if (materialCount < BINDLESS_MAX_MATERIALS)
+    {
+        slot = materialCount++;
+    }
+    else
+    {
+        if (!materialOverflowLogged)
+        {
+            Logger::Write(
+                "[Vulkan Bindless] All " + std::to_string(BINDLESS_MAX_MATERIALS) +
+                    " material slots are taken, new materials use the default one.",
+                Logger::Level::Warning,
+                Logger::MsgType::Renderer
+            );
+            materialOverflowLogged = true;
+        }
+        *data = &overflowMaterial;
+        return 0;
+    }
+
+    materials[slot] = MaterialData{};
+    *data = &materials[slot];
+    return slot;
+}
+
+void VulkanBindless::RemoveMaterial(uint32_t slot)
+{
+    ZoneScopedN("VulkanBindless::RemoveMaterial");
+
+    if (slot != 0 && vulkanDevice != nullptr)
+        freeMaterials.push_back(slot);
+}
+
+} // namespace renderer
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "vk_primitives/vulkan_device.h"
+#include "vk_primitives/vulkan_uniform.h"
+#include "vk_primitives/vulkan_pipeline_layout.h"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+// Mirrored in Phong/shader.frag.
+#define BINDLESS_MAX_TEXTURES   4096    // Texture slots, 0 means no texture
+#define BINDLESS_MAX_MATERIALS  16384   // Material slots, 0 is the fallback
+
+namespace renderer
+{
+
+/**
+ * Std430 layout of a material in the material storage buffer.
+ * Texture indices are slots of the bindless texture array, 0 for none.
+ */
+struct MaterialData
+{
+    glm::vec4 albedo = {1, 1, 1, 1}; // w is the opacity
+
+    float metallic = 0.1f;
+    float roughness = 0.9f;
+    float _1;
+    float _2;
+
+    uint32_t albedoTexture = 0;
+    uint32_t metallicTexture = 0;
+    uint32_t roughnessTexture = 0;
+    uint32_t normalTexture = 0;
+};
+
+/**
+ * @brief Materials and textures of all meshes in one descriptor set.
+ *
+ * Set 0 of the mesh pipelines holds a storage buffer with every material
+ * and an array of every material texture, so it is bound once per pipeline
+ * and draws only push the index of their material.
+ * The texture array is partially bound and updated after bind,
+ * slots are written when a texture is first used by a material
+ * and recycled when the texture is destroyed.
+ */
+class VulkanBindless
+{
+public:
+    /**
+     * Requires VK_EXT_descriptor_indexing, see VulkanDevice.
+     */
+    void Initialize(VulkanDevice* vulkanDevice);
+    void Destroy();
+
+    /**
+     * Push the layout of set 0 to a mesh pipeline layout.
+     * It is identical to the layout of GetDescriptorSet.
+     */
+    static void PushDescriptorSetLayout(PipelineLayoutBuilder& layoutBuilder);
+
+    /**
+     * @brief Take a texture slot and write the image to it.
+     *
+     * @return The slot, 0 if all slots are taken.
+     */
+    uint32_t AddTexture(const VkDescriptorImageInfo& imageInfo);
+
+    /**
+     * @brief Give a slot back. The texture must not be used
+     * by a material anymore, nor by a command buffer in flight.
+     */
+    void RemoveTexture(uint32_t slot);
+
+    /**
+     * @brief Take a material slot reset to default values.
+     *
+     * @param data the mapped material, host coherent
+     * @return The slot, 0 if all slots are taken. Data written
+     * to the fallback slot is not read by the shaders.
+     */
+    uint32_t AddMaterial(MaterialData** data);
+    void RemoveMaterial(uint32_t slot);
+
+    VkDescriptorSet* GetDescriptorSet() {return &descriptorSet;}
+
+    VulkanBindless() = default;
+    ~VulkanBindless() = default; // Destroyed by VulkanRenderer
+
+    VulkanBindless(const VulkanBindless&) = delete;
+    VulkanBindless& operator=(const VulkanBindless&) = delete;
+
+private:
+    static std::vector<VkDescriptorSetLayoutBinding> GetBindings(
+        std::vector<VkDescriptorBindingFlagsEXT>& bindingFlags);
+
+private:
+    VulkanDevice* vulkanDevice = nullptr; // Owned by VulkanRenderer
+
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+    VulkanUniform materialBuffer{};
+    MaterialData* materials = nullptr;
+    MaterialData overflowMaterial{}; // Written by materials past the limit
+
+    // Slots given back, reused before new ones.
+    std::vector<uint32_t> freeTextures;
+    std::vector<uint32_t> freeMaterials;
+    uint32_t textureCount = 1;
+    uint32_t materialCount = 1;
+
+    bool textureOverflowLogged = false;
+    bool materialOverflowLogged = false;
+};
+
+} // namespace renderer
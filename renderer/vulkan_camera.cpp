@@ -4,6 +4,7 @@
 #include "validation.h"
 #include "math_library.h"
 
+#include <algorithm>
 #include <array>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
@@ -13,14 +14,18 @@
 namespace renderer
 {
 
-std::shared_ptr<VulkanCamera> VulkanCamera::BuildCamera(CameraProperties& properties)
+std::shared_ptr<VulkanCamera> VulkanCamera::BuildCamera(
+    CameraProperties& properties, uint32_t viewCount)
 {
     ZoneScopedN("VulkanCamera::BuildCamera");
 
     std::shared_ptr<VulkanCamera> camera = std::make_unique<VulkanCamera>();
 
     VulkanRenderer& vkr = VulkanRenderer::GetInstance();
+    ASSERT(viewCount >= 1 && viewCount <= CAMERA_MAX_VIEWS);
+    ASSERT(viewCount == 1 || vkr.IsMultiviewEnabled());
     camera->cameraType = CameraType::CAMERA;
+    camera->viewCount = viewCount;
     camera->vulkanDevice = &vkr.vulkanDevice;
     camera->swapchain = vkr.GetSwapchain();
 
@@ -29,13 +34,23 @@ std::shared_ptr<VulkanCamera> VulkanCamera::BuildCamera(CameraProperties& proper
         VulkanPipelineLayout& pipelineLayout = vkr.GetPipelineLayout("render");
         pipelineLayout.AllocateDescriptorSet(
             "camera", vkr.FRAME_IN_FLIGHT, &camera->cameraDescSet);
+        pipelineLayout.AllocateDescriptorSet(
+            "scene", vkr.FRAME_IN_FLIGHT, &camera->lightDescSet);
+        for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+        {
+            pipelineLayout.AllocateDescriptorSet(
+                "camera", vkr.FRAME_IN_FLIGHT, &camera->shadowDescSets[i]);
+        }
     }
 
     // Create rendered texture descriptor set
     {
         VulkanPipelineLayout& pipelineLayout = vkr.GetPipelineLayout("display");
-        pipelineLayout.AllocateDescriptorSet(
-            "texture", vkr.FRAME_IN_FLIGHT, &camera->colorTexDescSet);
+        for (uint32_t i = 0; i < viewCount; i++)
+        {
+            pipelineLayout.AllocateDescriptorSet(
+                "texture", vkr.FRAME_IN_FLIGHT, &camera->colorTexDescSet[i]);
+        }
     }
 
     camera->Initialize(properties);
@@ -59,17 +74,49 @@ void VulkanCamera::Initialize(CameraProperties& prop)
             static_cast<unsigned int>(this->properties.Extent.x),
             static_cast<unsigned int>(this->properties.Extent.y)},
         this->swapchain->GetImageFormat(),
-        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        this->viewCount);
     this->colorImage.CreateSampler();
 
-    this->cameraUniform.Initialize(this->vulkanDevice, sizeof(ViewProjection));
+    VkSampleCountFlagBits samples = vkr.GetSampleCount();
+    if (samples != VK_SAMPLE_COUNT_1_BIT)
+    {
+        this->msaaImage.CreateImage({
+                static_cast<unsigned int>(this->properties.Extent.x),
+                static_cast<unsigned int>(this->properties.Extent.y)},
+            this->swapchain->GetImageFormat(),
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+            this->viewCount, samples);
+    }
+
+    this->cameraUniform.Initialize(this->vulkanDevice,
+        sizeof(ViewProjection) * this->viewCount);
     this->vpMap = static_cast<ViewProjection*>(this->cameraUniform.Map());
-    this->vpMap->projection = glm::perspective(
-        glm::radians(this->properties.Fov),
-        static_cast<float>(this->properties.Extent.x)
-            /static_cast<float>(this->properties.Extent.y),
-        this->properties.ZNear, this->properties.ZFar);
-    this->vpMap->view = glm::mat4(1.0f);
+    for (uint32_t i = 0; i < this->viewCount; i++)
+    {
+        this->vpMap[i].projection = glm::perspective(
+            glm::radians(this->properties.Fov),
+            static_cast<float>(this->properties.Extent.x)
+                /static_cast<float>(this->properties.Extent.y),
+            this->properties.ZNear, this->properties.ZFar);
+        this->vpMap[i].view = glm::mat4(1.0f);
+    }
+
+    this->lightBuffer.Initialize(this->vulkanDevice,
+        sizeof(SceneLights), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    this->lightMap = static_cast<SceneLights*>(this->lightBuffer.Map());
+    this->lightMap->lightCount = glm::uvec4(0);
+
+    if (vkr.GetTimestampPeriod() > 0.0f)
+    {
+        VkQueryPoolCreateInfo queryPoolInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = CAMERA_TIMESTAMP_COUNT * this->viewCount;
+        CHECK_VKCMD(vkCreateQueryPool(this->vulkanDevice->vkDevice,
+            &queryPoolInfo, nullptr, &this->timestampPool));
+    }
+    this->timestampsWritten = false;
+    this->passTimes = glm::vec3(0.0f);
 
     // Create depth image
     {
@@ -79,12 +126,14 @@ void VulkanCamera::Initialize(CameraProperties& prop)
         imageInfo.extent.height = this->properties.Extent.y;
         imageInfo.extent.depth = 1;
         imageInfo.mipLevels = 1;
-        imageInfo.arrayLayers = 1;
+        imageInfo.arrayLayers = this->viewCount;
         imageInfo.format = this->vulkanDevice->GetDepthFormat();
         imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
         imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
         imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        if (vkr.IsGpuCullingEnabled() && this->viewCount == 1)
+            imageInfo.usage |= VK_IMAGE_USAGE_SAMPLED_BIT; // Reduced into the depth pyramid
+        imageInfo.samples = samples;
         imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         CHECK_VKCMD(vkCreateImage(
             this->vulkanDevice->vkDevice, &imageInfo, nullptr, &this->depthImage));
@@ -103,13 +152,14 @@ void VulkanCamera::Initialize(CameraProperties& prop)
 
         VkImageViewCreateInfo depthViewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
         depthViewInfo.image = this->depthImage;
-        depthViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        depthViewInfo.viewType = (this->viewCount > 1)?
+            VK_IMAGE_VIEW_TYPE_2D_ARRAY: VK_IMAGE_VIEW_TYPE_2D;
         depthViewInfo.format = this->vulkanDevice->GetDepthFormat();;
         depthViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
         depthViewInfo.subresourceRange.baseMipLevel = 0;
         depthViewInfo.subresourceRange.levelCount = 1;
         depthViewInfo.subresourceRange.baseArrayLayer = 0;
-        depthViewInfo.subresourceRange.layerCount = 1;
+        depthViewInfo.subresourceRange.layerCount = this->viewCount;
 
         CHECK_VKCMD(vkCreateImageView(
             this->vulkanDevice->vkDevice, &depthViewInfo,
@@ -117,24 +167,165 @@ void VulkanCamera::Initialize(CameraProperties& prop)
 
         VkImageViewCreateInfo stencilViewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
         stencilViewInfo.image = this->depthImage;
-        stencilViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        stencilViewInfo.viewType = (this->viewCount > 1)?
+            VK_IMAGE_VIEW_TYPE_2D_ARRAY: VK_IMAGE_VIEW_TYPE_2D;
         stencilViewInfo.format = this->vulkanDevice->GetDepthFormat();
         stencilViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_STENCIL_BIT;
         stencilViewInfo.subresourceRange.baseMipLevel = 0;
         stencilViewInfo.subresourceRange.levelCount = 1;
         stencilViewInfo.subresourceRange.baseArrayLayer = 0;
-        stencilViewInfo.subresourceRange.layerCount = 1;
+        stencilViewInfo.subresourceRange.layerCount = this->viewCount;
 
         CHECK_VKCMD(vkCreateImageView(
             this->vulkanDevice->vkDevice, &stencilViewInfo,
             nullptr, &this->stencilImageView));
     }
 
+    if (vkr.IsGpuCullingEnabled())
+    {
+        this->culling.Initialize(this->vulkanDevice, vkr.GetCulling(),
+            this->depthImageView,
+            {static_cast<uint32_t>(this->properties.Extent.x),
+                static_cast<uint32_t>(this->properties.Extent.y)},
+            this->viewCount);
+    }
+
+    // Create shadow map
+    {
+        VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = SHADOW_MAP_SIZE;
+        imageInfo.extent.height = SHADOW_MAP_SIZE;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = SHADOW_CASCADE_COUNT;
+        imageInfo.format = SHADOW_MAP_FORMAT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage =
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        CHECK_VKCMD(vkCreateImage(
+            this->vulkanDevice->vkDevice, &imageInfo, nullptr, &this->shadowImage));
+
+        VkMemoryRequirements memRequirements{};
+        vkGetImageMemoryRequirements(
+            this->vulkanDevice->vkDevice, this->shadowImage, &memRequirements);
+        VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = this->vulkanDevice->GetMemoryTypeIndex(
+            memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        CHECK_VKCMD(vkAllocateMemory(
+            this->vulkanDevice->vkDevice, &allocInfo, nullptr, &this->shadowMemory));
+        CHECK_VKCMD(vkBindImageMemory(
+            this->vulkanDevice->vkDevice, this->shadowImage, this->shadowMemory, 0));
+
+        VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+        viewInfo.image = this->shadowImage;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        viewInfo.format = SHADOW_MAP_FORMAT;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = SHADOW_CASCADE_COUNT;
+        CHECK_VKCMD(vkCreateImageView(
+            this->vulkanDevice->vkDevice, &viewInfo, nullptr, &this->shadowArrayView));
+
+        // The lighting pass samples the map even when no cascade is drawn,
+        // without a directional light. It starts in the layout the shadow pass leaves.
+        {
+            VulkanSingleCmd cmd;
+            cmd.Initialize(this->vulkanDevice);
+            VkCommandBuffer vkCommandBuffer = cmd.BeginCommand();
+
+            VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = this->shadowImage;
+            barrier.subresourceRange = viewInfo.subresourceRange;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(vkCommandBuffer,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            cmd.EndCommand();
+        }
+
+        // Outside of the cascades is lit, linear filtering
+        // blends four depth comparisons per tap.
+        VkSamplerCreateInfo samplerInfo{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        samplerInfo.compareEnable = VK_TRUE;
+        samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = 0.0f;
+        CHECK_VKCMD(vkCreateSampler(
+            this->vulkanDevice->vkDevice, &samplerInfo, nullptr, &this->shadowSampler));
+
+        for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+        {
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.subresourceRange.baseArrayLayer = i;
+            viewInfo.subresourceRange.layerCount = 1;
+            CHECK_VKCMD(vkCreateImageView(
+                this->vulkanDevice->vkDevice, &viewInfo,
+                nullptr, &this->shadowLayerViews[i]));
+
+            VkFramebufferCreateInfo framebufferInfo{
+                VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+            framebufferInfo.renderPass = vkr.vkRenderPass.shadow;
+            framebufferInfo.attachmentCount = 1;
+            framebufferInfo.pAttachments = &this->shadowLayerViews[i];
+            framebufferInfo.width = SHADOW_MAP_SIZE;
+            framebufferInfo.height = SHADOW_MAP_SIZE;
+            framebufferInfo.layers = 1;
+            CHECK_VKCMD(vkCreateFramebuffer(
+                this->vulkanDevice->vkDevice, &framebufferInfo,
+                nullptr, &this->shadowFramebuffers[i]));
+
+            this->shadowUniforms[i].Initialize(this->vulkanDevice, sizeof(ViewProjection));
+            this->shadowVpMaps[i] = static_cast<ViewProjection*>(this->shadowUniforms[i].Map());
+            this->shadowVpMaps[i]->view = glm::mat4(1.0f);
+            this->shadowVpMaps[i]->projection = glm::mat4(1.0f);
+
+            VkWriteDescriptorSet descriptorWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+            descriptorWrite.dstSet = this->shadowDescSets[i];
+            descriptorWrite.dstBinding = 0;
+            descriptorWrite.dstArrayElement = 0;
+            descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            descriptorWrite.descriptorCount = 1;
+            descriptorWrite.pBufferInfo = this->shadowUniforms[i].GetDescriptor();
+            vkUpdateDescriptorSets(this->vulkanDevice->vkDevice,
+                1, &descriptorWrite, 0, nullptr);
+
+            this->shadowKeys[i] = 0; // The new image has to be drawn
+        }
+        this->lightMap->shadow.light = glm::uvec4(0);
+    }
+
     std::vector<VkImageView> attachments =
         {this->colorImage.GetImageView(), this->depthImageView};
+    if (samples != VK_SAMPLE_COUNT_1_BIT)
+    { // Same order as the attachments of the camera render passes
+        attachments = {this->msaaImage.GetImageView(),
+            this->depthImageView, this->colorImage.GetImageView()};
+    }
     VkFramebufferCreateInfo vkFramebufferCreateInfo{
         VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
-    vkFramebufferCreateInfo.renderPass = vkr.vkRenderPass.defaultCamera;
+    // Multiview broadcasts to the layers, the framebuffer itself has one layer.
+    vkFramebufferCreateInfo.renderPass = (this->viewCount > 1)?
+        vkr.vkRenderPass.multiviewCamera: vkr.vkRenderPass.defaultCamera;
     vkFramebufferCreateInfo.attachmentCount = attachments.size();
     vkFramebufferCreateInfo.pAttachments = attachments.data();
     vkFramebufferCreateInfo.width = this->properties.Extent.x;
@@ -147,7 +338,12 @@ void VulkanCamera::Initialize(CameraProperties& prop)
         &this->framebuffer));
 
     {
-        std::array<VkWriteDescriptorSet, 1> descriptorWrite{};
+        VkDescriptorImageInfo shadowInfo{};
+        shadowInfo.sampler = this->shadowSampler;
+        shadowInfo.imageView = this->shadowArrayView;
+        shadowInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+        std::array<VkWriteDescriptorSet, 3> descriptorWrite{};
 
         descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrite[0].dstSet = this->cameraDescSet;
@@ -157,20 +353,38 @@ void VulkanCamera::Initialize(CameraProperties& prop)
         descriptorWrite[0].descriptorCount = 1;
         descriptorWrite[0].pBufferInfo = this->cameraUniform.GetDescriptor();
 
+        descriptorWrite[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite[1].dstSet = this->lightDescSet;
+        descriptorWrite[1].dstBinding = 0;
+        descriptorWrite[1].dstArrayElement = 0;
+        descriptorWrite[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrite[1].descriptorCount = 1;
+        descriptorWrite[1].pBufferInfo = this->lightBuffer.GetDescriptor();
+
+        descriptorWrite[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite[2].dstSet = this->lightDescSet;
+        descriptorWrite[2].dstBinding = 1;
+        descriptorWrite[2].dstArrayElement = 0;
+        descriptorWrite[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite[2].descriptorCount = 1;
+        descriptorWrite[2].pImageInfo = &shadowInfo;
+
         vkUpdateDescriptorSets(this->vulkanDevice->vkDevice,
             descriptorWrite.size(), descriptorWrite.data(), 0, nullptr);
     }
 
+    for (uint32_t i = 0; i < this->viewCount; i++)
     {
         std::array<VkWriteDescriptorSet, 1> descriptorWrite{};
+        VkDescriptorImageInfo imageInfo = this->colorImage.GetLayerDescriptor(i);
 
         descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrite[0].dstSet = this->colorTexDescSet;
+        descriptorWrite[0].dstSet = this->colorTexDescSet[i];
         descriptorWrite[0].dstBinding = 0;
         descriptorWrite[0].dstArrayElement = 0;
         descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         descriptorWrite[0].descriptorCount = 1;
-        descriptorWrite[0].pImageInfo = this->colorImage.GetDescriptor();
+        descriptorWrite[0].pImageInfo = &imageInfo;
 
         vkUpdateDescriptorSets(this->vulkanDevice->vkDevice,
             descriptorWrite.size(), descriptorWrite.data(), 0, nullptr);
@@ -195,11 +409,14 @@ void VulkanCamera::SetCamProperties(CameraProperties& properties)
     ZoneScopedN("VulkanCamera::SetCamProperties");
 
     this->properties = properties;
-    vpMap->projection = glm::perspective(
-        glm::radians(this->properties.Fov),
-        static_cast<float>(this->properties.Extent.x)
-            /static_cast<float>(this->properties.Extent.y),
-        this->properties.ZNear, this->properties.ZFar);
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        vpMap[i].projection = glm::perspective(
+            glm::radians(this->properties.Fov),
+            static_cast<float>(this->properties.Extent.x)
+                /static_cast<float>(this->properties.Extent.y),
+            this->properties.ZNear, this->properties.ZFar);
+    }
 }
 
 void VulkanCamera::SetProjection(float aspectRatioXy, float fovy,
@@ -208,17 +425,23 @@ void VulkanCamera::SetProjection(float aspectRatioXy, float fovy,
     properties.Fov = fovy;
     properties.ZFar = zFar;
     properties.ZNear = zNear;
-    this->vpMap->projection = glm::perspective(
-        glm::radians(fovy), aspectRatioXy, zNear, zFar);
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        this->vpMap[i].projection = glm::perspective(
+            glm::radians(fovy), aspectRatioXy, zNear, zFar);
+    }
 }
 
-void VulkanCamera::SetProjection(glm::vec4 fov, float zNear, float zFar)
+void VulkanCamera::SetProjection(glm::vec4 fov, float zNear, float zFar,
+    uint32_t view)
 {
+    ASSERT(view < viewCount);
+
     properties.Fov = fov[2] - fov[3];
     properties.ZFar = zFar;
     properties.ZNear = zNear;
 
-    math::XrProjectionFov(this->vpMap->projection, fov, zNear, zFar);
+    math::XrProjectionFov(this->vpMap[view].projection, fov, zNear, zFar);
 }
 
 const glm::mat4& VulkanCamera::GetProjection()
@@ -233,11 +456,26 @@ const glm::mat4& VulkanCamera::GetTransform()
     return this->vpMap->view;
 }
 
-void VulkanCamera::SetTransform(const glm::mat4& transform)
+void VulkanCamera::SetRenderScale(float scale)
+{
+    ASSERT(scale > 0.0f && scale <= 1.0f);
+    renderScale = scale;
+}
+
+VkExtent2D VulkanCamera::GetRenderExtent()
+{
+    return {
+        std::max(1u, static_cast<uint32_t>(properties.Extent.x * renderScale)),
+        std::max(1u, static_cast<uint32_t>(properties.Extent.y * renderScale))
+    };
+}
+
+void VulkanCamera::SetTransform(const glm::mat4& transform, uint32_t view)
 {
     ZoneScopedN("VulkanCamera::SetTransform");
+    ASSERT(view < viewCount);
 
-    this->vpMap->view = glm::inverse(transform);
+    this->vpMap[view].view = glm::inverse(transform);
 }
 
 VulkanCamera::~VulkanCamera()
@@ -256,17 +494,45 @@ void VulkanCamera::Destroy()
     vkDeviceWaitIdle(vulkanDevice->vkDevice);
 
     colorImage.Destroy();
+    msaaImage.Destroy();
     cameraUniform.Destroy();
+    lightBuffer.Destroy();
 
     vkDestroyImageView(vulkanDevice->vkDevice, depthImageView, nullptr);
     vkDestroyImageView(vulkanDevice->vkDevice, stencilImageView, nullptr);
 
+    culling.Destroy();
     vkDestroyImage(vulkanDevice->vkDevice, depthImage, nullptr);
     vkFreeMemory(vulkanDevice->vkDevice, depthMemory, nullptr);
 
     vkDestroyFramebuffer(vulkanDevice->vkDevice,framebuffer, nullptr);
 
+    for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+    {
+        vkDestroyFramebuffer(vulkanDevice->vkDevice, shadowFramebuffers[i], nullptr);
+        vkDestroyImageView(vulkanDevice->vkDevice, shadowLayerViews[i], nullptr);
+        shadowUniforms[i].Destroy();
+        shadowFramebuffers[i] = VK_NULL_HANDLE;
+        shadowLayerViews[i] = VK_NULL_HANDLE;
+        shadowVpMaps[i] = nullptr;
+    }
+    vkDestroySampler(vulkanDevice->vkDevice, shadowSampler, nullptr);
+    vkDestroyImageView(vulkanDevice->vkDevice, shadowArrayView, nullptr);
+    vkDestroyImage(vulkanDevice->vkDevice, shadowImage, nullptr);
+    vkFreeMemory(vulkanDevice->vkDevice, shadowMemory, nullptr);
+    shadowSampler = VK_NULL_HANDLE;
+    shadowArrayView = VK_NULL_HANDLE;
+    shadowImage = VK_NULL_HANDLE;
+    shadowMemory = VK_NULL_HANDLE;
+
+    if (timestampPool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(vulkanDevice->vkDevice, timestampPool, nullptr);
+        timestampPool = VK_NULL_HANDLE;
+    }
+
     vpMap = nullptr;
+    lightMap = nullptr;
 }
 
 std::shared_ptr<VulkanVrDisplay> VulkanVrDisplay::BuildCamera()
@@ -279,8 +545,16 @@ std::shared_ptr<VulkanVrDisplay> VulkanVrDisplay::BuildCamera()
 
     CameraProperties prop{};
     prop.UseFrameExtent = false;
-    display->cameras[0] = VulkanCamera::BuildCamera(prop);
-    display->cameras[1] = VulkanCamera::BuildCamera(prop);
+    display->multiview = VulkanRenderer::GetInstance().IsMultiviewEnabled();
+    if (display->multiview)
+    {
+        display->stereoCamera = VulkanCamera::BuildCamera(prop, 2);
+    }
+    else
+    {
+        display->cameras[0] = VulkanCamera::BuildCamera(prop);
+        display->cameras[1] = VulkanCamera::BuildCamera(prop);
+    }
 
     return display;
 }
@@ -295,8 +569,62 @@ void VulkanVrDisplay::Initialize(glm::vec2 extent)
     prop.Fov = 90; // Just a placeholder.
     // Fox is directly acquired from Openxr system.
 
-    cameras[0]->RebuildCamera(prop);
-    cameras[1]->RebuildCamera(prop);
+    if (multiview)
+    {
+        stereoCamera->RebuildCamera(prop);
+    }
+    else
+    {
+        cameras[0]->RebuildCamera(prop);
+        cameras[1]->RebuildCamera(prop);
+    }
+}
+
+void VulkanVrDisplay::SetRenderScale(float scale)
+{
+    ZoneScopedN("VulkanVrDisplay::SetRenderScale");
+
+    if (multiview)
+    {
+        stereoCamera->SetRenderScale(scale);
+    }
+    else
+    {
+        cameras[0]->SetRenderScale(scale);
+        cameras[1]->SetRenderScale(scale);
+    }
+}
+
+void VulkanVrDisplay::SetEyeViews(
+    const EyeView views[2], const glm::mat4& origin)
+{
+    ZoneScopedN("VulkanVrDisplay::SetEyeViews");
+
+    trackingOrigin = origin;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        glm::vec4 quat = views[i].quat;
+        glm::vec3 pos = views[i].pos;
+        glm::mat4 eyeTransform;
+        math::XrToTransform(eyeTransform, &quat, &pos);
+
+        // View i of the stereo camera or camera i
+        std::shared_ptr<VulkanCamera> camera = multiview? stereoCamera: cameras[i];
+        uint32_t view = multiview? i: 0;
+
+        const CameraProperties& prop = camera->GetCamProperties();
+        float zNear = prop.ZNear;
+        float zFar = prop.ZFar;
+        camera->SetProjection(views[i].fov, zNear, zFar, view);
+        camera->SetTransform(origin * eyeTransform, view);
+    }
+}
+
+void VulkanVrDisplay::LateLatchEyeViews(const EyeView views[2])
+{
+    ZoneScopedN("VulkanVrDisplay::LateLatchEyeViews");
+
+    SetEyeViews(views, trackingOrigin);
 }
 
 void VulkanVrDisplay::Destory()
@@ -305,6 +633,7 @@ void VulkanVrDisplay::Destory()
 
     cameras[0] = nullptr;
     cameras[1] = nullptr;
+    stereoCamera = nullptr;
 }
 
 VulkanVrDisplay::~VulkanVrDisplay()
@@ -3,12 +3,29 @@
 #include "camera.h"
 
 #include "vulkan_texture.h"
+#include "vulkan_light.h"
+#include "light_clustering.h"
+#include "shadow_cascades.h"
+#include "vulkan_culling.h"
 #include "vk_primitives/vulkan_uniform.h"
 #include "vk_primitives/vulkan_device.h"
 #include "vulkan_swapchain.h"
 
 #include <vulkan/vulkan.h>
 #include <memory>
+#include <unordered_map>
+
+#define CAMERA_MAX_VIEWS 2 // Views rendered in one multiview pass
+
+// GPU timestamps written around the passes of a camera.
+#define CAMERA_TIMESTAMP_BEGIN          0
+#define CAMERA_TIMESTAMP_DEPTH_PREPASS  1
+#define CAMERA_TIMESTAMP_OPAQUE         2
+#define CAMERA_TIMESTAMP_TRANSPARENT    3
+#define CAMERA_TIMESTAMP_COUNT          4
+
+// Sampled depth format that every device supports.
+#define SHADOW_MAP_FORMAT   VK_FORMAT_D16_UNORM
 
 namespace renderer
 {
@@ -19,6 +36,42 @@ struct ViewProjection
     glm::mat4 projection;
 };
 
+/**
+ * Per view parameters to find the cluster of a fragment.
+ */
+struct ClusterView
+{
+    glm::vec4 depth; // p22 and p32 of the projection, slice scale and bias
+    glm::vec4 grid;  // Clusters per pixel in x and y
+};
+
+/**
+ * Cascades of the shadow casting directional light.
+ */
+struct ShadowData
+{
+    glm::mat4 cascades[SHADOW_CASCADE_COUNT]; // World to shadow map clip space
+    glm::vec4 splitDepth;   // Far end of each cascade in view depth
+    glm::vec4 texelSize;    // World size of a shadow map texel of each cascade
+    glm::uvec4 light;       // x: 1 if lights[0] casts shadows
+};
+static_assert(SHADOW_CASCADE_COUNT == 4, "Cascade parameters are packed in vec4");
+
+/**
+ * Std430 layout of the light storage buffer of a camera.
+ * Directional lights come first and light every fragment,
+ * the others only the clusters they reach.
+ */
+struct SceneLights
+{
+    glm::uvec4 lightCount; // x: all lights, y: directional lights
+    ClusterView views[CAMERA_MAX_VIEWS];
+    ShadowData shadow;
+    LightData lights[LIGHT_MAX_COUNT];
+    glm::uvec2 clusters[CAMERA_MAX_VIEWS][CLUSTER_COUNT]; // First index, count
+    uint32_t indices[CAMERA_MAX_VIEWS * CLUSTER_MAX_INDICES];
+};
+
 class RenderTechnique;
 
 class VulkanCamera: public Camera
@@ -30,8 +83,13 @@ public:
      * It must only be added to one node.
      * There is no check for it, but can cause undefined error
      * if a camera is added to multiple nodes.
+     * 
+     * With more than one view the camera renders all of them
+     * in a single multiview pass into a layered color image,
+     * one layer per view. Multiview must be enabled in the renderer.
     */
-    static std::shared_ptr<VulkanCamera> BuildCamera(CameraProperties&);
+    static std::shared_ptr<VulkanCamera> BuildCamera(
+        CameraProperties&, uint32_t viewCount = 1);
 
     void Initialize(CameraProperties& prop);
         
@@ -63,14 +121,43 @@ public:
      * @param fov <left, right, up, down> in ????
      * @param zNear near plane in meter
      * @param zFar far plane in meter
+     * @param view view of a multiview camera
      */
-    void SetProjection(glm::vec4 fov, float zNear, float zFar);
+    void SetProjection(glm::vec4 fov, float zNear, float zFar,
+        uint32_t view = 0);
 
     const glm::mat4& GetProjection(); // Used by VulkanNode
 
     const glm::mat4& GetTransform(); // Used by VulkanNode
 
-    void SetTransform(const glm::mat4&); // Used by VulkanNode
+    void SetTransform(const glm::mat4&, uint32_t view = 0); // Used by VulkanNode
+
+    uint32_t GetViewCount() {return viewCount;}
+
+    /**
+     * @brief Render to a part of the color image only.
+     * The images keep their size, the render extent is
+     * the extent of the camera times the scale.
+     * 
+     * @param scale in (0, 1]
+     */
+    void SetRenderScale(float scale);
+    float GetRenderScale() {return renderScale;}
+    VkExtent2D GetRenderExtent();
+
+    /**
+     * @brief Draw the opaque meshes into the depth buffer first,
+     * then shade only the visible fragments with an EQUAL depth test.
+     */
+    void SetDepthPrepass(bool enable) {properties.DepthPrepass = enable;}
+    bool IsDepthPrepass() {return properties.DepthPrepass;}
+
+    /**
+     * @brief GPU time of the last rendered frame in milliseconds:
+     * depth pre-pass, opaque and transparent meshes.
+     * Zero when timestamps are not supported.
+     */
+    const glm::vec3& GetPassTimes() {return passTimes;}
 
     VulkanCamera() = default;
     ~VulkanCamera() override;
@@ -80,23 +167,65 @@ public:
 
     VkFramebuffer GetFrameBuffer(){return framebuffer;}
     VkDescriptorSet* GetDescriptorSet(){return &cameraDescSet;}
-    VkDescriptorSet* GetTextureDescriptorSet(){return &colorTexDescSet;}
+    VkDescriptorSet* GetLightDescriptorSet(){return &lightDescSet;}
+    VkDescriptorSet* GetTextureDescriptorSet(uint32_t view = 0)
+    {
+        return &colorTexDescSet[view];
+    }
 
-    friend RenderTechnique; // Have access to colorTexDescSet
+    friend RenderTechnique; // Have access to colorTexDescSet and lights
 
 private: 
     VulkanTexture colorImage;
+    VulkanTexture msaaImage; // Resolved into colorImage, only with MSAA
     VulkanUniform cameraUniform;
-    ViewProjection* vpMap = nullptr;
+    ViewProjection* vpMap = nullptr; // One entry per view
+    uint32_t viewCount = 1;
+    float renderScale = 1.0f;
 
     VkDescriptorSet cameraDescSet; // Camera vp descriptor set
-    VkDescriptorSet colorTexDescSet; // Rendered texture descriptor set
+
+    // Lights binned for the views of this camera, filled by RenderTechnique.
+    VulkanUniform lightBuffer;
+    SceneLights* lightMap = nullptr;
+    VkDescriptorSet lightDescSet;
+    LightClustering clustering[CAMERA_MAX_VIEWS];
+    VkDescriptorSet colorTexDescSet[CAMERA_MAX_VIEWS]; // Rendered texture per view
+
+    // Multiview writes one query per view, so each timestamp
+    // takes viewCount queries. Read back by RenderTechnique a frame later.
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    bool timestampsWritten = false;
+    glm::vec3 passTimes{0.0f};
+
+    // LOD picked by RenderTechnique for each mesh instance id, in the last
+    // frame and in this one. Instances not drawn in a frame are dropped.
+    std::unordered_map<uint64_t, uint32_t> lastLods;
+    std::unordered_map<uint64_t, uint32_t> currentLods;
+
+    // Shadow map of the first directional light, one layer per cascade,
+    // drawn by RenderTechnique. A cascade is only drawn again
+    // when its matrix or one of its casters changes.
+    ShadowCascades shadowCascades;
+    VkImage shadowImage{VK_NULL_HANDLE};
+    VkDeviceMemory shadowMemory{VK_NULL_HANDLE};
+    VkImageView shadowArrayView{VK_NULL_HANDLE}; // Sampled with depth compare
+    VkSampler shadowSampler{VK_NULL_HANDLE};
+    VkImageView shadowLayerViews[SHADOW_CASCADE_COUNT]{};
+    VkFramebuffer shadowFramebuffers[SHADOW_CASCADE_COUNT]{};
+    VulkanUniform shadowUniforms[SHADOW_CASCADE_COUNT];
+    ViewProjection* shadowVpMaps[SHADOW_CASCADE_COUNT]{};
+    VkDescriptorSet shadowDescSets[SHADOW_CASCADE_COUNT];
+    uint64_t shadowKeys[SHADOW_CASCADE_COUNT]{}; // Matrix and casters last drawn
 
     VkImage depthImage{VK_NULL_HANDLE};
     VkDeviceMemory depthMemory{VK_NULL_HANDLE};
     VkImageView depthImageView{VK_NULL_HANDLE};
     VkImageView stencilImageView{VK_NULL_HANDLE};
 
+    // Draw commands and depth pyramid, only with GPU culling.
+    VulkanCullingView culling;
+
     VkFramebuffer framebuffer{VK_NULL_HANDLE};
 
     CameraProperties properties{};
@@ -110,14 +239,18 @@ class VulkanVrDisplay: public VrDisplay
 
 public:
     /**
-     * @brief Build two regular cameras.
+     * @brief Build the eye cameras.
+     * When multiview is enabled in the renderer, both eyes are rendered
+     * by one stereo camera with two views, otherwise by two regular
+     * cameras, one per eye. Outside of VR the display is previewed
+     * through GetPreviewCamera.
      * 
      * @return std::shared_ptr<VulkanVrDisplay> 
      */
     static std::shared_ptr<VulkanVrDisplay> BuildCamera();
 
     /**
-     * @brief Rebuild the two cameras when a new XR sessions is created.
+     * @brief Rebuild the eye cameras when a new XR sessions is created.
      * The extent is the resolution of the displays acquired from the session.
      * 
      * @param extent 
@@ -135,10 +268,48 @@ public:
 
     std::shared_ptr<VulkanCamera> GetLeftCamera() {return cameras[0];}
     std::shared_ptr<VulkanCamera> GetRightCamera() {return cameras[1];}
+    std::shared_ptr<VulkanCamera> GetStereoCamera() {return stereoCamera;}
+
+    /**
+     * @brief Camera shown outside of VR, in the editor and when running
+     * without a headset: the stereo camera with multiview, else the left eye.
+     * Its first view is the one to display.
+     */
+    std::shared_ptr<VulkanCamera> GetPreviewCamera()
+    {
+        return multiview? stereoCamera: cameras[0];
+    }
+    bool IsMultiview() {return multiview;}
+
+    /**
+     * @brief Render scale of the eye cameras, used
+     * by dynamic resolution.
+     */
+    void SetRenderScale(float scale);
+
+    /**
+     * @brief Set projection and view matrices of both eyes.
+     * 
+     * @param views eyes in the tracking space
+     * @param origin global transform of the tracking space
+     */
+    void SetEyeViews(const EyeView views[2], const glm::mat4& origin);
+
+    /**
+     * @brief Replace the eye views right before command recording,
+     * with the origin of the last SetEyeViews call.
+     */
+    void LateLatchEyeViews(const EyeView views[2]);
 
 private:
     // index 0 = left eye, index 1 = right eye
     std::shared_ptr<VulkanCamera> cameras[2] = {nullptr, nullptr};
+
+    // Both eyes, view 0 = left eye, view 1 = right eye
+    std::shared_ptr<VulkanCamera> stereoCamera = nullptr;
+    bool multiview = false;
+
+    glm::mat4 trackingOrigin{1.0f};
 };
 
 } // namespace renderer
\ No newline at end of file
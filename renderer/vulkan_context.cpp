@@ -1,5 +1,7 @@
 #include "vulkan_context.h"
 
+#include <glm/gtc/matrix_transform.hpp>
+
 #include <vector>
 
 namespace renderer
@@ -19,38 +21,63 @@ void VulkanContext::RenderDebugLine(glm::vec3 direction, float length)
 
 void VulkanContext::RenderDebugSphere(glm::vec3 position, float radius)
 {
-    std::vector<LineData> lineData;
-    VulkanLineGenerator::GetSphere(lineData, position, radius);
-    debugLineRenderer->AddLines(lineData);
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), position);
+    transform = glm::scale(transform, glm::vec3(radius));
+
+    debugLineRenderer->AddShape(VulkanLineGenerator::UnitShape::Sphere,
+        transform, debugLineRenderer->GetLineProperties()->color);
 }
 
 void VulkanContext::RenderDebugCircle(glm::vec3 position, glm::vec3 normal, float radius)
 {
-    std::vector<LineData> lineData;
-    VulkanLineGenerator::GetCircle(lineData, position, normal, radius);
-    debugLineRenderer->AddLines(lineData);
+    // Same basis as VulkanLineGenerator::GetCircle
+    glm::vec3 v1 = glm::normalize(normal);
+    glm::vec3 v2 = glm::normalize(glm::vec3(0.0, -v1.z, v1.y));
+    glm::vec3 v3 = glm::normalize(glm::cross(v1, v2));
+
+    glm::mat4 transform = glm::mat4(
+        glm::vec4(v2 * radius, 0),
+        glm::vec4(v3 * radius, 0),
+        glm::vec4(v1 * radius, 0),
+        glm::vec4(position, 1)
+    );
+
+    debugLineRenderer->AddShape(VulkanLineGenerator::UnitShape::Circle,
+        transform, debugLineRenderer->GetLineProperties()->color);
 }
 
 void VulkanContext::RenderDebugCapsule(float halfHeight, float radius,
     const glm::mat4& transform)
 {
-    std::vector<LineData> lineData;
-    VulkanLineGenerator::GetCapsule(lineData, halfHeight, radius, transform);
-    debugLineRenderer->AddLines(lineData);
+    glm::vec3 color = debugLineRenderer->GetLineProperties()->color;
+
+    // The cap at -X is the one at +X mirrored.
+    glm::mat4 capTransform = glm::translate(transform, glm::vec3(halfHeight, 0, 0));
+    debugLineRenderer->AddShape(VulkanLineGenerator::UnitShape::CapsuleCap,
+        glm::scale(capTransform, glm::vec3(radius)), color);
+
+    capTransform = glm::translate(transform, glm::vec3(-halfHeight, 0, 0));
+    debugLineRenderer->AddShape(VulkanLineGenerator::UnitShape::CapsuleCap,
+        glm::scale(capTransform, glm::vec3(-radius, radius, radius)), color);
+
+    debugLineRenderer->AddShape(VulkanLineGenerator::UnitShape::CapsuleSides,
+        glm::scale(transform, glm::vec3(halfHeight, radius, radius)), color);
 }
 
 void VulkanContext::RenderDebugAABB(glm::vec3 minCoordinates, glm::vec3 maxCoordinates)
 {
-    std::vector<LineData> lineData;
-    VulkanLineGenerator::GetAABB(lineData, minCoordinates, maxCoordinates);
-    debugLineRenderer->AddLines(lineData);
+    glm::mat4 transform = glm::translate(
+        glm::mat4(1.0f), 0.5f * (minCoordinates + maxCoordinates));
+    transform = glm::scale(transform, maxCoordinates - minCoordinates);
+
+    debugLineRenderer->AddShape(VulkanLineGenerator::UnitShape::Box,
+        transform, debugLineRenderer->GetLineProperties()->color);
 }
 
 void VulkanContext::RenderDebugOBB(glm::mat4 transform)
 {
-    std::vector<LineData> lineData;
-    VulkanLineGenerator::GetOBB(lineData, transform);
-    debugLineRenderer->AddLines(lineData);
+    debugLineRenderer->AddShape(VulkanLineGenerator::UnitShape::Box,
+        transform, debugLineRenderer->GetLineProperties()->color);
 }
 
 void VulkanContext::ClearRenderData()
@@ -0,0 +1,852 @@
+#include "vulkan_culling.h"
+
+#include "vulkan_camera.h"
+#include "vulkan_mesh.h"
+#include "vk_primitives/vulkan_cmdbuffer.h"
+#include "vk_primitives/vulkan_shader.h"
+#include "validation.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <tracy/Tracy.hpp>
+
+
+namespace renderer
+{
+
+static_assert(GPU_CULL_MAX_VIEWS == CAMERA_MAX_VIEWS,
+    "Cameras are culled in one dispatch");
+
+/**
+ * Push constants of culling/depth_pyramid.comp.
+ */
+struct ReducePushConst
+{
+    glm::uvec2 sourceSize;
+    glm::uvec2 targetSize;
+    uint32_t sampleCount;
+};
+
+/**
+ * Reallocate a mapped buffer if it holds less than count elements.
+ * Its content is lost, returns true if it was reallocated.
+ */
+static bool ReserveBuffer(VulkanDevice* vulkanDevice, VulkanUniform& buffer,
+    uint32_t& capacity, uint32_t count, size_t stride, VkBufferUsageFlags usage)
+{
+    if (count <= capacity)
+        return false;
+
+    capacity = std::max(std::max(count, capacity * 2), 64u);
+    buffer.Initialize(vulkanDevice, capacity * stride, usage);
+    return true;
+}
+
+void VulkanCullingView::Initialize(VulkanDevice* vulkanDevice, VulkanCulling& culling,
+    VkImageView depthView, VkExtent2D extent, uint32_t viewCount)
+{
+    ZoneScopedN("VulkanCullingView::Initialize");
+
+    this->vulkanDevice = vulkanDevice;
+    this->descriptorPool = culling.descriptorPool;
+    VkDevice vkDevice = vulkanDevice->vkDevice;
+
+    viewUniform.Initialize(vulkanDevice, sizeof(CullViewData));
+    viewMap = static_cast<CullViewData*>(viewUniform.Map());
+
+    // Buffers are allocated by the first Cull.
+    commandCapacity = 0;
+    countCapacity = 0;
+    lodCapacity = 0;
+    lodCount = 0;
+
+    culling.cullLayout->AllocateDescriptorSet("cull", 1, &cullSet);
+
+    // Multiview cameras still get a texel so that the cull set is complete.
+    occlusion = viewCount == 1;
+    pyramidSize = occlusion?
+        GpuCulling::GetPyramidSize(extent.width, extent.height): glm::uvec2(1, 1);
+    pyramidLevels = GpuCulling::GetPyramidLevels(pyramidSize);
+    pyramidValid = false;
+
+    {
+        VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = pyramidSize.x;
+        imageInfo.extent.height = pyramidSize.y;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = pyramidLevels;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        CHECK_VKCMD(vkCreateImage(vkDevice, &imageInfo, nullptr, &pyramidImage));
+
+        VkMemoryRequirements memRequirements{};
+        vkGetImageMemoryRequirements(vkDevice, pyramidImage, &memRequirements);
+        VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = vulkanDevice->GetMemoryTypeIndex(
+            memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        CHECK_VKCMD(vkAllocateMemory(vkDevice, &allocInfo, nullptr, &pyramidMemory));
+        CHECK_VKCMD(vkBindImageMemory(vkDevice, pyramidImage, pyramidMemory, 0));
+
+        VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+        viewInfo.image = pyramidImage;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R32_SFLOAT;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = pyramidLevels;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+        CHECK_VKCMD(vkCreateImageView(vkDevice, &viewInfo, nullptr, &pyramidView));
+
+        levelViews.resize(pyramidLevels);
+        for (uint32_t i = 0; i < pyramidLevels; i++)
+        {
+            viewInfo.subresourceRange.baseMipLevel = i;
+            viewInfo.subresourceRange.levelCount = 1;
+            CHECK_VKCMD(vkCreateImageView(vkDevice, &viewInfo, nullptr, &levelViews[i]));
+        }
+
+        // Texels are fetched, the sampler is only there for the descriptors.
+        VkSamplerCreateInfo samplerInfo{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = static_cast<float>(pyramidLevels);
+        CHECK_VKCMD(vkCreateSampler(vkDevice, &samplerInfo, nullptr, &pyramidSampler));
+    }
+
+    // The pyramid stays in the general layout, written and read by compute.
+    {
+        VulkanSingleCmd cmd;
+        cmd.Initialize(vulkanDevice);
+        VkCommandBuffer vkCommandBuffer = cmd.BeginCommand();
+
+        VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = pyramidImage;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = pyramidLevels;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(vkCommandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        cmd.EndCommand();
+    }
+
+    if (!occlusion)
+        return;
+
+    // Level 0 reads the depth buffer, the others the level above them.
+    reduceSets.resize(pyramidLevels);
+    for (uint32_t i = 0; i < pyramidLevels; i++)
+    {
+        culling.reduceLayout->AllocateDescriptorSet("reduce", 1, &reduceSets[i]);
+
+        VkDescriptorImageInfo sourceInfo{};
+        sourceInfo.sampler = pyramidSampler;
+        sourceInfo.imageView = (i == 0)? depthView: levelViews[i - 1];
+        sourceInfo.imageLayout = (i == 0)?
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL: VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorImageInfo targetInfo{};
+        targetInfo.imageView = levelViews[i];
+        targetInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::array<VkWriteDescriptorSet, 2> descriptorWrite{};
+
+        descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite[0].dstSet = reduceSets[i];
+        descriptorWrite[0].dstBinding = 0;
+        descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite[0].descriptorCount = 1;
+        descriptorWrite[0].pImageInfo = &sourceInfo;
+
+        descriptorWrite[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite[1].dstSet = reduceSets[i];
+        descriptorWrite[1].dstBinding = 1;
+        descriptorWrite[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptorWrite[1].descriptorCount = 1;
+        descriptorWrite[1].pImageInfo = &targetInfo;
+
+        vkUpdateDescriptorSets(vkDevice,
+            descriptorWrite.size(), descriptorWrite.data(), 0, nullptr);
+    }
+}
+
+void VulkanCullingView::Destroy()
+{
+    ZoneScopedN("VulkanCullingView::Destroy");
+
+    if (vulkanDevice == nullptr)
+        return;
+
+    VkDevice vkDevice = vulkanDevice->vkDevice;
+
+    if (!reduceSets.empty())
+    {
+        vkFreeDescriptorSets(vkDevice, descriptorPool,
+            static_cast<uint32_t>(reduceSets.size()), reduceSets.data());
+        reduceSets.clear();
+    }
+    vkFreeDescriptorSets(vkDevice, descriptorPool, 1, &cullSet);
+    cullSet = VK_NULL_HANDLE;
+
+    for (VkImageView levelView: levelViews)
+        vkDestroyImageView(vkDevice, levelView, nullptr);
+    levelViews.clear();
+    vkDestroyImageView(vkDevice, pyramidView, nullptr);
+    vkDestroySampler(vkDevice, pyramidSampler, nullptr);
+    vkDestroyImage(vkDevice, pyramidImage, nullptr);
+    vkFreeMemory(vkDevice, pyramidMemory, nullptr);
+    pyramidView = VK_NULL_HANDLE;
+    pyramidSampler = VK_NULL_HANDLE;
+    pyramidImage = VK_NULL_HANDLE;
+    pyramidMemory = VK_NULL_HANDLE;
+
+    viewUniform.Destroy();
+    commandBuffer.Destroy();
+    countBuffer.Destroy();
+    lodBuffer.Destroy();
+    viewMap = nullptr;
+    commandCapacity = 0;
+    countCapacity = 0;
+    lodCapacity = 0;
+
+    vulkanDevice = nullptr;
+}
+
+void VulkanCulling::PushDescriptorSetLayout(PipelineLayoutBuilder& layoutBuilder)
+{
+    ZoneScopedN("VulkanCulling::PushDescriptorSetLayout");
+
+    layoutBuilder.PushDescriptorSetLayout("instances",
+    {
+        /*
+        layout (set = 1, binding = 0, std430) readonly buffer Instances
+        {
+            Instance instances[];
+        };
+        */
+        layoutBuilder.descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT, 0)
+    });
+}
+
+void VulkanCulling::Initialize(VulkanDevice* vulkanDevice, VkDescriptorPool descriptorPool,
+    VkPipelineCache pipelineCache, VkSampleCountFlagBits samples)
+{
+    ZoneScopedN("VulkanCulling::Initialize");
+
+    this->vulkanDevice = vulkanDevice;
+    this->descriptorPool = descriptorPool;
+    this->samples = samples;
+
+    drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+        vkGetDeviceProcAddr(vulkanDevice->vkDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+    ASSERT(drawIndexedIndirectCount != nullptr);
+
+    {
+        PipelineLayoutBuilder layoutBuilder(vulkanDevice);
+        layoutBuilder.PushDescriptorSetLayout("cull",
+        {
+            // Batches, view parameters, commands, counts, levels and depth pyramid
+            layoutBuilder.descriptorSetLayoutBinding(
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 0),
+            layoutBuilder.descriptorSetLayoutBinding(
+                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1),
+            layoutBuilder.descriptorSetLayoutBinding(
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 2),
+            layoutBuilder.descriptorSetLayoutBinding(
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 3),
+            layoutBuilder.descriptorSetLayoutBinding(
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 4),
+            layoutBuilder.descriptorSetLayoutBinding(
+                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 5)
+        });
+        // Shared with the vertex shaders of the indirect draws.
+        PushDescriptorSetLayout(layoutBuilder);
+        cullLayout = layoutBuilder.BuildPipelineLayout(descriptorPool, nullptr, 0);
+    }
+
+    {
+        PipelineLayoutBuilder layoutBuilder(vulkanDevice);
+        layoutBuilder.PushDescriptorSetLayout("reduce",
+        {
+            layoutBuilder.descriptorSetLayoutBinding(
+                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 0),
+            layoutBuilder.descriptorSetLayoutBinding(
+                VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+        });
+
+        VkPushConstantRange range = {};
+        range.offset = 0;
+        range.size = sizeof(ReducePushConst);
+        range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        reduceLayout = layoutBuilder.BuildPipelineLayout(descriptorPool, &range);
+    }
+
+    cullPipeline = CreatePipeline("resources/vulkan_shaders/culling/cull_comp.spv",
+        cullLayout->layout, pipelineCache);
+    reducePipeline = CreatePipeline("resources/vulkan_shaders/culling/depth_pyramid_comp.spv",
+        reduceLayout->layout, pipelineCache);
+    if (samples != VK_SAMPLE_COUNT_1_BIT)
+    {
+        reduceMsaaPipeline = CreatePipeline(
+            "resources/vulkan_shaders/culling/depth_pyramid_msaa_comp.spv",
+            reduceLayout->layout, pipelineCache);
+    }
+
+    // The table is allocated by the first Upload with instances.
+    cullLayout->AllocateDescriptorSet("instances", 1, &instanceSet);
+    instanceCapacity = 0;
+    stagingCapacity = 0;
+    batchCapacity = 0;
+    batchesDirty = false;
+}
+
+void VulkanCulling::Destroy()
+{
+    ZoneScopedN("VulkanCulling::Destroy");
+
+    if (vulkanDevice == nullptr)
+        return;
+
+    VkDevice vkDevice = vulkanDevice->vkDevice;
+
+    vkFreeDescriptorSets(vkDevice, descriptorPool, 1, &instanceSet);
+    instanceSet = VK_NULL_HANDLE;
+
+    vkDestroyPipeline(vkDevice, cullPipeline, nullptr);
+    vkDestroyPipeline(vkDevice, reducePipeline, nullptr);
+    vkDestroyPipeline(vkDevice, reduceMsaaPipeline, nullptr);
+    cullPipeline = VK_NULL_HANDLE;
+    reducePipeline = VK_NULL_HANDLE;
+    reduceMsaaPipeline = VK_NULL_HANDLE;
+    cullLayout = nullptr;
+    reduceLayout = nullptr;
+
+    DestroyInstanceBuffer();
+    stagingBuffer.Destroy();
+    batchBuffer.Destroy();
+    stagingCapacity = 0;
+    batchCapacity = 0;
+
+    instances.clear();
+    freeSlots.clear();
+    dirtyBits.clear();
+    keptBits.clear();
+    visibleBits.clear();
+    batches.clear();
+    freeBatches.clear();
+    drawOrder.clear();
+    meshBatches.clear();
+
+    vulkanDevice = nullptr;
+}
+
+void VulkanCulling::DestroyInstanceBuffer()
+{
+    ZoneScopedN("VulkanCulling::DestroyInstanceBuffer");
+
+    VkDevice vkDevice = vulkanDevice->vkDevice;
+
+    vkDestroyBuffer(vkDevice, instanceBuffer, nullptr);
+    vkFreeMemory(vkDevice, instanceMemory, nullptr);
+    instanceBuffer = VK_NULL_HANDLE;
+    instanceMemory = VK_NULL_HANDLE;
+    instanceCapacity = 0;
+}
+
+VkPipeline VulkanCulling::CreatePipeline(const char* path, VkPipelineLayout layout,
+    VkPipelineCache pipelineCache)
+{
+    ZoneScopedN("VulkanCulling::CreatePipeline");
+
+    VkDevice vkDevice = vulkanDevice->vkDevice;
+
+    VkComputePipelineCreateInfo pipelineInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    pipelineInfo.stage = VulkanShader::LoadFromFile(
+        vkDevice, path, VK_SHADER_STAGE_COMPUTE_BIT);
+    pipelineInfo.layout = layout;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    CHECK_VKCMD(vkCreateComputePipelines(
+        vkDevice, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline));
+
+    vkDestroyShaderModule(vkDevice, pipelineInfo.stage.module, nullptr);
+    return pipeline;
+}
+
+uint32_t VulkanCulling::AddInstance(VulkanMesh* mesh)
+{
+    ZoneScopedN("VulkanCulling::AddInstance");
+
+    uint32_t slot;
+    if (!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(instances.size());
+        instances.emplace_back();
+        if (slot % 64 == 0)
+        {
+            dirtyBits.push_back(0);
+            keptBits.push_back(0);
+            visibleBits.push_back(0);
+        }
+    }
+
+    auto it = meshBatches.find(mesh);
+    uint32_t batch;
+    if (it != meshBatches.end())
+    {
+        batch = it->second;
+    }
+    else if (!freeBatches.empty())
+    {
+        batch = freeBatches.back();
+        freeBatches.pop_back();
+        meshBatches[mesh] = batch;
+    }
+    else
+    {
+        batch = static_cast<uint32_t>(batches.size());
+        batches.push_back({nullptr, 0, 0});
+        meshBatches[mesh] = batch;
+    }
+    batches[batch].mesh = mesh;
+    batches[batch].instanceCount++;
+    batchesDirty = true; // The commands of the next batches move
+
+    GpuInstance& instance = instances[slot];
+    instance = GpuInstance{};
+    instance.batch = batch;
+    MarkDirty(slot);
+    return slot;
+}
+
+void VulkanCulling::RemoveInstance(uint32_t slot)
+{
+    ZoneScopedN("VulkanCulling::RemoveInstance");
+
+    // Components outlive the renderer when the application closes.
+    if (vulkanDevice == nullptr || slot >= instances.size())
+        return;
+
+    GpuInstance& instance = instances[slot];
+    Batch& batch = batches[instance.batch];
+    if (--batch.instanceCount == 0)
+    {
+        meshBatches.erase(batch.mesh);
+        batch.mesh = nullptr;
+        freeBatches.push_back(instance.batch);
+    }
+    batchesDirty = true;
+
+    instance.visible = 0;
+    keptBits[slot / 64] &= ~(1ull << (slot % 64));
+    visibleBits[slot / 64] &= ~(1ull << (slot % 64));
+    MarkDirty(slot);
+    freeSlots.push_back(slot);
+}
+
+void VulkanCulling::SetTransform(uint32_t slot, const glm::mat4& model,
+    const glm::vec4& sphere)
+{
+    instances[slot].model = model;
+    instances[slot].sphere = sphere;
+    MarkDirty(slot);
+}
+
+void VulkanCulling::SetMaterial(uint32_t slot, uint32_t material)
+{
+    if (instances[slot].material == material)
+        return;
+
+    instances[slot].material = material;
+    MarkDirty(slot);
+}
+
+void VulkanCulling::KeepInstance(uint32_t slot)
+{
+    keptBits[slot / 64] |= 1ull << (slot % 64);
+}
+
+void VulkanCulling::MarkDirty(uint32_t slot)
+{
+    dirtyBits[slot / 64] |= 1ull << (slot % 64);
+}
+
+void VulkanCulling::ReserveInstances()
+{
+    ZoneScopedN("VulkanCulling::ReserveInstances");
+
+    uint32_t slotCount = static_cast<uint32_t>(instances.size());
+    if (slotCount <= instanceCapacity)
+        return;
+
+    // Nothing reads the old table anymore, EndCommand waited for the last frame.
+    uint32_t capacity = std::max(std::max(slotCount, instanceCapacity * 2), 64u);
+    if (instanceBuffer != VK_NULL_HANDLE)
+        DestroyInstanceBuffer();
+
+    VkDevice vkDevice = vulkanDevice->vkDevice;
+
+    VkBufferCreateInfo bufferInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufferInfo.size = sizeof(GpuInstance) * capacity;
+    bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    CHECK_VKCMD(vkCreateBuffer(vkDevice, &bufferInfo, nullptr, &instanceBuffer));
+
+    VkMemoryRequirements memRequirements{};
+    vkGetBufferMemoryRequirements(vkDevice, instanceBuffer, &memRequirements);
+    VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = vulkanDevice->GetMemoryTypeIndex(
+        memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    CHECK_VKCMD(vkAllocateMemory(vkDevice, &allocInfo, nullptr, &instanceMemory));
+    CHECK_VKCMD(vkBindBufferMemory(vkDevice, instanceBuffer, instanceMemory, 0));
+    instanceCapacity = capacity;
+
+    VkDescriptorBufferInfo instanceInfo{};
+    instanceInfo.buffer = instanceBuffer;
+    instanceInfo.offset = 0;
+    instanceInfo.range = bufferInfo.size;
+
+    VkWriteDescriptorSet descriptorWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    descriptorWrite.dstSet = instanceSet;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pBufferInfo = &instanceInfo;
+    vkUpdateDescriptorSets(vkDevice, 1, &descriptorWrite, 0, nullptr);
+
+    std::fill(dirtyBits.begin(), dirtyBits.end(), ~0ull);
+    if (slotCount % 64 != 0)
+        dirtyBits.back() = (1ull << (slotCount % 64)) - 1;
+}
+
+void VulkanCulling::WriteBatches()
+{
+    ZoneScopedN("VulkanCulling::WriteBatches");
+
+    // Each batch has a command slot per instance, filled from its first command.
+    uint32_t batchCount = static_cast<uint32_t>(batches.size());
+    ReserveBuffer(vulkanDevice, batchBuffer, batchCapacity,
+        batchCount, sizeof(GpuBatch), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+    GpuBatch* gpuBatches = static_cast<GpuBatch*>(batchBuffer.Map());
+    uint32_t firstCommand = 0;
+    drawOrder.clear();
+    for (uint32_t i = 0; i < batchCount; i++)
+    {
+        batches[i].firstCommand = firstCommand;
+        firstCommand += batches[i].instanceCount;
+
+        GpuBatch& gpuBatch = gpuBatches[i];
+        gpuBatch = GpuBatch{};
+        gpuBatch.firstCommand = batches[i].firstCommand;
+
+        VulkanMesh* mesh = batches[i].mesh;
+        if (mesh == nullptr)
+            continue;
+
+        drawOrder.push_back(i);
+        gpuBatch.lodCount = std::min(mesh->GetLodCount(), static_cast<uint32_t>(MESH_MAX_LOD));
+        for (uint32_t level = 0; level < gpuBatch.lodCount; level++)
+        {
+            const MeshLod& lod = mesh->GetLod(level);
+            gpuBatch.lods[level] = glm::uvec2(lod.firstIndex, lod.indexCount);
+        }
+    }
+
+    std::sort(drawOrder.begin(), drawOrder.end(),
+        [this](uint32_t a, uint32_t b) {
+            return batches[a].mesh->GetVertexFormat() < batches[b].mesh->GetVertexFormat();
+        });
+    batchesDirty = false;
+}
+
+void VulkanCulling::Upload(VkCommandBuffer commandBuffer)
+{
+    ZoneScopedN("VulkanCulling::Upload");
+
+    // Slots that were not kept in this frame are hidden, the others shown again.
+    for (uint32_t word = 0; word < keptBits.size(); word++)
+    {
+        uint64_t changed = keptBits[word] ^ visibleBits[word];
+        if (changed == 0)
+            continue;
+
+        for (uint32_t bit = 0; bit < 64; bit++)
+        {
+            if ((changed >> bit) & 1ull)
+                instances[word * 64 + bit].visible = (keptBits[word] >> bit) & 1ull;
+        }
+        dirtyBits[word] |= changed;
+        visibleBits[word] = keptBits[word];
+    }
+    std::fill(keptBits.begin(), keptBits.end(), 0ull);
+
+    if (batchesDirty)
+        WriteBatches();
+
+    ReserveInstances();
+
+    std::vector<glm::uvec2> ranges;
+    GpuCulling::GetDirtyRanges(dirtyBits, ranges);
+    std::fill(dirtyBits.begin(), dirtyBits.end(), 0ull);
+
+    uint32_t dirtyCount = 0;
+    for (const glm::uvec2& range: ranges)
+        dirtyCount += range.y;
+    TracyPlot("GPU instances uploaded", static_cast<int64_t>(dirtyCount));
+
+    if (dirtyCount == 0)
+        return;
+
+    ReserveBuffer(vulkanDevice, stagingBuffer, stagingCapacity,
+        dirtyCount, sizeof(GpuInstance), VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+    // The dirty slots are packed in the staging buffer
+    // and scattered into the table with one region per run.
+    GpuInstance* staging = static_cast<GpuInstance*>(stagingBuffer.Map());
+    std::vector<VkBufferCopy> regions(ranges.size());
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < ranges.size(); i++)
+    {
+        memcpy(staging + offset, &instances[ranges[i].x], sizeof(GpuInstance) * ranges[i].y);
+
+        regions[i].srcOffset = sizeof(GpuInstance) * offset;
+        regions[i].dstOffset = sizeof(GpuInstance) * ranges[i].x;
+        regions[i].size = sizeof(GpuInstance) * ranges[i].y;
+        offset += ranges[i].y;
+    }
+
+    vkCmdCopyBuffer(commandBuffer, stagingBuffer.vkBuffer, instanceBuffer,
+        static_cast<uint32_t>(regions.size()), regions.data());
+
+    VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void VulkanCulling::WriteCullSet(VulkanCullingView& view)
+{
+    ZoneScopedN("VulkanCulling::WriteCullSet");
+
+    VkDescriptorImageInfo pyramidInfo{};
+    pyramidInfo.sampler = view.pyramidSampler;
+    pyramidInfo.imageView = view.pyramidView;
+    pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    std::array<VkDescriptorBufferInfo*, 5> buffers = {
+        batchBuffer.GetDescriptor(),
+        view.viewUniform.GetDescriptor(),
+        view.commandBuffer.GetDescriptor(),
+        view.countBuffer.GetDescriptor(),
+        view.lodBuffer.GetDescriptor()
+    };
+
+    std::array<VkWriteDescriptorSet, 6> descriptorWrite{};
+    for (uint32_t i = 0; i < descriptorWrite.size(); i++)
+    {
+        descriptorWrite[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite[i].dstSet = view.cullSet;
+        descriptorWrite[i].dstBinding = i;
+        descriptorWrite[i].descriptorCount = 1;
+        if (i < buffers.size())
+        {
+            descriptorWrite[i].descriptorType = (i == 1)?
+                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER: VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrite[i].pBufferInfo = buffers[i];
+        }
+        else
+        {
+            descriptorWrite[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            descriptorWrite[i].pImageInfo = &pyramidInfo;
+        }
+    }
+
+    vkUpdateDescriptorSets(vulkanDevice->vkDevice,
+        descriptorWrite.size(), descriptorWrite.data(), 0, nullptr);
+}
+
+void VulkanCulling::Cull(VkCommandBuffer commandBuffer, VulkanCullingView& view,
+    const glm::mat4* viewMatrices, const glm::mat4* projections, uint32_t viewCount)
+{
+    ZoneScopedN("VulkanCulling::Cull");
+    ASSERT(viewCount <= GPU_CULL_MAX_VIEWS);
+
+    // Free and hidden slots are dispatched too, the shader skips them.
+    uint32_t instanceCount = static_cast<uint32_t>(instances.size());
+    if (instanceCount == 0)
+        return;
+
+    // The commands of a batch are a range of the command buffer,
+    // so there is one command slot per instance.
+    uint32_t batchCount = static_cast<uint32_t>(batches.size());
+    ReserveBuffer(vulkanDevice, view.commandBuffer, view.commandCapacity,
+        instanceCount, sizeof(VkDrawIndexedIndirectCommand),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+    if (ReserveBuffer(vulkanDevice, view.lodBuffer, view.lodCapacity, instanceCount,
+        sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT))
+        view.lodCount = 0;
+    ReserveBuffer(vulkanDevice, view.countBuffer, view.countCapacity, batchCount,
+        sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+    // Buffers may have been reallocated, EndCommand waited for the last frame.
+    WriteCullSet(view);
+
+    CullViewData& data = *view.viewMap;
+    for (uint32_t i = 0; i < viewCount; i++)
+        GpuCulling::ExtractPlanes(projections[i] * viewMatrices[i], &data.planes[i * 6]);
+
+    // Levels follow the first view, so that both eyes draw the same triangles.
+    bool occlusion = view.occlusion && view.pyramidValid;
+    data.lodView = viewMatrices[0];
+    data.lod = glm::vec4(std::abs(projections[0][1][1]), 0.0f, 0.0f, 0.0f);
+    data.occlusionView = view.pyramidViewMatrix;
+    data.occlusionProjection = view.pyramidProjection;
+    data.counts = glm::uvec4(instanceCount, viewCount, occlusion? 1: 0, view.pyramidLevels);
+    data.pyramid = glm::uvec4(view.pyramidSize, 0, 0);
+
+    vkCmdFillBuffer(commandBuffer, view.countBuffer.vkBuffer,
+        0, sizeof(uint32_t) * batchCount, 0);
+    if (view.lodCount < instanceCount)
+    { // New slots have no last level. A reused slot keeps the level of
+      // its previous instance, SelectLod moves it within the hysteresis.
+        vkCmdFillBuffer(commandBuffer, view.lodBuffer.vkBuffer,
+            sizeof(uint32_t) * view.lodCount,
+            sizeof(uint32_t) * (instanceCount - view.lodCount), 0xFFFFFFFF);
+        view.lodCount = instanceCount;
+    }
+
+    VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    VkDescriptorSet descriptorSets[2] = {view.cullSet, instanceSet};
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+        cullLayout->layout, 0, 2, descriptorSets, 0, nullptr);
+    vkCmdDispatch(commandBuffer,
+        (instanceCount + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE, 1, 1);
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void VulkanCulling::DrawIndirect(VkCommandBuffer commandBuffer,
+    VulkanCullingView& view, uint32_t batch)
+{
+    const Batch& b = batches[batch];
+    drawIndexedIndirectCount(commandBuffer,
+        view.commandBuffer.vkBuffer, sizeof(VkDrawIndexedIndirectCommand) * b.firstCommand,
+        view.countBuffer.vkBuffer, sizeof(uint32_t) * batch,
+        b.instanceCount, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void VulkanCulling::BuildPyramid(VkCommandBuffer commandBuffer, VulkanCullingView& view,
+    VkImage depthImage, VkExtent2D renderExtent,
+    const glm::mat4& viewMatrix, const glm::mat4& projection)
+{
+    ZoneScopedN("VulkanCulling::BuildPyramid");
+
+    if (!view.occlusion)
+        return;
+
+    // Also orders the reduction after the cull shader read the last pyramid.
+    VkImageMemoryBarrier depthBarrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    depthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depthBarrier.image = depthImage;
+    depthBarrier.subresourceRange.aspectMask =
+        VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    depthBarrier.subresourceRange.baseMipLevel = 0;
+    depthBarrier.subresourceRange.levelCount = 1;
+    depthBarrier.subresourceRange.baseArrayLayer = 0;
+    depthBarrier.subresourceRange.layerCount = 1;
+    depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    depthBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    depthBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &depthBarrier);
+
+    VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    // Dynamic resolution only renders to the top left part of the depth buffer,
+    // it is stretched over the whole pyramid.
+    for (uint32_t level = 0; level < view.pyramidLevels; level++)
+    {
+        ReducePushConst reduce{};
+        reduce.sourceSize = (level == 0)?
+            glm::uvec2(renderExtent.width, renderExtent.height):
+            glm::max(view.pyramidSize >> (level - 1), glm::uvec2(1));
+        reduce.targetSize = glm::max(view.pyramidSize >> level, glm::uvec2(1));
+        reduce.sampleCount = static_cast<uint32_t>(samples);
+
+        VkPipeline pipeline = (level == 0 && reduceMsaaPipeline != VK_NULL_HANDLE)?
+            reduceMsaaPipeline: reducePipeline;
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+            reduceLayout->layout, 0, 1, &view.reduceSets[level], 0, nullptr);
+        vkCmdPushConstants(commandBuffer, reduceLayout->layout,
+            VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ReducePushConst), &reduce);
+        vkCmdDispatch(commandBuffer,
+            (reduce.targetSize.x + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE,
+            (reduce.targetSize.y + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE,
+            1);
+
+        // The next level, or the cull shader of the next frame, reads it.
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    view.pyramidViewMatrix = viewMatrix;
+    view.pyramidProjection = projection;
+    view.pyramidValid = true;
+}
+
+} // namespace renderer
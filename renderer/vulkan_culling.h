@@ -0,0 +1,296 @@
+#pragma once
+
+#include "gpu_culling.h"
+#include "mesh.h"
+#include "vk_primitives/vulkan_device.h"
+#include "vk_primitives/vulkan_uniform.h"
+#include "vk_primitives/vulkan_pipeline_layout.h"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Views culled in one dispatch, same as CAMERA_MAX_VIEWS.
+// Mirrored in culling/cull.comp.
+#define GPU_CULL_MAX_VIEWS 2
+
+// Slot of a renderable that is not in the instance table.
+#define GPU_INSTANCE_NONE 0xFFFFFFFF
+
+namespace renderer
+{
+
+class VulkanMesh;
+
+/**
+ * Std430 layout of an instance, read by the cull shader
+ * and by the vertex shaders of the indirect draws.
+ */
+struct GpuInstance
+{
+    glm::mat4 model;
+    glm::vec4 sphere; // World space bounds, center and radius
+    uint32_t batch;   // Index in the batch buffer
+    uint32_t material; // Bindless material slot
+    uint32_t visible; // 0 for free slots and renderables not pushed this frame
+    uint32_t _1;
+};
+
+/**
+ * Std430 layout of a batch: all instances of one mesh,
+ * drawn by one indirect draw call.
+ */
+struct GpuBatch
+{
+    uint32_t firstCommand; // Commands of the batch start here
+    uint32_t lodCount;
+    uint32_t _0;
+    uint32_t _1;
+    glm::uvec2 lods[MESH_MAX_LOD]; // First index, index count
+};
+
+/**
+ * Std140 layout of the cull parameters of a camera.
+ */
+struct CullViewData
+{
+    glm::vec4 planes[GPU_CULL_MAX_VIEWS * 6];
+    glm::mat4 lodView;
+    glm::mat4 occlusionView;        // Last frame, when the pyramid was built
+    glm::mat4 occlusionProjection;
+    glm::vec4 lod;                  // x: |p11| of the LOD projection
+    glm::uvec4 counts;              // Instances, views, 1 to test occlusion, pyramid levels
+    glm::uvec4 pyramid;             // Size of level 0
+};
+
+class VulkanCulling;
+
+/**
+ * @brief Draw commands and depth pyramid of one camera.
+ *
+ * Commands are written by the cull shader and read by
+ * the indirect draws of the same frame. The pyramid is built from
+ * the depth buffer once the camera is rendered and tested against
+ * in the next frame. Multiview cameras do not have one,
+ * their views are only culled against their frustums.
+ */
+class VulkanCullingView
+{
+public:
+    void Initialize(VulkanDevice* vulkanDevice, VulkanCulling& culling,
+        VkImageView depthView, VkExtent2D extent, uint32_t viewCount);
+    void Destroy();
+
+    VulkanCullingView() = default;
+    ~VulkanCullingView() {Destroy();}
+
+    VulkanCullingView(const VulkanCullingView&) = delete;
+    VulkanCullingView& operator=(const VulkanCullingView&) = delete;
+
+    friend VulkanCulling;
+
+private:
+    VulkanDevice* vulkanDevice = nullptr; // Owned by VulkanRenderer
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+
+    VulkanUniform viewUniform;
+    CullViewData* viewMap = nullptr;
+
+    // Sized for the instances and batches of the scene, grown on demand.
+    VulkanUniform commandBuffer;
+    VulkanUniform countBuffer;
+    VulkanUniform lodBuffer;    // Level of each instance in the last frame
+    uint32_t commandCapacity = 0;
+    uint32_t countCapacity = 0;
+    uint32_t lodCapacity = 0;
+    uint32_t lodCount = 0;      // Instances the levels were written for
+
+    VkDescriptorSet cullSet = VK_NULL_HANDLE;
+
+    // Farthest depth per texel, kept in VK_IMAGE_LAYOUT_GENERAL.
+    VkImage pyramidImage = VK_NULL_HANDLE;
+    VkDeviceMemory pyramidMemory = VK_NULL_HANDLE;
+    VkImageView pyramidView = VK_NULL_HANDLE; // All levels, read by the cull shader
+    std::vector<VkImageView> levelViews;
+    std::vector<VkDescriptorSet> reduceSets; // Level i is reduced from level i - 1
+    VkSampler pyramidSampler = VK_NULL_HANDLE;
+    glm::uvec2 pyramidSize{1, 1};
+    uint32_t pyramidLevels = 1;
+    bool occlusion = false;     // Single view cameras only
+    bool pyramidValid = false;  // Built at least once since Initialize
+    glm::mat4 pyramidViewMatrix{1.0f};
+    glm::mat4 pyramidProjection{1.0f};
+};
+
+/**
+ * @brief GPU-driven culling and level of detail of opaque meshes.
+ *
+ * Opaque meshes have a persistent slot in a device local instance table.
+ * Only the slots changed since the last frame are uploaded, with one
+ * copy region per run of dirty slots, so static meshes cost nothing.
+ * A compute pass per camera then picks a level of detail, culls each
+ * instance against the view frustums and the depth pyramid
+ * of the last frame, and appends a draw command for the survivors.
+ * Meshes have their own vertex and index buffers, so the commands
+ * are grouped in one batch per mesh and each batch is drawn by one
+ * vkCmdDrawIndexedIndirectCountKHR with the count the shader wrote.
+ * Requires VulkanDevice::drawIndirectCountSupported.
+ */
+class VulkanCulling
+{
+public:
+    /**
+     * CPU side of a GpuBatch, without a mesh once its instances are removed.
+     */
+    struct Batch
+    {
+        VulkanMesh* mesh;
+        uint32_t instanceCount;
+        uint32_t firstCommand;
+    };
+
+    /**
+     * @param samples sample count of the camera depth buffers
+     */
+    void Initialize(VulkanDevice* vulkanDevice, VkDescriptorPool descriptorPool,
+        VkPipelineCache pipelineCache, VkSampleCountFlagBits samples);
+    void Destroy();
+
+    /**
+     * Push the layout of set 1 of the GPU-driven mesh pipelines.
+     * It is identical to the layout of GetInstanceSet.
+     */
+    static void PushDescriptorSetLayout(PipelineLayoutBuilder& layoutBuilder);
+
+    /**
+     * @brief Reserve a slot in the instance table.
+     * The mesh must stay alive until the slot is removed.
+     *
+     * @return slot of the instance, hidden until it is kept in a frame
+     */
+    uint32_t AddInstance(VulkanMesh* mesh);
+    void RemoveInstance(uint32_t slot);
+
+    /**
+     * Mark the slot dirty with a new transform and world space bounds.
+     */
+    void SetTransform(uint32_t slot, const glm::mat4& model, const glm::vec4& sphere);
+
+    /**
+     * Mark the slot dirty if the material changed.
+     */
+    void SetMaterial(uint32_t slot, uint32_t material);
+
+    /**
+     * Draw the slot in this frame. Slots that are not kept
+     * before Upload are hidden until they are kept again.
+     */
+    void KeepInstance(uint32_t slot);
+
+    /**
+     * @brief Record the copies of the dirty slots into the instance table.
+     * Must be recorded outside of a render pass, before Cull.
+     */
+    void Upload(VkCommandBuffer commandBuffer);
+
+    const std::vector<Batch>& GetBatches() {return batches;}
+    // Batches with instances, grouped by vertex format.
+    const std::vector<uint32_t>& GetDrawOrder() {return drawOrder;}
+    VkDescriptorSet* GetInstanceSet() {return &instanceSet;}
+
+    /**
+     * @brief Write the draw commands of a camera.
+     * Must be recorded outside of a render pass, before the draws.
+     *
+     * @param viewMatrices view matrix of each view of the camera
+     * @param projections projection of each view of the camera
+     */
+    void Cull(VkCommandBuffer commandBuffer, VulkanCullingView& view,
+        const glm::mat4* viewMatrices, const glm::mat4* projections, uint32_t viewCount);
+
+    /**
+     * Draw the instances of a batch kept by the last Cull of the view.
+     * The pipeline, descriptor sets and mesh buffers must be bound.
+     */
+    void DrawIndirect(VkCommandBuffer commandBuffer, VulkanCullingView& view,
+        uint32_t batch);
+
+    /**
+     * @brief Reduce the depth buffer of a camera into its depth pyramid.
+     * Must be recorded after the render pass of the camera.
+     * The depth image is left in DEPTH_STENCIL_READ_ONLY_OPTIMAL.
+     *
+     * @param renderExtent part of the depth buffer rendered to
+     */
+    void BuildPyramid(VkCommandBuffer commandBuffer, VulkanCullingView& view,
+        VkImage depthImage, VkExtent2D renderExtent,
+        const glm::mat4& viewMatrix, const glm::mat4& projection);
+
+    VulkanCulling() = default;
+    ~VulkanCulling() = default; // Destroyed by VulkanRenderer
+
+    VulkanCulling(const VulkanCulling&) = delete;
+    VulkanCulling& operator=(const VulkanCulling&) = delete;
+
+    friend VulkanCullingView;
+
+private:
+    VkPipeline CreatePipeline(const char* path, VkPipelineLayout layout,
+        VkPipelineCache pipelineCache);
+    void WriteCullSet(VulkanCullingView& view);
+    void MarkDirty(uint32_t slot);
+
+    /**
+     * Grow the device local instance table to hold all slots,
+     * every slot is uploaded again when it is reallocated.
+     */
+    void ReserveInstances();
+    void DestroyInstanceBuffer();
+
+    /**
+     * Write the batches and their draw order after instances
+     * were added or removed.
+     */
+    void WriteBatches();
+
+private:
+    VulkanDevice* vulkanDevice = nullptr; // Owned by VulkanRenderer
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+    std::unique_ptr<VulkanPipelineLayout> cullLayout;
+    std::unique_ptr<VulkanPipelineLayout> reduceLayout;
+    VkPipeline cullPipeline = VK_NULL_HANDLE;
+    VkPipeline reducePipeline = VK_NULL_HANDLE;
+    VkPipeline reduceMsaaPipeline = VK_NULL_HANDLE; // Level 0 with MSAA only
+
+    // Persistent instance table, instances is the CPU copy of all slots.
+    std::vector<GpuInstance> instances;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint64_t> dirtyBits;    // Slots to upload, 64 per word
+    std::vector<uint64_t> keptBits;     // Slots kept in this frame
+    std::vector<uint64_t> visibleBits;  // Slots kept in the last frame
+    VkBuffer instanceBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory instanceMemory = VK_NULL_HANDLE;
+    uint32_t instanceCapacity = 0;
+    VulkanUniform stagingBuffer;        // Dirty slots, one after the other
+    uint32_t stagingCapacity = 0;
+    VkDescriptorSet instanceSet = VK_NULL_HANDLE;
+
+    // A batch per mesh, kept while the mesh has instances.
+    VulkanUniform batchBuffer;
+    uint32_t batchCapacity = 0;
+    std::vector<Batch> batches;
+    std::vector<uint32_t> freeBatches;
+    std::vector<uint32_t> drawOrder;
+    std::unordered_map<VulkanMesh*, uint32_t> meshBatches;
+    bool batchesDirty = false;
+
+    PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = nullptr;
+};
+
+} // namespace renderer
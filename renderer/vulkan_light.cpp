@@ -2,6 +2,7 @@
 
 #include "vulkan_renderer.h"
 
+#include <cmath>
 #include <memory>
 #include <tracy/Tracy.hpp>
 
@@ -17,16 +18,11 @@ std::shared_ptr<VulkanLight> VulkanLight::BuildLight(LightProperties& prop)
 
     std::shared_ptr<VulkanLight> light = std::make_shared<VulkanLight>();
 
-    light->properties = prop;
+    light->SetLightProperties(prop);
 
-    // For now it only supports direction light
-    if (light->properties.type != DIRECTIONAL_LIGHT)
-        throw;
-
-    glm::vec3 direction = light->dirLight.direction;
-    light->dirLight.direction = 
+    glm::vec3 direction = light->lightData.direction;
+    light->lightData.direction = 
         glm::vec4(direction / glm::length(direction), 0);
-    light->dirLight.color = glm::vec4(prop.color, 0);
 
     return light;
 }
@@ -50,8 +46,11 @@ void VulkanLight::SetTransform(const glm::mat4& transform)
 
     glm::vec4 up{0, 1, 0, 0};
     glm::vec3 direction = transform * up; //FIXME: needs to check direction
-    this->dirLight.direction = 
+    this->lightData.direction = 
         glm::vec4(direction / glm::length(direction), 0);
+
+    float range = this->lightData.position.w;
+    this->lightData.position = glm::vec4(glm::vec3(transform[3]), range);
 }
 
 const LightProperties& VulkanLight::GetLightProperties()
@@ -66,6 +65,12 @@ void VulkanLight::SetLightProperties(LightProperties& prop)
     ZoneScopedN("VulkanLight::SetLightProperties");
 
     this->properties = prop;
+
+    lightData.type = prop.type;
+    lightData.color = glm::vec4(prop.color, 1.0f);
+    lightData.position.w = prop.range;
+    lightData.spotCos = glm::vec2(
+        std::cos(prop.innerConeAngle), std::cos(prop.outerConeAngle));
 }
 
 void VulkanLight::Destroy()
@@ -8,25 +8,22 @@
 #include <vulkan/vulkan.h>
 #include <memory>
 
+#define LIGHT_MAX_COUNT 1024 // Lights of all types rendered per frame
+
 namespace renderer
 {
 
-struct DirLight
+/**
+ * Std430 layout of a light in the light storage buffer of a camera.
+ */
+struct LightData
 {
+    glm::vec4 position{0, 0, 0, 0}; // w is the range
     glm::vec4 direction{-1, -1, -1, 0};
     glm::vec4 color;
-};
-struct PointLight
-{// TODO: not used yet
-    glm::vec3 position;
-    
-    float constant;
-    float linear;
-    float quadratic;  
-
-    glm::vec3 ambient;
-    glm::vec3 diffuse;
-    glm::vec3 specular;
+    glm::vec2 spotCos;              // cos of inner and outer cone angles
+    uint32_t type;                  // LightType
+    uint32_t _0;
 };
 
 class VulkanLight: public Light
@@ -56,7 +53,7 @@ public:
     void Destroy();
 
 public:
-    DirLight dirLight{}; //FIXME:
+    LightData lightData{};
 
 private:
     LightProperties properties{};
@@ -64,4 +61,4 @@ private:
     static std::shared_ptr<VulkanLight> defaultLight;
 };
 
-} // namespace renderer
\ No newline at end of file
+} // namespace renderer
@@ -1,11 +1,10 @@
 #include "vulkan_material.h"
 
 #include "vulkan_renderer.h"
-#include "vk_primitives/vulkan_pipeline_layout.h"
+#include "vulkan_texture.h"
 
 #include "serialization.h"
 
-#include <vector>
 #include <tracy/Tracy.hpp>
 
 
@@ -14,6 +13,18 @@ namespace renderer
 
 std::shared_ptr<VulkanMaterial> VulkanMaterial::defaultMaterial;
 
+/**
+ * Bindless slot of a texture, 0 without texture.
+ */
+static uint32_t GetTextureIndex(const std::shared_ptr<Texture>& texture)
+{
+    if (texture == nullptr)
+        return 0;
+
+    std::shared_ptr<VulkanTexture> vkt = std::dynamic_pointer_cast<VulkanTexture>(texture);
+    return vkt->GetBindlessIndex();
+}
+
 std::shared_ptr<Material> VulkanMaterial::BuildMaterial(MaterialProperties* prop)
 {
     ZoneScopedN("VulkanMaterial::BuildMaterial");
@@ -22,120 +33,17 @@ std::shared_ptr<Material> VulkanMaterial::BuildMaterial(MaterialProperties* prop
 
     std::shared_ptr<VulkanMaterial> material = std::make_shared<VulkanMaterial>();
 
-    material->vulkanDevice = &vkr.vulkanDevice;
-    material->uniform.Initialize(material->vulkanDevice, sizeof(MaterialUniform));
-    material->map = static_cast<MaterialUniform*>(material->uniform.Map());
+    material->index = vkr.GetBindless().AddMaterial(&material->map);
 
-    material->map->useAlbedoTex = (prop->albedoTexture != nullptr);
-    material->map->useMetallicTex = (prop->metallicTexture != nullptr);
-    material->map->useRoughnessTex = (prop->roughnessTexture != nullptr);
-    material->map->useNormalTex = (prop->normalTexture != nullptr);
-    material->map->albedo = glm::vec4(prop->albedo, 0);
+    material->map->albedoTexture = GetTextureIndex(prop->albedoTexture);
+    material->map->metallicTexture = GetTextureIndex(prop->metallicTexture);
+    material->map->roughnessTexture = GetTextureIndex(prop->roughnessTexture);
+    material->map->normalTexture = GetTextureIndex(prop->normalTexture);
+    material->map->albedo = glm::vec4(prop->albedo, prop->opacity);
     material->map->metallic = prop->metallic;
     material->map->roughness = prop->roughness;
 
     material->properties = *prop;
-    
-    VulkanPipelineLayout& layout = vkr.GetPipelineLayout("render");
-
-    layout.AllocateDescriptorSet(
-        "material",
-        vkr.FRAME_IN_FLIGHT,
-        &material->descriptorSet);
-
-    std::vector<VkWriteDescriptorSet> descWrites;
-
-    {
-        VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        descWrite.dstSet = material->descriptorSet;
-        descWrite.dstBinding = 0;
-        descWrite.dstArrayElement = 0;
-        descWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descWrite.descriptorCount = 1;
-        descWrite.pBufferInfo = material->uniform.GetDescriptor();
-        descWrites.push_back(descWrite);
-    }
-
-    {
-        VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        descWrite.dstSet = material->descriptorSet;
-        descWrite.dstBinding = 1;
-        descWrite.dstArrayElement = 0;
-        descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descWrite.descriptorCount = 1;
-
-        if (material->map->useAlbedoTex)
-        {
-            std::shared_ptr<VulkanTexture> vkt = std::dynamic_pointer_cast<VulkanTexture>(
-                material->properties.albedoTexture);
-            descWrite.pImageInfo = vkt->GetDescriptor();
-        } else {
-            descWrite.pImageInfo = VulkanTexture::GetDefaultTexture()->GetDescriptor();
-        }
-        descWrites.push_back(descWrite);
-    }
-
-    {
-        VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        descWrite.dstSet = material->descriptorSet;
-        descWrite.dstBinding = 2;
-        descWrite.dstArrayElement = 0;
-        descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descWrite.descriptorCount = 1;
-
-        if (material->map->useMetallicTex)
-        {
-            std::shared_ptr<VulkanTexture> vkt = std::dynamic_pointer_cast<VulkanTexture>(
-                material->properties.metallicTexture);
-            descWrite.pImageInfo = vkt->GetDescriptor();
-        } else {
-            descWrite.pImageInfo = VulkanTexture::GetDefaultTexture()->GetDescriptor();
-        }
-        descWrites.push_back(descWrite);
-    }
-
-    {
-        VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        descWrite.dstSet = material->descriptorSet;
-        descWrite.dstBinding = 3;
-        descWrite.dstArrayElement = 0;
-        descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descWrite.descriptorCount = 1;
-
-        if (material->map->useRoughnessTex)
-        {
-            std::shared_ptr<VulkanTexture> vkt = std::dynamic_pointer_cast<VulkanTexture>(
-                material->properties.roughnessTexture);
-            descWrite.pImageInfo = vkt->GetDescriptor();
-        } else {
-            descWrite.pImageInfo = VulkanTexture::GetDefaultTexture()->GetDescriptor();
-        }
-        descWrites.push_back(descWrite);
-    }
-
-    {
-        VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        descWrite.dstSet = material->descriptorSet;
-        descWrite.dstBinding = 4;
-        descWrite.dstArrayElement = 0;
-        descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descWrite.descriptorCount = 1;
-
-        if (material->map->useNormalTex)
-        {
-            std::shared_ptr<VulkanTexture> vkt = std::dynamic_pointer_cast<VulkanTexture>(
-                material->properties.normalTexture);
-            descWrite.pImageInfo = vkt->GetDescriptor();
-        } else {
-            descWrite.pImageInfo = VulkanTexture::GetDefaultTexture()->GetDescriptor();
-        }
-        descWrites.push_back(descWrite);
-    }
-
-    vkUpdateDescriptorSets(
-        material->vulkanDevice->vkDevice,
-        descWrites.size(), descWrites.data(),
-        0, nullptr);
 
     material->resourcePath = prop->resourcePath;
     return material;
@@ -182,7 +90,7 @@ void VulkanMaterial::ResetProperties()
 void VulkanMaterial::SetAlbedo(glm::vec3 albedo)
 {
     properties.albedo = albedo; // cpu
-    map->albedo = glm::vec4(albedo, 1.0f); // gpu
+    map->albedo = glm::vec4(albedo, properties.opacity); // gpu
 }
 
 void VulkanMaterial::SetMetallic(float metallic)
@@ -197,229 +105,84 @@ void VulkanMaterial::SetRoughness(float roughness)
     map->roughness = roughness; // gpu
 }
 
+void VulkanMaterial::SetOpacity(float opacity)
+{
+    properties.opacity = opacity; // cpu
+    map->albedo.w = opacity; // gpu
+}
+
 void VulkanMaterial::AddAlbedoTexture(std::shared_ptr<Texture> texture)
 {
     ZoneScopedN("VulkanMaterial::AddAlbedoTexture");
 
-    if(this->properties.albedoTexture != nullptr)
-    {
-        vkDeviceWaitIdle(vulkanDevice->vkDevice);
-    }
-
-    map->useAlbedoTex = 1.0f;
+    // Draws read the slot of the material, no descriptor is rewritten.
     properties.albedoTexture = texture;
-
-    std::shared_ptr<VulkanTexture> vkt =
-        std::dynamic_pointer_cast<VulkanTexture>(texture);
-
-    VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    descWrite.dstSet = this->descriptorSet;
-    descWrite.dstBinding = 1;
-    descWrite.dstArrayElement = 0;
-    descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descWrite.descriptorCount = 1;
-    descWrite.pImageInfo = vkt->GetDescriptor();
-
-    vkUpdateDescriptorSets(
-        this->vulkanDevice->vkDevice, 1, &descWrite, 0, nullptr);
+    map->albedoTexture = GetTextureIndex(texture);
 }
 
 void VulkanMaterial::AddMetallicTexture(std::shared_ptr<Texture> texture)
 {
     ZoneScopedN("VulkanMaterial::AddMetallicTexture");
 
-    if(this->properties.metallicTexture != nullptr)
-    {
-        vkDeviceWaitIdle(vulkanDevice->vkDevice);
-    }
-
-    map->useMetallicTex = 1.0f;
     properties.metallicTexture = texture;
-
-    std::shared_ptr<VulkanTexture> vkt =
-        std::dynamic_pointer_cast<VulkanTexture>(texture);
-
-    VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    descWrite.dstSet = this->descriptorSet;
-    descWrite.dstBinding = 2;
-    descWrite.dstArrayElement = 0;
-    descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descWrite.descriptorCount = 1;
-    descWrite.pImageInfo = vkt->GetDescriptor();
-
-    vkUpdateDescriptorSets(
-        this->vulkanDevice->vkDevice, 1, &descWrite, 0, nullptr);
+    map->metallicTexture = GetTextureIndex(texture);
 }
 
 void VulkanMaterial::AddRoughnessTexture(std::shared_ptr<Texture> texture)
 {
     ZoneScopedN("VulkanMaterial::AddRoughnessTexture");
 
-    if(this->properties.roughnessTexture != nullptr)
-    {
-        vkDeviceWaitIdle(vulkanDevice->vkDevice);
-    }
-
-    map->useRoughnessTex = 1.0f;
     properties.roughnessTexture = texture;
-
-    std::shared_ptr<VulkanTexture> vkt =
-        std::dynamic_pointer_cast<VulkanTexture>(texture);
-
-    VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    descWrite.dstSet = this->descriptorSet;
-    descWrite.dstBinding = 3;
-    descWrite.dstArrayElement = 0;
-    descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descWrite.descriptorCount = 1;
-    descWrite.pImageInfo = vkt->GetDescriptor();
-
-    vkUpdateDescriptorSets(
-        this->vulkanDevice->vkDevice, 1, &descWrite, 0, nullptr);
+    map->roughnessTexture = GetTextureIndex(texture);
 }
 
 void VulkanMaterial::AddNormalTexture(std::shared_ptr<Texture> texture)
 {
     ZoneScopedN("VulkanMaterial::AddNormalTexture");
 
-    if(this->properties.normalTexture != nullptr)
-    {
-        vkDeviceWaitIdle(vulkanDevice->vkDevice);
-    }
-
-    map->useNormalTex = 1.0f;
     properties.normalTexture = texture;
-
-    std::shared_ptr<VulkanTexture> vkt =
-        std::dynamic_pointer_cast<VulkanTexture>(texture);
-
-    VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    descWrite.dstSet = this->descriptorSet;
-    descWrite.dstBinding = 4;
-    descWrite.dstArrayElement = 0;
-    descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descWrite.descriptorCount = 1;
-    descWrite.pImageInfo = vkt->GetDescriptor();
-
-    vkUpdateDescriptorSets(
-        this->vulkanDevice->vkDevice, 1, &descWrite, 0, nullptr);
+    map->normalTexture = GetTextureIndex(texture);
 }
 
 void VulkanMaterial::ResetAlbedoTexture()
 {
     ZoneScopedN("VulkanMaterial::ResetAlbedoTexture");
 
-    if (this->properties.albedoTexture != nullptr)
-    {
-        vkDeviceWaitIdle(vulkanDevice->vkDevice);
-
-        VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        descWrite.dstSet = this->descriptorSet;
-        descWrite.dstBinding = 1;
-        descWrite.dstArrayElement = 0;
-        descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descWrite.descriptorCount = 1;
-        descWrite.pImageInfo = 
-            VulkanTexture::GetDefaultTexture()->GetDescriptor();
-
-        vkUpdateDescriptorSets(
-            this->vulkanDevice->vkDevice,
-            1, &descWrite, 0, nullptr);
-
-        this->properties.albedoTexture = nullptr;
-    }
-
     MaterialProperties originalProp{};
+    this->properties.albedoTexture = nullptr;
     this->properties.albedo = originalProp.albedo;
-    this->map->albedo = glm::vec4(this->properties.albedo, 0);
-    this->map->useAlbedoTex = 0.0f;
+    this->map->albedo = glm::vec4(this->properties.albedo, this->properties.opacity);
+    this->map->albedoTexture = 0;
 }
 
 void VulkanMaterial::ResetMetallicTexture()
 {
     ZoneScopedN("VulkanMaterial::ResetMetallicTexture");
 
-    if (this->properties.metallicTexture != nullptr)
-    {
-        vkDeviceWaitIdle(vulkanDevice->vkDevice);
-
-        VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        descWrite.dstSet = this->descriptorSet;
-        descWrite.dstBinding = 2;
-        descWrite.dstArrayElement = 0;
-        descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descWrite.descriptorCount = 1;
-        descWrite.pImageInfo = 
-            VulkanTexture::GetDefaultTexture()->GetDescriptor();
-
-        vkUpdateDescriptorSets(
-            this->vulkanDevice->vkDevice,
-            1, &descWrite, 0, nullptr);
-
-        this->properties.metallicTexture = nullptr;
-    }
-
     MaterialProperties originalProp{};
+    this->properties.metallicTexture = nullptr;
     this->properties.metallic = originalProp.metallic;
     this->map->metallic = this->properties.metallic;
-    this->map->useMetallicTex = 0.0f; 
+    this->map->metallicTexture = 0;
 }
 
 void VulkanMaterial::ResetRoughnessTexture()
 {
     ZoneScopedN("VulkanMaterial::ResetRoughnessTexture");
 
-    if (this->properties.roughnessTexture != nullptr)
-    {
-        vkDeviceWaitIdle(vulkanDevice->vkDevice);
-
-        VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        descWrite.dstSet = this->descriptorSet;
-        descWrite.dstBinding = 1;
-        descWrite.dstArrayElement = 0;
-        descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descWrite.descriptorCount = 1;
-        descWrite.pImageInfo = 
-            VulkanTexture::GetDefaultTexture()->GetDescriptor();
-
-        vkUpdateDescriptorSets(
-            this->vulkanDevice->vkDevice,
-            1, &descWrite, 0, nullptr);
-
-        this->properties.roughnessTexture = nullptr;
-    }
-
     MaterialProperties originalProp{};
+    this->properties.roughnessTexture = nullptr;
     this->properties.roughness = originalProp.roughness;
     this->map->roughness = this->properties.roughness;
-    this->map->useRoughnessTex = 0.0f;
+    this->map->roughnessTexture = 0;
 }
 
 void VulkanMaterial::ResetNormalTexture()
 {
     ZoneScopedN("VulkanMaterial::ResetNormalTexture");
 
-    if (this->properties.normalTexture != nullptr)
-    {
-        vkDeviceWaitIdle(vulkanDevice->vkDevice);
-
-        VkWriteDescriptorSet descWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        descWrite.dstSet = this->descriptorSet;
-        descWrite.dstBinding = 1;
-        descWrite.dstArrayElement = 0;
-        descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descWrite.descriptorCount = 1;
-        descWrite.pImageInfo = 
-            VulkanTexture::GetDefaultTexture()->GetDescriptor();
-
-        vkUpdateDescriptorSets(
-            this->vulkanDevice->vkDevice,
-            1, &descWrite, 0, nullptr);
-
-        this->properties.normalTexture = nullptr;
-    }
-
-    this->map->useAlbedoTex = 0.0f;
+    this->properties.normalTexture = nullptr;
+    this->map->normalTexture = 0;
 }
 
 void VulkanMaterial::Serialize(Json::Value& json)
@@ -429,6 +192,7 @@ void VulkanMaterial::Serialize(Json::Value& json)
     SerializeVec3(properties.albedo, json["albedo"]);
     json["metallic"] = properties.metallic;
     json["roughness"] = properties.roughness;
+    json["opacity"] = properties.opacity;
     
     json["albedoTexture"] = 
         properties.albedoTexture?
@@ -455,8 +219,8 @@ void VulkanMaterial::Destory()
 {
     ZoneScopedN("VulkanMaterial::Destory");
 
-    vkDeviceWaitIdle(vulkanDevice->vkDevice);
-    uniform.Destroy();
+    VulkanRenderer::GetInstance().GetBindless().RemoveMaterial(index);
+    this->index = 0;
     this->map = nullptr;
 }
 
@@ -2,27 +2,11 @@
 
 #include "material.h"
 
-#include "vk_primitives/vulkan_device.h"
-#include "vk_primitives/vulkan_uniform.h"
+#include "vulkan_bindless.h"
 
 namespace renderer
 {
 
-struct MaterialUniform
-{
-    glm::vec4 albedo = {1, 1, 1, 0};
-
-    float metallic = 0.1f;
-    float roughness = 0.9f;
-    float _1;
-    float _2;
-
-    float useAlbedoTex = 0.0f;
-    float useMetallicTex = 0.0f;
-    float useRoughnessTex = 0.0f;
-    float useNormalTex = 0.0f;
-};
-
 class VulkanMaterial: public Material
 {
 
@@ -39,6 +23,7 @@ public:
     void SetAlbedo(glm::vec3 albedo) override;
     void SetMetallic(float metallic) override;
     void SetRoughness(float roughness) override;
+    void SetOpacity(float opacity) override;
 
     void AddAlbedoTexture(std::shared_ptr<Texture> texture) override;
     void AddMetallicTexture(std::shared_ptr<Texture> texture) override;
@@ -52,18 +37,16 @@ public:
 
     void Serialize(Json::Value& json) override;
 
-    VkDescriptorSet* GetDescriptorSet() {return &descriptorSet;}
+    uint32_t GetBindlessIndex() {return index;} // Pushed with the draws
+    bool IsTransparent() {return properties.opacity < 1.0f;}
 
 private:
     void Destory();
 
 private:
-    VulkanDevice* vulkanDevice = nullptr;
-    
     MaterialProperties properties;
-    VulkanUniform uniform{};
-    MaterialUniform* map = nullptr;
-    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    uint32_t index = 0;          // Slot in VulkanBindless
+    MaterialData* map = nullptr; // Mapped slot
 
     std::string resourcePath;
 
@@ -2,6 +2,7 @@
 
 #include "vulkan_renderer.h"
 #include "vulkan_material.h"
+#include "vertex_compression.h"
 
 #include "vk_primitives/vulkan_device.h"
 #include "vk_primitives/vulkan_pipeline_layout.h"
@@ -16,25 +17,92 @@ std::shared_ptr<Mesh> VulkanMesh::BuildMesh(BuildMeshInfo& info)
 {
     ZoneScopedN("VulkanMesh::BuildMesh");
 
+    MeshDataView data{};
+    data.vertices = info.vertices.data();
+    data.vertexCount = info.vertices.size();
+    data.indices = info.indices.data();
+    data.indexCount = info.indices.size();
+    data.lods = info.lods.data();
+    data.lodCount = static_cast<uint32_t>(info.lods.size());
+
+    return BuildMesh(info.resourcePath, data, info.vertexFormat);
+}
+
+std::shared_ptr<Mesh> VulkanMesh::BuildMesh(
+    const std::string& resourcePath, const MeshDataView& data,
+    VertexFormat vertexFormat)
+{
+    ZoneScopedN("VulkanMesh::BuildMesh#View");
+
     std::shared_ptr<VulkanMesh> mesh = std::make_shared<VulkanMesh>();
     VulkanRenderer& vkr = VulkanRenderer::GetInstance();
     VulkanDevice* vulkanDevice = &vkr.vulkanDevice;
 
-    mesh->vertexbuffer.Initialize(vulkanDevice,
-        sizeof(unsigned int) * info.indices.size(),
-        sizeof(Vertex) * info.vertices.size());
+    bool compactIndices = CanUseCompactIndices(data.vertexCount);
+    VkIndexType indexType = compactIndices?
+        VK_INDEX_TYPE_UINT16: VK_INDEX_TYPE_UINT32;
+    VkDeviceSize indexBytes = data.indexCount * (compactIndices?
+        sizeof(CompactVertexIndex): sizeof(VertexIndex));
+    VkDeviceSize vertexBytes = data.vertexCount *
+        ((vertexFormat == VertexFormat::Compact)?
+        sizeof(CompactVertex): sizeof(Vertex));
+
+    mesh->vertexbuffer.Initialize(
+        vulkanDevice, indexBytes, vertexBytes, indexType);
 
     void* indexData = mesh->vertexbuffer.MapIndex();
     void* vertexData = mesh->vertexbuffer.MapVertex();
 
-    memcpy(indexData, info.indices.data(),
-        sizeof(VertexIndex) * info.indices.size());
-    memcpy(vertexData, info.vertices.data(),
-        sizeof(Vertex) * info.vertices.size());
-
+    if (compactIndices)
+    {
+        CompressIndices(data.indices, data.indexCount,
+            static_cast<CompactVertexIndex*>(indexData));
+    }
+    else
+    {
+        memcpy(indexData, data.indices, indexBytes);
+    }
+
+    if (vertexFormat == VertexFormat::Compact)
+    {
+        mesh->quantization = ComputeQuantization(
+            data.vertices, data.vertexCount);
+        CompressVertices(data.vertices, data.vertexCount,
+            mesh->quantization, static_cast<CompactVertex*>(vertexData));
+    }
+    else
+    {
+        memcpy(vertexData, data.vertices, vertexBytes);
+    }
+
+    if (data.lodCount > 0)
+    {
+        mesh->lods.assign(data.lods, data.lods + data.lodCount);
+    }
+    else
+    {
+        mesh->lods.push_back({0, static_cast<uint32_t>(data.indexCount), 0.0f});
+    }
+
+    if (data.vertexCount > 0)
+    {
+        glm::vec3 minBound = data.vertices[0].Position;
+        glm::vec3 maxBound = minBound;
+        for (uint64_t i = 1; i < data.vertexCount; i++)
+        {
+            minBound = glm::min(minBound, data.vertices[i].Position);
+            maxBound = glm::max(maxBound, data.vertices[i].Position);
+        }
+
+        glm::vec3 center = (minBound + maxBound) * 0.5f;
+        mesh->boundingSphere = glm::vec4(center,
+            glm::length(maxBound - center));
+    }
+
+    mesh->vertexFormat = vertexFormat;
     mesh->material = VulkanMaterial::GetDefaultMaterial();
 
-    mesh->resourcePath = info.resourcePath;
+    mesh->resourcePath = resourcePath;
     return mesh;
 }
 
@@ -59,6 +127,7 @@ void VulkanMesh::Serialize(Json::Value& json)
     json["resourcePath"] = resourcePath;
     json["material"] = material?
         material->GetProperties()->resourcePath: "none";
+    json["vertexFormat"] = (int)vertexFormat;
 }
 
 std::string VulkanMesh::GetResourcePath()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "mesh.h"
+#include "pipeline_inputs.h"
 
 #include "vulkan_material.h"
 #include "vk_primitives/vulkan_vertexbuffer.h"
@@ -23,6 +24,17 @@ class VulkanMesh: public Mesh
 public:
     static std::shared_ptr<Mesh> BuildMesh(BuildMeshInfo& info);
 
+    /**
+     * Build a mesh from data that is not owned by the caller.
+     * Vertices and indices are copied straight into the mapped
+     * vertex buffer without an intermediate copy.
+     * With the compact format, vertices are compressed
+     * while they are written into the vertex buffer.
+    */
+    static std::shared_ptr<Mesh> BuildMesh(
+        const std::string& resourcePath, const MeshDataView& data,
+        VertexFormat vertexFormat = VertexFormat::Standard);
+
     void AddMaterial(std::shared_ptr<Material> material) override;
 
     void RemoveMaterial() override;
@@ -36,8 +48,25 @@ public:
     VulkanVertexbuffer& GetVertexbuffer();
     std::shared_ptr<VulkanMaterial> GetVulkanMaterial();
 
+    VertexFormat GetVertexFormat() {return vertexFormat;}
+    const VertexQuantization& GetQuantization() {return quantization;}
+
+    uint32_t GetLodCount() {return static_cast<uint32_t>(lods.size());}
+    const MeshLod& GetLod(uint32_t level) {return lods[level];}
+
+    /**
+     * Bounding sphere in model space used for LOD selection.
+     * xyz is the center and w is the radius.
+    */
+    const glm::vec4& GetBoundingSphere() {return boundingSphere;}
+
 private:
     VulkanVertexbuffer vertexbuffer{};
+    VertexFormat vertexFormat = VertexFormat::Standard;
+    VertexQuantization quantization{};
+
+    std::vector<MeshLod> lods;
+    glm::vec4 boundingSphere{0.0f};
 
     std::shared_ptr<Material> material;
     
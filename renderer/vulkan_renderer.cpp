@@ -12,6 +12,7 @@
 
 #include "validation.h"
 #include "logger.h"
+#include "configuration.h"
 
 #include "component.h"
 #include "light_component.h"
@@ -27,6 +28,10 @@
 #include <vector>
 #include <array>
 #include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <stddef.h> // offset(type, member)
 
 #include <tracy/Tracy.hpp>
@@ -86,10 +91,18 @@ void VulkanRenderer::InitializeDevice(
 
 #ifdef VULKAN_APPLE_SUPPORT
         vkCreateInfo.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
-        extensionList.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
         extensionList.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
 #endif
 
+        // Dependency of VK_EXT_descriptor_indexing on Vulkan 1.0,
+        // OpenXR runtimes may already ask for it.
+        if (std::none_of(extensionList.begin(), extensionList.end(),
+            [](const char* name) {
+                return std::strcmp(name,
+                    VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0;
+            }))
+            extensionList.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
 #ifdef VULKAN_DEBUG_REPORT
         // Enabling validation layers
         const char* layers[] = { "VK_LAYER_KHRONOS_validation" };
@@ -171,8 +184,86 @@ void VulkanRenderer::AllocateResources(
         &vkDescriptorPoolInfo, nullptr, &vkDescriptorPool));
 
     vulkanCmdBuffer.Initialize(&vulkanDevice, FRAME_IN_FLIGHT);
+
+    {
+        std::string value;
+        multiviewEnabled = vulkanDevice.multiviewSupported &&
+            !(Configuration::Get(CONFIG_VR_MULTIVIEW, value) && value == "false");
+        Logger::Write(
+            std::string("[Vulkan Renderer] Single pass stereo with multiview ") +
+            (multiviewEnabled? "enabled.": "disabled."),
+            Logger::Level::Info,
+            Logger::MsgType::Renderer
+        );
+    }
+
+    {
+        std::string value;
+        int samples = 4;
+        if (Configuration::Get(CONFIG_MSAA_SAMPLES, value))
+            samples = std::atoi(value.c_str());
+
+        // Highest supported count not above the requested one.
+        const VkPhysicalDeviceLimits& limits = vulkanDevice.GetProperties().limits;
+        VkSampleCountFlags supported =
+            limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts;
+        msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+        for (int count = 8; count > 1; count /= 2)
+        {
+            if (count <= samples && (supported & count))
+            {
+                msaaSamples = static_cast<VkSampleCountFlagBits>(count);
+                break;
+            }
+        }
+
+        dynamicResolutionEnabled =
+            !(Configuration::Get(CONFIG_VR_DYNAMIC_RESOLUTION, value) && value == "false");
+        lateLatchEnabled =
+            !(Configuration::Get(CONFIG_VR_LATE_LATCH, value) && value == "false");
+
+        Logger::Write(
+            "[Vulkan Renderer] Camera MSAA samples: " +
+                std::to_string(static_cast<int>(msaaSamples)),
+            Logger::Level::Info,
+            Logger::MsgType::Renderer
+        );
+    }
     
+    {
+        const VkPhysicalDeviceLimits& limits = vulkanDevice.GetProperties().limits;
+        if (limits.timestampComputeAndGraphics)
+        {
+            VkQueryPoolCreateInfo queryPoolInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+            queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryPoolInfo.queryCount = 2;
+            CHECK_VKCMD(vkCreateQueryPool(vulkanDevice.vkDevice,
+                &queryPoolInfo, nullptr, &timestampPool));
+            timestampPeriod = limits.timestampPeriod;
+        }
+    }
+
+    {
+        std::string value;
+        gpuCullingEnabled = vulkanDevice.drawIndirectCountSupported &&
+            Configuration::Get(CONFIG_GPU_CULLING, value) && value == "true";
+        Logger::Write(
+            std::string("[Vulkan Renderer] GPU culling with indirect draws ") +
+            (gpuCullingEnabled? "enabled.": "disabled."),
+            Logger::Level::Info,
+            Logger::MsgType::Renderer
+        );
+    }
+
+    bindless.Initialize(&vulkanDevice);
+
     CreateRenderPasses();
+    pipelineCache.Initialize(&vulkanDevice);
+    if (gpuCullingEnabled)
+    {
+        culling.Initialize(&vulkanDevice, vkDescriptorPool,
+            pipelineCache.GetPipelineCache(), msaaSamples);
+    }
     CreatePipelines();
     CreateFramebuffers();
     defaultTechnique.Initialize(&vulkanDevice);
@@ -292,6 +383,20 @@ void VulkanRenderer::CreateRenderPasses()
     VkAttachmentReference displayAttachment{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
     VkAttachmentReference colorAttachment{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
     VkAttachmentReference depthAttachment{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+    VkAttachmentReference resolveAttachment{2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+    // With MSAA, cameras render to transient multisampled attachments
+    // that are resolved into the sampled color image at the end of the pass.
+    VkAttachmentDescription msaaColorAttachmentDesc = colorAttachmentDesc;
+    msaaColorAttachmentDesc.samples = msaaSamples;
+    msaaColorAttachmentDesc.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    msaaColorAttachmentDesc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentDescription cameraDepthAttachmentDesc = depthAttachmentDesc;
+    cameraDepthAttachmentDesc.samples = msaaSamples;
+
+    VkAttachmentDescription resolveAttachmentDesc = colorAttachmentDesc;
+    resolveAttachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 
     // Display render pass.
     {
@@ -331,6 +436,13 @@ void VulkanRenderer::CreateRenderPasses()
         subpass.pColorAttachments = &colorAttachment;
         subpass.pDepthStencilAttachment = &depthAttachment;
 
+        if (msaaSamples != VK_SAMPLE_COUNT_1_BIT)
+        {
+            attachmentDesc = {msaaColorAttachmentDesc,
+                cameraDepthAttachmentDesc, resolveAttachmentDesc};
+            subpass.pResolveAttachments = &resolveAttachment;
+        }
+
         // Dependency for vkQueuePresentKHR with attachment output semaphore.
         VkSubpassDependency dependency = {};
         dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
@@ -341,7 +453,7 @@ void VulkanRenderer::CreateRenderPasses()
         dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
         VkRenderPassCreateInfo vkRenderPassCreateInfo{VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
-        vkRenderPassCreateInfo.attachmentCount = 2;
+        vkRenderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachmentDesc.size());
         vkRenderPassCreateInfo.pAttachments = attachmentDesc.data();
         vkRenderPassCreateInfo.subpassCount = 1;
         vkRenderPassCreateInfo.pSubpasses = &subpass;
@@ -350,6 +462,23 @@ void VulkanRenderer::CreateRenderPasses()
 
         CHECK_VKCMD(vkCreateRenderPass(vulkanDevice.vkDevice,
             &vkRenderPassCreateInfo, nullptr, &vkRenderPass.defaultCamera));
+
+        if (multiviewEnabled)
+        { // Same attachments with two layers, each view renders to its own layer.
+            const uint32_t viewMask = 0b11;
+            const uint32_t correlationMask = 0b11; // Eyes see mostly the same scene
+
+            VkRenderPassMultiviewCreateInfoKHR multiviewInfo
+                {VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO_KHR};
+            multiviewInfo.subpassCount = 1;
+            multiviewInfo.pViewMasks = &viewMask;
+            multiviewInfo.correlationMaskCount = 1;
+            multiviewInfo.pCorrelationMasks = &correlationMask;
+            vkRenderPassCreateInfo.pNext = &multiviewInfo;
+
+            CHECK_VKCMD(vkCreateRenderPass(vulkanDevice.vkDevice,
+                &vkRenderPassCreateInfo, nullptr, &vkRenderPass.multiviewCamera));
+        }
     }
 
 
@@ -383,6 +512,53 @@ void VulkanRenderer::CreateRenderPasses()
             &vkRenderPassCreateInfo, nullptr, &vkRenderPass.imgui));
     }
 
+    // Shadow render pass, one layer of the shadow map of a camera.
+    {
+        VkAttachmentDescription shadowAttachmentDesc{};
+        shadowAttachmentDesc.format = SHADOW_MAP_FORMAT;
+        shadowAttachmentDesc.samples = VK_SAMPLE_COUNT_1_BIT;
+        shadowAttachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        shadowAttachmentDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        shadowAttachmentDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        shadowAttachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        shadowAttachmentDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        shadowAttachmentDesc.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+        VkAttachmentReference shadowAttachment{0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 0;
+        subpass.pDepthStencilAttachment = &shadowAttachment;
+
+        // The camera passes sample the shadow map before and after it is drawn.
+        std::array<VkSubpassDependency, 2> dependencies{};
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].srcAccessMask = 0;
+        dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        VkRenderPassCreateInfo vkRenderPassCreateInfo{VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
+        vkRenderPassCreateInfo.attachmentCount = 1;
+        vkRenderPassCreateInfo.pAttachments = &shadowAttachmentDesc;
+        vkRenderPassCreateInfo.subpassCount = 1;
+        vkRenderPassCreateInfo.pSubpasses = &subpass;
+        vkRenderPassCreateInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        vkRenderPassCreateInfo.pDependencies = dependencies.data();
+
+        CHECK_VKCMD(vkCreateRenderPass(vulkanDevice.vkDevice,
+            &vkRenderPassCreateInfo, nullptr, &vkRenderPass.shadow));
+    }
+
 }
 
 void VulkanRenderer::DestroyRenderPasses()
@@ -390,8 +566,14 @@ void VulkanRenderer::DestroyRenderPasses()
     ZoneScopedN("VulkanRenderer::DestroyRenderPasses");
 
     vkDestroyRenderPass(vulkanDevice.vkDevice, vkRenderPass.defaultCamera, nullptr);
+    if (vkRenderPass.multiviewCamera != VK_NULL_HANDLE)
+    {
+        vkDestroyRenderPass(vulkanDevice.vkDevice, vkRenderPass.multiviewCamera, nullptr);
+        vkRenderPass.multiviewCamera = VK_NULL_HANDLE;
+    }
     vkDestroyRenderPass(vulkanDevice.vkDevice, vkRenderPass.display, nullptr);
     vkDestroyRenderPass(vulkanDevice.vkDevice, vkRenderPass.imgui, nullptr);
+    vkDestroyRenderPass(vulkanDevice.vkDevice, vkRenderPass.shadow, nullptr);
 }
 
 void VulkanRenderer::CreateFramebuffers()
@@ -436,41 +618,34 @@ void VulkanRenderer::CreatePipelines()
 {
     ZoneScopedN("VulkanRenderer::CreatePipelines");
 
-    {    
-        std::unique_ptr<VulkanPipeline> renderPipeline = 
-            std::make_unique<VulkanPipeline>(vulkanDevice.vkDevice);
-        PipelineLayoutBuilder layoutBuilder(&vulkanDevice);
-        std::unique_ptr<VulkanPipelineLayout> pipelineLayout;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
+    // Mesh pipelines share their descriptor set layouts so that
+    // sets allocated from "render" can be bound to all of them.
+    // GPU-driven pipelines read the transforms of all instances instead.
+    auto pushMeshSetLayouts = [](PipelineLayoutBuilder& layoutBuilder, bool gpuDriven)
+    {
+        // All materials and textures, see VulkanBindless.
+        VulkanBindless::PushDescriptorSetLayout(layoutBuilder);
 
-        renderPipeline->LoadShader("resources/vulkan_shaders/Phong/vert.spv",
-                                "resources/vulkan_shaders/Phong/frag.spv");
-
-        layoutBuilder.PushDescriptorSetLayout("material",
-        {
-            layoutBuilder.descriptorSetLayoutBinding(
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 0),
-            layoutBuilder.descriptorSetLayoutBinding(
-                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1),
-            layoutBuilder.descriptorSetLayoutBinding(
-                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 2),
-            layoutBuilder.descriptorSetLayoutBinding(
-                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 3),
-            layoutBuilder.descriptorSetLayoutBinding(
-                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 4),
-        });
-
-        layoutBuilder.PushDescriptorSetLayout("mesh",
+        if (gpuDriven)
+        { // Instances of the indirect draws, see VulkanCulling.
+            VulkanCulling::PushDescriptorSetLayout(layoutBuilder);
+        }
+        else
         {
-            /*
-            layout (set = 1, binding = 0) uniform MeshCoordinates
+            layoutBuilder.PushDescriptorSetLayout("mesh",
             {
-                mat4 model;
-            } m;
-            */
-            layoutBuilder.descriptorSetLayoutBinding(
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0)
-        });
+                /*
+                layout (set = 1, binding = 0) uniform MeshCoordinates
+                {
+                    mat4 model;
+                } m;
+                */
+                layoutBuilder.descriptorSetLayoutBinding(
+                    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0)
+            });
+        }
 
         layoutBuilder.PushDescriptorSetLayout("camera",
         {
@@ -479,7 +654,7 @@ void VulkanRenderer::CreatePipelines()
             {
                 mat4 view;
                 mat4 projection;
-            } vp;
+            } vp[viewCount];
             */
             layoutBuilder.descriptorSetLayoutBinding(
                 VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0)
@@ -487,20 +662,172 @@ void VulkanRenderer::CreatePipelines()
 
         layoutBuilder.PushDescriptorSetLayout("scene",
         {
+            /*
+            layout (set = 3, binding = 0, std430) readonly buffer SceneLights
+            {
+                lights, clusters and shadow cascades of a camera
+            } scene;
+            layout (set = 3, binding = 1) uniform sampler2DArrayShadow ShadowMap;
+            */
             layoutBuilder.descriptorSetLayoutBinding(
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 0)
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 0),
+            layoutBuilder.descriptorSetLayoutBinding(
+                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
         });
+    };
 
-        pipelineLayout = layoutBuilder.BuildPipelineLayout(vkDescriptorPool);
-        renderPipeline->rasterState.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    struct MeshPipelineInfo
+    {
+        const char* name;
+        const char* vertPath;
+        const char* fragPath;
+        const char* gpuVertPath; // Built with GPU_DRIVEN
+        const char* gpuFragPath;
+        VkPipelineVertexInputStateCreateInfo* vertexInput;
+        uint32_t pushConstantSize; // Compact vertices take their quantization
+        VkRenderPass renderPass;
+    };
 
-        renderPipeline->BuildPipeline(
+    std::vector<MeshPipelineInfo> meshPipelineInfos =
+    {
+        {"render", "resources/vulkan_shaders/Phong/vert.spv",
+            "resources/vulkan_shaders/Phong/frag.spv",
+            "resources/vulkan_shaders/Phong/gpu_vert.spv",
+            "resources/vulkan_shaders/Phong/gpu_frag.spv",
             VulkanVertexbuffer::GetVertexInputState(),
-            std::move(pipelineLayout),
-            vkRenderPass.defaultCamera
-        );
+            0, vkRenderPass.defaultCamera},
+        {"renderCompact", "resources/vulkan_shaders/Phong/compact_vert.spv",
+            "resources/vulkan_shaders/Phong/frag.spv",
+            "resources/vulkan_shaders/Phong/gpu_compact_vert.spv",
+            "resources/vulkan_shaders/Phong/gpu_frag.spv",
+            VulkanVertexbuffer::GetCompactVertexInputState(),
+            sizeof(VertexQuantization), vkRenderPass.defaultCamera}
+    };
 
-        pipelines["render"] = std::move(renderPipeline);
+    if (multiviewEnabled)
+    { // Both eyes in one pass, the shaders select the view with gl_ViewIndex.
+        meshPipelineInfos.push_back(
+            {"renderMultiview", "resources/vulkan_shaders/Phong/multiview_vert.spv",
+            "resources/vulkan_shaders/Phong/multiview_frag.spv",
+            "resources/vulkan_shaders/Phong/gpu_multiview_vert.spv",
+            "resources/vulkan_shaders/Phong/gpu_multiview_frag.spv",
+            VulkanVertexbuffer::GetVertexInputState(),
+            0, vkRenderPass.multiviewCamera});
+        meshPipelineInfos.push_back(
+            {"renderCompactMultiview", "resources/vulkan_shaders/Phong/compact_multiview_vert.spv",
+            "resources/vulkan_shaders/Phong/multiview_frag.spv",
+            "resources/vulkan_shaders/Phong/gpu_compact_multiview_vert.spv",
+            "resources/vulkan_shaders/Phong/gpu_multiview_frag.spv",
+            VulkanVertexbuffer::GetCompactVertexInputState(),
+            sizeof(VertexQuantization), vkRenderPass.multiviewCamera});
+    }
+
+    // Every mesh pipeline has variants with the same vertex input and layout.
+    // "Depth" only writes depth for the pre-pass, "Equal" shades the
+    // fragments the pre-pass kept, "Transparent" blends without writing depth.
+    // Single view pipelines also have "Shadow" to draw shadow map cascades.
+    // With GPU culling, the opaque passes also have a "Gpu" variant drawing
+    // the instances of VulkanCulling with indirect draws.
+    enum class MeshPass {Default, Depth, Equal, Transparent, Shadow};
+    struct MeshVariant
+    {
+        MeshPass pass;
+        const char* suffix;
+        bool gpuDriven;
+    };
+    std::vector<MeshVariant> meshVariants =
+    {
+        {MeshPass::Default, "", false},
+        {MeshPass::Depth, "Depth", false},
+        {MeshPass::Equal, "Equal", false},
+        {MeshPass::Transparent, "Transparent", false},
+        {MeshPass::Shadow, "Shadow", false}
+    };
+    if (gpuCullingEnabled)
+    {
+        meshVariants.push_back({MeshPass::Default, "Gpu", true});
+        meshVariants.push_back({MeshPass::Depth, "DepthGpu", true});
+        meshVariants.push_back({MeshPass::Equal, "EqualGpu", true});
+    }
+
+    for (const MeshPipelineInfo& info: meshPipelineInfos)
+    {
+        for (const MeshVariant& variant: meshVariants)
+        {
+            if (variant.pass == MeshPass::Shadow &&
+                info.renderPass != vkRenderPass.defaultCamera)
+                continue;
+
+            std::unique_ptr<VulkanPipeline> meshPipeline = 
+                std::make_unique<VulkanPipeline>(vulkanDevice.vkDevice);
+            PipelineLayoutBuilder layoutBuilder(&vulkanDevice);
+            std::unique_ptr<VulkanPipelineLayout> pipelineLayout;
+
+            meshPipeline->LoadShader(
+                variant.gpuDriven? info.gpuVertPath: info.vertPath,
+                (variant.pass == MeshPass::Depth || variant.pass == MeshPass::Shadow)?
+                    "resources/vulkan_shaders/Phong/depth_frag.spv":
+                    (variant.gpuDriven? info.gpuFragPath: info.fragPath));
+
+            pushMeshSetLayouts(layoutBuilder, variant.gpuDriven);
+
+            // The material index of a draw follows the vertex constants
+            // at the same offset in all mesh pipelines.
+            std::vector<VkPushConstantRange> ranges(1);
+            ranges[0].offset = MATERIAL_PUSH_OFFSET;
+            ranges[0].size = sizeof(MaterialPushConst);
+            ranges[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+            if (info.pushConstantSize > 0)
+            {
+                VkPushConstantRange range = {};
+                range.offset = 0;
+                range.size = info.pushConstantSize;
+                range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+                ranges.push_back(range);
+            }
+            pipelineLayout = layoutBuilder.BuildPipelineLayout(
+                vkDescriptorPool, ranges.data(), static_cast<uint32_t>(ranges.size()));
+            meshPipeline->rasterState.frontFace = VK_FRONT_FACE_CLOCKWISE;
+            meshPipeline->multisampleState.rasterizationSamples = msaaSamples;
+
+            switch (variant.pass)
+            {
+            case MeshPass::Depth:
+                meshPipeline->blendAttachment.colorWriteMask = 0;
+                break;
+            case MeshPass::Equal:
+                meshPipeline->depthStencilState.depthCompareOp = VK_COMPARE_OP_EQUAL;
+                meshPipeline->depthStencilState.depthWriteEnable = VK_FALSE;
+                break;
+            case MeshPass::Shadow:
+                // Both faces cast, slope scaled bias against shadow acne.
+                meshPipeline->rasterState.cullMode = VK_CULL_MODE_NONE;
+                meshPipeline->rasterState.depthBiasEnable = VK_TRUE;
+                meshPipeline->rasterState.depthBiasConstantFactor = 1.25f;
+                meshPipeline->rasterState.depthBiasSlopeFactor = 1.75f;
+                meshPipeline->multisampleState.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+                meshPipeline->colorBlend.attachmentCount = 0;
+                break;
+            case MeshPass::Transparent:
+                meshPipeline->blendAttachment.blendEnable = VK_TRUE;
+                meshPipeline->blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+                meshPipeline->blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                meshPipeline->blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+                meshPipeline->blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                meshPipeline->depthStencilState.depthWriteEnable = VK_FALSE;
+                break;
+            default:
+                break;
+            }
+
+            meshPipeline->PreparePipeline(
+                info.vertexInput,
+                std::move(pipelineLayout),
+                (variant.pass == MeshPass::Shadow)? vkRenderPass.shadow: info.renderPass
+            );
+
+            pipelines[std::string(info.name) + variant.suffix] = std::move(meshPipeline);
+        }
     }
 
     {
@@ -520,7 +847,7 @@ void VulkanRenderer::CreatePipelines()
 
         VkPushConstantRange range = {};
         range.offset = 0;
-        range.size = sizeof(int);
+        range.size = sizeof(TransferPushConst);
         range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
         displayLayout = layoutBuilder.BuildPipelineLayout(
@@ -534,7 +861,7 @@ void VulkanRenderer::CreatePipelines()
         displayPipeline->rasterState.cullMode = VK_CULL_MODE_NONE;
         displayPipeline->rasterState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 
-        displayPipeline->BuildPipeline(
+        displayPipeline->PreparePipeline(
             &info,
             std::move(displayLayout),
             vkRenderPass.display
@@ -543,14 +870,32 @@ void VulkanRenderer::CreatePipelines()
         pipelines["display"] = std::move(displayPipeline);
     }
 
+    std::vector<MeshPipelineInfo> skyboxPipelineInfos =
+    {
+        {"skybox", "resources/vulkan_shaders/skybox/vert.spv",
+            "resources/vulkan_shaders/skybox/frag.spv",
+            nullptr, nullptr,
+            VulkanVertexbuffer::GetVertexInputState(),
+            0, vkRenderPass.defaultCamera}
+    };
+    if (multiviewEnabled)
+    {
+        skyboxPipelineInfos.push_back(
+            {"skyboxMultiview", "resources/vulkan_shaders/skybox/multiview_vert.spv",
+            "resources/vulkan_shaders/skybox/frag.spv",
+            nullptr, nullptr,
+            VulkanVertexbuffer::GetVertexInputState(),
+            0, vkRenderPass.multiviewCamera});
+    }
+
+    for (const MeshPipelineInfo& info: skyboxPipelineInfos)
     {
         std::unique_ptr<VulkanPipeline> skyboxPipeline = 
             std::make_unique<VulkanPipeline>(vulkanDevice.vkDevice);
         PipelineLayoutBuilder layoutBuilder(&vulkanDevice);
         std::unique_ptr<VulkanPipelineLayout> skyboxLayout;
 
-        skyboxPipeline->LoadShader("resources/vulkan_shaders/skybox/vert.spv",
-                                    "resources/vulkan_shaders/skybox/frag.spv");
+        skyboxPipeline->LoadShader(info.vertPath, info.fragPath);
         
         layoutBuilder.PushDescriptorSetLayout("textureCube",
         {
@@ -576,14 +921,15 @@ void VulkanRenderer::CreatePipelines()
         skyboxPipeline->rasterState.cullMode = VK_CULL_MODE_NONE;
         skyboxPipeline->rasterState.frontFace = VK_FRONT_FACE_CLOCKWISE;
         skyboxPipeline->depthStencilState.depthTestEnable = VK_FALSE;
+        skyboxPipeline->multisampleState.rasterizationSamples = msaaSamples;
 
-        skyboxPipeline->BuildPipeline(
-            VulkanVertexbuffer::GetVertexInputState(),
+        skyboxPipeline->PreparePipeline(
+            info.vertexInput,
             std::move(skyboxLayout),
-            vkRenderPass.defaultCamera
+            info.renderPass
         );
 
-        pipelines["skybox"] = std::move(skyboxPipeline);
+        pipelines[info.name] = std::move(skyboxPipeline);
     }
 
     {
@@ -619,13 +965,14 @@ void VulkanRenderer::CreatePipelines()
         );
 
         wirePipeline->rasterState.cullMode = VK_CULL_MODE_NONE;
+        wirePipeline->multisampleState.rasterizationSamples = msaaSamples;
 
         VkPipelineVertexInputStateCreateInfo info{};
         info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
         info.vertexAttributeDescriptionCount = 0;
         info.vertexBindingDescriptionCount = 0;
 
-        wirePipeline->BuildPipeline(
+        wirePipeline->PreparePipeline(
             &info,
             std::move(wireLayout),
             vkRenderPass.defaultCamera
@@ -640,6 +987,47 @@ void VulkanRenderer::CreatePipelines()
     pipelineLine = std::make_unique<PipelineLine>(
         vulkanDevice, vkDescriptorPool, vkRenderPass.defaultCamera
     );
+    pipelineLine->GetVulkanPipeline()->multisampleState.rasterizationSamples =
+        msaaSamples;
+    pipelineLine->GetShapePipeline()->multisampleState.rasterizationSamples =
+        msaaSamples;
+    if (multiviewEnabled)
+    {
+        pipelineLineMultiview = std::make_unique<PipelineLine>(
+            vulkanDevice, vkDescriptorPool, vkRenderPass.multiviewCamera, true
+        );
+        pipelineLineMultiview->GetVulkanPipeline()
+            ->multisampleState.rasterizationSamples = msaaSamples;
+        pipelineLineMultiview->GetShapePipeline()
+            ->multisampleState.rasterizationSamples = msaaSamples;
+    }
+
+    // All pipelines above are only prepared, compile them together.
+    std::vector<VulkanPipeline*> compileList;
+    for (auto& pipeline: pipelines)
+        compileList.push_back(pipeline.second.get());
+    compileList.push_back(pipelineImgui->GetVulkanPipeline());
+    compileList.push_back(pipelineLine->GetVulkanPipeline());
+    compileList.push_back(pipelineLine->GetShapePipeline());
+    if (pipelineLineMultiview)
+    {
+        compileList.push_back(pipelineLineMultiview->GetVulkanPipeline());
+        compileList.push_back(pipelineLineMultiview->GetShapePipeline());
+    }
+
+    VulkanPipeline::CompilePipelines(
+        compileList, pipelineCache.GetPipelineCache());
+
+    std::chrono::steady_clock::duration duration =
+        std::chrono::steady_clock::now() - start;
+    Logger::Write(
+        "[Vulkan Renderer] Created " + std::to_string(compileList.size()) +
+        " pipelines in " + std::to_string(
+        std::chrono::duration_cast<std::chrono::milliseconds>(duration).count()) +
+        " ms, " + (pipelineCache.GetLoadedSize()? "warm": "cold") + " cache.",
+        Logger::Level::Info,
+        Logger::MsgType::Renderer
+    );
 }
 
 void VulkanRenderer::BeginFrame()
@@ -660,6 +1048,24 @@ void VulkanRenderer::EndFrame()
 
     int imageIndex = swapchain->GetNextImageIndex(&vulkanDevice, imageAcquiredSemaphore);
 
+    if (timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(vkCommandBuffer, timestampPool, 0, 2);
+        vkCmdWriteTimestamp(vkCommandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 0);
+    }
+
+    if (xrContext && xrDisplay && lateLatchEnabled)
+    {   // The scene update used poses from xrWaitFrame, replace them
+        // with newer ones. The camera uniforms are mapped, so
+        // this takes effect without recording anything.
+        ZoneScopedN("EndFrame#LateLatch");
+
+        EyeView views[2];
+        if (xrContext->swapchain->LateLatchViews(views))
+            xrDisplay->LateLatchEyeViews(views);
+    }
+
     defaultTechnique.ExecuteCommand(vkCommandBuffer);
 
     {
@@ -677,16 +1083,20 @@ void VulkanRenderer::EndFrame()
         vkCmdBeginRenderPass(vkCommandBuffer, &vkRenderPassinfo, VK_SUBPASS_CONTENTS_INLINE);
 
         VkDescriptorSet activeWindowDescSet;
-        int isTexture;
+        TransferPushConst transfer{};
+        transfer.uvScale = glm::vec2(1.0f);
         if(cameraWindowDescSet == VK_NULL_HANDLE) 
         {
             activeWindowDescSet = textureWindowDescSet;
-            isTexture = 1;
+            transfer.isTexture = 1;
         }
         else
         {
             activeWindowDescSet = cameraWindowDescSet;
-            isTexture = 0;
+            transfer.isTexture = 0;
+            transfer.uvScale = glm::vec2(
+                std::dynamic_pointer_cast<VulkanCamera>(cameraWindow)
+                ->GetRenderScale());
         }
 
         vkCmdBindPipeline(vkCommandBuffer, 
@@ -717,7 +1127,7 @@ void VulkanRenderer::EndFrame()
         vkCmdPushConstants(
             vkCommandBuffer,
             pipelines["display"]->pipelineLayout->layout, VK_SHADER_STAGE_VERTEX_BIT,
-            0, sizeof(int), &isTexture);
+            0, sizeof(TransferPushConst), &transfer);
 
         vkCmdDraw(vkCommandBuffer, 3, 1, 0, 0);
         vkCmdEndRenderPass(vkCommandBuffer);
@@ -725,15 +1135,53 @@ void VulkanRenderer::EndFrame()
 
     RenderOpenxrFrame(vkCommandBuffer);
 
+    if (timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(vkCommandBuffer,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 1);
+    }
+
     TracyVkCollect(tracyVkCtx, vkCommandBuffer);
     vcb.EndCommand();
 
+    // EndCommand waits for the frame, so the timestamps are ready.
+    UpdateDynamicResolution();
+
     // Present image
     swapchain->PresentImage(&vulkanDevice, renderFinishedSemaphore, imageIndex);
 
     defaultTechnique.ResetSceneData();
 }
 
+void VulkanRenderer::UpdateDynamicResolution()
+{
+    ZoneScopedN("VulkanRenderer::UpdateDynamicResolution");
+
+    if (timestampPool == VK_NULL_HANDLE)
+        return;
+
+    uint64_t timestamps[2];
+    VkResult result = vkGetQueryPoolResults(vulkanDevice.vkDevice,
+        timestampPool, 0, 2, sizeof(timestamps), timestamps,
+        sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS || timestamps[1] < timestamps[0])
+        return;
+
+    float gpuTime = static_cast<float>(timestamps[1] - timestamps[0])
+        * timestampPeriod * 1e-9f;
+    TracyPlot("GPU frame time (ms)", gpuTime * 1000.0f);
+
+    if (!xrContext || !xrDisplay || !dynamicResolutionEnabled)
+        return;
+
+    // Applied to the next frame, both to the eye cameras
+    // and to the copy into the OpenXR swapchain.
+    xrRenderScale = dynamicResolution.Update(
+        gpuTime, xrContext->swapchain->GetDisplayPeriod());
+    xrDisplay->SetRenderScale(xrRenderScale);
+    TracyPlot("VR render scale", xrRenderScale);
+}
+
 void VulkanRenderer::RenderOpenxrFrame(VkCommandBuffer vkCommandBuffer)
 {
     ZoneScopedN("VulkanRenderer::RenderOpenxrFrame");
@@ -786,13 +1234,16 @@ void VulkanRenderer::RenderOpenxrFrame(VkCommandBuffer vkCommandBuffer)
             xrContext->pipeline->pipelineLayout->layout,
             0, 1, &descSet, 0, nullptr);
 
-        // transfer image from camera instead of texture
-        int isTexture = 0;
+        // transfer image from camera instead of texture,
+        // only the part covered by the dynamic render extent.
+        TransferPushConst transfer{};
+        transfer.isTexture = 0;
+        transfer.uvScale = glm::vec2(xrRenderScale);
 
         vkCmdPushConstants(
         vkCommandBuffer,
         pipelines["display"]->pipelineLayout->layout, VK_SHADER_STAGE_VERTEX_BIT,
-        0, sizeof(int), &isTexture);
+        0, sizeof(TransferPushConst), &transfer);
 
         vkCmdDraw(vkCommandBuffer, 3, 1, 0, 0);
 
@@ -818,6 +1269,8 @@ void VulkanRenderer::DeallocateResources()
     VulkanMaterial::DestroyDefaultMaterial();
     VulkanTexture::DestroyDefaultTexture();
     VulkanTextureCube::DestroyDefaultTexture();
+    bindless.Destroy();
+    culling.Destroy();
 
     DestroyFramebuffers();
     swapchain->Destroy(&vulkanDevice);
@@ -825,8 +1278,18 @@ void VulkanRenderer::DeallocateResources()
     pipelines.clear();
     pipelineImgui.reset();
     pipelineLine.reset();
+    pipelineLineMultiview.reset();
     DestroyRenderPasses();
 
+    pipelineCache.Save();
+    pipelineCache.Destroy();
+
+    if (timestampPool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(vulkanDevice.vkDevice, timestampPool, nullptr);
+        timestampPool = VK_NULL_HANDLE;
+    }
+
     vulkanCmdBuffer.Destroy();
     vkDestroyDescriptorPool(vulkanDevice.vkDevice, vkDescriptorPool, nullptr);
 }
@@ -918,7 +1381,7 @@ bool VulkanRenderer::InitializeXrSession(IVulkanSwapchain* xrSwapchain)
 
         VkPushConstantRange range = {};
         range.offset = 0;
-        range.size = sizeof(int);
+        range.size = sizeof(TransferPushConst);
         range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
         displayLayout = layoutBuilder.BuildPipelineLayout(
@@ -935,7 +1398,8 @@ bool VulkanRenderer::InitializeXrSession(IVulkanSwapchain* xrSwapchain)
         displayPipeline->BuildPipeline(
             &info,
             std::move(displayLayout),
-            xrContext->renderpass
+            xrContext->renderpass,
+            pipelineCache.GetPipelineCache()
         );
 
         xrContext->pipeline = std::move(displayPipeline);
@@ -965,6 +1429,9 @@ void VulkanRenderer::DestroyXrSession()
 
     if (!xrContext)
         return;
+
+    xrDisplay = nullptr;
+    xrRenderScale = 1.0f;
     
     xrContext->pipeline = nullptr;
     vkDestroyRenderPass(vulkanDevice.vkDevice, xrContext->renderpass, nullptr);
@@ -1074,6 +1541,23 @@ void VulkanRenderer::SetWindowContent(std::shared_ptr<Camera> camera)
 void VulkanRenderer::SetXRWindowContext(
     std::shared_ptr<VulkanVrDisplay> vrDisplay)
 {
+    // The display starts at the full extent it was initialized with.
+    xrDisplay = vrDisplay;
+    dynamicResolution.SetRange(DYNAMIC_RESOLUTION_MIN_SCALE, 1.0f);
+    dynamicResolution.Reset();
+    xrRenderScale = dynamicResolution.GetScale();
+    xrDisplay->SetRenderScale(xrRenderScale);
+
+    if (vrDisplay->IsMultiview())
+    { // One layer of the stereo camera per eye
+        xrDisplayDescSet[0] = 
+            *vrDisplay->GetStereoCamera()->GetTextureDescriptorSet(0);
+
+        xrDisplayDescSet[1] = 
+            *vrDisplay->GetStereoCamera()->GetTextureDescriptorSet(1);
+        return;
+    }
+
     xrDisplayDescSet[0] = 
         *vrDisplay->GetLeftCamera()->GetTextureDescriptorSet();
 
@@ -5,12 +5,16 @@
 #include "vk_primitives/vulkan_device.h"
 #include "vk_primitives/vulkan_cmdbuffer.h"
 #include "vk_primitives/vulkan_pipeline.h"
+#include "vk_primitives/vulkan_pipeline_cache.h"
 
 #include "vulkan_texture.h"
+#include "vulkan_bindless.h"
+#include "vulkan_culling.h"
 #include "vulkan_swapchain.h"
 #include "render_technique.h"
 #include "pipeline_imgui.h"
 #include "pipeline_line.h"
+#include "dynamic_resolution.h"
 
 #include <vulkan/vulkan.h>
 #include <string>
@@ -48,7 +52,9 @@ public:
     struct {
         VkRenderPass display;
         VkRenderPass defaultCamera;
+        VkRenderPass multiviewCamera = VK_NULL_HANDLE; // Both eyes in one pass
         VkRenderPass imgui;
+        VkRenderPass shadow; // Depth only, one cascade of a shadow map
     } vkRenderPass;
     /**
      * FIXME:
@@ -65,6 +71,12 @@ public:/* Services */
     VulkanPipelineLayout& GetPipelineLayout(std::string name);
     VulkanPipeline& GetPipeline(std::string name);
     IVulkanSwapchain* GetSwapchain() {return swapchain;}
+    bool IsMultiviewEnabled() {return multiviewEnabled;}
+    VkSampleCountFlagBits GetSampleCount() {return msaaSamples;}
+    float GetTimestampPeriod() {return timestampPeriod;} // 0 without timestamps
+    VulkanBindless& GetBindless() {return bindless;}
+    bool IsGpuCullingEnabled() {return gpuCullingEnabled;}
+    VulkanCulling& GetCulling() {return culling;}
     
     void SetWindowContent(std::shared_ptr<Texture> texture);
     void SetWindowContent(std::shared_ptr<UI> ui);
@@ -78,6 +90,7 @@ private: /* Private Vulkan helpers */
     void operator=(VulkanRenderer const&) = delete;
 
     void RenderOpenxrFrame(VkCommandBuffer vkCommandBuffer);
+    void UpdateDynamicResolution();
 
     void CreateRenderPasses();
     void CreateFramebuffers();
@@ -95,7 +108,10 @@ public:
 
 private:
     VkDescriptorPool vkDescriptorPool;
+    VulkanBindless bindless; // Set 0 of the mesh pipelines
+    VulkanCulling culling; // Only initialized with gpuCullingEnabled
     VulkanCmdBuffer vulkanCmdBuffer;
+    VulkanPipelineCache pipelineCache;
 
     // Display to glfw window
     std::shared_ptr<UI> uiWindow;
@@ -108,6 +124,27 @@ private:
     std::map<std::string, std::unique_ptr<VulkanPipeline>> pipelines;
     std::unique_ptr<PipelineImgui> pipelineImgui;
     std::unique_ptr<PipelineLine> pipelineLine;
+    std::unique_ptr<PipelineLine> pipelineLineMultiview;
+
+    // VK_KHR_multiview is supported and not disabled by CONFIG_VR_MULTIVIEW.
+    bool multiviewEnabled = false;
+    // VK_KHR_draw_indirect_count is supported and CONFIG_GPU_CULLING is "true".
+    bool gpuCullingEnabled = false;
+    // Samples of the camera render passes, from CONFIG_MSAA_SAMPLES.
+    VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // GPU time of a frame, written at the begin and the end of the command buffer.
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    float timestampPeriod = 0.0f; // Nanoseconds per tick
+
+    // Scales the render extent of the VR display to hold the display period.
+    DynamicResolution dynamicResolution;
+    bool dynamicResolutionEnabled = true;
+    float xrRenderScale = 1.0f;
+    std::shared_ptr<VulkanVrDisplay> xrDisplay;
+
+    // Update the eye views of xrDisplay right before command recording.
+    bool lateLatchEnabled = true;
 
     // Owned by glfw
     IVulkanSwapchain* swapchain = nullptr;
@@ -2,6 +2,17 @@
 
 #include "vk_primitives/vulkan_device.h"
 #include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+/**
+ * Pose and field of view of one eye in the tracking space.
+ */
+struct EyeView
+{
+    glm::vec4 fov;  // <left, right, up, down>
+    glm::vec4 quat; // <x, y, z, w>
+    glm::vec3 pos;
+};
 
 
 class IVulkanSwapchain
@@ -24,6 +35,23 @@ public:
         VkSemaphore renderFinishedSemaphores, uint32_t imageIndex) = 0;
     virtual bool ShouldRender() = 0;
 
+    /**
+     * @brief Time between two refreshes of the display in seconds,
+     * 0 if the swapchain does not know it.
+     */
+    virtual float GetDisplayPeriod() {return 0.0f;}
+
+    /**
+     * @brief Locate the eyes again right before command recording,
+     * for the same predicted display time as the frame.
+     * The poses returned are the ones submitted with the frame.
+     * 
+     * @param views index 0 = left eye, index 1 = right eye
+     * @return false if the swapchain has no tracked views
+     * or tracking is lost. The views are not modified then.
+     */
+    virtual bool LateLatchViews(EyeView views[2]) {return false;}
+
     /**
      * @brief Rebuild swapchain, images, and image views. 
      * It should be called internally by the renderer, not by the window system that implements the interface.
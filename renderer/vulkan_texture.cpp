@@ -21,7 +21,8 @@ std::shared_ptr<VulkanTexture> VulkanTexture::defaultTexture;
 std::shared_ptr<VulkanTextureCube> VulkanTextureCube::defaultTexture;
 
 void VulkanTexture::CreateImage(
-    VkExtent2D imageExtent, VkFormat colorFormat, VkImageUsageFlags usage)
+    VkExtent2D imageExtent, VkFormat colorFormat, VkImageUsageFlags usage,
+    uint32_t layerCount, VkSampleCountFlagBits samples)
 {
     ZoneScopedN("VulkanTexture::CreateImage");
 
@@ -36,12 +37,12 @@ void VulkanTexture::CreateImage(
     imageInfo.extent.height = imageExtent.height;
     imageInfo.extent.depth = 1;
     imageInfo.mipLevels = 1;
-    imageInfo.arrayLayers = 1;
+    imageInfo.arrayLayers = layerCount;
     imageInfo.format = colorFormat;
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     imageInfo.usage = usage;
-    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.samples = samples;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     CHECK_VKCMD(vkCreateImage(vkDevice, &imageInfo, nullptr, &vkImage));
 
@@ -58,15 +59,28 @@ void VulkanTexture::CreateImage(
     // Allocate image view 
     VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
     viewInfo.image = vkImage;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.viewType = (layerCount > 1)?
+        VK_IMAGE_VIEW_TYPE_2D_ARRAY: VK_IMAGE_VIEW_TYPE_2D;
     viewInfo.format = colorFormat;
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = 1;
     viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.layerCount = layerCount;
 
     CHECK_VKCMD(vkCreateImageView(vkDevice, &viewInfo, nullptr, &vkImageView));
+
+    layerViews.clear();
+    for (uint32_t i = 0; layerCount > 1 && i < layerCount; i++)
+    {
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.subresourceRange.baseArrayLayer = i;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        VkImageView layerView;
+        CHECK_VKCMD(vkCreateImageView(vkDevice, &viewInfo, nullptr, &layerView));
+        layerViews.push_back(layerView);
+    }
 }
 
 void VulkanTexture::LoadImageFromBuffer(unsigned char *pixels, int texWidth, int texHeight)
@@ -250,6 +264,30 @@ VkDescriptorImageInfo* VulkanTexture::GetDescriptor(VkImageLayout vkImageLayout)
     return &vkDecriptorInfo;
 }
 
+VkDescriptorImageInfo VulkanTexture::GetLayerDescriptor(
+    uint32_t layer, VkImageLayout vkImageLayout)
+{
+    ZoneScopedN("VulkanTexture::GetLayerDescriptor");
+
+    VkDescriptorImageInfo descriptor{};
+    descriptor.imageLayout = vkImageLayout;
+    descriptor.imageView = layerViews.empty()? vkImageView: layerViews[layer];
+    descriptor.sampler = vkSampler;
+    return descriptor;
+}
+
+uint32_t VulkanTexture::GetBindlessIndex()
+{
+    ZoneScopedN("VulkanTexture::GetBindlessIndex");
+
+    if (bindlessIndex == 0 && vulkanDevice)
+    {
+        bindlessIndex = VulkanRenderer::GetInstance().GetBindless().AddTexture(
+            *GetDescriptor());
+    }
+    return bindlessIndex;
+}
+
 void VulkanTexture::Destroy()
 {
     ZoneScopedN("VulkanTexture::Destroy");
@@ -260,8 +298,13 @@ void VulkanTexture::Destroy()
         vkDeviceWaitIdle(vkDevice); 
         // FIXME: wait until this resource has been used by GPU
         // Not the best way to do this.
+        VulkanRenderer::GetInstance().GetBindless().RemoveTexture(bindlessIndex);
+        bindlessIndex = 0;
         vkDestroySampler(vkDevice, vkSampler, nullptr);
         vkDestroyImageView(vkDevice, vkImageView, nullptr);
+        for (VkImageView layerView: layerViews)
+            vkDestroyImageView(vkDevice, layerView, nullptr);
+        layerViews.clear();
         vkDestroyImage(vkDevice, vkImage, nullptr);
         vkFreeMemory(vkDevice, vkDeviceMemory, nullptr);
         vulkanDevice = nullptr;
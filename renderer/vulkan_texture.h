@@ -2,6 +2,7 @@
 
 #include <vulkan/vulkan.h>
 #include <string>
+#include <vector>
 
 #include "texture.h"
 #include "vk_primitives/vulkan_device.h"
@@ -39,9 +40,17 @@ public:
     glm::vec2 GetExtent() override;
     void Serialize(Json::Value& json) override;
 
+    /**
+     * @brief Create the image and its view.
+     * With more than one layer the view covers all layers as
+     * a 2D array, and each layer gets its own 2D view for sampling.
+     * Multisampled images are only meant to be render targets.
+     */
     void CreateImage(
         VkExtent2D imageExtent, VkFormat colorFormat, 
-        VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+        VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        uint32_t layerCount = 1,
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT);
     void CreateSampler(
         VkFilter minFilter = VK_FILTER_LINEAR,
         VkFilter magFilter = VK_FILTER_LINEAR,
@@ -58,15 +67,24 @@ public:
     void LoadImageFromBuffer(unsigned char *pixels, int texWidth, int texHeight);
     VkImageView GetImageView() {return vkImageView;}
     VkImage GetImage() {return vkImage;}
+    VkDescriptorImageInfo GetLayerDescriptor(uint32_t layer,
+        VkImageLayout vkImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    /**
+     * Slot of the texture in the bindless texture array,
+     * taken on the first call and given back by Destroy.
+     */
+    uint32_t GetBindlessIndex();
     void Destroy();
 
 private:
     VkImage vkImage = VK_NULL_HANDLE;
     VkDeviceMemory vkDeviceMemory = VK_NULL_HANDLE;
     VkImageView vkImageView = VK_NULL_HANDLE;
+    std::vector<VkImageView> layerViews{}; // Only for layered images
     VkSampler vkSampler = VK_NULL_HANDLE;
     VkExtent2D imageExtent{};
     VkDescriptorImageInfo vkDecriptorInfo{};
+    uint32_t bindlessIndex = 0; // 0 until used by a material
 
     TextureBuildInfo info;
     TextureType textureType;
@@ -400,6 +400,110 @@ void VulkanLineGenerator::GetOBB(std::vector<LineData>& lineData,
     lineData.push_back(data);
 }
 
+static void GetCapsuleCap(std::vector<LineData>& lineData,
+    unsigned int resolution)
+{
+    const int DIVISION = resolution;
+    const float DEGREE = glm::two_pi<float>() / DIVISION;
+
+    glm::vec3 prevPoint = glm::vec3(0, -1, 0);
+    for (int i = 1; i <= DIVISION/2; i++)
+    {
+        float currDegree = DEGREE * i - glm::half_pi<float>();
+
+        LineData data;
+        data.beginPoint = prevPoint;
+        data.endPoint = glm::vec3(glm::cos(currDegree), glm::sin(currDegree), 0);
+
+        prevPoint = data.endPoint;
+        lineData.push_back(data);
+    }
+
+    prevPoint = glm::vec3(0, 0, -1);
+    for (int i = 1; i <= DIVISION/2; i++)
+    {
+        float currDegree = DEGREE * i - glm::half_pi<float>();
+
+        LineData data;
+        data.beginPoint = prevPoint;
+        data.endPoint = glm::vec3(glm::cos(currDegree), 0, glm::sin(currDegree));
+
+        prevPoint = data.endPoint;
+        lineData.push_back(data);
+    }
+
+    prevPoint = glm::vec3(0, 1, 0);
+    for (int i = 1; i <= DIVISION; i++)
+    {
+        float currDegree = DEGREE * i;
+
+        LineData data;
+        data.beginPoint = prevPoint;
+        data.endPoint = glm::vec3(0, glm::cos(currDegree), glm::sin(currDegree));
+
+        prevPoint = data.endPoint;
+        lineData.push_back(data);
+    }
+}
+
+const std::vector<LineData>& VulkanLineGenerator::GetUnitShape(UnitShape shape)
+{
+    // Built on first use, shapes are never modified afterwards.
+    static const std::vector<LineData> sphere = []()
+    {
+        std::vector<LineData> lineData;
+        GetSphere(lineData, glm::vec3(0.0f), 1.0f);
+        return lineData;
+    }();
+
+    static const std::vector<LineData> circle = []()
+    {
+        std::vector<LineData> lineData;
+        GetCircle(lineData, glm::vec3(0.0f), glm::vec3(0, 0, 1), 1.0f);
+        return lineData;
+    }();
+
+    static const std::vector<LineData> box = []()
+    {
+        std::vector<LineData> lineData;
+        GetOBB(lineData, glm::mat4(1.0f));
+        return lineData;
+    }();
+
+    static const std::vector<LineData> capsuleCap = []()
+    {
+        std::vector<LineData> lineData;
+        GetCapsuleCap(lineData, 64);
+        return lineData;
+    }();
+
+    static const std::vector<LineData> capsuleSides = []()
+    {
+        std::vector<LineData> lineData;
+        lineData.push_back({glm::vec3( 1,  1,  0), glm::vec3(-1,  1,  0)});
+        lineData.push_back({glm::vec3( 1, -1,  0), glm::vec3(-1, -1,  0)});
+        lineData.push_back({glm::vec3( 1,  0,  1), glm::vec3(-1,  0,  1)});
+        lineData.push_back({glm::vec3( 1,  0, -1), glm::vec3(-1,  0, -1)});
+        return lineData;
+    }();
+
+    switch (shape)
+    {
+    case UnitShape::Sphere:
+        return sphere;
+    case UnitShape::Circle:
+        return circle;
+    case UnitShape::Box:
+        return box;
+    case UnitShape::CapsuleCap:
+        return capsuleCap;
+    case UnitShape::CapsuleSides:
+        return capsuleSides;
+    }
+
+    return sphere;
+}
+
 static void GetLineMesh(
     std::vector<uint32_t>& indexList, std::vector<Vertex>& vertexList,
     uint32_t resolution)
@@ -462,6 +566,28 @@ static void GetLineMesh(
     indexList.push_back(vertexCount++);
 }
 
+void VulkanLineGenerator::GetShapeMesh(UnitShape shape,
+    std::vector<uint32_t>& indices, std::vector<ShapeVertex>& vertices)
+{
+    ZoneScopedN("VulkanLineGenerator::GetShapeMesh");
+
+    // Shape lines are thin, fewer triangles round their ends.
+    std::vector<uint32_t> lineIndices;
+    std::vector<Vertex> lineVertices;
+    GetLineMesh(lineIndices, lineVertices, 4);
+
+    indices.clear();
+    vertices.clear();
+    for (const LineData& segment: GetUnitShape(shape))
+    {
+        uint32_t first = static_cast<uint32_t>(vertices.size());
+        for (const Vertex& vertex: lineVertices)
+            vertices.push_back({vertex.Position, segment.beginPoint, segment.endPoint});
+        for (uint32_t index: lineIndices)
+            indices.push_back(first + index);
+    }
+}
+
 LineRenderer::LineRenderer(
         VulkanDevice* vulkanDevice,
         VulkanPipelineLayout* linePipelineLayout)
@@ -482,6 +608,9 @@ LineRenderer::LineRenderer(
     LineProperties defaultProp{};
     *(this->lineProperties) = defaultProp;
 
+    for (VulkanBuffer<ShapeInstance>& instances: shapeInstances)
+        instances.Initialize(vulkanDevice, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 64);
+
     {
         linePipelineLayout->AllocateDescriptorSet(
             "lineProperties", 1, &linePropDescSet
@@ -502,7 +631,11 @@ LineRenderer::LineRenderer(
     }
 }
 
-//FIXME destructor
+LineRenderer::~LineRenderer()
+{
+    for (VulkanBuffer<ShapeInstance>& instances: shapeInstances)
+        instances.Destroy();
+}
 
 void LineRenderer::AddLine(LineData data)
 {
@@ -518,9 +651,20 @@ void LineRenderer::AddLines(std::vector<LineData>& data)
         lineDataList->PushBack(e);
 }
 
+void LineRenderer::AddShape(VulkanLineGenerator::UnitShape shape,
+    const glm::mat4& transform, glm::vec3 color)
+{
+    ShapeInstance instance;
+    instance.transform = transform;
+    instance.color = color;
+    shapeInstances[static_cast<int>(shape)].PushBack(instance);
+}
+
 void LineRenderer::ClearAllLines()
 {
     lineInstance->GetInstanceBuffer()->Clear();
+    for (VulkanBuffer<ShapeInstance>& instances: shapeInstances)
+        instances.Clear();
 }
 
 } // namespace renderer
\ No newline at end of file
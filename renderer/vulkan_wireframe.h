@@ -95,9 +95,54 @@ struct LineData
     glm::vec3 endPoint;
 };
 
+#define LINE_UNIT_SHAPE_COUNT 5
+
+/**
+ * Vertex of a unit shape mesh, one line mesh per segment.
+ * Every vertex of a segment holds both of its points.
+ */
+struct ShapeVertex
+{
+    glm::vec3 position; // Of the line mesh
+    glm::vec3 beginPoint;
+    glm::vec3 endPoint;
+};
+
+/**
+ * One drawn unit shape, the segments of its mesh
+ * are moved by the transform on the GPU.
+ */
+struct ShapeInstance
+{
+    glm::mat4 transform;
+    glm::vec3 color;
+    float _0;
+};
+
 class VulkanLineGenerator
 {
 public:
+    /**
+     * Shapes generated once in local space. Their meshes are built once
+     * by PipelineLine and drawn instanced with LineRenderer::AddShape.
+     */
+    enum class UnitShape
+    {
+        Sphere,         // Radius 1 at the origin, circles in the XY, XZ and YZ planes
+        Circle,         // Radius 1 in the XY plane, 32 segments
+        Box,            // Cube from -0.5 to 0.5
+        CapsuleCap,     // Hemisphere of radius 1 towards +X, with its ring at X = 0
+        CapsuleSides    // Four lines from X = -1 to 1 on the cylinder of radius 1
+    };
+
+    static const std::vector<LineData>& GetUnitShape(UnitShape shape);
+
+    /**
+     * Line mesh of every segment of a unit shape, in one vertex buffer.
+     */
+    static void GetShapeMesh(UnitShape shape,
+        std::vector<uint32_t>& indices, std::vector<ShapeVertex>& vertices);
+
     static void GetLine(LineData& lineData,
         glm::vec3 direction, float length);
 
@@ -140,6 +185,12 @@ public:
 public:
     void AddLine(LineData data);
     void AddLines(std::vector<LineData>& data);
+    /**
+     * Draw a unit shape moved by transform. Only the instance is written,
+     * all instances of a shape are drawn at once.
+     */
+    void AddShape(VulkanLineGenerator::UnitShape shape,
+        const glm::mat4& transform, glm::vec3 color);
     void ClearAllLines();
 
     void SetLineWidth(float width)
@@ -192,11 +243,17 @@ public:
         return lineInstance->GetInstanceCount();
     }
 
+    VulkanBuffer<ShapeInstance>* GetShapeInstances(
+        VulkanLineGenerator::UnitShape shape)
+    {
+        return &shapeInstances[static_cast<int>(shape)];
+    }
+
     LineRenderer(
         VulkanDevice* vulkanDevice,
         VulkanPipelineLayout* linePipelineLayout
     );
-    ~LineRenderer() = default;
+    ~LineRenderer();
 
     LineRenderer(const LineRenderer&) = delete;
     void operator=(const LineRenderer&) = delete;
@@ -204,6 +261,7 @@ public:
 private:
     VulkanUniform linePropUniform;
     std::shared_ptr<VulkanInstanceMesh<LineData>> lineInstance = nullptr;
+    VulkanBuffer<ShapeInstance> shapeInstances[LINE_UNIT_SHAPE_COUNT];
 
     LineProperties* lineProperties = nullptr;
     VkDescriptorSet linePropDescSet = VK_NULL_HANDLE;
@@ -0,0 +1,97 @@
+#version 450
+#extension GL_EXT_scalar_block_layout : require
+#extension GL_EXT_multiview : require
+
+// glslc compact_multiview.vert -o compact_multiview_vert.spv
+// glslc -DGPU_DRIVEN compact_multiview.vert -o gpu_compact_multiview_vert.spv
+
+// The depth pre-pass and the shading pass must produce the same depth.
+invariant gl_Position;
+
+layout (location = 0) out vec3 oFragPos;
+layout (location = 1) out vec3 oNormal;
+layout (location = 2) out vec2 oTexCoords;
+layout (location = 3) out vec3 oViewPos;
+
+#ifdef GPU_DRIVEN
+// Same as GpuInstance in vulkan_culling.h,
+// indirect draws start at the instance they draw.
+struct Instance
+{
+    mat4 model;
+    vec4 sphere;
+    uint batch;
+    uint material;
+    uint visible;
+    uint _1;
+};
+
+layout (set = 1, binding = 0, std430) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout (location = 4) flat out uint oMaterialIndex;
+#else
+layout (set = 1, binding = 0, std430) uniform MeshCoordinates
+{
+    mat4 model;
+} m;
+#endif
+
+struct ViewProjection
+{
+    mat4 view;
+    mat4 projection;
+};
+
+// One entry per eye, selected with gl_ViewIndex.
+layout (set = 2, binding = 0, std430) uniform MultiviewProjection
+{
+    ViewProjection views[2];
+} vp;
+
+layout (push_constant, std430) uniform Quantization
+{
+    vec4 offset;
+    vec4 scale;
+} q;
+
+
+layout (location = 0) in vec4 Position;  // UNORM16, relative to mesh bounds
+layout (location = 1) in vec2 Normal;    // SNORM16, octahedral encoded
+layout (location = 2) in vec2 TexCoords; // FLOAT16
+
+vec3 OctDecode(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+    {
+        vec2 s = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(n.yx)) * s;
+    }
+    return normalize(n);
+}
+
+void main()
+{
+#ifdef GPU_DRIVEN
+    mat4 model = instances[gl_InstanceIndex].model;
+    oMaterialIndex = instances[gl_InstanceIndex].material;
+#else
+    mat4 model = m.model;
+#endif
+
+    mat4 view = vp.views[gl_ViewIndex].view;
+    mat4 projection = vp.views[gl_ViewIndex].projection;
+
+    vec3 position = q.offset.xyz + Position.xyz * q.scale.xyz;
+    vec3 normal = OctDecode(Normal);
+
+    oFragPos = vec3(model * vec4(position, 1.0));
+    oNormal =  vec3(model * vec4(normal, 0.0));
+    oTexCoords = TexCoords;
+    mat4 camera = inverse(view);
+    oViewPos = vec3(camera[3][0], camera[3][1], camera[3][2]);
+    gl_Position = projection * view * vec4(oFragPos, 1);
+}
@@ -0,0 +1,8 @@
+#version 450
+
+// glslc depth.frag -o depth_frag.spv
+
+// Depth pre-pass, only the depth attachment is written.
+void main()
+{
+}
@@ -1,7 +1,31 @@
 #version 450
 #extension GL_EXT_scalar_block_layout : require
+#extension GL_EXT_nonuniform_qualifier : require
 
 // glslc shader.frag -o frag.spv
+// glslc -DMULTIVIEW shader.frag -o multiview_frag.spv
+// glslc -DGPU_DRIVEN shader.frag -o gpu_frag.spv
+// glslc -DGPU_DRIVEN -DMULTIVIEW shader.frag -o gpu_multiview_frag.spv
+
+#ifdef MULTIVIEW
+#extension GL_EXT_multiview : require
+#define VIEW_INDEX gl_ViewIndex
+#else
+#define VIEW_INDEX 0
+#endif
+
+// Same as light_clustering.h, shadow_cascades.h and vulkan_light.h
+#define CLUSTER_GRID_X      16
+#define CLUSTER_GRID_Y      9
+#define CLUSTER_GRID_Z      24
+#define CLUSTER_COUNT       (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+#define CAMERA_MAX_VIEWS    2
+#define LIGHT_MAX_COUNT     1024
+#define SHADOW_CASCADE_COUNT 4
+
+#define SPOT_LIGHT          0
+#define DIRECTIONAL_LIGHT   1
+#define POINT_LIGHT         2
 
 layout (location = 0) in vec3 FragPos;  
 layout (location = 1) in vec3 Normal;  
@@ -10,39 +34,81 @@ layout (location = 3) in vec3 ViewPos;
 
 layout (location = 0) out vec4 FragColor;
 
-layout (set = 0, binding = 0, std430) uniform MeshProperties
+// Same as vulkan_bindless.h
+struct Material
 {
-    vec4  albedo;
+    vec4  albedo; // a is the opacity
 
     float metallic;
     float roughness;
     float _1;
     float _2;
 
-    float useAlbedoTex;
-    float useMetallicTex;
-    float useRoughnessTex;
-    float useNormalTex;
-} meshProperties;
+    uint albedoTexture; // Slots in Textures, 0 for none
+    uint metallicTexture;
+    uint roughnessTexture;
+    uint normalTexture;
+};
 
-layout (set = 0, binding = 1) uniform sampler2D AlbedoTexture;
-layout (set = 0, binding = 2) uniform sampler2D MetallicTexture;
-layout (set = 0, binding = 3) uniform sampler2D RoughnessTexture;
-layout (set = 0, binding = 4) uniform sampler2D NormalTexture;
+layout (set = 0, binding = 0, std430) readonly buffer Materials
+{
+    Material materials[];
+};
+
+layout (set = 0, binding = 1) uniform sampler2D Textures[];
+
+#ifdef GPU_DRIVEN
+// Material of the instance of an indirect draw, see shader.vert.
+// Instances of a draw can differ in material, so the texture index does too.
+layout (location = 4) flat in uint MaterialIndex;
+#define MATERIAL_INDEX MaterialIndex
+#define TEXTURE(index) Textures[nonuniformEXT(index)]
+#else
+// Same as MaterialPushConst, after the vertex quantization
+layout (push_constant) uniform DrawConstants
+{
+    layout (offset = 32) uint materialIndex;
+} draw;
+#define MATERIAL_INDEX draw.materialIndex
+#define TEXTURE(index) Textures[index]
+#endif
 
-struct DirLight
+struct Light
 {
+    vec4 position;  // w is the range
     vec4 direction;
     vec4 color;
-} dirLight;
+    vec2 spotCos;   // cos of inner and outer cone angles
+    uint type;
+    uint _0;
+};
 
-layout (set = 3, binding = 0, std430) uniform SceneProperties
+struct ClusterView
 {
-    uvec4 lightCount; // only 1st is used
-    DirLight lights[5];
+    vec4 depth;     // p22 and p32 of the projection, slice scale and bias
+    vec4 grid;      // Clusters per pixel in x and y
+};
 
+struct ShadowData
+{
+    mat4 cascades[SHADOW_CASCADE_COUNT]; // World to shadow map clip space
+    vec4 splitDepth;    // Far end of each cascade in view depth
+    vec4 texelSize;     // World size of a shadow map texel of each cascade
+    uvec4 light;        // x: 1 if lights[0] casts shadows
+};
+
+layout (set = 3, binding = 0, std430) readonly buffer SceneLights
+{
+    uvec4 lightCount; // x: all lights, y: directional lights, stored first
+    ClusterView views[CAMERA_MAX_VIEWS];
+    ShadowData shadow;
+    Light lights[LIGHT_MAX_COUNT];
+    uvec2 clusters[CAMERA_MAX_VIEWS][CLUSTER_COUNT]; // First index, count
+    uint indices[];
 } scene;
 
+layout (set = 3, binding = 1) uniform sampler2DArrayShadow ShadowMap;
+
 const float PI = 3.14159265359;
 
 
@@ -101,38 +167,109 @@ vec3 BRDF(vec3 L, vec3 V, vec3 N, float metallic, float roughness, vec3 albedo,
 	return color;
 }
 
+// Froxel of the fragment, see LightClustering::GetClusterIndex
+uint ClusterIndex()
+{
+    ClusterView view = scene.views[VIEW_INDEX];
+
+    float depth = view.depth.y / (gl_FragCoord.z + view.depth.x);
+    float slice = floor(log(max(depth, 1e-6)) * view.depth.z + view.depth.w);
+    uint z = uint(clamp(slice, 0.0, CLUSTER_GRID_Z - 1.0));
+
+    uvec2 tile = uvec2(gl_FragCoord.xy * view.grid.xy);
+    tile = min(tile, uvec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+
+    return (z * CLUSTER_GRID_Y + tile.y) * CLUSTER_GRID_X + tile.x;
+}
+
+// Inverse square falloff windowed to zero at the range
+float Attenuation(Light light, vec3 toLight)
+{
+    float distance2 = dot(toLight, toLight);
+    float range = light.position.w;
+    float ratio = distance2 / (range * range);
+    float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+
+    float attenuation = window * window / max(distance2, 0.0001);
+    if (light.type == SPOT_LIGHT)
+    {
+        float cosAngle = dot(normalize(-toLight), normalize(light.direction.xyz));
+        attenuation *= smoothstep(light.spotCos.y, light.spotCos.x, cosAngle);
+    }
+    return attenuation;
+}
+
+// Visibility of lights[0], 3x3 PCF in the cascade of the fragment depth
+float Shadow(vec3 N)
+{
+    ClusterView view = scene.views[VIEW_INDEX];
+    float depth = view.depth.y / (gl_FragCoord.z + view.depth.x);
+
+    uint cascade = 0;
+    while (cascade < SHADOW_CASCADE_COUNT && depth > scene.shadow.splitDepth[cascade])
+        cascade++;
+    if (cascade == SHADOW_CASCADE_COUNT)
+        return 1.0;
+
+    // Offset along the normal by the texel size against acne on slopes
+    vec3 position = FragPos + N * (1.5 * scene.shadow.texelSize[cascade]);
+    vec4 clip = scene.shadow.cascades[cascade] * vec4(position, 1.0);
+    vec2 uv = clip.xy * 0.5 + 0.5;
+
+    vec2 texel = 1.0 / vec2(textureSize(ShadowMap, 0).xy);
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++)
+            lit += texture(ShadowMap, vec4(uv + vec2(x, y) * texel, cascade, clip.z));
+    return lit / 9.0;
+}
+
 void main()
 {
 	vec3 N = normalize(Normal);
 	vec3 V = normalize(ViewPos - FragPos);
 
+    Material material = materials[MATERIAL_INDEX];
+
     float metallicFrag;
     float roughnessFrag;
     vec3 albedoFrag;
 
-    if (meshProperties.useMetallicTex == 0)
-        metallicFrag = meshProperties.metallic;
+    if (material.metallicTexture == 0)
+        metallicFrag = material.metallic;
     else
-        metallicFrag = texture(MetallicTexture, TexCoords).x;
+        metallicFrag = texture(TEXTURE(material.metallicTexture), TexCoords).x;
 
-    if (meshProperties.useRoughnessTex == 0)
-        roughnessFrag = clamp(meshProperties.roughness, 0.0, 1.0);
+    if (material.roughnessTexture == 0)
+        roughnessFrag = clamp(material.roughness, 0.0, 1.0);
     else
-        roughnessFrag = clamp(texture(RoughnessTexture, TexCoords).x, 0.0, 1.0);
+        roughnessFrag = clamp(texture(TEXTURE(material.roughnessTexture), TexCoords).x, 0.0, 1.0);
 
-    if (meshProperties.useAlbedoTex == 0)
-        albedoFrag = meshProperties.albedo.rgb;
+    if (material.albedoTexture == 0)
+        albedoFrag = material.albedo.rgb;
     else
-        albedoFrag = texture(AlbedoTexture, TexCoords).rgb;
+        albedoFrag = texture(TEXTURE(material.albedoTexture), TexCoords).rgb;
 
 	// Specular contribution
 	vec3 Lo = vec3(0.0);
-	for (int i = 0; i < scene.lightCount.x; i++) {
+	for (uint i = 0; i < scene.lightCount.y; i++) {
 		vec3 L = normalize(-scene.lights[i].direction.xyz);
         vec3 lightColor = scene.lights[i].color.rgb;
+        if (i == 0 && scene.shadow.light.x == 1)
+            lightColor *= Shadow(N);
 		Lo += BRDF(L, V, N, metallicFrag, roughnessFrag, albedoFrag, lightColor);
 	}
 
+    // Point and spot lights reaching the cluster of the fragment
+    uvec2 cluster = scene.clusters[VIEW_INDEX][ClusterIndex()];
+    for (uint i = 0; i < cluster.y; i++) {
+        Light light = scene.lights[scene.indices[cluster.x + i]];
+        vec3 toLight = light.position.xyz - FragPos;
+        vec3 L = normalize(toLight);
+        vec3 lightColor = light.color.rgb * Attenuation(light, toLight);
+        Lo += BRDF(L, V, N, metallicFrag, roughnessFrag, albedoFrag, lightColor);
+    }
+
 	// Combine with ambient
 	vec3 color = albedoFrag * 0.02;
 	color += Lo;
@@ -143,5 +280,5 @@ void main()
 	// Gamma correct
 	color = pow(color, vec3(0.4545));
 
-	FragColor = vec4(color, 1.0);
+	FragColor = vec4(color, material.albedo.a);
 }
\ No newline at end of file
@@ -2,16 +2,41 @@
 #extension GL_EXT_scalar_block_layout : require
 
 // glslc shader.vert -o vert.spv
+// glslc -DGPU_DRIVEN shader.vert -o gpu_vert.spv
+
+// The depth pre-pass and the shading pass must produce the same depth.
+invariant gl_Position;
 
 layout (location = 0) out vec3 oFragPos;
 layout (location = 1) out vec3 oNormal;
 layout (location = 2) out vec2 oTexCoords;
 layout (location = 3) out vec3 oViewPos;
 
+#ifdef GPU_DRIVEN
+// Same as GpuInstance in vulkan_culling.h,
+// indirect draws start at the instance they draw.
+struct Instance
+{
+    mat4 model;
+    vec4 sphere;
+    uint batch;
+    uint material;
+    uint visible;
+    uint _1;
+};
+
+layout (set = 1, binding = 0, std430) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout (location = 4) flat out uint oMaterialIndex;
+#else
 layout (set = 1, binding = 0, std430) uniform MeshCoordinates
 {
     mat4 model;
 } m;
+#endif
 
 layout (set = 2, binding = 0, std430) uniform ViewProjection 
 {
@@ -27,8 +52,15 @@ layout (location = 2) in vec2 TexCoords;
 
 void main()
 {
-    oFragPos = vec3(m.model * vec4(Position, 1.0));
-    oNormal =  vec3(m.model * vec4(Normal, 0.0));;  
+#ifdef GPU_DRIVEN
+    mat4 model = instances[gl_InstanceIndex].model;
+    oMaterialIndex = instances[gl_InstanceIndex].material;
+#else
+    mat4 model = m.model;
+#endif
+
+    oFragPos = vec3(model * vec4(Position, 1.0));
+    oNormal =  vec3(model * vec4(Normal, 0.0));;  
     oTexCoords = TexCoords;
     mat4 camera = inverse(vp.view);
     oViewPos = vec3(camera[3][0], camera[3][1], camera[3][2]);
@@ -0,0 +1,78 @@
+#version 450
+#ifdef MULTIVIEW
+#extension GL_EXT_multiview : require
+#endif
+
+// Line mesh of one segment of the unit shape
+layout (location = 0) in vec3 Position;
+layout (location = 1) in vec3 BeginPoint;
+layout (location = 2) in vec3 EndPoint;
+
+// Shape instance
+layout (location = 3) in mat4 Transform;
+layout (location = 7) in vec3 Color;
+
+layout (location = 0) out vec3 VertColor;
+
+#ifdef MULTIVIEW
+struct ViewProjection
+{
+    mat4 view;
+    mat4 projection;
+};
+
+layout (set = 0, binding = 0) uniform MultiviewProjection
+{
+    ViewProjection views[2];
+} vp;
+#else
+layout (set = 0, binding = 0) uniform ViewProjection
+{
+    mat4 view;
+    mat4 projection;
+} vp;
+#endif
+
+layout (set = 1, binding = 0) uniform LineProperties
+{
+    mat4 model;
+
+    vec3  color;
+    float _0;
+
+    float width;
+    int   useGlobalTransform;
+    vec2  resolution;
+} line;
+
+
+void main()
+{
+#ifdef MULTIVIEW
+    mat4 viewProjection =
+        vp.views[gl_ViewIndex].projection * vp.views[gl_ViewIndex].view;
+#else
+    mat4 viewProjection = vp.projection * vp.view;
+#endif
+
+    mat4 model = (line.useGlobalTransform != 0)? line.model * Transform: Transform;
+
+    // https://wwwtyro.net/2019/11/18/instanced-lines.html
+    vec4 clip0 = viewProjection * model * vec4(BeginPoint, 1.0);
+    vec4 clip1 = viewProjection * model * vec4(EndPoint, 1.0);
+
+    vec2 screen0 = line.resolution * (0.5 * clip0.xy/clip0.w + 0.5);
+    vec2 screen1 = line.resolution * (0.5 * clip1.xy/clip1.w + 0.5);
+
+    vec2 xBasis = normalize(screen1 - screen0);
+    vec2 yBasis = vec2(-xBasis.y, xBasis.x);
+    vec2 pt0 = screen0 + line.width * (Position.x * xBasis + Position.y * yBasis);
+    vec2 pt1 = screen1 + line.width * (Position.x * xBasis + Position.y * yBasis);
+    vec2 pt = mix(pt0, pt1, Position.z);
+
+    vec4 clip = mix(clip0, clip1, Position.z);
+
+    gl_Position = vec4(clip.w * ((2.0 * pt) / line.resolution - 1.0), clip.z, clip.w);
+
+    VertColor = Color;
+}
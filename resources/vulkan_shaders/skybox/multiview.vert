@@ -0,0 +1,31 @@
+#version 450
+#extension GL_EXT_multiview : require
+
+layout (location = 0) in vec3 Position;
+layout (location = 1) in vec3 Normal;
+layout (location = 2) in vec2 TexCoords;
+
+layout (location = 0) out vec3 outUVW;
+
+struct ViewProjection
+{
+    mat4 view;
+    mat4 projection;
+};
+
+layout (set = 1, binding = 0) uniform MultiviewProjection
+{
+    ViewProjection views[2];
+} vp;
+
+void main() 
+{
+	outUVW = Position;
+
+	mat4 newView = vp.views[gl_ViewIndex].view;
+	newView[3][0] = 0;
+	newView[3][1] = 0;
+	newView[3][2] = 0;
+
+	gl_Position = vp.views[gl_ViewIndex].projection * newView * vec4(Position.xyz, 1.0);
+}
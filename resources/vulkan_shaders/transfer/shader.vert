@@ -5,12 +5,15 @@ layout (location = 0) out vec2 outUV;
 layout(push_constant) uniform PushConstant
 {
 	int isTexture; // Camera or texture to swapchain display.
+	float _0;
+	vec2 uvScale;  // Part of the image covered by the render extent.
 } texInfo;
 
 void main() 
 {
-	outUV = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
-	gl_Position = vec4(outUV * 2.0f - 1.0f, 0.0f, 1.0f);
+	vec2 uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+	gl_Position = vec4(uv * 2.0f - 1.0f, 0.0f, 1.0f);
+	outUV = uv * texInfo.uvScale;
 	
 	if (texInfo.isTexture == 0)
 		gl_Position.y = -gl_Position.y;
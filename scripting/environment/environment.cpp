@@ -81,6 +81,8 @@ v8::Local<v8::FunctionTemplate> MakeSceneTemplate(v8::Isolate* isolate)
         v8::FunctionTemplate::New(isolate, GetEntitiesWithComponent));
     prototype->Set(isolate, "GetRootEntity",
         v8::FunctionTemplate::New(isolate, GetRootEntity));
+    prototype->Set(isolate, "RaycastBatch",
+        v8::FunctionTemplate::New(isolate, RaycastBatch));
 
     return handleScope.Escape(temp);
 }
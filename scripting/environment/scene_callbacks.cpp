@@ -7,6 +7,8 @@
 #include "entity.h"
 #include "validation.h"
 #include "logger.h"
+#include "physics_context.h"
+#include "scene_query_batch.h"
 
 #include <v8-function.h>
 #include <v8-external.h>
@@ -14,7 +16,11 @@
 #include <v8-isolate.h>
 #include <v8-value.h>
 #include <v8-container.h>
+#include <v8-typed-array.h>
+#include <v8-array-buffer.h>
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 
 namespace scripting
@@ -236,5 +242,140 @@ void GetRootEntity(const v8::FunctionCallbackInfo<v8::Value> &info)
     info.GetReturnValue().Set(v8Entity);
 }
 
+// Floats per ray in and per result out of RaycastBatch
+#define RAYCAST_BATCH_RAY_SIZE      6
+#define RAYCAST_BATCH_RESULT_SIZE   8
+
+static float* GetFloat32ArrayData(v8::Local<v8::Float32Array> array)
+{
+    uint8_t* data = static_cast<uint8_t*>(array->Buffer()->GetBackingStore()->Data());
+    return reinterpret_cast<float*>(data + array->ByteOffset());
+}
+
+void RaycastBatch(const v8::FunctionCallbackInfo<v8::Value> &info)
+{
+    v8::Isolate* isolate = info.GetIsolate();
+    v8::HandleScope handleScope(isolate);
+
+    v8::Local<v8::Object> holder = info.Holder();
+
+    v8::Local<v8::External> field =
+        holder->GetInternalField(0).As<v8::External>();
+    Scene* scene = static_cast<Scene*>(field->Value());
+    ASSERT(scene != nullptr);
+
+    if (info.Length() < 3 || !info[0]->IsFloat32Array() ||
+        !info[1]->IsNumber() || !info[2]->IsFloat32Array() ||
+        (info.Length() > 3 && !info[3]->IsArray()))
+    {
+        Logger::Write(
+            "[Scripting] RaycastBatch parameters are invalid",
+            Logger::Level::Warning, Logger::Scripting
+        );
+        return;
+    }
+
+    v8::Local<v8::Float32Array> v8Rays = info[0].As<v8::Float32Array>();
+    v8::Local<v8::Float32Array> v8Results = info[2].As<v8::Float32Array>();
+    const unsigned int rayCount = v8Rays->Length() / RAYCAST_BATCH_RAY_SIZE;
+    if (v8Results->Length() < rayCount * RAYCAST_BATCH_RESULT_SIZE)
+    {
+        Logger::Write(
+            "[Scripting] RaycastBatch results are smaller than the rays",
+            Logger::Level::Warning, Logger::Scripting
+        );
+        return;
+    }
+
+    const float maxDistance = info[1].As<v8::Number>()->Value();
+    const float* rays = GetFloat32ArrayData(v8Rays);
+    float* results = GetFloat32ArrayData(v8Results);
+
+    v8::Local<v8::Context> context = isolate->GetCurrentContext();
+    v8::Local<v8::Array> v8Entities;
+    if (info.Length() > 3)
+        v8Entities = info[3].As<v8::Array>();
+
+    std::shared_ptr<physics::PhysicsContext> physicsCtx =
+        std::dynamic_pointer_cast<physics::PhysicsContext>(
+            scene->GetSceneContext(SceneContext::Type::PhysicsCtx));
+    if (!physicsCtx)
+    {
+        // No ray hits, results of a previous call must not read as hits.
+        std::fill(results, results + rayCount * RAYCAST_BATCH_RESULT_SIZE, 0.0f);
+        if (!v8Entities.IsEmpty())
+        {
+            for (unsigned int i = 0; i < rayCount; i++)
+                v8Entities->Set(context, i, v8::Undefined(isolate)).ToChecked();
+        }
+        info.GetReturnValue().Set(0);
+        return;
+    }
+
+    // Scripts run on the main thread, the batch is reused by every call.
+    static physics::SceneQueryBatch batch;
+    batch.Clear();
+    batch.Reserve(rayCount);
+    for (unsigned int i = 0; i < rayCount; i++)
+    {
+        const float* ray = rays + i * RAYCAST_BATCH_RAY_SIZE;
+        batch.AddRaycast(
+            glm::vec3(ray[0], ray[1], ray[2]),
+            glm::vec3(ray[3], ray[4], ray[5]),
+            maxDistance);
+    }
+
+    physicsCtx->ExecuteQueries(batch);
+
+    v8::Local<v8::Function> entityFunction;
+    if (!v8Entities.IsEmpty())
+    {
+        v8::Local<v8::FunctionTemplate> entityTemplate =
+            v8::Local<v8::FunctionTemplate>::New(
+                isolate, Templates::entityTemplate);
+        entityFunction = entityTemplate->GetFunction(context).ToLocalChecked();
+    }
+
+    unsigned int hitCount = 0;
+    for (unsigned int i = 0; i < rayCount; i++)
+    {
+        float* result = results + i * RAYCAST_BATCH_RESULT_SIZE;
+        if (batch.GetHitCount(i) == 0)
+        {
+            std::fill(result, result + RAYCAST_BATCH_RESULT_SIZE, 0.0f);
+            if (!v8Entities.IsEmpty())
+                v8Entities->Set(context, i, v8::Undefined(isolate)).ToChecked();
+            continue;
+        }
+
+        const physics::PhysicsContext::Hit& hit = batch.GetHit(i);
+        result[0] = 1.0f;
+        result[1] = hit.distance.x;
+        result[2] = hit.position.x;
+        result[3] = hit.position.y;
+        result[4] = hit.position.z;
+        result[5] = hit.normal.x;
+        result[6] = hit.normal.y;
+        result[7] = hit.normal.z;
+        hitCount++;
+
+        if (!v8Entities.IsEmpty())
+        {
+            if (hit.entity)
+            {
+                v8::Local<v8::Object> v8Entity =
+                    entityFunction->NewInstance(context).ToLocalChecked();
+                v8Entity->SetInternalField(0, v8::External::New(isolate, hit.entity));
+                v8Entities->Set(context, i, v8Entity).ToChecked();
+            }
+            else
+            {
+                v8Entities->Set(context, i, v8::Undefined(isolate)).ToChecked();
+            }
+        }
+    }
+
+    info.GetReturnValue().Set(hitCount);
+}
 
 } // namespace scripting
@@ -16,4 +16,14 @@ void GetEntityByName(const v8::FunctionCallbackInfo<v8::Value> &info);
 void GetEntitiesWithComponent(const v8::FunctionCallbackInfo<v8::Value> &info);
 void GetRootEntity(const v8::FunctionCallbackInfo<v8::Value> &info);
 
+/**
+ * @brief RaycastBatch(rays, maxDistance, results[, entities])
+ * Cast rays.length / 6 rays at once, each is an origin and a direction
+ * in a Float32Array. The closest hit of ray i is written to the
+ * Float32Array results at 8 * i: 1 or 0 for a hit, distance, position
+ * and normal. With an Array of entities, entities[i] is set to the hit
+ * entity or undefined. Returns the number of rays that hit.
+ */
+void RaycastBatch(const v8::FunctionCallbackInfo<v8::Value> &info);
+
 } // namespace scripting
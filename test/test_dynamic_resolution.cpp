@@ -0,0 +1,100 @@
+#include "dynamic_resolution.h"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+
+/**
+ * Simulated GPU with a fixed cost and a cost
+ * proportional to the number of pixels.
+ */
+static float GpuTime(float fixedTime, float pixelTime, float scale)
+{
+    return fixedTime + pixelTime * scale * scale;
+}
+
+static bool TestConverge(const std::string& name,
+    float fixedTime, float pixelTime, float displayPeriod)
+{
+    renderer::DynamicResolution controller;
+    controller.SetRange(0.5f, 1.0f);
+
+    float budget = displayPeriod * DYNAMIC_RESOLUTION_HEADROOM;
+    float scale = controller.GetScale();
+    float minSeen = 1.0f, maxSeen = 0.0f;
+    int frames = 600;
+    for (int i = 0; i < frames; i++)
+    {
+        scale = controller.Update(
+            GpuTime(fixedTime, pixelTime, scale), displayPeriod);
+        if (i >= frames - 60)
+        {
+            minSeen = std::fmin(minSeen, scale);
+            maxSeen = std::fmax(maxSeen, scale);
+        }
+    }
+
+    float gpuTime = GpuTime(fixedTime, pixelTime, scale);
+    std::cout << name << ": scale " << scale << ", GPU "
+        << gpuTime * 1000.0f << " ms, budget " << budget * 1000.0f
+        << " ms" << std::endl;
+
+    bool passed = true;
+    if (scale < 0.5f || scale > 1.0f)
+    {
+        std::cout << name << ": scale out of range" << std::endl;
+        passed = false;
+    }
+    if (gpuTime > budget * 1.01f && scale > 0.5f)
+    {
+        std::cout << name << ": over budget" << std::endl;
+        passed = false;
+    }
+    if (maxSeen - minSeen > 0.02f)
+    {
+        std::cout << name << ": scale oscillates between "
+            << minSeen << " and " << maxSeen << std::endl;
+        passed = false;
+    }
+    return passed;
+}
+
+int main()
+{
+    bool passed = true;
+    const float period90Hz = 1.0f / 90.0f;
+
+    // Cheap scene stays at full resolution.
+    passed &= TestConverge("cheap", 0.001f, 0.004f, period90Hz);
+    // Heavy scene settles below full resolution.
+    passed &= TestConverge("heavy", 0.002f, 0.020f, period90Hz);
+    // Too heavy even at the lowest scale, must clamp.
+    passed &= TestConverge("overload", 0.012f, 0.020f, period90Hz);
+
+    {   // A single slow frame lowers the scale at once.
+        renderer::DynamicResolution controller;
+        for (int i = 0; i < 100; i++)
+            controller.Update(0.005f, period90Hz);
+        float before = controller.GetScale();
+        controller.Update(0.020f, period90Hz);
+        if (controller.GetScale() >= before)
+        {
+            std::cout << "spike: scale did not drop" << std::endl;
+            passed = false;
+        }
+    }
+
+    {   // Unknown display period leaves the scale alone.
+        renderer::DynamicResolution controller;
+        controller.Update(1.0f, 0.0f);
+        if (controller.GetScale() != 1.0f)
+        {
+            std::cout << "no period: scale changed" << std::endl;
+            passed = false;
+        }
+    }
+
+    std::cout << (passed? "passed": "failed") << std::endl;
+    return passed? 0: 1;
+}
@@ -0,0 +1,288 @@
+#include "gpu_culling.h"
+#include "math_library.h"
+#include "test_sampling.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+static bool TestFrustum(const std::string& name, const glm::mat4& projection)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    glm::mat4 view = glm::inverse(
+        glm::translate(glm::mat4(1.0f), glm::vec3(3.0f, 1.0f, -2.0f)) *
+        glm::rotate(glm::mat4(1.0f), 0.7f, glm::vec3(0.0f, 1.0f, 0.0f)));
+    glm::mat4 viewProjection = projection * view;
+    glm::vec4 planes[6];
+    GpuCulling::ExtractPlanes(viewProjection, planes);
+
+    auto inside = [&viewProjection](glm::vec3 point) {
+        glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+        return std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w &&
+            clip.z >= 0.0f && clip.z <= clip.w;
+    };
+
+    uint32_t culled = 0;
+    for (uint32_t n = 0; n < 4000; n++)
+    {
+        glm::vec4 sphere(unit(rng) * 200.0f - 100.0f, unit(rng) * 40.0f - 20.0f,
+            unit(rng) * 200.0f - 100.0f, 0.1f + unit(rng) * 4.0f);
+        bool visible = GpuCulling::IsInFrustum(planes, sphere);
+
+        if (!visible && inside(glm::vec3(sphere)))
+        {
+            std::cout << name << ": sphere " << n << " culled with its center inside" << std::endl;
+            return false;
+        }
+
+        if (visible)
+            continue;
+        culled++;
+
+        for (const glm::vec3& point: SampleSphere(sphere, rng, true))
+        {
+            if (inside(point))
+            {
+                std::cout << name << ": sphere " << n << " culled while in the frustum" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    std::cout << name << ": " << culled << " of 4000 spheres outside the frustum" << std::endl;
+    return culled > 0;
+}
+
+static bool TestProjection(const std::string& name, const glm::mat4& projection)
+{
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    uint32_t projected = 0;
+    for (uint32_t n = 0; n < 4000; n++)
+    {
+        glm::vec4 sphere(unit(rng) * 20.0f - 10.0f, unit(rng) * 20.0f - 10.0f,
+            -unit(rng) * 40.0f, 0.05f + unit(rng) * 3.0f);
+
+        glm::vec4 rect;
+        float depth;
+        if (!GpuCulling::ProjectSphere(glm::vec3(sphere), sphere.w, projection, rect, depth))
+            continue;
+        projected++;
+
+        for (const glm::vec3& point: SampleSphere(sphere, rng, true))
+        {
+            glm::vec4 clip = projection * glm::vec4(point, 1.0f);
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            glm::vec2 uv(ndc.x * 0.5f + 0.5f, ndc.y * 0.5f + 0.5f);
+
+            if (uv.x < rect.x - 1e-4f || uv.x > rect.z + 1e-4f ||
+                uv.y < rect.y - 1e-4f || uv.y > rect.w + 1e-4f)
+            {
+                std::cout << name << ": sphere " << n << " reaches past its bounds" << std::endl;
+                return false;
+            }
+            if (ndc.z < depth - 1e-5f)
+            {
+                std::cout << name << ": sphere " << n << " is closer than "
+                    << depth << std::endl;
+                return false;
+            }
+        }
+    }
+
+    std::cout << name << ": " << projected << " of 4000 spheres projected" << std::endl;
+    return projected > 0;
+}
+
+static bool TestOcclusion(const std::string& name, const glm::mat4& projection)
+{
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const uint32_t width = 173;
+    const uint32_t height = 97;
+    const float wallDepth = 8.0f;
+
+    // A wall across the middle of the view, the rest is the far plane.
+    float wallValue = projection[3][2] / wallDepth - projection[2][2];
+    std::vector<float> depthBuffer(width * height);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            float ndcX = (x + 0.5f) / width * 2.0f - 1.0f;
+            float ndcY = (y + 0.5f) / height * 2.0f - 1.0f;
+            float viewX = wallDepth * (ndcX + projection[2][0]) / projection[0][0];
+            float viewY = wallDepth * (ndcY + projection[2][1]) / projection[1][1];
+            bool wall = std::abs(viewX) < 3.0f && std::abs(viewY) < 2.0f;
+            depthBuffer[y * width + x] = wall? wallValue: 1.0f;
+        }
+    }
+
+    glm::uvec2 size = GpuCulling::GetPyramidSize(width, height);
+    std::vector<std::vector<float>> levels;
+    GpuCulling::BuildPyramid(depthBuffer.data(), width, height, size, levels);
+    if (size != glm::uvec2(128, 64) || levels.size() != 8 || levels.back().size() != 1)
+    {
+        std::cout << name << ": unexpected pyramid of " << levels.size() << " levels" << std::endl;
+        return false;
+    }
+
+    auto occluded = [&](glm::vec4 sphere) {
+        glm::vec4 rect;
+        float depth;
+        return GpuCulling::ProjectSphere(glm::vec3(sphere), sphere.w, projection, rect, depth) &&
+            GpuCulling::IsOccluded(levels, size, rect, depth);
+    };
+
+    if (!occluded(glm::vec4(0.0f, 0.0f, -20.0f, 0.5f)) ||
+        occluded(glm::vec4(0.0f, 0.0f, -6.0f, 1.0f)) ||
+        occluded(glm::vec4(0.0f, 0.0f, -20.0f, 12.0f)))
+    {
+        std::cout << name << ": spheres in front or behind the wall are misplaced" << std::endl;
+        return false;
+    }
+
+    // Every point of an occluded sphere is behind the depth buffer.
+    uint32_t culled = 0;
+    for (uint32_t n = 0; n < 4000; n++)
+    {
+        glm::vec4 sphere(unit(rng) * 16.0f - 8.0f, unit(rng) * 10.0f - 5.0f,
+            -2.0f - unit(rng) * 40.0f, 0.05f + unit(rng) * 2.0f);
+        if (!occluded(sphere))
+            continue;
+        culled++;
+
+        for (const glm::vec3& point: SampleSphere(sphere, rng, true))
+        {
+            glm::vec4 clip = projection * glm::vec4(point, 1.0f);
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            int32_t x = static_cast<int32_t>(std::floor((ndc.x * 0.5f + 0.5f) * width));
+            int32_t y = static_cast<int32_t>(std::floor((ndc.y * 0.5f + 0.5f) * height));
+            if (x < 0 || y < 0 || x >= static_cast<int32_t>(width) ||
+                y >= static_cast<int32_t>(height))
+                continue;
+
+            if (ndc.z < depthBuffer[y * width + x])
+            {
+                std::cout << name << ": sphere " << n << " culled while visible" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    std::cout << name << ": " << culled << " of 4000 spheres occluded" << std::endl;
+    return culled > 0;
+}
+
+static bool TestLod()
+{
+    const uint32_t lodCount = 4;
+
+    // Sizes going down only ever pick coarser levels.
+    uint32_t level = lodCount;
+    for (float size = 2.0f; size > 0.01f; size *= 0.97f)
+    {
+        uint32_t next = GpuCulling::SelectLod(size, lodCount, level);
+        if (level < lodCount && next < level)
+        {
+            std::cout << "lod: finer level at a smaller size " << size << std::endl;
+            return false;
+        }
+        level = next;
+    }
+    if (level != lodCount - 1)
+    {
+        std::cout << "lod: coarsest level not reached" << std::endl;
+        return false;
+    }
+
+    // Sizes around a threshold keep the level picked first.
+    level = GpuCulling::SelectLod(MESH_LOD_SCREEN_SIZE * 0.98f, lodCount, lodCount);
+    for (uint32_t n = 0; n < 20; n++)
+    {
+        float size = MESH_LOD_SCREEN_SIZE * ((n % 2)? 1.05f: 0.95f);
+        if (GpuCulling::SelectLod(size, lodCount, level) != level)
+        {
+            std::cout << "lod: level changed within the hysteresis" << std::endl;
+            return false;
+        }
+    }
+
+    return GpuCulling::SelectLod(0.001f, 1, 0) == 0;
+}
+
+static bool TestDirtyRanges()
+{
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<uint32_t> coin(0, 9);
+
+    // Sparse, dense and whole words, against a bit by bit reference.
+    for (uint32_t density = 0; density <= 10; density += 5)
+    {
+        std::vector<uint64_t> bits(8, 0);
+        std::vector<bool> reference(bits.size() * 64, false);
+        for (uint32_t i = 0; i < reference.size(); i++)
+        {
+            bool set = (i / 64 == 3) || coin(rng) < density;
+            reference[i] = set;
+            if (set)
+                bits[i / 64] |= 1ull << (i % 64);
+        }
+
+        std::vector<glm::uvec2> ranges;
+        GpuCulling::GetDirtyRanges(bits, ranges);
+
+        std::vector<bool> covered(reference.size(), false);
+        for (uint32_t r = 0; r < ranges.size(); r++)
+        {
+            if (r > 0 && ranges[r].x <= ranges[r - 1].x + ranges[r - 1].y)
+            {
+                std::cout << "dirty ranges: ranges touch or overlap" << std::endl;
+                return false;
+            }
+            for (uint32_t i = ranges[r].x; i < ranges[r].x + ranges[r].y; i++)
+                covered[i] = true;
+        }
+        if (covered != reference)
+        {
+            std::cout << "dirty ranges: wrong bits at density " << density << std::endl;
+            return false;
+        }
+        std::cout << "dirty ranges: " << ranges.size() << " copies at density "
+            << density << std::endl;
+    }
+
+    return true;
+}
+
+int main()
+{
+    bool passed = true;
+
+    glm::mat4 perspective = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+    // Asymmetric with the far plane at infinity, as used in VR.
+    glm::mat4 eye;
+    math::XrProjectionFov(eye, glm::vec4(-0.94f, 0.87f, 0.96f, -0.96f), 0.05f, 0.0f);
+
+    passed &= TestFrustum("perspective", perspective);
+    passed &= TestFrustum("xr eye", eye);
+    passed &= TestProjection("perspective", perspective);
+    passed &= TestProjection("xr eye", eye);
+    passed &= TestOcclusion("perspective", perspective);
+    passed &= TestOcclusion("xr eye", eye);
+    passed &= TestLod();
+    passed &= TestDirtyRanges();
+
+    std::cout << (passed? "passed": "failed") << std::endl;
+    return passed? 0: 1;
+}
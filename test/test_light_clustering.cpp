@@ -0,0 +1,211 @@
+#include "light_clustering.h"
+#include "math_library.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+/**
+ * View space point of a framebuffer position, same projection
+ * assumptions as LightClustering.
+ */
+static glm::vec3 Unproject(const glm::mat4& projection, glm::vec2 uv, float depth)
+{
+    float x = -1.0f + 2.0f * uv.x;
+    float y = -1.0f + 2.0f * uv.y;
+    return glm::vec3(
+        depth * (x + projection[2][0]) / projection[0][0],
+        depth * (y + projection[2][1]) / projection[1][1],
+        -depth);
+}
+
+static std::vector<LightClustering::Sphere> RandomLights(
+    const glm::mat4& projection, uint32_t count, float maxDepth, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<LightClustering::Sphere> lights(count);
+    for (LightClustering::Sphere& light: lights)
+    { // Slightly outside the frustum as well
+        glm::vec2 uv(unit(rng) * 1.4f - 0.2f, unit(rng) * 1.4f - 0.2f);
+        light.center = Unproject(projection, uv, 0.05f + unit(rng) * maxDepth);
+        light.radius = 0.2f + unit(rng) * unit(rng) * 6.0f;
+    }
+    return lights;
+}
+
+/**
+ * Sphere and box test against froxel corners built from
+ * the slice parameters instead of the bounds of LightClustering.
+ */
+static bool Intersects(const LightClustering& clustering, const glm::mat4& projection,
+    uint32_t cluster, const LightClustering::Sphere& light)
+{
+    uint32_t x = cluster % CLUSTER_GRID_X;
+    uint32_t y = (cluster / CLUSTER_GRID_X) % CLUSTER_GRID_Y;
+    uint32_t z = cluster / (CLUSTER_GRID_X * CLUSTER_GRID_Y);
+
+    glm::vec2 slice = clustering.GetSliceParameters();
+    float depths[2] = {
+        std::exp((z - slice.y) / slice.x),
+        std::exp((z + 1 - slice.y) / slice.x)
+    };
+
+    glm::vec3 boxMin(1e30f), boxMax(-1e30f);
+    for (float depth: depths)
+    {
+        for (uint32_t corner = 0; corner < 4; corner++)
+        {
+            glm::vec2 uv(
+                static_cast<float>(x + corner % 2) / CLUSTER_GRID_X,
+                static_cast<float>(y + corner / 2) / CLUSTER_GRID_Y);
+            glm::vec3 p = Unproject(projection, uv, depth);
+            boxMin = glm::min(boxMin, p);
+            boxMax = glm::max(boxMax, p);
+        }
+    }
+
+    glm::vec3 d = glm::max(glm::vec3(0.0f),
+        glm::max(boxMin - light.center, light.center - boxMax));
+    float tolerance = 1e-3f * (1.0f + light.radius);
+    return glm::dot(d, d) <= (light.radius + tolerance) * (light.radius + tolerance);
+}
+
+static bool TestProjection(const std::string& name, const glm::mat4& projection)
+{
+    bool passed = true;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    LightClustering clustering;
+    clustering.SetProjection(projection);
+
+    const uint32_t lightBase = 3;  // Directional lights come first
+    const uint32_t indexBase = 100;
+    std::vector<LightClustering::Sphere> lights =
+        RandomLights(projection, 500, 80.0f, rng);
+    std::vector<glm::uvec2> clusters(CLUSTER_COUNT);
+    std::vector<uint32_t> indices(CLUSTER_MAX_INDICES);
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t dropped = clustering.Bin(lights.data(), lights.size(), lightBase,
+        clusters.data(), indices.data(), indices.size(), indexBase);
+    auto end = std::chrono::steady_clock::now();
+
+    uint64_t indexCount = 0;
+    for (const glm::uvec2& cluster: clusters)
+    {
+        if (cluster.x != indexBase + indexCount)
+        {
+            std::cout << name << ": clusters are not back to back" << std::endl;
+            return false;
+        }
+        indexCount += cluster.y;
+    }
+
+    std::cout << name << ": near " << clustering.GetNear()
+        << ", far " << clustering.GetFar()
+        << ", " << lights.size() << " lights, " << indexCount << " indices, "
+        << std::chrono::duration<double, std::micro>(end - start).count()
+        << " us" << std::endl;
+
+    if (dropped != 0)
+    {
+        std::cout << name << ": " << dropped << " lights dropped" << std::endl;
+        passed = false;
+    }
+
+    // Same result as a scalar test against the froxels.
+    for (uint32_t c = 0; c < CLUSTER_COUNT; c++)
+    {
+        std::vector<bool> binned(lights.size(), false);
+        for (uint32_t j = 0; j < clusters[c].y; j++)
+            binned[indices[clusters[c].x - indexBase + j] - lightBase] = true;
+
+        for (uint32_t i = 0; i < lights.size(); i++)
+        {
+            float depth = -lights[i].center.z;
+            bool inRange = depth + lights[i].radius >= clustering.GetNear() &&
+                depth - lights[i].radius <= clustering.GetFar();
+            bool expected = inRange &&
+                Intersects(clustering, projection, c, lights[i]);
+            if (binned[i] && !expected)
+            {
+                std::cout << name << ": light " << i
+                    << " binned to cluster " << c << " it misses" << std::endl;
+                passed = false;
+            }
+            if (!binned[i] && expected &&
+                Intersects(clustering, projection, c,
+                    {lights[i].center, lights[i].radius * 0.999f - 1e-3f}))
+            {
+                std::cout << name << ": light " << i
+                    << " missing from cluster " << c << std::endl;
+                passed = false;
+            }
+        }
+        if (!passed)
+            return false;
+    }
+
+    // Every light that reaches a point is in the cluster of the point.
+    for (uint32_t n = 0; n < 20000; n++)
+    {
+        glm::vec2 uv(unit(rng), unit(rng));
+        float depth = clustering.GetNear() +
+            unit(rng) * (std::min(clustering.GetFar(), 80.0f) - clustering.GetNear());
+        glm::vec3 point = Unproject(projection, uv, depth);
+        const glm::uvec2& cluster = clusters[clustering.GetClusterIndex(uv, depth)];
+
+        for (uint32_t i = 0; i < lights.size(); i++)
+        {
+            if (glm::length(point - lights[i].center) > lights[i].radius * 0.999f)
+                continue;
+
+            const uint32_t* first = &indices[cluster.x - indexBase];
+            if (std::find(first, first + cluster.y, lightBase + i) == first + cluster.y)
+            {
+                std::cout << name << ": light " << i << " missing at uv ("
+                    << uv.x << ", " << uv.y << "), depth " << depth << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // Full index list, the last pairs are dropped.
+    std::vector<uint32_t> small(64);
+    dropped = clustering.Bin(lights.data(), lights.size(), lightBase,
+        clusters.data(), small.data(), small.size());
+    if (dropped + small.size() != indexCount ||
+        clusters[CLUSTER_COUNT - 1].x + clusters[CLUSTER_COUNT - 1].y != small.size())
+    {
+        std::cout << name << ": overflow dropped " << dropped
+            << " of " << indexCount << std::endl;
+        passed = false;
+    }
+
+    return passed;
+}
+
+int main()
+{
+    bool passed = true;
+
+    passed &= TestProjection("perspective",
+        glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f));
+
+    // Asymmetric eye with the far plane at infinity, as used in VR.
+    glm::mat4 eye;
+    math::XrProjectionFov(eye, glm::vec4(-0.94f, 0.87f, 0.96f, -0.96f), 0.05f, 0.0f);
+    passed &= TestProjection("xr eye", eye);
+
+    std::cout << (passed? "passed": "failed") << std::endl;
+    return passed? 0: 1;
+}
@@ -0,0 +1,263 @@
+#include "mesh_optimizer.h"
+#include "obj_loader.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+typedef std::array<renderer::Vertex, 3> Triangle;
+
+static bool VertexLess(const renderer::Vertex& a, const renderer::Vertex& b)
+{
+    return memcmp(&a, &b, sizeof(renderer::Vertex)) < 0;
+}
+
+/**
+ * Triangles as vertex data, rotated so that winding is kept
+ * but the first vertex is the smallest. Order independent.
+ */
+static std::vector<Triangle> CollectTriangles(
+    const std::vector<unsigned int>& indices,
+    const std::vector<renderer::Vertex>& vertices)
+{
+    std::vector<Triangle> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        Triangle t = {
+            vertices[indices[i]],
+            vertices[indices[i + 1]],
+            vertices[indices[i + 2]]
+        };
+        while (VertexLess(t[1], t[0]) || VertexLess(t[2], t[0]))
+            std::rotate(t.begin(), t.begin() + 1, t.end());
+        triangles.push_back(t);
+    }
+
+    std::sort(triangles.begin(), triangles.end(),
+        [](const Triangle& a, const Triangle& b) {
+            return memcmp(a.data(), b.data(), sizeof(Triangle)) < 0;
+        });
+    return triangles;
+}
+
+/**
+ * Unwelded UV sphere with triangles in random order,
+ * similar to what ObjLoader2 produces.
+ */
+static void BuildSphere(int rings, int segments,
+    std::vector<unsigned int>& indices,
+    std::vector<renderer::Vertex>& vertices)
+{
+    auto point = [rings, segments](int r, int s) {
+        float theta = 3.14159265f * r / rings;
+        float phi = 2.0f * 3.14159265f * (s % segments) / segments;
+        renderer::Vertex vertex{};
+        vertex.Position = glm::vec3(
+            std::sin(theta) * std::cos(phi),
+            std::cos(theta),
+            std::sin(theta) * std::sin(phi));
+        vertex.Normal = vertex.Position;
+        vertex.TexCoords = glm::vec2(
+            static_cast<float>(s) / segments,
+            static_cast<float>(r) / rings);
+        return vertex;
+    };
+
+    std::vector<Triangle> triangles;
+    for (int r = 0; r < rings; r++)
+    {
+        for (int s = 0; s < segments; s++)
+        {
+            triangles.push_back({point(r, s), point(r + 1, s), point(r + 1, s + 1)});
+            triangles.push_back({point(r, s), point(r + 1, s + 1), point(r, s + 1)});
+        }
+    }
+
+    std::mt19937 rng(7);
+    std::shuffle(triangles.begin(), triangles.end(), rng);
+
+    for (const Triangle& t: triangles)
+    {
+        for (const renderer::Vertex& vertex: t)
+        {
+            indices.push_back(static_cast<unsigned int>(vertices.size()));
+            vertices.push_back(vertex);
+        }
+    }
+}
+
+static bool TestLods(const std::string& name,
+    const std::vector<unsigned int>& indices,
+    const std::vector<renderer::Vertex>& vertices,
+    const std::vector<renderer::MeshLod>& lods)
+{
+    bool passed = true;
+    if (lods.empty() || lods.size() > MESH_MAX_LOD ||
+        lods[0].firstIndex != 0 || lods[0].error != 0.0f)
+    {
+        std::cout << name << ": invalid LOD table" << std::endl;
+        return false;
+    }
+
+    uint64_t expectedFirst = 0;
+    for (size_t i = 0; i < lods.size(); i++)
+    {
+        const renderer::MeshLod& lod = lods[i];
+        if (lod.firstIndex != expectedFirst || lod.indexCount % 3 != 0)
+        {
+            std::cout << name << ": LOD " << i << " has a bad range" << std::endl;
+            passed = false;
+        }
+        expectedFirst = lod.firstIndex + lod.indexCount;
+
+        if (i > 0 && (lod.indexCount >= lods[i - 1].indexCount ||
+            lod.error < lods[i - 1].error))
+        {
+            std::cout << name << ": LOD " << i << " is not coarser" << std::endl;
+            passed = false;
+        }
+
+        for (uint32_t j = 0; j < lod.indexCount; j += 3)
+        {
+            unsigned int a = indices[lod.firstIndex + j];
+            unsigned int b = indices[lod.firstIndex + j + 1];
+            unsigned int c = indices[lod.firstIndex + j + 2];
+            if (a >= vertices.size() || b >= vertices.size() ||
+                c >= vertices.size() || a == b || b == c || c == a)
+            {
+                std::cout << name << ": LOD " << i
+                    << " has an invalid triangle" << std::endl;
+                passed = false;
+                break;
+            }
+        }
+    }
+
+    if (expectedFirst != indices.size())
+    {
+        std::cout << name << ": indices not covered by LODs" << std::endl;
+        passed = false;
+    }
+    return passed;
+}
+
+static bool TestMesh(const std::string& name,
+    std::vector<unsigned int> indices,
+    std::vector<renderer::Vertex> vertices)
+{
+    std::vector<Triangle> reference = CollectTriangles(indices, vertices);
+    MeshOptimizer::CacheStats before =
+        MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+
+    std::vector<renderer::MeshLod> lods;
+    MeshOptimizer::Optimize(name, indices, vertices, lods);
+
+    // Levels of detail follow the full resolution indices.
+    std::vector<unsigned int> fullIndices(
+        indices.begin(), indices.begin() + lods[0].indexCount);
+    MeshOptimizer::CacheStats after =
+        MeshOptimizer::AnalyzeVertexCache(fullIndices, vertices.size());
+
+    std::cout << name << ": ACMR " << before.acmr << " -> " << after.acmr
+        << ", ATVR " << before.atvr << " -> " << after.atvr
+        << ", vertices " << vertices.size() << ", LODs " << lods.size()
+        << std::endl;
+
+    bool passed = true;
+    std::vector<Triangle> result = CollectTriangles(fullIndices, vertices);
+    if (result.size() != reference.size() || memcmp(result.data(),
+        reference.data(), sizeof(Triangle) * result.size()) != 0)
+    {
+        std::cout << name << ": triangles changed" << std::endl;
+        passed = false;
+    }
+    if (after.acmr > before.acmr)
+    {
+        std::cout << name << ": ACMR regressed" << std::endl;
+        passed = false;
+    }
+    unsigned int nextVertex = 0;
+    for (unsigned int index: fullIndices)
+    { // Vertex fetch order means new indices grow one by one.
+        if (index > nextVertex)
+        {
+            std::cout << name << ": vertices not in fetch order" << std::endl;
+            passed = false;
+            break;
+        }
+        if (index == nextVertex)
+            nextVertex++;
+    }
+    if (!TestLods(name, indices, vertices, lods))
+        passed = false;
+    return passed;
+}
+
+int main()
+{
+    bool passed = true;
+
+    {
+        std::vector<unsigned int> indices;
+        std::vector<renderer::Vertex> vertices;
+        BuildSphere(32, 48, indices, vertices);
+
+        std::vector<unsigned int> weldIndices = indices;
+        std::vector<renderer::Vertex> weldVertices = vertices;
+        uint64_t welded = MeshOptimizer::WeldVertices(weldIndices, weldVertices);
+        if (welded != 33 * 49)
+        {
+            std::cout << "sphere: welded to " << welded
+                << " vertices, expected " << 33 * 49 << std::endl;
+            passed = false;
+        }
+
+        passed &= TestMesh("sphere", indices, vertices);
+
+        // A smooth closed sphere must simplify to several levels.
+        std::vector<renderer::MeshLod> lods;
+        MeshOptimizer::Optimize("sphere", indices, vertices, lods);
+        if (lods.size() < 3)
+        {
+            std::cout << "sphere: only " << lods.size() << " LODs" << std::endl;
+            passed = false;
+        }
+    }
+
+    {   // Fixture mesh, checked in next to the test.
+        std::string path = "data/icosphere.obj";
+        std::vector<unsigned int> indices;
+        std::vector<renderer::Vertex> vertices;
+        if (!ObjLoader2(path, vertices, indices) || indices.size() != 80 * 3)
+        {
+            std::cout << path << ": failed to load "
+                << indices.size() / 3 << " of 80 triangles" << std::endl;
+            passed = false;
+        }
+        else
+        {
+            std::vector<unsigned int> weldIndices = indices;
+            std::vector<renderer::Vertex> weldVertices = vertices;
+            uint64_t welded =
+                MeshOptimizer::WeldVertices(weldIndices, weldVertices);
+            if (welded != 42)
+            {
+                std::cout << path << ": welded to " << welded
+                    << " vertices, expected 42" << std::endl;
+                passed = false;
+            }
+
+            passed &= TestMesh(path, indices, vertices);
+        }
+    }
+
+    std::cout << (passed? "passed": "failed") << std::endl;
+    return passed? 0: 1;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+/**
+ * Points of a sphere, just inside its surface.
+ * With inside set, every other point is scaled towards the center.
+ */
+static std::vector<glm::vec3> SampleSphere(glm::vec4 sphere, std::mt19937& rng,
+    bool inside)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<glm::vec3> points;
+    for (uint32_t s = 0; s < 64; s++)
+    {
+        glm::vec3 offset(unit(rng) - 0.5f, unit(rng) - 0.5f, unit(rng) - 0.5f);
+        float scale = (inside && s % 2 == 0)? unit(rng): 1.0f;
+        points.push_back(glm::vec3(sphere) +
+            offset * (0.999f * scale * sphere.w / std::max(glm::length(offset), 1e-3f)));
+    }
+    return points;
+}
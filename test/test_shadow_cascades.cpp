@@ -0,0 +1,194 @@
+#include "shadow_cascades.h"
+#include "math_library.h"
+#include "test_sampling.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+/**
+ * World space point of a framebuffer position of a view.
+ */
+static glm::vec3 Unproject(const glm::mat4& view, const glm::mat4& projection,
+    glm::vec2 uv, float depth)
+{
+    float x = -1.0f + 2.0f * uv.x;
+    float y = -1.0f + 2.0f * uv.y;
+    glm::vec4 point(
+        depth * (x + projection[2][0]) / projection[0][0],
+        depth * (y + projection[2][1]) / projection[1][1],
+        -depth, 1.0f);
+    return glm::vec3(glm::inverse(view) * point);
+}
+
+static bool TestCamera(const std::string& name,
+    const std::vector<glm::mat4>& eyes, const std::vector<glm::mat4>& projections)
+{
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const glm::vec3 direction(-0.4f, -1.0f, -0.3f);
+    const uint32_t viewCount = static_cast<uint32_t>(eyes.size());
+
+    auto viewsOf = [&](const glm::mat4& camera) {
+        std::vector<glm::mat4> views;
+        for (const glm::mat4& eye: eyes)
+            views.push_back(glm::inverse(camera * eye));
+        return views;
+    };
+
+    ShadowCascades reference;
+    std::vector<glm::mat4> views = viewsOf(glm::mat4(1.0f));
+    reference.Fit(views.data(), projections.data(), viewCount, direction);
+
+    float lastSplit = 0.0f;
+    for (uint32_t c = 0; c < SHADOW_CASCADE_COUNT; c++)
+    {
+        if (reference.GetCascade(c).splitDepth <= lastSplit)
+        {
+            std::cout << name << ": splits do not increase" << std::endl;
+            return false;
+        }
+        lastSplit = reference.GetCascade(c).splitDepth;
+    }
+    std::cout << name << ": last split " << lastSplit << ", texel sizes";
+    for (uint32_t c = 0; c < SHADOW_CASCADE_COUNT; c++)
+        std::cout << " " << reference.GetCascade(c).texelSize;
+    std::cout << std::endl;
+
+    // Every point a view sees is in the cascade of its depth.
+    for (uint32_t n = 0; n < 20000; n++)
+    {
+        uint32_t v = n % viewCount;
+        float depth = 0.2f + unit(rng) * (lastSplit - 0.2f);
+        glm::vec3 point = Unproject(views[v], projections[v],
+            glm::vec2(unit(rng), unit(rng)), depth);
+
+        uint32_t c = 0;
+        while (c + 1 < SHADOW_CASCADE_COUNT && depth > reference.GetCascade(c).splitDepth)
+            c++;
+
+        glm::vec4 clip = reference.GetCascade(c).viewProjection * glm::vec4(point, 1.0f);
+        if (std::abs(clip.x) > 1.0f || std::abs(clip.y) > 1.0f ||
+            clip.z < -1e-4f || clip.z > 1.0f + 1e-4f)
+        {
+            std::cout << name << ": point at depth " << depth
+                << " outside of cascade " << c << std::endl;
+            return false;
+        }
+    }
+
+    // Moving and turning keeps the size of the cascades,
+    // and world points at the same place within their texels.
+    const glm::vec3 probe(3.3f, -0.7f, -12.9f);
+    for (uint32_t n = 0; n < 50; n++)
+    {
+        glm::mat4 camera = glm::translate(glm::mat4(1.0f), glm::vec3(
+            unit(rng) * 4.0f - 2.0f, unit(rng) - 0.5f, unit(rng) * 4.0f - 2.0f)) *
+            glm::rotate(glm::mat4(1.0f), unit(rng) * 6.28f, glm::vec3(0.0f, 1.0f, 0.0f));
+        std::vector<glm::mat4> moved = viewsOf(camera);
+
+        ShadowCascades cascades;
+        cascades.Fit(moved.data(), projections.data(), viewCount, direction);
+
+        for (uint32_t c = 0; c < SHADOW_CASCADE_COUNT; c++)
+        {
+            const ShadowCascades::Cascade& a = reference.GetCascade(c);
+            const ShadowCascades::Cascade& b = cascades.GetCascade(c);
+            if (a.texelSize != b.texelSize)
+            {
+                std::cout << name << ": cascade " << c << " changed size from "
+                    << a.texelSize << " to " << b.texelSize << std::endl;
+                return false;
+            }
+
+            glm::vec4 clipA = a.viewProjection * glm::vec4(probe, 1.0f);
+            glm::vec4 clipB = b.viewProjection * glm::vec4(probe, 1.0f);
+            for (int axis = 0; axis < 2; axis++)
+            {
+                float texels = (clipA[axis] - clipB[axis]) * 0.5f * SHADOW_MAP_SIZE;
+                if (std::abs(texels - std::round(texels)) > 0.02f)
+                {
+                    std::cout << name << ": cascade " << c << " moved by "
+                        << texels << " texels" << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Culled spheres do not reach the cascade, kept ones are within its depth.
+    std::vector<glm::vec4> spheres;
+    for (uint32_t n = 0; n < 2000; n++)
+    {
+        glm::vec3 center(unit(rng) * 200.0f - 100.0f,
+            unit(rng) * 60.0f - 20.0f, unit(rng) * 200.0f - 100.0f);
+        spheres.push_back(glm::vec4(center, 0.1f + unit(rng) * 3.0f));
+    }
+
+    for (uint32_t c = 0; c < SHADOW_CASCADE_COUNT; c++)
+    {
+        std::vector<uint32_t> casters;
+        reference.Cull(c, spheres.data(), static_cast<uint32_t>(spheres.size()), casters);
+        const glm::mat4& viewProjection = reference.GetCascade(c).viewProjection;
+
+        std::vector<bool> kept(spheres.size(), false);
+        for (uint32_t i: casters)
+            kept[i] = true;
+
+        for (uint32_t i = 0; i < spheres.size(); i++)
+        {
+            glm::vec3 center = glm::vec3(spheres[i]);
+            glm::vec4 clip = viewProjection * glm::vec4(center, 1.0f);
+
+            if (kept[i] && clip.z < -1e-4f)
+            {
+                std::cout << name << ": caster " << i << " of cascade " << c
+                    << " is clipped by the near plane" << std::endl;
+                return false;
+            }
+
+            if (kept[i])
+                continue;
+
+            for (const glm::vec3& point: SampleSphere(spheres[i], rng, false))
+            {
+                glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+                if (std::abs(clip.x) <= 1.0f && std::abs(clip.y) <= 1.0f &&
+                    clip.z <= 1.0f)
+                {
+                    std::cout << name << ": sphere " << i
+                        << " culled from cascade " << c << " it reaches" << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+int main()
+{
+    bool passed = true;
+
+    passed &= TestCamera("perspective", {glm::mat4(1.0f)},
+        {glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f)});
+
+    // Two asymmetric eyes with the far plane at infinity, as used in VR.
+    glm::mat4 left, right;
+    math::XrProjectionFov(left, glm::vec4(-0.94f, 0.87f, 0.96f, -0.96f), 0.05f, 0.0f);
+    math::XrProjectionFov(right, glm::vec4(-0.87f, 0.94f, 0.96f, -0.96f), 0.05f, 0.0f);
+    passed &= TestCamera("xr eyes",
+        {glm::translate(glm::mat4(1.0f), glm::vec3(-0.032f, 0.0f, 0.0f)),
+            glm::translate(glm::mat4(1.0f), glm::vec3(0.032f, 0.0f, 0.0f))},
+        {left, right});
+
+    std::cout << (passed? "passed": "failed") << std::endl;
+    return passed? 0: 1;
+}
@@ -28,6 +28,8 @@
 */
 
 #include <string>
+#include <vector>
+#include <cstdint>
 #include <tracy/Tracy.hpp>
 
 
@@ -138,4 +140,56 @@ static std::string base64_decode(std::string const &encoded_string) {
   return ret;
 }
 
+/*
+   Decode straight into a byte buffer, avoiding the intermediate
+   std::string and the per character lookups of base64_decode.
+   Decoding stops at the first padding or non base64 character.
+*/
+static void base64_decode(const char *encoded, size_t length,
+                          std::vector<unsigned char> &out) {
+  ZoneScopedN("base64_decode#buffer");
+
+  static const struct Table {
+    unsigned char value[256];
+    Table() {
+      const char *base64_chars =
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+          "abcdefghijklmnopqrstuvwxyz"
+          "0123456789+/";
+      for (int c = 0; c < 256; c++) value[c] = 0xFF;
+      for (int c = 0; c < 64; c++)
+        value[static_cast<unsigned char>(base64_chars[c])] =
+            static_cast<unsigned char>(c);
+    }
+  } table;
+
+  auto decode = [encoded](size_t i) -> uint32_t {
+    return table.value[static_cast<unsigned char>(encoded[i])];
+  };
+
+  size_t valid = 0;
+  while (valid < length && decode(valid) != 0xFF) valid++;
+
+  size_t tail = valid % 4;
+  out.resize(valid / 4 * 3 + (tail ? tail - 1 : 0));
+
+  unsigned char *dst = out.data();
+  size_t in_ = 0;
+  for (; in_ + 4 <= valid; in_ += 4) {
+    uint32_t bits = (decode(in_) << 18) | (decode(in_ + 1) << 12) |
+                    (decode(in_ + 2) << 6) | decode(in_ + 3);
+    *dst++ = static_cast<unsigned char>(bits >> 16);
+    *dst++ = static_cast<unsigned char>(bits >> 8);
+    *dst++ = static_cast<unsigned char>(bits);
+  }
+
+  if (tail >= 2) {
+    uint32_t bits = (decode(in_) << 18) | (decode(in_ + 1) << 12);
+    if (tail == 3) bits |= decode(in_ + 2) << 6;
+
+    *dst++ = static_cast<unsigned char>(bits >> 16);
+    if (tail == 3) *dst++ = static_cast<unsigned char>(bits >> 8);
+  }
+}
+
 } // namespace base64
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "job_system.h"
+
+#include <algorithm>
+#include <memory>
+#include <tracy/Tracy.hpp>
+
+
+JobSystem& JobSystem::GetInstance()
+{
+    // Leave one hardware thread for the main thread.
+    static JobSystem jobSystem(
+        std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return jobSystem;
+}
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    for (uint32_t i = 0; i < workerCount; i++)
+        workers.emplace_back(&JobSystem::WorkerLoop, this);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+
+    for (std::thread& worker: workers)
+        worker.join();
+}
+
+void JobSystem::Submit(std::function<void()> job)
+{
+    if (workers.empty())
+    {
+        job();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back(std::move(job));
+    }
+    jobAvailable.notify_one();
+}
+
+void JobSystem::ParallelFor(
+    uint32_t count, const std::function<void(uint32_t)>& func)
+{
+    ZoneScopedN("JobSystem::ParallelFor");
+
+    if (count == 0)
+        return;
+
+    struct Batch
+    {
+        std::atomic<uint32_t> next{0};
+        std::atomic<uint32_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+
+    // Indices are taken one by one so uneven jobs balance out.
+    auto run = [batch, count, &func]()
+    {
+        uint32_t i;
+        while ((i = batch->next++) < count)
+        {
+            func(i);
+            if (++batch->done == count)
+            {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                batch->finished.notify_all();
+            }
+        }
+    };
+
+    uint32_t helpers = std::min(GetWorkerCount(), count - 1);
+    for (uint32_t i = 0; i < helpers; i++)
+        Submit(run);
+
+    run();
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->finished.wait(lock, [&batch, count]() {return batch->done == count;});
+}
+
+void JobSystem::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobAvailable.wait(lock, [this]() {return stopping || !jobs.empty();});
+
+            if (stopping && jobs.empty())
+                return;
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        job();
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief A fixed pool of worker threads shared by the engine.
+ * Jobs must not touch Vulkan queues or the scene graph,
+ * those stay on the main thread.
+ */
+class JobSystem
+{
+public:
+    static JobSystem& GetInstance();
+
+    /**
+     * @brief Queue a job to run on a worker thread.
+     */
+    void Submit(std::function<void()> job);
+
+    /**
+     * @brief Run func(i) for every i in [0, count) and wait for all of them.
+     * The calling thread takes part in the work,
+     * so it is safe to call from inside a job.
+     */
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+
+    uint32_t GetWorkerCount() {return static_cast<uint32_t>(workers.size());}
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+private:
+    JobSystem(uint32_t workerCount);
+    ~JobSystem();
+
+    void WorkerLoop();
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex jobMutex;
+    std::condition_variable jobAvailable;
+    bool stopping = false;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ * The mapped bytes are served straight from the OS page cache,
+ * so reading them does not go through an intermediate buffer.
+ */
+class MappedFile
+{
+public:
+
+    /**
+     * @brief Map the file at the path.
+     * If a file is already mapped, it is unmapped first.
+     *
+     * @param path An absolute path to a regular file.
+     * @return Return false if the file cannot be opened or mapped.
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * @brief Unmap the file. Called in destructor.
+     * Can be called multiple times.
+     */
+    void Close();
+
+    const uint8_t* Data() const {return data;}
+    uint64_t Size() const {return size;}
+    bool IsOpen() const {return data != nullptr;}
+
+    MappedFile() = default;
+    ~MappedFile() {Close();}
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+    const uint8_t* data = nullptr;
+    uint64_t size = 0;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};